@@ -15,7 +15,11 @@
 #include "dcFile.h"
 #include "dcClass.h"
 #include "dcTypedef.h"
+#include "dcField.h"
+#include "dcPacker.h"
+#include "dcPackProgram.h"
 #include "memoryUsage.h"
+#include "trueClock.h"
 #include "indent.h"
 #include "panda_getopt.h"
 
@@ -53,7 +57,16 @@ help() {
     "     inheritance.\n\n"
 
     "  -f Write a complete list of field names available for each class,\n"
-    "     including all inherited fields.\n\n";
+    "     including all inherited fields.\n\n"
+
+    "  -p Write the pack program compiled for each field, listing the flat\n"
+    "     sequence of operations used to unpack it.\n\n"
+
+    "  -t Time the validating and skipping of a sample value for each\n"
+    "     field, and its conversion to and from a Python object, both with\n"
+    "     and without the field's compiled pack program, and report the\n"
+    "     speedup.  The sample value has a few elements in each array, or\n"
+    "     is the field's default value if that is out of range.\n\n";
 }
 
 void
@@ -114,16 +127,289 @@ write_complete_field_list(const DCFile &file) {
   }
 }
 
+void
+write_pack_programs(const DCFile &file) {
+  int num_classes = file.get_num_classes();
+  for (int i = 0; i < num_classes; ++i) {
+    const DCClass *dclass = file.get_class(i);
+    int num_fields = dclass->get_num_fields();
+    for (int j = 0; j < num_fields; ++j) {
+      const DCField *field = dclass->get_field(j);
+      cout << dclass->get_name() << "::" << field->get_name();
+      const DCPackProgram *program = field->get_pack_program();
+      if (program == (DCPackProgram *)NULL) {
+        cout << " (not compiled)\n";
+      } else {
+        cout << "\n";
+        program->write(cout, 2);
+      }
+    }
+  }
+}
+
+/**
+ * Packs a made-up value for the packer's current field: a few elements in
+ * each variable-length array and a short string in each string, so that the
+ * timings don't depend on the default value, in which the arrays and strings
+ * are usually empty.
+ */
+void
+pack_sample_value(DCPacker &packer) {
+  switch (packer.get_pack_type()) {
+  case PT_double:
+    packer.pack_double(1.5);
+    break;
+
+  case PT_int:
+  case PT_int64:
+    packer.pack_int(3);
+    break;
+
+  case PT_uint:
+  case PT_uint64:
+    packer.pack_uint(3);
+    break;
+
+  case PT_string:
+  case PT_blob:
+    packer.pack_string("sample");
+    break;
+
+  default:
+    {
+      int num_nested = packer.get_num_nested_fields();
+      if (num_nested < 0) {
+        num_nested = 4;
+      }
+      packer.push();
+      for (int i = 0; i < num_nested; ++i) {
+        pack_sample_value(packer);
+      }
+      packer.pop();
+    }
+  }
+}
+
+/**
+ * Returns the packed data to time for the indicated field.  This is a sample
+ * value if the field will accept one, or its default value if a sample value
+ * is out of its range.
+ */
+string
+make_sample_value(const DCField *field) {
+  DCPacker packer;
+  packer.begin_pack(field);
+  pack_sample_value(packer);
+  if (!packer.end_pack()) {
+    return field->get_default_value();
+  }
+  return packer.get_string();
+}
+
+// Each timing is the average over this many iterations, and the best of
+// this many runs, so that a run interrupted by another process is ignored.
+static const int iterations = 10000;
+static const int num_runs = 5;
+
+/**
+ * Returns the average time in seconds to validate (or skip) the indicated
+ * packed data for the field.
+ */
+double
+time_unpack(const DCField *field, const string &data, bool skip) {
+  TrueClock *clock = TrueClock::get_global_ptr();
+  DCPacker packer;
+
+  double best = 0.0;
+  for (int run = 0; run < num_runs; ++run) {
+    double start = clock->get_short_time();
+    for (int i = 0; i < iterations; ++i) {
+      packer.set_unpack_data(data.data(), data.length(), false);
+      packer.begin_unpack(field);
+      if (skip) {
+        packer.unpack_skip();
+      } else {
+        packer.unpack_validate();
+      }
+      packer.end_unpack();
+    }
+    double elapsed = clock->get_short_time() - start;
+    if (run == 0 || elapsed < best) {
+      best = elapsed;
+    }
+  }
+  return best / iterations;
+}
+
+#ifdef HAVE_PYTHON
+/**
+ * Returns the average time in seconds to convert the indicated packed data
+ * for the field to a Python object.
+ */
+double
+time_unpack_object(const DCField *field, const string &data) {
+  TrueClock *clock = TrueClock::get_global_ptr();
+  DCPacker packer;
+
+  double best = 0.0;
+  for (int run = 0; run < num_runs; ++run) {
+    double start = clock->get_short_time();
+    for (int i = 0; i < iterations; ++i) {
+      packer.set_unpack_data(data.data(), data.length(), false);
+      packer.begin_unpack(field);
+      PyObject *object = packer.unpack_object();
+      Py_XDECREF(object);
+      packer.end_unpack();
+    }
+    double elapsed = clock->get_short_time() - start;
+    if (run == 0 || elapsed < best) {
+      best = elapsed;
+    }
+  }
+  return best / iterations;
+}
+
+/**
+ * Returns the average time in seconds to pack the indicated Python object
+ * for the field.
+ */
+double
+time_pack_object(const DCField *field, PyObject *object) {
+  TrueClock *clock = TrueClock::get_global_ptr();
+  DCPacker packer;
+
+  double best = 0.0;
+  for (int run = 0; run < num_runs; ++run) {
+    double start = clock->get_short_time();
+    for (int i = 0; i < iterations; ++i) {
+      packer.clear_data();
+      packer.begin_pack(field);
+      packer.pack_object(object);
+      packer.end_pack();
+    }
+    double elapsed = clock->get_short_time() - start;
+    if (run == 0 || elapsed < best) {
+      best = elapsed;
+    }
+  }
+  return best / iterations;
+}
+#endif  // HAVE_PYTHON
+
+/**
+ * Writes one line of the timings reported by time_pack_programs().
+ */
+void
+report_time(const string &name, double plain, double compiled) {
+  cout << "  " << name << ": " << plain * 1.0e9 << " ns, compiled "
+       << compiled * 1.0e9 << " ns";
+  if (compiled > 0.0) {
+    cout << " (" << plain / compiled << "x)";
+  }
+  cout << "\n";
+}
+
+void
+time_pack_programs(const DCFile &file, int argc, char *argv[]) {
+  // Read the files again without compiling them, for comparison.
+  DCFile plain_file;
+  dc_compile_fields.set_value(false);
+  for (int i = 1; i < argc; i++) {
+    plain_file.read(argv[i]);
+  }
+  dc_compile_fields.clear_local_value();
+
+#ifdef HAVE_PYTHON
+  Py_Initialize();
+#endif
+
+  // The totals of each of the timings, first without the pack programs, then
+  // with them.
+  enum Timing {
+    T_validate,
+    T_skip,
+    T_unpack_object,
+    T_pack_object,
+    T_num_timings
+  };
+  static const char *const timing_names[T_num_timings] = {
+    "unpack_validate", "unpack_skip", "unpack_object", "pack_object",
+  };
+  double total_plain[T_num_timings];
+  double total_compiled[T_num_timings];
+  for (int t = 0; t < T_num_timings; ++t) {
+    total_plain[t] = 0.0;
+    total_compiled[t] = 0.0;
+  }
+
+  int num_classes = file.get_num_classes();
+  for (int i = 0; i < num_classes; ++i) {
+    const DCClass *dclass = file.get_class(i);
+    const DCClass *plain_dclass = plain_file.get_class(i);
+    int num_fields = dclass->get_num_fields();
+    for (int j = 0; j < num_fields; ++j) {
+      const DCField *field = dclass->get_field(j);
+      const DCField *plain_field = plain_dclass->get_field(j);
+      if (field->get_pack_program() == (DCPackProgram *)NULL) {
+        continue;
+      }
+
+      string data = make_sample_value(field);
+      double plain[T_num_timings];
+      double compiled[T_num_timings];
+      plain[T_validate] = time_unpack(plain_field, data, false);
+      compiled[T_validate] = time_unpack(field, data, false);
+      plain[T_skip] = time_unpack(plain_field, data, true);
+      compiled[T_skip] = time_unpack(field, data, true);
+      int num_timings = T_unpack_object;
+
+#ifdef HAVE_PYTHON
+      // Convert the data to an object once, to have something to pack.
+      DCPacker packer;
+      packer.set_unpack_data(data);
+      packer.begin_unpack(field);
+      PyObject *object = packer.unpack_object();
+      if (packer.end_unpack() && object != (PyObject *)NULL) {
+        plain[T_unpack_object] = time_unpack_object(plain_field, data);
+        compiled[T_unpack_object] = time_unpack_object(field, data);
+        plain[T_pack_object] = time_pack_object(plain_field, object);
+        compiled[T_pack_object] = time_pack_object(field, object);
+        num_timings = T_num_timings;
+      }
+      Py_XDECREF(object);
+      PyErr_Clear();
+#endif  // HAVE_PYTHON
+
+      cout << dclass->get_name() << "::" << field->get_name() << ", "
+           << data.length() << " bytes:\n";
+      for (int t = 0; t < num_timings; ++t) {
+        report_time(timing_names[t], plain[t], compiled[t]);
+        total_plain[t] += plain[t];
+        total_compiled[t] += compiled[t];
+      }
+    }
+  }
+
+  cout << "\nTotal:\n";
+  for (int t = 0; t < T_num_timings; ++t) {
+    if (total_compiled[t] > 0.0) {
+      report_time(timing_names[t], total_plain[t], total_compiled[t]);
+    }
+  }
+}
+
 int
 main(int argc, char *argv[]) {
   // extern char *optarg;
   extern int optind;
-  const char *optstr = "bvcfh";
+  const char *optstr = "bvcfpth";
 
   bool dump_verbose = false;
   bool dump_brief = false;
   bool dump_classes = false;
   bool dump_fields = false;
+  bool dump_programs = false;
+  bool time_programs = false;
 
   int flag = getopt(argc, argv, optstr);
 
@@ -145,6 +431,14 @@ main(int argc, char *argv[]) {
       dump_fields = true;
       break;
 
+    case 'p':
+      dump_programs = true;
+      break;
+
+    case 't':
+      time_programs = true;
+      break;
+
     case 'h':
       help();
       exit(1);
@@ -204,6 +498,12 @@ main(int argc, char *argv[]) {
   } else if (dump_fields) {
     write_complete_field_list(file);
 
+  } else if (dump_programs) {
+    write_pack_programs(file);
+
+  } else if (time_programs) {
+    time_pack_programs(file, argc, argv);
+
   } else {
     unsigned long hash = file.get_hash();
     cerr << "File hash is " << hash << " (signed " << (long)hash << ")\n";
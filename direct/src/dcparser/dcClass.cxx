@@ -55,6 +55,13 @@ ConfigVariableBool dc_sort_inheritance_by_file
           "rather than based on the order in which the references are made "
           "within the class."));
 
+ConfigVariableBool dc_compile_fields
+("dc-compile-fields", true,
+ PRC_DESC("Set this true to compile the structure of each field into a "
+          "flat list of operations when a dc file is read, so that messages "
+          "can be unpacked, validated, or skipped without walking the tree "
+          "of nested fields.  Set it false to fall back to the tree walk, "
+          "for instance to compare the two."));
 
 #endif  // WITHIN_PANDA
 
@@ -435,8 +442,7 @@ receive_update(PyObject *distobj, DatagramIterator &di) const {
   PStatTimer timer(((DCClass *)this)->_class_update_pcollector);
 #endif
     DCPacker packer;
-    const char *data = (const char *)di.get_datagram().get_data();
-    packer.set_unpack_data(data + di.get_current_index(),
+    packer.set_unpack_data((const char *)di.get_current_data(),
                            di.get_remaining_size(), false);
 
     int field_id = packer.raw_unpack_uint16();
@@ -471,8 +477,7 @@ receive_update_broadcast_required(PyObject *distobj, DatagramIterator &di) const
   PStatTimer timer(((DCClass *)this)->_class_update_pcollector);
 #endif
   DCPacker packer;
-  const char *data = (const char *)di.get_datagram().get_data();
-  packer.set_unpack_data(data + di.get_current_index(),
+  packer.set_unpack_data((const char *)di.get_current_data(),
                          di.get_remaining_size(), false);
 
   int num_fields = get_num_inherited_fields();
@@ -506,8 +511,7 @@ receive_update_broadcast_required_owner(PyObject *distobj,
   PStatTimer timer(((DCClass *)this)->_class_update_pcollector);
 #endif
   DCPacker packer;
-  const char *data = (const char *)di.get_datagram().get_data();
-  packer.set_unpack_data(data + di.get_current_index(),
+  packer.set_unpack_data((const char *)di.get_current_data(),
                          di.get_remaining_size(), false);
 
   int num_fields = get_num_inherited_fields();
@@ -545,8 +549,7 @@ receive_update_all_required(PyObject *distobj, DatagramIterator &di) const {
   PStatTimer timer(((DCClass *)this)->_class_update_pcollector);
 #endif
   DCPacker packer;
-  const char *data = (const char *)di.get_datagram().get_data();
-  packer.set_unpack_data(data + di.get_current_index(),
+  packer.set_unpack_data((const char *)di.get_current_data(),
                          di.get_remaining_size(), false);
 
   int num_fields = get_num_inherited_fields();
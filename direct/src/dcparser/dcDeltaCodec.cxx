@@ -0,0 +1,268 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file dcDeltaCodec.cxx
+ * @date 2026-10-18
+ */
+
+#include "dcDeltaCodec.h"
+#include "dcField.h"
+#include "dcParameter.h"
+#include "dcSimpleParameter.h"
+#include "dcPacker.h"
+
+/**
+ * Encodes the indicated value of the field as a delta from the indicated
+ * base value, both of which are complete packed values of the field.
+ * Returns true on success, or false if either value cannot be unpacked.
+ */
+bool DCDeltaCodec::
+pack_delta(const DCField *field, const string &base, const string &value,
+           string &delta) {
+  Elements base_elements, value_elements;
+  if (!split_elements(field, base, base_elements) ||
+      !split_elements(field, value, value_elements) ||
+      base_elements.size() != value_elements.size()) {
+    return false;
+  }
+
+  delta = string();
+  BitWriter writer(delta);
+
+  size_t num_elements = value_elements.size();
+  pvector<bool> changed(num_elements);
+  size_t i;
+  for (i = 0; i < num_elements; ++i) {
+    const Element &b = base_elements[i];
+    const Element &v = value_elements[i];
+    changed[i] = (base.compare(b._start, b._length, value, v._start, v._length) != 0);
+    writer.write(changed[i], 1);
+  }
+
+  for (i = 0; i < num_elements; ++i) {
+    if (!changed[i]) {
+      continue;
+    }
+    const Element &b = base_elements[i];
+    const Element &v = value_elements[i];
+
+    const DCSimpleParameter *simple;
+    int size = get_integer_size(v._field, simple);
+    if (size == 0) {
+      // Not an integer; send the bytes as they are.
+      if (!v._field->has_fixed_byte_size()) {
+        writer.write_length(v._length);
+      }
+      for (size_t j = 0; j < v._length; ++j) {
+        writer.write((unsigned char)value[v._start + j], 8);
+      }
+      continue;
+    }
+
+    // Compute the difference, modulo the size of the integer, and zigzag
+    // encode it so that small changes in either direction are short.
+    int num_bits = size * 8;
+    uint64_t mask = ((uint64_t)1 << num_bits) - 1;
+    uint64_t diff = (read_integer(value.data() + v._start, size) -
+                     read_integer(base.data() + b._start, size)) & mask;
+    uint64_t zigzag;
+    if ((diff >> (num_bits - 1)) != 0) {
+      zigzag = (((mask - diff) << 1) | 1) & mask;
+    } else {
+      zigzag = diff << 1;
+    }
+
+    int quantized_bits = simple->get_quantized_bits();
+    if (quantized_bits >= 0) {
+      unsigned int code;
+      bool use_code = simple->quantize(value.data() + v._start, code) &&
+        quantized_bits < 6 + count_bits(zigzag);
+      writer.write(use_code, 1);
+      if (use_code) {
+        writer.write(code, quantized_bits);
+        continue;
+      }
+    }
+    writer.write_length(zigzag);
+  }
+
+  return true;
+}
+
+/**
+ * Reconstructs the value of the field from the indicated delta, as returned
+ * by pack_delta() for the same base value.  Returns true on success, or false
+ * if the base value cannot be unpacked or the delta is malformed.
+ */
+bool DCDeltaCodec::
+unpack_delta(const DCField *field, const string &base, const string &delta,
+             string &value) {
+  Elements base_elements;
+  if (!split_elements(field, base, base_elements)) {
+    return false;
+  }
+
+  value = string();
+  BitReader reader(delta);
+
+  size_t num_elements = base_elements.size();
+  pvector<bool> changed(num_elements);
+  size_t i;
+  for (i = 0; i < num_elements; ++i) {
+    uint64_t bit;
+    if (!reader.read(bit, 1)) {
+      return false;
+    }
+    changed[i] = (bit != 0);
+  }
+
+  for (i = 0; i < num_elements; ++i) {
+    const Element &b = base_elements[i];
+    if (!changed[i]) {
+      value.append(base, b._start, b._length);
+      continue;
+    }
+
+    const DCSimpleParameter *simple;
+    int size = get_integer_size(b._field, simple);
+    if (size == 0) {
+      uint64_t length = b._length;
+      if (!b._field->has_fixed_byte_size()) {
+        if (!reader.read_length(length) || length > delta.length()) {
+          return false;
+        }
+      }
+      for (uint64_t j = 0; j < length; ++j) {
+        uint64_t byte;
+        if (!reader.read(byte, 8)) {
+          return false;
+        }
+        value += (char)byte;
+      }
+      continue;
+    }
+
+    char buffer[4];
+    int quantized_bits = simple->get_quantized_bits();
+    if (quantized_bits >= 0) {
+      uint64_t use_code;
+      if (!reader.read(use_code, 1)) {
+        return false;
+      }
+      if (use_code) {
+        uint64_t code;
+        if (!reader.read(code, quantized_bits)) {
+          return false;
+        }
+        simple->unquantize((unsigned int)code, buffer);
+        value.append(buffer, size);
+        continue;
+      }
+    }
+
+    uint64_t zigzag;
+    if (!reader.read_length(zigzag)) {
+      return false;
+    }
+    int num_bits = size * 8;
+    uint64_t mask = ((uint64_t)1 << num_bits) - 1;
+    uint64_t diff;
+    if ((zigzag & 1) != 0) {
+      diff = mask - (zigzag >> 1);
+    } else {
+      diff = zigzag >> 1;
+    }
+    write_integer(buffer, read_integer(base.data() + b._start, size) + diff, size);
+    value.append(buffer, size);
+  }
+
+  return true;
+}
+
+/**
+ * Fills the elements list with the position and type of each top-level
+ * element of the packed value.  Returns true on success, or false if the
+ * value cannot be unpacked.
+ */
+bool DCDeltaCodec::
+split_elements(const DCField *field, const string &data, Elements &elements) {
+  elements.clear();
+
+  DCPacker packer;
+  packer.set_unpack_data(data.data(), data.length(), false);
+  packer.begin_unpack(field);
+
+  if (field->get_pack_type() == PT_field && packer.more_nested_fields()) {
+    packer.push();
+    while (packer.more_nested_fields()) {
+      Element element;
+      element._field = packer.get_current_field();
+      element._start = packer.get_num_unpacked_bytes();
+      packer.unpack_skip();
+      element._length = packer.get_num_unpacked_bytes() - element._start;
+      elements.push_back(element);
+    }
+    packer.pop();
+
+  } else {
+    // A field that is a single parameter is one element.
+    Element element;
+    element._field = field;
+    element._start = 0;
+    packer.unpack_skip();
+    element._length = packer.get_num_unpacked_bytes();
+    elements.push_back(element);
+  }
+
+  if (!packer.end_unpack()) {
+    return false;
+  }
+  return packer.get_num_unpacked_bytes() == data.length();
+}
+
+/**
+ * Returns the size in bytes of the indicated element if it is an integer
+ * parameter of up to 32 bits, in which case simple is set to the parameter,
+ * or 0 if it is anything else.
+ */
+int DCDeltaCodec::
+get_integer_size(const DCPackerInterface *field,
+                 const DCSimpleParameter *&simple) {
+  simple = NULL;
+  const DCField *as_field = field->as_field();
+  if (as_field == (DCField *)NULL) {
+    return 0;
+  }
+  const DCParameter *parameter = as_field->as_parameter();
+  if (parameter == (DCParameter *)NULL) {
+    return 0;
+  }
+  simple = parameter->as_simple_parameter();
+  if (simple == (DCSimpleParameter *)NULL) {
+    return 0;
+  }
+
+  // Note that the type, rather than the pack type, must be checked here,
+  // since a parameter with a divisor is packed as a double.
+  switch (simple->get_type()) {
+  case ST_int8:
+  case ST_uint8:
+    return 1;
+
+  case ST_int16:
+  case ST_uint16:
+    return 2;
+
+  case ST_int32:
+  case ST_uint32:
+    return 4;
+
+  default:
+    return 0;
+  }
+}
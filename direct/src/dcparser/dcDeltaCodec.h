@@ -0,0 +1,91 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file dcDeltaCodec.h
+ * @date 2026-10-18
+ */
+
+#ifndef DCDELTACODEC_H
+#define DCDELTACODEC_H
+
+#include "dcbase.h"
+
+class DCField;
+class DCPackerInterface;
+class DCSimpleParameter;
+
+/**
+ * Encodes the packed value of a field as the difference from an earlier
+ * value of the same field, which the receiver is known to have, and decodes
+ * it again.  This is the implementation of DCField::pack_delta() and
+ * unpack_delta().
+ *
+ * The value is divided into its top-level elements (the parameters of an
+ * atomic field, or the atomic fields of a molecular field).  The delta is a
+ * bit stream that begins with one bit per element, set if the element has
+ * changed.  Each changed element follows:
+ *
+ * An integer parameter of up to 32 bits is stored either as the zigzag-
+ * encoded difference from the earlier value, preceded by its length in bits,
+ * or, if it has range limits and the value is within them, as its offset from
+ * the lowest limit, whichever is smaller; a selector bit precedes these
+ * parameters that have range limits.  Any other element is stored as its
+ * packed bytes, preceded by its length if that is not fixed.
+ */
+class DCDeltaCodec {
+public:
+  static bool pack_delta(const DCField *field, const string &base,
+                         const string &value, string &delta);
+  static bool unpack_delta(const DCField *field, const string &base,
+                           const string &delta, string &value);
+
+private:
+  class Element {
+  public:
+    const DCPackerInterface *_field;
+    size_t _start;
+    size_t _length;
+  };
+  typedef pvector<Element> Elements;
+
+  static bool split_elements(const DCField *field, const string &data,
+                             Elements &elements);
+  static int get_integer_size(const DCPackerInterface *field,
+                              const DCSimpleParameter *&simple);
+
+  INLINE static uint64_t read_integer(const char *data, int size);
+  INLINE static void write_integer(char *data, uint64_t value, int size);
+  INLINE static int count_bits(uint64_t value);
+
+  class BitWriter {
+  public:
+    INLINE BitWriter(string &data);
+    INLINE void write(uint64_t value, int num_bits);
+    INLINE void write_length(uint64_t value);
+
+  private:
+    string &_data;
+    int _bit;
+  };
+
+  class BitReader {
+  public:
+    INLINE BitReader(const string &data);
+    INLINE bool read(uint64_t &value, int num_bits);
+    INLINE bool read_length(uint64_t &value);
+
+  private:
+    const string &_data;
+    size_t _p;
+    int _bit;
+  };
+};
+
+#include "dcDeltaCodec.I"
+
+#endif
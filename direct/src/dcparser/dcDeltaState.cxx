@@ -0,0 +1,246 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file dcDeltaState.cxx
+ * @date 2026-10-18
+ */
+
+#include "dcDeltaState.h"
+#include "dcField.h"
+#include "dcPackerInterface.h"
+
+/**
+ * The max_history parameter limits the number of values kept for each peer,
+ * object and field while waiting for acknowledgements.  If the peer
+ * acknowledges an update after this many later updates have been sent, the
+ * acknowledgement is ignored.
+ */
+DCDeltaState::
+DCDeltaState(int max_history) :
+  _max_history(max(max_history, 1)),
+  _num_full_updates(0),
+  _num_delta_updates(0)
+{
+}
+
+/**
+ *
+ */
+DCDeltaState::
+~DCDeltaState() {
+}
+
+/**
+ * Encodes the indicated packed value of the field, to be sent to the
+ * indicated peer as an update for the indicated object.  The result is a
+ * delta from the last value the peer acknowledged, if there is one and the
+ * delta is smaller; otherwise it is the full value.
+ */
+string DCDeltaState::
+pack_update(CHANNEL_TYPE peer, DOID_TYPE do_id, const DCField *field,
+            const string &value) {
+  SendState &state = _send_states[Key(peer, do_id, field->get_number())];
+
+  unsigned int seq = state._next_seq;
+  // Sequence number 0 is reserved to mean no baseline.
+  state._next_seq = (seq < 0xffff) ? seq + 1 : 1;
+
+  string delta;
+  unsigned int baseline_seq = 0;
+  if (state._baseline_seq != 0) {
+    delta = field->pack_delta(state._baseline, value);
+    if (!delta.empty() && delta.length() < value.length()) {
+      baseline_seq = state._baseline_seq;
+    }
+  }
+
+  char header[4];
+  DCPackerInterface::do_pack_uint16(header, seq);
+  DCPackerInterface::do_pack_uint16(header + 2, baseline_seq);
+  string data(header, 4);
+  if (baseline_seq != 0) {
+    data += delta;
+    ++_num_delta_updates;
+  } else {
+    data += value;
+    ++_num_full_updates;
+  }
+
+  Snapshot snapshot;
+  snapshot._seq = seq;
+  snapshot._value = value;
+  state._pending.push_back(snapshot);
+  if (state._pending.size() > _max_history) {
+    state._pending.erase(state._pending.begin());
+  }
+
+  return data;
+}
+
+/**
+ * Records that the indicated peer has received the update with the indicated
+ * sequence number, so that later updates may be sent as deltas from it.
+ * Acknowledgements of updates older than the last one acknowledged are
+ * ignored.
+ */
+void DCDeltaState::
+ack_update(CHANNEL_TYPE peer, DOID_TYPE do_id, const DCField *field,
+           unsigned int seq) {
+  SendStates::iterator si = _send_states.find(Key(peer, do_id, field->get_number()));
+  if (si == _send_states.end()) {
+    return;
+  }
+
+  SendState &state = (*si).second;
+  Snapshots::iterator pi;
+  for (pi = state._pending.begin(); pi != state._pending.end(); ++pi) {
+    if ((*pi)._seq == seq) {
+      state._baseline_seq = seq;
+      state._baseline.swap((*pi)._value);
+      state._pending.erase(state._pending.begin(), pi + 1);
+      return;
+    }
+  }
+}
+
+/**
+ * Decodes an update returned by pack_update() on the peer, and returns the
+ * packed value of the field.  Returns empty string if the update is a delta
+ * from a value that is no longer known, or if it is malformed; the update
+ * should be discarded in this case.
+ */
+string DCDeltaState::
+unpack_update(CHANNEL_TYPE peer, DOID_TYPE do_id, const DCField *field,
+              const string &data) {
+  if (data.length() < 4) {
+    return string();
+  }
+  unsigned int seq = DCPackerInterface::do_unpack_uint16(data.data());
+  unsigned int baseline_seq = DCPackerInterface::do_unpack_uint16(data.data() + 2);
+  string payload = data.substr(4);
+
+  ReceiveState &state = _receive_states[Key(peer, do_id, field->get_number())];
+  Snapshots &received = state._received;
+
+  string value;
+  if (baseline_seq == 0) {
+    value.swap(payload);
+
+  } else {
+    Snapshots::iterator ri;
+    for (ri = received.begin(); ri != received.end(); ++ri) {
+      if ((*ri)._seq == baseline_seq) {
+        break;
+      }
+    }
+    if (ri == received.end()) {
+      return string();
+    }
+    value = field->unpack_delta((*ri)._value, payload);
+    if (value.empty()) {
+      return string();
+    }
+
+    // The sender won't send deltas from values older than this baseline any
+    // more, so we can forget them.
+    Snapshots::iterator wi = received.begin();
+    for (ri = received.begin(); ri != received.end(); ++ri) {
+      if (!is_seq_before((*ri)._seq, baseline_seq)) {
+        if (wi != ri) {
+          (*wi)._seq = (*ri)._seq;
+          (*wi)._value.swap((*ri)._value);
+        }
+        ++wi;
+      }
+    }
+    received.erase(wi, received.end());
+  }
+
+  Snapshot snapshot;
+  snapshot._seq = seq;
+  snapshot._value = value;
+  received.push_back(snapshot);
+  if (received.size() > _max_history) {
+    received.erase(received.begin());
+  }
+
+  return value;
+}
+
+/**
+ * Returns the sequence number of an update returned by pack_update(), which
+ * the receiver should pass back to the sender's ack_update().
+ */
+unsigned int DCDeltaState::
+get_update_seq(const string &data) {
+  if (data.length() < 2) {
+    return 0;
+  }
+  return DCPackerInterface::do_unpack_uint16(data.data());
+}
+
+/**
+ * Forgets all values exchanged with the indicated peer, as when it
+ * disconnects.
+ */
+void DCDeltaState::
+remove_peer(CHANNEL_TYPE peer) {
+  SendStates::iterator si = _send_states.begin();
+  while (si != _send_states.end()) {
+    if ((*si).first._peer == peer) {
+      _send_states.erase(si++);
+    } else {
+      ++si;
+    }
+  }
+
+  ReceiveStates::iterator ri = _receive_states.begin();
+  while (ri != _receive_states.end()) {
+    if ((*ri).first._peer == peer) {
+      _receive_states.erase(ri++);
+    } else {
+      ++ri;
+    }
+  }
+}
+
+/**
+ * Forgets all values exchanged for the indicated object, as when it is
+ * deleted.
+ */
+void DCDeltaState::
+remove_object(DOID_TYPE do_id) {
+  SendStates::iterator si = _send_states.begin();
+  while (si != _send_states.end()) {
+    if ((*si).first._do_id == do_id) {
+      _send_states.erase(si++);
+    } else {
+      ++si;
+    }
+  }
+
+  ReceiveStates::iterator ri = _receive_states.begin();
+  while (ri != _receive_states.end()) {
+    if ((*ri).first._do_id == do_id) {
+      _receive_states.erase(ri++);
+    } else {
+      ++ri;
+    }
+  }
+}
+
+/**
+ * Forgets all values exchanged with all peers.
+ */
+void DCDeltaState::
+clear() {
+  _send_states.clear();
+  _receive_states.clear();
+  _num_full_updates = 0;
+  _num_delta_updates = 0;
+}
@@ -0,0 +1,107 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file dcDeltaState.h
+ * @date 2026-10-18
+ */
+
+#ifndef DCDELTASTATE_H
+#define DCDELTASTATE_H
+
+#include "dcbase.h"
+
+class DCField;
+
+/**
+ * Keeps track of the field values exchanged with each peer, so that field
+ * updates can be sent as deltas (see DCField::pack_delta()) from the last
+ * value the peer has acknowledged receiving, rather than as full values.
+ *
+ * The sender calls pack_update() to encode each update to a peer, and
+ * ack_update() when the peer acknowledges one; the receiver calls
+ * unpack_update() to decode each update, and sends back the sequence number
+ * returned by get_update_seq().  How the acknowledgements are carried is up
+ * to the application.  Until an update is acknowledged, the full value is
+ * sent, so updates that are lost simply cost more bandwidth.
+ *
+ * Each encoded update begins with a 16-bit sequence number and the 16-bit
+ * sequence number of the value it is a delta from, or 0 if it is a full
+ * value.  The values are kept separately for each peer, object and field.
+ * This class is not thread-safe.
+ */
+class DCDeltaState {
+PUBLISHED:
+  explicit DCDeltaState(int max_history = 16);
+  ~DCDeltaState();
+
+  string pack_update(CHANNEL_TYPE peer, DOID_TYPE do_id,
+                     const DCField *field, const string &value);
+  void ack_update(CHANNEL_TYPE peer, DOID_TYPE do_id,
+                  const DCField *field, unsigned int seq);
+  string unpack_update(CHANNEL_TYPE peer, DOID_TYPE do_id,
+                       const DCField *field, const string &data);
+  static unsigned int get_update_seq(const string &data);
+
+  void remove_peer(CHANNEL_TYPE peer);
+  void remove_object(DOID_TYPE do_id);
+  void clear();
+
+  INLINE int get_num_full_updates() const;
+  INLINE int get_num_delta_updates() const;
+
+private:
+  class Key {
+  public:
+    INLINE Key(CHANNEL_TYPE peer, DOID_TYPE do_id, int field);
+    INLINE bool operator < (const Key &other) const;
+
+    CHANNEL_TYPE _peer;
+    DOID_TYPE _do_id;
+    int _field;
+  };
+
+  class Snapshot {
+  public:
+    unsigned int _seq;
+    string _value;
+  };
+  typedef pvector<Snapshot> Snapshots;
+
+  // The values sent to the peer and not yet acknowledged, oldest first, and
+  // the last value acknowledged.
+  class SendState {
+  public:
+    INLINE SendState();
+
+    unsigned int _next_seq;
+    unsigned int _baseline_seq;
+    string _baseline;
+    Snapshots _pending;
+  };
+
+  // The values received from the peer that it may still send deltas from.
+  class ReceiveState {
+  public:
+    Snapshots _received;
+  };
+
+  INLINE static bool is_seq_before(unsigned int a, unsigned int b);
+
+  typedef pmap<Key, SendState> SendStates;
+  SendStates _send_states;
+  typedef pmap<Key, ReceiveState> ReceiveStates;
+  ReceiveStates _receive_states;
+
+  size_t _max_history;
+  int _num_full_updates;
+  int _num_delta_updates;
+};
+
+#include "dcDeltaState.I"
+
+#endif
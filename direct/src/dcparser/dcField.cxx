@@ -15,6 +15,7 @@
 #include "dcFile.h"
 #include "dcPacker.h"
 #include "dcClass.h"
+#include "dcDeltaCodec.h"
 #include "hashGenerator.h"
 #include "dcmsgtypes.h"
 
@@ -210,6 +211,36 @@ validate_ranges(const string &packed_data) const {
   return (packer.get_num_unpacked_bytes() == packed_data.length());
 }
 
+/**
+ * Given two packed values of this field, returns a compact encoding of the
+ * second one as the difference from the first, which can be decoded again by
+ * unpack_delta() given the same first value.  Only the parameters that have
+ * changed are stored, and integer parameters are stored in as few bits as
+ * possible.  Returns empty string if either value is invalid.
+ */
+string DCField::
+pack_delta(const string &base, const string &value) const {
+  string delta;
+  if (!DCDeltaCodec::pack_delta(this, base, value, delta)) {
+    return string();
+  }
+  return delta;
+}
+
+/**
+ * Reconstructs a packed value of this field from a delta returned by
+ * pack_delta(), given the same base value.  Returns empty string if the base
+ * value is invalid or the delta is malformed.
+ */
+string DCField::
+unpack_delta(const string &base, const string &delta) const {
+  string value;
+  if (!DCDeltaCodec::unpack_delta(this, base, delta, value)) {
+    return string();
+  }
+  return value;
+}
+
 #ifdef HAVE_PYTHON
 /**
  * Packs the Python arguments from the indicated tuple into the packer.
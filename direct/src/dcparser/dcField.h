@@ -58,6 +58,9 @@ PUBLISHED:
 
   bool validate_ranges(const string &packed_data) const;
 
+  string pack_delta(const string &base, const string &value) const;
+  string unpack_delta(const string &base, const string &delta) const;
+
   INLINE bool has_default_value() const;
   INLINE const string &get_default_value() const;
 
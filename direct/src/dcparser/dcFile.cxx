@@ -169,7 +169,14 @@ read(istream &in, const string &filename) {
   dcyyparse();
   dc_cleanup_parser();
 
-  return (dc_error_count() == 0);
+  if (dc_error_count() != 0) {
+    return false;
+  }
+
+  if (dc_compile_fields) {
+    compile_pack_programs();
+  }
+  return true;
 }
 
 /**
@@ -592,6 +599,19 @@ set_new_index_number(DCField *field) {
   _fields_by_index.push_back(field);
 }
 
+/**
+ * Compiles a DCPackProgram for each of the fields read so far, so that
+ * DCPacker can pack and unpack them without walking their nested fields.
+ * This is called automatically by read(), unless dc-compile-fields is false.
+ */
+void DCFile::
+compile_pack_programs() {
+  FieldsByIndex::iterator fi;
+  for (fi = _fields_by_index.begin(); fi != _fields_by_index.end(); ++fi) {
+    (*fi)->compile_pack_program();
+  }
+}
+
 /**
  * Adds an entry for each of the default keywords that are defined for every
  * DCFile for legacy reasons.
@@ -81,6 +81,7 @@ public:
   void add_thing_to_delete(DCDeclaration *decl);
 
   void set_new_index_number(DCField *field);
+  void compile_pack_programs();
   INLINE void check_inherited_fields();
   INLINE void mark_inherited_fields_stale();
 
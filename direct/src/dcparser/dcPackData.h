@@ -32,6 +32,7 @@ public:
   INLINE void append_junk(size_t size);
   INLINE void rewrite_data(size_t position, const char *buffer, size_t size);
   INLINE char *get_rewrite_pointer(size_t position, size_t size);
+  INLINE void truncate(size_t length);
 
 PUBLISHED:
   INLINE string get_string() const;
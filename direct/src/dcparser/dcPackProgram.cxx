@@ -0,0 +1,654 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file dcPackProgram.cxx
+ * @date 2026-10-18
+ */
+
+#include "dcPackProgram.h"
+#include "dcPackData.h"
+#include "dcField.h"
+#include "dcClass.h"
+#include "dcClassParameter.h"
+#include "dcindent.h"
+
+#ifdef HAVE_PYTHON
+#include "py_panda.h"
+#endif
+
+/**
+ *
+ */
+DCPackProgram::
+DCPackProgram() :
+  _has_class_parameters(false)
+{
+}
+
+/**
+ * Compiles the structure of the indicated field into a new program, and
+ * returns it.  The caller is responsible for deleting it.  Returns NULL if
+ * the field contains something that can't be compiled, such as a switch, or
+ * if it is a single value, which DCPacker handles in one step anyway.
+ */
+DCPackProgram *DCPackProgram::
+compile(const DCPackerInterface *root) {
+  DCPackProgram *program = new DCPackProgram;
+  if (!program->r_compile(root, 0) || program->_ops.size() == 1) {
+    delete program;
+    return NULL;
+  }
+  return program;
+}
+
+/**
+ * Internally unpacks the field and validates each value against its range
+ * limits, advancing p past the end of the field.  This does the same thing as
+ * DCPacker::unpack_validate() on the root field.
+ */
+void DCPackProgram::
+unpack_validate(const char *data, size_t length, size_t &p,
+                bool &pack_error, bool &range_error) const {
+  nassertv(!_ops.empty());
+  r_unpack_validate(0, data, length, p, pack_error, range_error);
+}
+
+/**
+ * Advances p past the end of the field without unpacking it.  This does the
+ * same thing as DCPacker::unpack_skip() on the root field.
+ */
+void DCPackProgram::
+unpack_skip(const char *data, size_t length, size_t &p,
+            bool &pack_error) const {
+  nassertv(!_ops.empty());
+  r_unpack_skip(0, data, length, p, pack_error);
+}
+
+#ifdef HAVE_PYTHON
+/**
+ * Packs the indicated Python object into the data, as DCPacker::pack_object()
+ * would for the root field.
+ *
+ * Returns true if the object was packed (possibly with errors), or false if
+ * the object is of a form that this program doesn't handle, such as a
+ * sequence supplied for a single value; in this case the data is left
+ * partially packed, and the caller should discard it and fall back to
+ * DCPacker::pack_object(), which knows how to report the problem.
+ */
+bool DCPackProgram::
+pack_object(DCPackData &pack_data, PyObject *object,
+            bool &pack_error, bool &range_error) const {
+  nassertr(!_ops.empty(), false);
+  return r_pack_object(0, pack_data, object, pack_error, range_error);
+}
+#endif  // HAVE_PYTHON
+
+#ifdef HAVE_PYTHON
+/**
+ * Unpacks a Python object for the field, as DCPacker::unpack_object() would
+ * for the root field, and advances p past the end of the field.
+ *
+ * Returns NULL, without unpacking anything, if the field contains a class
+ * parameter whose class has a Python class definition, since the program
+ * doesn't know how to construct those; the caller should fall back to
+ * DCPacker::unpack_object().
+ */
+PyObject *DCPackProgram::
+unpack_object(const char *data, size_t length, size_t &p,
+              bool &pack_error, bool &range_error) const {
+  nassertr(!_ops.empty(), NULL);
+
+  if (_has_class_parameters) {
+    // The class definitions may have been set since we were compiled.
+    Ops::const_iterator oi;
+    for (oi = _ops.begin(); oi != _ops.end(); ++oi) {
+      if ((*oi)._dclass != (DCClass *)NULL && (*oi)._dclass->has_class_def()) {
+        return NULL;
+      }
+    }
+  }
+
+  return r_unpack_object(0, data, length, p, pack_error, range_error);
+}
+#endif  // HAVE_PYTHON
+
+/**
+ * Writes a listing of the ops, one per line, with the ops for nested fields
+ * indented below their parent.
+ */
+void DCPackProgram::
+write(ostream &out, int indent_level) const {
+  pvector<int> ends;
+  for (int pc = 0; pc < (int)_ops.size(); ++pc) {
+    while (!ends.empty() && pc >= ends.back()) {
+      ends.pop_back();
+    }
+
+    const Op &op = _ops[pc];
+    indent(out, indent_level + (int)ends.size() * 2) << pc << ": ";
+    switch (op._type) {
+    case OT_value:
+      out << "value";
+      break;
+
+    case OT_struct:
+      out << ((op._dclass != (DCClass *)NULL) ? "class of " : "struct of ")
+          << op._num_nested_fields;
+      break;
+
+    case OT_array:
+      out << "array";
+      if (op._num_nested_fields >= 0) {
+        out << " of " << op._num_nested_fields;
+      }
+      break;
+    }
+
+    if (!op._field->get_name().empty()) {
+      out << " " << op._field->get_name();
+    }
+    if (op._has_fixed_byte_size) {
+      out << ", " << op._fixed_byte_size << " bytes";
+    }
+    if (op._num_length_bytes != 0) {
+      out << ", " << op._num_length_bytes << "-byte length";
+    }
+    if (op._has_range_limits) {
+      out << ", range limits";
+    }
+    out << "\n";
+
+    if (op._type != OT_value) {
+      ends.push_back(op._end);
+    }
+  }
+}
+
+/**
+ * Appends the ops for the indicated field, and all of its nested fields, to
+ * the program.  Returns true on success, false if the field can't be
+ * compiled.
+ */
+bool DCPackProgram::
+r_compile(const DCPackerInterface *field, int depth) {
+  // The depth limit is just a safeguard against a structure that somehow
+  // contains itself.
+  if (field == (DCPackerInterface *)NULL || depth > 100 ||
+      field->as_switch_parameter() != (DCSwitchParameter *)NULL) {
+    return false;
+  }
+
+  DCPackType pack_type = field->get_pack_type();
+  if (pack_type == PT_invalid || pack_type == PT_switch) {
+    return false;
+  }
+
+  Op op;
+  op._type = OT_value;
+  op._field = field;
+  op._pack_type = pack_type;
+  op._has_fixed_byte_size = field->has_fixed_byte_size();
+  op._has_range_limits = field->has_range_limits();
+  op._fixed_byte_size = field->get_fixed_byte_size();
+  op._num_length_bytes = field->get_num_length_bytes();
+  op._num_nested_fields = field->get_num_nested_fields();
+  op._dclass = NULL;
+  op._end = 0;
+
+  const DCClassParameter *class_param = field->as_class_parameter();
+  if (class_param != (DCClassParameter *)NULL) {
+    op._dclass = class_param->get_class();
+    _has_class_parameters = true;
+  }
+
+  // The ops for the nested fields will follow this one, so we have to refer
+  // to it by index from here on.
+  int pc = (int)_ops.size();
+  _ops.push_back(op);
+
+  if (field->has_nested_fields()) {
+    if (pack_type == PT_field || pack_type == PT_class) {
+      // The parameters of a field, or the fields of a class, are all
+      // different.
+      int num_nested_fields = field->get_num_nested_fields();
+      if (num_nested_fields < 0) {
+        return false;
+      }
+      _ops[pc]._type = OT_struct;
+      for (int i = 0; i < num_nested_fields; ++i) {
+        if (!r_compile(field->get_nested_field(i), depth + 1)) {
+          return false;
+        }
+      }
+
+    } else {
+      // Anything else with nested fields, including a string, is an array
+      // of the same element type.
+      _ops[pc]._type = OT_array;
+      if (!r_compile(field->get_nested_field(0), depth + 1)) {
+        return false;
+      }
+    }
+
+  } else if (pack_type == PT_array || pack_type == PT_field ||
+             pack_type == PT_class) {
+    return false;
+  }
+
+  _ops[pc]._end = (int)_ops.size();
+  return true;
+}
+
+/**
+ * The recursive implementation of unpack_validate().  Returns true if the
+ * field's nested fields were validated one at a time, or false if the field
+ * was validated as a whole.
+ */
+bool DCPackProgram::
+r_unpack_validate(int pc, const char *data, size_t length, size_t &p,
+                  bool &pack_error, bool &range_error) const {
+  const Op &op = _ops[pc];
+  if (op._has_fixed_byte_size && !op._has_range_limits) {
+    // There's nothing to validate; just skip it.
+    p += op._fixed_byte_size;
+    if (p > length) {
+      pack_error = true;
+    }
+    return false;
+  }
+
+  if (op._field->unpack_validate(data, length, p, pack_error, range_error)) {
+    return false;
+  }
+
+  if (op._type == OT_value) {
+    pack_error = true;
+    return false;
+  }
+
+  // The field couldn't validate itself as a whole; validate its nested
+  // fields one at a time.
+  int num_nested_fields;
+  size_t pop_marker;
+  begin_unpack_nested(op, data, length, p, pack_error,
+                      num_nested_fields, pop_marker);
+
+  int index = 0;
+  int child = pc + 1;
+  while (more_nested_fields(index, num_nested_fields, p, pop_marker,
+                            pack_error)) {
+    if (r_unpack_validate(child, data, length, p, pack_error, range_error)) {
+      restore_num_nested_fields(op, num_nested_fields);
+    }
+    ++index;
+    child = next_nested_op(op, pc, child);
+  }
+
+  end_unpack_nested(op, index, p, pop_marker, pack_error);
+  return true;
+}
+
+/**
+ * The recursive implementation of unpack_skip().  Returns true if the field's
+ * nested fields were skipped one at a time, or false if the field was skipped
+ * as a whole.
+ */
+bool DCPackProgram::
+r_unpack_skip(int pc, const char *data, size_t length, size_t &p,
+              bool &pack_error) const {
+  const Op &op = _ops[pc];
+  if (op._has_fixed_byte_size) {
+    p += op._fixed_byte_size;
+    if (p > length) {
+      pack_error = true;
+    }
+    return false;
+  }
+
+  if (op._field->unpack_skip(data, length, p, pack_error)) {
+    return false;
+  }
+
+  if (op._type == OT_value) {
+    pack_error = true;
+    return false;
+  }
+
+  // The field couldn't skip itself as a whole; skip its nested fields one at
+  // a time.
+  int num_nested_fields;
+  size_t pop_marker;
+  begin_unpack_nested(op, data, length, p, pack_error,
+                      num_nested_fields, pop_marker);
+
+  int index = 0;
+  int child = pc + 1;
+  while (more_nested_fields(index, num_nested_fields, p, pop_marker,
+                            pack_error)) {
+    if (r_unpack_skip(child, data, length, p, pack_error)) {
+      restore_num_nested_fields(op, num_nested_fields);
+    }
+    ++index;
+    child = next_nested_op(op, pc, child);
+  }
+
+  end_unpack_nested(op, index, p, pop_marker, pack_error);
+  return true;
+}
+
+#ifdef HAVE_PYTHON
+/**
+ * The recursive implementation of pack_object().  This follows
+ * DCPacker::pack_object() closely; see the comments there.
+ */
+bool DCPackProgram::
+r_pack_object(int pc, DCPackData &pack_data, PyObject *object,
+              bool &pack_error, bool &range_error) const {
+  const Op &op = _ops[pc];
+  const DCPackerInterface *field = op._field;
+
+  switch (op._pack_type) {
+  case PT_int64:
+    if (PyLong_Check(object)) {
+      field->pack_int64(pack_data, PyLong_AsLongLong(object), pack_error, range_error);
+      return true;
+    }
+#if PY_MAJOR_VERSION < 3
+    if (PyInt_Check(object)) {
+      field->pack_int64(pack_data, PyInt_AsLong(object), pack_error, range_error);
+      return true;
+    }
+#endif
+    break;
+
+  case PT_uint64:
+    if (PyLong_Check(object)) {
+      field->pack_uint64(pack_data, PyLong_AsUnsignedLongLong(object), pack_error, range_error);
+      return true;
+    }
+#if PY_MAJOR_VERSION < 3
+    if (PyInt_Check(object)) {
+      PyObject *obj1 = PyNumber_Long(object);
+      field->pack_int(pack_data, PyLong_AsUnsignedLongLong(obj1), pack_error, range_error);
+      Py_DECREF(obj1);
+      return true;
+    }
+#endif
+    break;
+
+  case PT_int:
+    if (PyLong_Check(object)) {
+      field->pack_int(pack_data, PyLong_AsLong(object), pack_error, range_error);
+      return true;
+    }
+#if PY_MAJOR_VERSION < 3
+    if (PyInt_Check(object)) {
+      field->pack_int(pack_data, PyInt_AsLong(object), pack_error, range_error);
+      return true;
+    }
+#endif
+    break;
+
+  case PT_uint:
+    if (PyLong_Check(object)) {
+      field->pack_uint(pack_data, PyLong_AsUnsignedLong(object), pack_error, range_error);
+      return true;
+    }
+#if PY_MAJOR_VERSION < 3
+    if (PyInt_Check(object)) {
+      PyObject *obj1 = PyNumber_Long(object);
+      field->pack_uint(pack_data, PyLong_AsUnsignedLong(obj1), pack_error, range_error);
+      Py_DECREF(obj1);
+      return true;
+    }
+#endif
+    break;
+
+  default:
+    break;
+  }
+
+  if (PyLong_Check(object)) {
+    field->pack_int(pack_data, PyLong_AsLong(object), pack_error, range_error);
+    return true;
+  }
+#if PY_MAJOR_VERSION < 3
+  if (PyInt_Check(object)) {
+    field->pack_int(pack_data, PyInt_AS_LONG(object), pack_error, range_error);
+    return true;
+  }
+#endif
+  if (PyFloat_Check(object)) {
+    field->pack_double(pack_data, PyFloat_AS_DOUBLE(object), pack_error, range_error);
+    return true;
+  }
+#if PY_MAJOR_VERSION >= 3
+  if (PyUnicode_Check(object)) {
+    const char *buffer;
+    Py_ssize_t length;
+    buffer = PyUnicode_AsUTF8AndSize(object, &length);
+    if (buffer) {
+      field->pack_string(pack_data, string(buffer, length), pack_error, range_error);
+    }
+    return true;
+  }
+  if (PyBytes_Check(object)) {
+    char *buffer;
+    Py_ssize_t length;
+    PyBytes_AsStringAndSize(object, &buffer, &length);
+    if (buffer) {
+      field->pack_string(pack_data, string(buffer, length), pack_error, range_error);
+    }
+    return true;
+  }
+#else
+  if (PyString_Check(object) || PyUnicode_Check(object)) {
+    char *buffer;
+    Py_ssize_t length;
+    PyString_AsStringAndSize(object, &buffer, &length);
+    if (buffer) {
+      field->pack_string(pack_data, string(buffer, length), pack_error, range_error);
+    }
+    return true;
+  }
+#endif
+
+  if (op._type == OT_value) {
+    // A sequence (or something stranger) for a single value.
+    return false;
+  }
+
+  if (op._dclass != (DCClass *)NULL && op._dclass->has_class_def()) {
+    // This might be an instance of the class.
+    return false;
+  }
+
+  bool is_sequence =
+    (PySequence_Check(object) != 0) &&
+    (PyObject_HasAttrString(object, "__len__") != 0);
+  if (!is_sequence) {
+    return false;
+  }
+
+  // Reserve room for the length prefix, which we fill in at the end.
+  size_t push_marker = pack_data.get_length();
+  pack_data.append_junk(op._num_length_bytes);
+
+  int size = PySequence_Size(object);
+  int child = pc + 1;
+  for (int i = 0; i < size; ++i) {
+    if (op._num_nested_fields >= 0 && i >= op._num_nested_fields) {
+      // Too many elements.
+      return false;
+    }
+
+    PyObject *element = PySequence_GetItem(object, i);
+    if (element == (PyObject *)NULL) {
+      return false;
+    }
+    bool packed = r_pack_object(child, pack_data, element, pack_error, range_error);
+    Py_DECREF(element);
+    if (!packed) {
+      return false;
+    }
+    child = next_nested_op(op, pc, child);
+  }
+
+  if (op._num_nested_fields >= 0 && size < op._num_nested_fields) {
+    // Too few elements.
+    pack_error = true;
+  }
+  if (!field->validate_num_nested_fields(size)) {
+    pack_error = true;
+  }
+
+  if (op._num_length_bytes != 0) {
+    size_t length = pack_data.get_length() - push_marker - op._num_length_bytes;
+    if (op._num_length_bytes == 4) {
+      DCPackerInterface::do_pack_uint32
+        (pack_data.get_rewrite_pointer(push_marker, 4), length);
+    } else {
+      DCPackerInterface::validate_uint_limits(length, 16, range_error);
+      DCPackerInterface::do_pack_uint16
+        (pack_data.get_rewrite_pointer(push_marker, 2), length);
+    }
+  }
+
+  return true;
+}
+#endif  // HAVE_PYTHON
+
+#ifdef HAVE_PYTHON
+/**
+ * The recursive implementation of unpack_object().  This follows
+ * DCPacker::unpack_object() closely; see the comments there.
+ */
+PyObject *DCPackProgram::
+r_unpack_object(int pc, const char *data, size_t length, size_t &p,
+                bool &pack_error, bool &range_error) const {
+  const Op &op = _ops[pc];
+  const DCPackerInterface *field = op._field;
+  PyObject *object = NULL;
+
+  switch (op._pack_type) {
+  case PT_double:
+    {
+      double value = 0.0;
+      field->unpack_double(data, length, p, value, pack_error, range_error);
+      object = PyFloat_FromDouble(value);
+    }
+    break;
+
+  case PT_int:
+    {
+      int value = 0;
+      field->unpack_int(data, length, p, value, pack_error, range_error);
+#if PY_MAJOR_VERSION >= 3
+      object = PyLong_FromLong(value);
+#else
+      object = PyInt_FromLong(value);
+#endif
+    }
+    break;
+
+  case PT_uint:
+    {
+      unsigned int value = 0;
+      field->unpack_uint(data, length, p, value, pack_error, range_error);
+#if PY_MAJOR_VERSION >= 3
+      object = PyLong_FromLong(value);
+#else
+      if (value & 0x80000000) {
+        object = PyLong_FromUnsignedLong(value);
+      } else {
+        object = PyInt_FromLong(value);
+      }
+#endif
+    }
+    break;
+
+  case PT_int64:
+    {
+      int64_t value = 0;
+      field->unpack_int64(data, length, p, value, pack_error, range_error);
+      object = PyLong_FromLongLong(value);
+    }
+    break;
+
+  case PT_uint64:
+    {
+      uint64_t value = 0;
+      field->unpack_uint64(data, length, p, value, pack_error, range_error);
+      object = PyLong_FromUnsignedLongLong(value);
+    }
+    break;
+
+  case PT_blob:
+#if PY_MAJOR_VERSION >= 3
+    {
+      string str;
+      field->unpack_string(data, length, p, str, pack_error, range_error);
+      object = PyBytes_FromStringAndSize(str.data(), str.size());
+    }
+    break;
+#endif
+    // On Python 2, fall through to below.
+
+  case PT_string:
+    {
+      string str;
+      field->unpack_string(data, length, p, str, pack_error, range_error);
+#if PY_MAJOR_VERSION >= 3
+      object = PyUnicode_FromStringAndSize(str.data(), str.size());
+#else
+      object = PyString_FromStringAndSize(str.data(), str.size());
+#endif
+    }
+    break;
+
+  default:
+    {
+      object = PyList_New(0);
+
+      int num_nested_fields;
+      size_t pop_marker;
+      begin_unpack_nested(op, data, length, p, pack_error,
+                          num_nested_fields, pop_marker);
+
+      int index = 0;
+      int child = pc + 1;
+      while (more_nested_fields(index, num_nested_fields, p, pop_marker,
+                                pack_error)) {
+        PyObject *element =
+          r_unpack_object(child, data, length, p, pack_error, range_error);
+        PyList_Append(object, element);
+        Py_DECREF(element);
+        DCPackType child_type = _ops[child]._pack_type;
+        if (child_type == PT_array || child_type == PT_field ||
+            child_type == PT_class) {
+          restore_num_nested_fields(op, num_nested_fields);
+        }
+        ++index;
+        child = next_nested_op(op, pc, child);
+      }
+
+      end_unpack_nested(op, index, p, pop_marker, pack_error);
+
+      if (op._pack_type != PT_array) {
+        PyObject *tuple = PyList_AsTuple(object);
+        Py_DECREF(object);
+        object = tuple;
+      }
+    }
+    break;
+  }
+
+  nassertr(object != (PyObject *)NULL, NULL);
+  return object;
+}
+#endif  // HAVE_PYTHON
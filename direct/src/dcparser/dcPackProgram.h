@@ -0,0 +1,124 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file dcPackProgram.h
+ * @date 2026-10-18
+ */
+
+#ifndef DCPACKPROGRAM_H
+#define DCPACKPROGRAM_H
+
+#include "dcbase.h"
+#include "dcPackerInterface.h"
+#include "dcPython.h"
+
+class DCPackData;
+class DCClass;
+
+/**
+ * A flattened description of the complete structure of a field, compiled
+ * once from its tree of DCPackerInterface objects.  DCPacker uses it, when it
+ * is available, to validate, skip, or convert a whole field to and from a
+ * Python object in one pass, instead of walking the tree with push() and
+ * pop() for every nested field.
+ *
+ * Each nested field becomes one op, listed in the order the fields appear in
+ * the data; an op with nested fields is followed by the ops for those fields.
+ * The individual values are still packed and unpacked by the leaf fields
+ * themselves, so the results are the same as the tree walk's.
+ *
+ * Fields that contain a switch can't be compiled, since their structure
+ * depends on the data; DCPacker keeps walking the tree for those.  Nor does
+ * the program construct the Python objects for class parameters whose class
+ * has a Python class definition; DCPacker does that itself.  The program is
+ * owned by its field, and is created by DCFile when it reads a file.
+ */
+class DCPackProgram {
+private:
+  DCPackProgram();
+
+public:
+  static DCPackProgram *compile(const DCPackerInterface *root);
+
+  INLINE int get_num_ops() const;
+
+  void unpack_validate(const char *data, size_t length, size_t &p,
+                       bool &pack_error, bool &range_error) const;
+  void unpack_skip(const char *data, size_t length, size_t &p,
+                   bool &pack_error) const;
+
+#ifdef HAVE_PYTHON
+  bool pack_object(DCPackData &pack_data, PyObject *object,
+                   bool &pack_error, bool &range_error) const;
+  PyObject *unpack_object(const char *data, size_t length, size_t &p,
+                          bool &pack_error, bool &range_error) const;
+#endif
+
+  void write(ostream &out, int indent_level = 0) const;
+
+private:
+  enum OpType {
+    OT_value,
+    OT_struct,
+    OT_array,
+  };
+
+  class Op {
+  public:
+    OpType _type;
+    const DCPackerInterface *_field;
+    DCPackType _pack_type;
+    bool _has_fixed_byte_size;
+    bool _has_range_limits;
+    size_t _fixed_byte_size;
+    size_t _num_length_bytes;
+    int _num_nested_fields;
+
+    // The class of a class parameter, or NULL.
+    const DCClass *_dclass;
+
+    // The index of the first op after this one's nested ops.
+    int _end;
+  };
+
+  bool r_compile(const DCPackerInterface *field, int depth);
+
+  bool r_unpack_validate(int pc, const char *data, size_t length, size_t &p,
+                         bool &pack_error, bool &range_error) const;
+  bool r_unpack_skip(int pc, const char *data, size_t length, size_t &p,
+                     bool &pack_error) const;
+
+  INLINE void begin_unpack_nested(const Op &op, const char *data,
+                                  size_t length, size_t &p, bool &pack_error,
+                                  int &num_nested_fields,
+                                  size_t &pop_marker) const;
+  INLINE static bool more_nested_fields(int index, int num_nested_fields,
+                                        size_t p, size_t pop_marker,
+                                        bool pack_error);
+  INLINE static void restore_num_nested_fields(const Op &op,
+                                               int &num_nested_fields);
+  INLINE void end_unpack_nested(const Op &op, int index, size_t p,
+                                size_t pop_marker, bool &pack_error) const;
+  INLINE int next_nested_op(const Op &op, int pc, int child) const;
+
+#ifdef HAVE_PYTHON
+  bool r_pack_object(int pc, DCPackData &pack_data, PyObject *object,
+                     bool &pack_error, bool &range_error) const;
+  PyObject *r_unpack_object(int pc, const char *data, size_t length,
+                            size_t &p, bool &pack_error,
+                            bool &range_error) const;
+#endif
+
+  typedef pvector<Op> Ops;
+  Ops _ops;
+  bool _has_class_parameters;
+};
+
+#include "dcPackProgram.I"
+
+#endif
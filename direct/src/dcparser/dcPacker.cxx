@@ -18,6 +18,7 @@
 #include "dcClassParameter.h"
 #include "dcSwitchParameter.h"
 #include "dcClass.h"
+#include "dcPackProgram.h"
 
 #ifdef HAVE_PYTHON
 #include "py_panda.h"
@@ -574,6 +575,11 @@ unpack_validate() {
   if (_current_field == NULL) {
     _pack_error = true;
 
+  } else if (_current_field->get_pack_program() != (DCPackProgram *)NULL) {
+    _current_field->get_pack_program()->unpack_validate
+      (_unpack_data, _unpack_length, _unpack_p, _pack_error, _range_error);
+    advance();
+
   } else {
     if (_current_field->unpack_validate(_unpack_data, _unpack_length, _unpack_p,
                                         _pack_error, _range_error)) {
@@ -600,6 +606,11 @@ unpack_skip() {
   if (_current_field == NULL) {
     _pack_error = true;
 
+  } else if (_current_field->get_pack_program() != (DCPackProgram *)NULL) {
+    _current_field->get_pack_program()->unpack_skip
+      (_unpack_data, _unpack_length, _unpack_p, _pack_error);
+    advance();
+
   } else {
     if (_current_field->unpack_skip(_unpack_data, _unpack_length, _unpack_p,
                                     _pack_error)) {
@@ -626,6 +637,24 @@ unpack_skip() {
 void DCPacker::
 pack_object(PyObject *object) {
   nassertv(_mode == M_pack || _mode == M_repack);
+
+  if (_current_field != NULL &&
+      _current_field->get_pack_program() != (DCPackProgram *)NULL) {
+    // Try the compiled program first.  If it doesn't know what to do with
+    // this object, undo whatever it did, and do it the long way.
+    size_t start = _pack_data.get_length();
+    bool pack_error = _pack_error;
+    bool range_error = _range_error;
+    if (_current_field->get_pack_program()->pack_object
+        (_pack_data, object, _pack_error, _range_error)) {
+      advance();
+      return;
+    }
+    _pack_data.truncate(start);
+    _pack_error = pack_error;
+    _range_error = range_error;
+  }
+
   DCPackType pack_type = get_pack_type();
 
   // had to add this for basic 64 and unsigned data to get packed right .. Not
@@ -814,6 +843,16 @@ PyObject *DCPacker::
 unpack_object() {
   PyObject *object = NULL;
 
+  if (_mode == M_unpack && _current_field != NULL &&
+      _current_field->get_pack_program() != (DCPackProgram *)NULL) {
+    object = _current_field->get_pack_program()->unpack_object
+      (_unpack_data, _unpack_length, _unpack_p, _pack_error, _range_error);
+    if (object != (PyObject *)NULL) {
+      advance();
+      return object;
+    }
+  }
+
   DCPackType pack_type = get_pack_type();
 
   switch (pack_type) {
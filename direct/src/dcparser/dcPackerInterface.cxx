@@ -13,6 +13,7 @@
 
 #include "dcPackerInterface.h"
 #include "dcPackerCatalog.h"
+#include "dcPackProgram.h"
 #include "dcField.h"
 #include "dcParserDefs.h"
 #include "dcLexerDefs.h"
@@ -33,6 +34,7 @@ DCPackerInterface(const string &name) :
   _num_nested_fields = -1;
   _pack_type = PT_invalid;
   _catalog = NULL;
+  _pack_program = NULL;
 }
 
 /**
@@ -51,6 +53,7 @@ DCPackerInterface(const DCPackerInterface &copy) :
   _pack_type(copy._pack_type)
 {
   _catalog = NULL;
+  _pack_program = NULL;
 }
 
 /**
@@ -61,6 +64,9 @@ DCPackerInterface::
   if (_catalog != (DCPackerCatalog *)NULL) {
     delete _catalog;
   }
+  if (_pack_program != (DCPackProgram *)NULL) {
+    delete _pack_program;
+  }
 }
 
 /**
@@ -373,6 +379,23 @@ get_catalog() const {
   return _catalog;
 }
 
+/**
+ * Compiles the structure of this field into a DCPackProgram, which DCPacker
+ * will use from now on to unpack, validate, or skip the field as a whole (and
+ * to pack it from a Python object).  This should only be called once the
+ * field is complete.  Returns true if the field was compiled, or false if it
+ * contains something that can't be compiled, or is only a single value, in
+ * which case DCPacker goes on walking the nested fields one at a time.
+ */
+bool DCPackerInterface::
+compile_pack_program() {
+  if (_pack_program != (DCPackProgram *)NULL) {
+    delete _pack_program;
+  }
+  _pack_program = DCPackProgram::compile(this);
+  return (_pack_program != (DCPackProgram *)NULL);
+}
+
 /**
  * Returns true if this field matches the indicated simple parameter, false
  * otherwise.
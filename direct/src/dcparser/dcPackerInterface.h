@@ -27,6 +27,7 @@ class DCAtomicField;
 class DCMolecularField;
 class DCPackData;
 class DCPackerCatalog;
+class DCPackProgram;
 
 BEGIN_PUBLISH
 // This enumerated type is returned by get_pack_type() and represents the best
@@ -166,6 +167,9 @@ public:
 
   const DCPackerCatalog *get_catalog() const;
 
+  INLINE const DCPackProgram *get_pack_program() const;
+  bool compile_pack_program();
+
 protected:
   virtual bool do_check_match(const DCPackerInterface *other) const=0;
 
@@ -196,6 +200,7 @@ protected:
 
 private:
   DCPackerCatalog *_catalog;
+  DCPackProgram *_pack_program;
 };
 
 #include "dcPackerInterface.I"
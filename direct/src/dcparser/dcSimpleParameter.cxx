@@ -563,6 +563,121 @@ set_range(const DCDoubleRange &range) {
   return !range_error;
 }
 
+/**
+ * Returns the number of bits needed to store any value within the range
+ * limits of this parameter, relative to the lowest limit, or -1 if the
+ * parameter is not an integer type of up to 32 bits with range limits.  Such
+ * values may be stored in this many bits with quantize() and unquantize().
+ */
+int DCSimpleParameter::
+get_quantized_bits() const {
+  int64_t min_value, max_value;
+  if (!get_quantized_range(min_value, max_value)) {
+    return -1;
+  }
+
+  uint64_t span = (uint64_t)(max_value - min_value);
+  int num_bits = 0;
+  while (num_bits < 64 && (span >> num_bits) != 0) {
+    ++num_bits;
+  }
+  return num_bits;
+}
+
+/**
+ * Reads the packed value at the indicated data, which must be the value of
+ * this parameter, and computes its offset from the lowest range limit, which
+ * fits in get_quantized_bits() bits.  Returns false if the parameter cannot
+ * be quantized or the value is outside the range limits.
+ */
+bool DCSimpleParameter::
+quantize(const char *data, unsigned int &code) const {
+  int64_t min_value, max_value;
+  if (!get_quantized_range(min_value, max_value)) {
+    return false;
+  }
+
+  int64_t value;
+  switch (_type) {
+  case ST_int8:
+    value = do_unpack_int8(data);
+    break;
+
+  case ST_int16:
+    value = do_unpack_int16(data);
+    break;
+
+  case ST_int32:
+    value = do_unpack_int32(data);
+    break;
+
+  case ST_uint8:
+    value = do_unpack_uint8(data);
+    break;
+
+  case ST_uint16:
+    value = do_unpack_uint16(data);
+    break;
+
+  case ST_uint32:
+    value = do_unpack_uint32(data);
+    break;
+
+  default:
+    return false;
+  }
+
+  if (value < min_value || value > max_value) {
+    return false;
+  }
+  code = (unsigned int)(value - min_value);
+  return true;
+}
+
+/**
+ * The inverse of quantize(): writes the packed value corresponding to the
+ * indicated code to the indicated buffer, which must have room for
+ * get_fixed_byte_size() bytes.
+ */
+void DCSimpleParameter::
+unquantize(unsigned int code, char *data) const {
+  int64_t min_value, max_value;
+  if (!get_quantized_range(min_value, max_value)) {
+    nassertv(false);
+    return;
+  }
+
+  int64_t value = min_value + (int64_t)code;
+  switch (_type) {
+  case ST_int8:
+    do_pack_int8(data, (int)value);
+    break;
+
+  case ST_int16:
+    do_pack_int16(data, (int)value);
+    break;
+
+  case ST_int32:
+    do_pack_int32(data, (int)value);
+    break;
+
+  case ST_uint8:
+    do_pack_uint8(data, (unsigned int)value);
+    break;
+
+  case ST_uint16:
+    do_pack_uint16(data, (unsigned int)value);
+    break;
+
+  case ST_uint32:
+    do_pack_uint32(data, (unsigned int)value);
+    break;
+
+  default:
+    break;
+  }
+}
+
 /**
  * This flavor of get_num_nested_fields is used during unpacking.  It returns
  * the number of nested fields to expect, given a certain length in bytes (as
@@ -2348,6 +2463,51 @@ do_check_match_array_parameter(const DCArrayParameter *other) const {
   return _nested_field->check_match(other->get_element_type());
 }
 
+/**
+ * Computes the lowest and highest of the range limits, in packed units, for
+ * an integer type of up to 32 bits.  Returns false if the parameter is not
+ * such a type, or has no range limits.
+ */
+bool DCSimpleParameter::
+get_quantized_range(int64_t &min_value, int64_t &max_value) const {
+  int i, num_ranges;
+
+  switch (_type) {
+  case ST_int8:
+  case ST_int16:
+  case ST_int32:
+    num_ranges = _int_range.get_num_ranges();
+    if (num_ranges == 0) {
+      return false;
+    }
+    min_value = _int_range.get_min(0);
+    max_value = _int_range.get_max(0);
+    for (i = 1; i < num_ranges; i++) {
+      min_value = min(min_value, (int64_t)_int_range.get_min(i));
+      max_value = max(max_value, (int64_t)_int_range.get_max(i));
+    }
+    return true;
+
+  case ST_uint8:
+  case ST_uint16:
+  case ST_uint32:
+    num_ranges = _uint_range.get_num_ranges();
+    if (num_ranges == 0) {
+      return false;
+    }
+    min_value = _uint_range.get_min(0);
+    max_value = _uint_range.get_max(0);
+    for (i = 1; i < num_ranges; i++) {
+      min_value = min(min_value, (int64_t)_uint_range.get_min(i));
+      max_value = max(max_value, (int64_t)_uint_range.get_max(i));
+    }
+    return true;
+
+  default:
+    return false;
+  }
+}
+
 /**
  * Creates the one instance of the DCSimpleParameter corresponding to this
  * combination of type and divisor if it is not already created.
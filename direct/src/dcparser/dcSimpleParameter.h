@@ -47,6 +47,10 @@ public:
   bool set_divisor(unsigned int divisor);
   bool set_range(const DCDoubleRange &range);
 
+  int get_quantized_bits() const;
+  bool quantize(const char *data, unsigned int &code) const;
+  void unquantize(unsigned int code, char *data) const;
+
   virtual int calc_num_nested_fields(size_t length_bytes) const;
   virtual DCPackerInterface *get_nested_field(int n) const;
 
@@ -91,6 +95,8 @@ protected:
   virtual bool do_check_match_array_parameter(const DCArrayParameter *other) const;
 
 private:
+  bool get_quantized_range(int64_t &min_value, int64_t &max_value) const;
+
   static DCSimpleParameter *create_nested_field(DCSubatomicType type,
                                                 unsigned int divisor);
   static DCPackerInterface *create_uint32uint8_type();
@@ -4,9 +4,12 @@
 #include "dcAtomicField.cxx"
 #include "dcClass.cxx"
 #include "dcDeclaration.cxx"
+#include "dcDeltaCodec.cxx"
+#include "dcDeltaState.cxx"
 #include "dcKeyword.cxx"
 #include "dcKeywordList.cxx"
 #include "dcPackData.cxx"
+#include "dcPackProgram.cxx"
 #include "dcPacker.cxx"
 #include "dcPackerCatalog.cxx"
 #include "dcPackerInterface.cxx"
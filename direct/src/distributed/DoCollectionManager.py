@@ -337,6 +337,7 @@ class DoCollectionManager:
             # Do not store null values
             object.parentId = None
             object.zoneId = None
+            self.getInterestIndex().removeObject(object.doId)
         else:
             # Add to new location
             self._doHierarchy.storeObjectLocation(object, parentId, zoneId)
@@ -347,6 +348,7 @@ class DoCollectionManager:
             # Set the new parent and zone on the object
             object.parentId = parentId
             object.zoneId = zoneId
+            self.getInterestIndex().setObjectLocation(object.doId, parentId, zoneId)
 
 
         if oldParentId != parentId:
@@ -435,6 +437,7 @@ class DoCollectionManager:
         ##         del self.zoneId2doIds[location][do.doId]
         ##         if len(self.zoneId2doIds[location]) == 0:
         ##             del self.zoneId2doIds[location]
+        self.getInterestIndex().removeObject(do.doId)
         if do.doId in self.doId2do:
             del self.doId2do[do.doId]
 
@@ -134,6 +134,7 @@ class DoInterestManager(DirectObject.DirectObject):
 
     def resetInterestStateForConnectionLoss(self):
         DoInterestManager._interests.clear()
+        self.getInterestIndex().clearInterests()
         self._completeEventCount = ScratchPad(num=0)
         if __debug__:
             self._addDebugInterestHistory("RESET", "", 0, 0, 0, [])
@@ -184,6 +185,7 @@ class DoInterestManager(DirectObject.DirectObject):
 
         DoInterestManager._interests[handle] = InterestState(
             description, InterestState.StateActive, contextId, event, parentId, zoneIdList, self._completeEventCount)
+        self._storeInterestZones(handle, parentId, zoneIdList)
         if self.__verbose():
             print('CR::INTEREST.addInterest(handle=%s, parentId=%s, zoneIdList=%s, description=%s, event=%s)' % (
                 handle, parentId, zoneIdList, description, event))
@@ -218,6 +220,7 @@ class DoInterestManager(DirectObject.DirectObject):
 
         DoInterestManager._interests[handle] = InterestState(
             description, InterestState.StateActive, 0, None, parentId, zoneIdList, self._completeEventCount, True)
+        self._storeInterestZones(handle, parentId, zoneIdList)
         if self.__verbose():
             print('CR::INTEREST.addInterest(handle=%s, parentId=%s, zoneIdList=%s, description=%s)' % (
                 handle, parentId, zoneIdList, description))
@@ -356,6 +359,7 @@ class DoInterestManager(DirectObject.DirectObject):
             DoInterestManager._interests[handle].parentId = parentId
             DoInterestManager._interests[handle].zoneIdList = zoneIdList
             DoInterestManager._interests[handle].addEvent(event)
+            self._storeInterestZones(handle, parentId, zoneIdList)
 
             if self.__verbose():
                 print('CR::INTEREST.alterInterest(handle=%s, parentId=%s, zoneIdList=%s, description=%s, event=%s)' % (
@@ -417,6 +421,19 @@ class DoInterestManager(DirectObject.DirectObject):
         DoInterestManager._ContextIdSerialNum = contextId
         return DoInterestManager._ContextIdSerialNum
 
+    def _storeInterestZones(self, handle, parentId, zoneIdList):
+        """
+        Records the zones named by the interest in the C++ interest
+        index, which the repository uses to drop updates for objects
+        outside of our interest (see setFilterByInterest()).
+        """
+        index = self.getInterestIndex()
+        index.removeInterest(handle)
+        if not isinstance(zoneIdList, (list, tuple, set)):
+            zoneIdList = [zoneIdList]
+        for zoneId in zoneIdList:
+            index.addInterestZone(handle, parentId, zoneId)
+
     def _considerRemoveInterest(self, handle):
         """
         Consider whether we should cull the interest set.
@@ -429,6 +446,9 @@ class DoInterestManager(DirectObject.DirectObject):
                 if DoInterestManager._interests[handle].context == NO_CONTEXT:
                     assert len(DoInterestManager._interests[handle].events) == 0
                     del DoInterestManager._interests[handle]
+                    # The server has stopped sending us the interest's
+                    # objects, so it is now safe to filter out their updates.
+                    self.getInterestIndex().removeInterest(handle)
 
     if __debug__:
         def printInterestsIfDebug(self):
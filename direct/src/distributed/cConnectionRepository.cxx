@@ -66,7 +66,9 @@ CConnectionRepository(bool has_owner_view, bool threaded_net) :
   _handle_c_updates(true),
   _want_message_bundling(true),
   _bundling_msgs(0),
-  _in_quiet_zone(0)
+  _in_quiet_zone(0),
+  _filter_by_interest(filter_updates_by_interest),
+  _num_filtered_updates(0)
 {
 #if defined(HAVE_NET) && defined(SIMULATE_NETWORK_DELAY)
   if (min_lag != 0.0 || max_lag != 0.0) {
@@ -300,9 +302,13 @@ check_datagram() {
     }
 
     switch (_msg_type) {
-#ifdef HAVE_PYTHON
     case CLIENT_OBJECT_UPDATE_FIELD:
     case STATESERVER_OBJECT_UPDATE_FIELD:
+      if (_filter_by_interest && !accept_update_field()) {
+        // The object is outside of our interest; drop the update.
+        break;
+      }
+#ifdef HAVE_PYTHON
       if (_handle_c_updates) {
         if (_has_owner_view) {
           if (!handle_update_field_owner()) {
@@ -318,6 +324,8 @@ check_datagram() {
         return true;
       }
       break;
+#else
+      return true;
 #endif  // HAVE_PYTHON
 
     default:
@@ -668,6 +676,46 @@ do_check_datagram() {
   return false;
 }
 
+/**
+ * Checks the update message on a field against the interest index, before
+ * anything else is done with it.  Returns true if the update should be
+ * processed, or false if it should be dropped because its object is in a zone
+ * we no longer have interest in.
+ */
+bool CConnectionRepository::
+accept_update_field() {
+  DatagramIterator di(_di);
+  if (di.get_remaining_size() < 6) {
+    // Let the usual handler deal with a malformed message.
+    return true;
+  }
+
+  DOID_TYPE do_id = di.get_uint32();
+  if (_interest_index.is_object_visible(do_id)) {
+    return true;
+  }
+
+  int field_id = di.get_uint16();
+  const DCField *field = _dc_file.get_field_by_index(field_id);
+  if (field == (DCField *)NULL) {
+    return true;
+  }
+
+  if (_has_owner_view && field->is_ownrecv()) {
+    // The owner view hears about its object wherever the object is.
+    return true;
+  }
+
+  if (field->get_name() == "setLocation") {
+    // The object may be moving into a zone we're interested in.  Python will
+    // store its new location in the index.
+    return true;
+  }
+
+  ++_num_filtered_updates;
+  return false;
+}
+
 /**
  * Directly handles an update message on a field.  Python never touches the
  * datagram; it just gets its distributed method called with the appropriate
@@ -804,7 +852,8 @@ handle_update_field_owner() {
 
       // check if we should forward this update to the owner view
       DCPacker packer;
-      packer.set_unpack_data(_di.get_remaining_bytes());
+      packer.set_unpack_data((const char *)_di.get_current_data(),
+                             _di.get_remaining_size(), false);
       int field_id = packer.raw_unpack_uint16();
       DCField *field = dclass->get_field_by_index(field_id);
       if (field->is_ownrecv()) {
@@ -846,7 +895,8 @@ handle_update_field_owner() {
 
       // check if we should forward this update to the owner view
       DCPacker packer;
-      packer.set_unpack_data(_di.get_remaining_bytes());
+      packer.set_unpack_data((const char *)_di.get_current_data(),
+                             _di.get_remaining_size(), false);
       int field_id = packer.raw_unpack_uint16();
       DCField *field = dclass->get_field_by_index(field_id);
       if (true) {//field->is_broadcast()) {
@@ -20,6 +20,7 @@
 #include "dcbase.h"
 #include "dcFile.h"
 #include "dcField.h"  // to pick up Python.h
+#include "cInterestIndex.h"
 #include "pStatCollector.h"
 #include "datagramIterator.h"
 #include "clockObject.h"
@@ -134,6 +135,11 @@ PUBLISHED:
   BLOCKING INLINE void set_in_quiet_zone(bool flag);
   BLOCKING INLINE bool get_in_quiet_zone() const;
 
+  INLINE CInterestIndex &get_interest_index();
+  BLOCKING INLINE void set_filter_by_interest(bool flag);
+  BLOCKING INLINE bool get_filter_by_interest() const;
+  BLOCKING INLINE int get_num_filtered_updates() const;
+
   BLOCKING void start_message_bundle();
   BLOCKING INLINE bool is_bundling_messages() const;
   BLOCKING void send_message_bundle(unsigned int channel, unsigned int sender_channel);
@@ -158,6 +164,7 @@ PUBLISHED:
 
 private:
   bool do_check_datagram();
+  bool accept_update_field();
   bool handle_update_field();
   bool handle_update_field_owner();
 
@@ -198,6 +205,10 @@ private:
   bool _in_quiet_zone;
   float _time_warning;
 
+  CInterestIndex _interest_index;
+  bool _filter_by_interest;
+  int _num_filtered_updates;
+
   Datagram _dg;
   DatagramIterator _di;
 
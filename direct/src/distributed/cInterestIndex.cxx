@@ -0,0 +1,301 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file cInterestIndex.cxx
+ * @date 2026-10-18
+ */
+
+#include "cInterestIndex.h"
+#include "lightMutexHolder.h"
+#include "indent.h"
+#include "cmath.h"
+
+/**
+ *
+ */
+CInterestIndex::
+CInterestIndex() :
+  _lock("CInterestIndex::_lock")
+{
+}
+
+/**
+ *
+ */
+CInterestIndex::
+~CInterestIndex() {
+}
+
+/**
+ * Adds the indicated zone to the set of zones named by the interest with the
+ * indicated handle.  An interest may name any number of zones.
+ */
+void CInterestIndex::
+add_interest_zone(int handle, DOID_TYPE parent_id, ZONEID_TYPE zone_id) {
+  LightMutexHolder holder(_lock);
+  do_add_interest_zone(handle, make_zone_key(parent_id, zone_id));
+}
+
+/**
+ * Removes the interest with the indicated handle, and all of the zones it
+ * names.  Updates for objects in zones no longer named by any interest will
+ * be dropped from then on, even though the server may not yet have removed
+ * the objects.
+ */
+void CInterestIndex::
+remove_interest(int handle) {
+  LightMutexHolder holder(_lock);
+  do_remove_interest(handle);
+}
+
+/**
+ * Removes all interests, as when the connection is lost.
+ */
+void CInterestIndex::
+clear_interests() {
+  LightMutexHolder holder(_lock);
+  _interests.clear();
+  _zone_counts.clear();
+}
+
+/**
+ * Returns true if any interest names the indicated zone.
+ */
+bool CInterestIndex::
+has_interest(DOID_TYPE parent_id, ZONEID_TYPE zone_id) const {
+  LightMutexHolder holder(_lock);
+  return _zone_counts.find(make_zone_key(parent_id, zone_id)) != _zone_counts.end();
+}
+
+/**
+ * Returns the number of interest handles in the index.
+ */
+int CInterestIndex::
+get_num_interests() const {
+  LightMutexHolder holder(_lock);
+  return (int)_interests.size();
+}
+
+/**
+ * Records the location of the indicated object.  This should be called
+ * whenever the object is generated or changes location.
+ */
+void CInterestIndex::
+set_object_location(DOID_TYPE do_id, DOID_TYPE parent_id,
+                    ZONEID_TYPE zone_id) {
+  LightMutexHolder holder(_lock);
+  _objects[do_id] = make_zone_key(parent_id, zone_id);
+}
+
+/**
+ * Forgets the location of the indicated object, which will be considered
+ * visible from then on.  This should be called when the object is deleted.
+ */
+void CInterestIndex::
+remove_object(DOID_TYPE do_id) {
+  LightMutexHolder holder(_lock);
+  _objects.remove(do_id);
+}
+
+/**
+ * Forgets the locations of all objects.
+ */
+void CInterestIndex::
+clear_objects() {
+  LightMutexHolder holder(_lock);
+  _objects.clear();
+}
+
+/**
+ * Returns true if the indicated object is in a zone named by some interest,
+ * or if its location isn't known.  This is called for each incoming update.
+ */
+bool CInterestIndex::
+is_object_visible(DOID_TYPE do_id) const {
+  LightMutexHolder holder(_lock);
+  int index = _objects.find(do_id);
+  if (index == -1) {
+    return true;
+  }
+  return _zone_counts.find(_objects.get_data(index)) != _zone_counts.end();
+}
+
+/**
+ * Returns the number of objects whose location is known.
+ */
+int CInterestIndex::
+get_num_objects() const {
+  LightMutexHolder holder(_lock);
+  return (int)_objects.get_num_entries();
+}
+
+/**
+ * Describes the layout of the zones of a Cartesian grid, which is the object
+ * with the indicated id.  The parameters have the same meaning as the
+ * attributes of CartesianGridBase: the grid is grid_size by grid_size cells,
+ * each cell_width wide, centered on the grid's origin, and the zones are
+ * numbered row by row from starting_zone.
+ */
+void CInterestIndex::
+add_grid(DOID_TYPE parent_id, PN_stdfloat cell_width, int grid_size,
+         ZONEID_TYPE starting_zone) {
+  nassertv(cell_width > 0.0f && grid_size > 0);
+  LightMutexHolder holder(_lock);
+  Grid &grid = _grids[parent_id];
+  grid._cell_width = cell_width;
+  grid._grid_size = grid_size;
+  grid._starting_zone = starting_zone;
+}
+
+/**
+ * Forgets the layout of the indicated grid.
+ */
+void CInterestIndex::
+remove_grid(DOID_TYPE parent_id) {
+  LightMutexHolder holder(_lock);
+  _grids.erase(parent_id);
+}
+
+/**
+ * Returns the zone of the indicated grid that contains the indicated point,
+ * which is relative to the grid's origin.  This is the same computation as
+ * CartesianGridBase.getZoneFromXYZ().  Returns 0 if the point is outside the
+ * grid.
+ */
+ZONEID_TYPE CInterestIndex::
+get_grid_zone(DOID_TYPE parent_id, PN_stdfloat x, PN_stdfloat y) const {
+  LightMutexHolder holder(_lock);
+  Grids::const_iterator gi = _grids.find(parent_id);
+  nassertr(gi != _grids.end(), 0);
+
+  const Grid &grid = (*gi).second;
+  int row, col;
+  if (!find_grid_cell(grid, x, y, row, col)) {
+    return 0;
+  }
+  return grid._starting_zone + (ZONEID_TYPE)(row * grid._grid_size + col);
+}
+
+/**
+ * Replaces the zones named by the interest with the indicated handle with
+ * the zones of the indicated grid within radius cells, in each direction, of
+ * the cell containing the indicated point.  The point is relative to the
+ * grid's origin.  Returns the number of zones now named by the interest,
+ * which is 0 if the point is outside the grid.
+ */
+int CInterestIndex::
+set_grid_interest(int handle, DOID_TYPE parent_id,
+                  PN_stdfloat x, PN_stdfloat y, int radius) {
+  LightMutexHolder holder(_lock);
+  do_remove_interest(handle);
+
+  Grids::const_iterator gi = _grids.find(parent_id);
+  nassertr(gi != _grids.end(), 0);
+
+  const Grid &grid = (*gi).second;
+  int row, col;
+  if (!find_grid_cell(grid, x, y, row, col)) {
+    return 0;
+  }
+
+  int min_row = max(row - radius, 0);
+  int max_row = min(row + radius, grid._grid_size - 1);
+  int min_col = max(col - radius, 0);
+  int max_col = min(col + radius, grid._grid_size - 1);
+
+  int num_zones = 0;
+  for (int r = min_row; r <= max_row; ++r) {
+    for (int c = min_col; c <= max_col; ++c) {
+      ZONEID_TYPE zone_id =
+        grid._starting_zone + (ZONEID_TYPE)(r * grid._grid_size + c);
+      do_add_interest_zone(handle, make_zone_key(parent_id, zone_id));
+      ++num_zones;
+    }
+  }
+  return num_zones;
+}
+
+/**
+ *
+ */
+void CInterestIndex::
+output(ostream &out) const {
+  LightMutexHolder holder(_lock);
+  out << "CInterestIndex, " << _interests.size() << " interests in "
+      << _zone_counts.size() << " zones, " << _objects.get_num_entries()
+      << " objects";
+}
+
+/**
+ * Lists the zones named by each interest.
+ */
+void CInterestIndex::
+write(ostream &out, int indent_level) const {
+  LightMutexHolder holder(_lock);
+  Interests::const_iterator ii;
+  for (ii = _interests.begin(); ii != _interests.end(); ++ii) {
+    indent(out, indent_level) << "interest " << (*ii).first << ":";
+    const Zones &zones = (*ii).second;
+    Zones::const_iterator zi;
+    for (zi = zones.begin(); zi != zones.end(); ++zi) {
+      out << " " << (DOID_TYPE)((*zi) >> 32) << ":"
+          << (ZONEID_TYPE)((*zi) & 0xffffffff);
+    }
+    out << "\n";
+  }
+}
+
+/**
+ * The implementation of add_interest_zone().  Assumes the lock is held.
+ */
+void CInterestIndex::
+do_add_interest_zone(int handle, ZoneKey key) {
+  Zones &zones = _interests[handle];
+  if (find(zones.begin(), zones.end(), key) != zones.end()) {
+    // This interest already names this zone.
+    return;
+  }
+  zones.push_back(key);
+  ++_zone_counts[key];
+}
+
+/**
+ * The implementation of remove_interest().  Assumes the lock is held.
+ */
+void CInterestIndex::
+do_remove_interest(int handle) {
+  Interests::iterator ii = _interests.find(handle);
+  if (ii == _interests.end()) {
+    return;
+  }
+
+  const Zones &zones = (*ii).second;
+  Zones::const_iterator zi;
+  for (zi = zones.begin(); zi != zones.end(); ++zi) {
+    ZoneCounts::iterator ci = _zone_counts.find(*zi);
+    nassertd(ci != _zone_counts.end()) continue;
+    if (--(*ci).second == 0) {
+      _zone_counts.erase(ci);
+    }
+  }
+  _interests.erase(ii);
+}
+
+/**
+ * Computes the row and column of the grid cell containing the indicated
+ * point.  Returns false if the point is outside the grid.
+ */
+bool CInterestIndex::
+find_grid_cell(const Grid &grid, PN_stdfloat x, PN_stdfloat y,
+               int &row, int &col) const {
+  PN_stdfloat dx = grid._cell_width * grid._grid_size * 0.5f;
+  col = (int)cfloor((x + dx) / grid._cell_width);
+  row = (int)cfloor((y + dx) / grid._cell_width);
+  return (row >= 0 && row < grid._grid_size &&
+          col >= 0 && col < grid._grid_size);
+}
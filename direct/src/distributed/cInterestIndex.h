@@ -0,0 +1,109 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file cInterestIndex.h
+ * @date 2026-10-18
+ */
+
+#ifndef CINTERESTINDEX_H
+#define CINTERESTINDEX_H
+
+#include "directbase.h"
+#include "dcbase.h"
+#include "lightMutex.h"
+#include "simpleHashMap.h"
+#include "pmap.h"
+#include "pvector.h"
+
+/**
+ * A C++ mirror of the client's interest set and of the locations of the
+ * distributed objects it knows about, so that CConnectionRepository can tell,
+ * without calling into Python, whether an incoming field update is for an
+ * object in a zone the client is still interested in.
+ *
+ * Interests are added zone by zone under the same handles that
+ * DoInterestManager uses.  Objects whose location has never been stored are
+ * always considered visible.
+ *
+ * The index also knows the layout of any Cartesian grids (see
+ * CartesianGridBase), so that the interest in the zones around a point on a
+ * grid can be computed and set natively.
+ */
+class EXPCL_DIRECT CInterestIndex {
+PUBLISHED:
+  CInterestIndex();
+  ~CInterestIndex();
+
+  void add_interest_zone(int handle, DOID_TYPE parent_id, ZONEID_TYPE zone_id);
+  void remove_interest(int handle);
+  void clear_interests();
+  bool has_interest(DOID_TYPE parent_id, ZONEID_TYPE zone_id) const;
+  int get_num_interests() const;
+
+  void set_object_location(DOID_TYPE do_id, DOID_TYPE parent_id,
+                           ZONEID_TYPE zone_id);
+  void remove_object(DOID_TYPE do_id);
+  void clear_objects();
+  bool is_object_visible(DOID_TYPE do_id) const;
+  int get_num_objects() const;
+
+  void add_grid(DOID_TYPE parent_id, PN_stdfloat cell_width, int grid_size,
+                ZONEID_TYPE starting_zone);
+  void remove_grid(DOID_TYPE parent_id);
+  ZONEID_TYPE get_grid_zone(DOID_TYPE parent_id,
+                            PN_stdfloat x, PN_stdfloat y) const;
+  int set_grid_interest(int handle, DOID_TYPE parent_id,
+                        PN_stdfloat x, PN_stdfloat y, int radius);
+
+  void output(ostream &out) const;
+  void write(ostream &out, int indent_level = 0) const;
+
+private:
+  // A parent and zone, packed into one number.
+  typedef uint64_t ZoneKey;
+  INLINE static ZoneKey make_zone_key(DOID_TYPE parent_id, ZONEID_TYPE zone_id);
+
+  void do_add_interest_zone(int handle, ZoneKey key);
+  void do_remove_interest(int handle);
+
+  class Grid {
+  public:
+    PN_stdfloat _cell_width;
+    int _grid_size;
+    ZONEID_TYPE _starting_zone;
+  };
+  bool find_grid_cell(const Grid &grid, PN_stdfloat x, PN_stdfloat y,
+                      int &row, int &col) const;
+
+  // The zones named by each interest handle.
+  typedef pvector<ZoneKey> Zones;
+  typedef pmap<int, Zones> Interests;
+  Interests _interests;
+
+  // The number of interests that name each zone.
+  typedef pmap<ZoneKey, int> ZoneCounts;
+  ZoneCounts _zone_counts;
+
+  // The location of each object, looked up for every update.
+  typedef SimpleHashMap<DOID_TYPE, ZoneKey, integer_hash<DOID_TYPE> > Objects;
+  Objects _objects;
+
+  typedef pmap<DOID_TYPE, Grid> Grids;
+  Grids _grids;
+
+  LightMutex _lock;
+};
+
+INLINE ostream &operator << (ostream &out, const CInterestIndex &index) {
+  index.output(out);
+  return out;
+}
+
+#include "cInterestIndex.I"
+
+#endif  // CINTERESTINDEX_H
@@ -46,6 +46,13 @@ ConfigVariableBool handle_datagrams_internally
           "for performance reasons.  When it is false, all datagrams "
           "are handled by the Python implementation."));
 
+ConfigVariableBool filter_updates_by_interest
+("filter-updates-by-interest", false,
+ PRC_DESC("When this is true, the C++ cConnectionRepository drops field "
+          "updates for objects that are in zones no longer covered by any "
+          "interest, without passing them to Python.  This only applies to "
+          "datagrams handled internally; see handle-datagrams-internally."));
+
 /**
  * Initializes the library.  This must be called at least once before any of
  * the functions or classes in this library can be used.  Normally it will be
@@ -27,6 +27,7 @@ extern ConfigVariableInt game_server_timeout_ms;
 extern ConfigVariableDouble min_lag;
 extern ConfigVariableDouble max_lag;
 extern ConfigVariableBool handle_datagrams_internally;
+extern ConfigVariableBool filter_updates_by_interest;
 
 extern EXPCL_DIRECT void init_libdistributed();
 
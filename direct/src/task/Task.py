@@ -192,7 +192,8 @@ class TaskManager:
 
     def setupTaskChain(self, chainName, numThreads = None, tickClock = None,
                        threadPriority = None, frameBudget = None,
-                       frameSync = None, timeslicePriority = None):
+                       frameSync = None, timeslicePriority = None,
+                       workStealing = None):
         """Defines a new task chain.  Each task chain executes tasks
         potentially in parallel with all of the other task chains (if
         numThreads is more than zero).  When a new task is created, it
@@ -240,6 +241,13 @@ class TaskManager:
         meaning of priority so that certain tasks are run less often,
         in proportion to their time used and to their priority value.
         See AsyncTaskManager.setTimeslicePriority() for more.
+
+        workStealing is True to divide the tasks of each sort value
+        among the threads, so that they do not all contend for the
+        same queue.  This helps a chain with several threads and many
+        short tasks, but priority order is then only kept within each
+        thread's share of the tasks.  See
+        AsyncTaskChain.setWorkStealing() for more.
         """
 
         chain = self.mgr.makeTaskChain(chainName)
@@ -255,6 +263,8 @@ class TaskManager:
             chain.setFrameSync(frameSync)
         if timeslicePriority is not None:
             chain.setTimeslicePriority(timeslicePriority)
+        if workStealing is not None:
+            chain.setWorkStealing(workStealing)
 
     def hasTaskNamed(self, taskName):
         """Returns true if there is at least one task, active or
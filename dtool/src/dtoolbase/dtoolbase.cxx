@@ -59,3 +59,12 @@ void (*global_thread_yield)() = default_thread_yield;
 void (*global_thread_consider_yield)() = default_thread_consider_yield;
 
 #endif  // HAVE_THREADS && SIMPLE_THREADS
+
+static void
+default_parallel_for(ParallelForFunc *func, void *data, int num_items,
+                     int num_threads) {
+  if (num_items > 0) {
+    (*func)(data, 0, num_items);
+  }
+}
+void (*global_parallel_for)(ParallelForFunc *, void *, int, int) = default_parallel_for;
@@ -365,6 +365,18 @@ typedef struct _object PyObject;
 #define ALIGN_64BYTE
 #endif
 
+/* Declares a static variable of which each thread has its own copy.  Only
+   plain types with a constant initializer may be declared this way.  Such a
+   variable can't be exported from a DLL, so it should be a file-static
+   variable rather than a static class member. */
+#ifdef CPPPARSER
+#define THREAD_LOCAL
+#elif defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
 // Do we need to implement memory-alignment enforcement within the MemoryHook
 // class, or will the underlying malloc implementation provide it
 // automatically?
@@ -377,6 +389,11 @@ typedef struct _object PyObject;
 // This specialized malloc implementation can perform the required alignment.
 #undef MEMORY_HOOK_DO_ALIGN
 
+#elif defined(USE_MEMORY_THREAD_CACHE)
+// Nor does our own thread-caching allocator, whose block sizes are all
+// multiples of the alignment.
+#undef MEMORY_HOOK_DO_ALIGN
+
 #elif defined(USE_MEMORY_PTMALLOC2)
 // But not this one.  For some reason it crashes when we try to build it with
 // alignment 16.  So if we're using ptmalloc2, we need to enforce alignment
@@ -428,7 +445,7 @@ typedef struct _object PyObject;
 #endif
 
 /* Determine our memory-allocation requirements. */
-#if defined(USE_MEMORY_PTMALLOC2) || defined(USE_MEMORY_DLMALLOC) || defined(DO_MEMORY_USAGE) || defined(MEMORY_HOOK_DO_ALIGN)
+#if defined(USE_MEMORY_PTMALLOC2) || defined(USE_MEMORY_DLMALLOC) || defined(USE_MEMORY_THREAD_CACHE) || defined(DO_MEMORY_USAGE) || defined(MEMORY_HOOK_DO_ALIGN)
 /* In this case we have some custom memory management requirements. */
 #else
 /* Otherwise, if we have no custom memory management needs at all, we
@@ -325,6 +325,15 @@ INLINE void thread_consider_yield() {
 
 #endif  // HAVE_THREADS && SIMPLE_THREADS
 
+// A function that processes the items [begin, end) of a parallel_for() call.
+typedef void ParallelForFunc(void *data, int begin, int end);
+
+// Similarly, this allows low-level code to divide independent work among
+// several threads.  The default implementation just calls func() on the
+// current thread; the pipeline library replaces it with parallel_for().
+extern EXPCL_DTOOL void (*global_parallel_for)(ParallelForFunc *func, void *data,
+                                               int num_items, int num_threads);
+
 #if defined(USE_TAU) && defined(WIN32)
 // Hack around tau's lack of DLL export declarations for Profiler class.
 extern EXPCL_DTOOL bool __tau_shutdown;
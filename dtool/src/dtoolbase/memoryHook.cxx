@@ -93,6 +93,28 @@ static_assert((MEMORY_HOOK_ALIGNMENT & (MEMORY_HOOK_ALIGNMENT - 1)) == 0,
 #define call_free dlfree
 #undef MEMORY_HOOK_MALLOC_LOCK
 
+#elif defined(USE_MEMORY_THREAD_CACHE)
+
+// Memory manager: THREAD_CACHE This is our own allocator, which keeps a cache
+// of free blocks for each thread, so that most allocations don't need to
+// take a lock.  See ThreadCacheAllocator.
+
+INLINE static void *
+call_malloc(size_t size) {
+  return ThreadCacheAllocator::get_global_ptr()->alloc(size);
+}
+
+INLINE static void *
+call_realloc(void *ptr, size_t size) {
+  return ThreadCacheAllocator::get_global_ptr()->realloc(ptr, size);
+}
+
+INLINE static void
+call_free(void *ptr) {
+  ThreadCacheAllocator::get_global_ptr()->free(ptr);
+}
+#undef MEMORY_HOOK_MALLOC_LOCK
+
 #else
 
 // Memory manager: MALLOC This option uses the built-in system allocator.
@@ -115,7 +137,7 @@ inflate_size(size_t size) {
   // If we're aligning, we need to request the header size, plus extra bytes
   // to give us wiggle room to adjust the pointer.
   return size + sizeof(uintptr_t) * 2 + MEMORY_HOOK_ALIGNMENT - 1;
-#elif defined(USE_MEMORY_DLMALLOC) || defined(USE_MEMORY_PTMALLOC2)
+#elif defined(USE_MEMORY_DLMALLOC) || defined(USE_MEMORY_PTMALLOC2) || defined(USE_MEMORY_THREAD_CACHE)
   // If we are can access the allocator's bookkeeping to figure out how many
   // bytes were allocated, we don't need to add our own information.
   return size;
@@ -146,7 +168,7 @@ alloc_to_ptr(void *alloc, size_t size) {
   root[-2] = size;
   root[-1] = (uintptr_t)alloc;  // Save the pointer we originally allocated.
   return (void *)root;
-#elif defined(USE_MEMORY_DLMALLOC) || defined(USE_MEMORY_PTMALLOC2)
+#elif defined(USE_MEMORY_DLMALLOC) || defined(USE_MEMORY_PTMALLOC2) || defined(USE_MEMORY_THREAD_CACHE)
   return alloc;
 #elif defined(DO_MEMORY_USAGE)
   size_t *root = (size_t *)alloc;
@@ -168,7 +190,7 @@ ptr_to_alloc(void *ptr, size_t &size) {
   uintptr_t *root = (uintptr_t *)ptr;
   size = root[-2];
   return (void *)root[-1]; // Get the pointer we originally allocated.
-#elif defined(USE_MEMORY_DLMALLOC) || defined(USE_MEMORY_PTMALLOC2)
+#elif defined(USE_MEMORY_DLMALLOC) || defined(USE_MEMORY_PTMALLOC2) || defined(USE_MEMORY_THREAD_CACHE)
 #ifdef DO_MEMORY_USAGE
   size = MemoryHook::get_ptr_size(ptr);
 #endif
@@ -273,8 +295,8 @@ heap_alloc_single(size_t size) {
 #ifdef DO_MEMORY_USAGE
   // In the DO_MEMORY_USAGE case, we want to track the total size of allocated
   // bytes on the heap.
-#if defined(USE_MEMORY_DLMALLOC) || defined(USE_MEMORY_PTMALLOC2)
-  // dlmalloc may slightly overallocate, however.
+#if defined(USE_MEMORY_DLMALLOC) || defined(USE_MEMORY_PTMALLOC2) || defined(USE_MEMORY_THREAD_CACHE)
+  // The allocator may slightly overallocate, however.
   size = get_ptr_size(alloc);
   inflated_size = size;
 #endif
@@ -350,8 +372,8 @@ heap_alloc_array(size_t size) {
 #ifdef DO_MEMORY_USAGE
   // In the DO_MEMORY_USAGE case, we want to track the total size of allocated
   // bytes on the heap.
-#if defined(USE_MEMORY_DLMALLOC) || defined(USE_MEMORY_PTMALLOC2)
-  // dlmalloc may slightly overallocate, however.
+#if defined(USE_MEMORY_DLMALLOC) || defined(USE_MEMORY_PTMALLOC2) || defined(USE_MEMORY_THREAD_CACHE)
+  // The allocator may slightly overallocate, however.
   size = get_ptr_size(alloc);
   inflated_size = size;
 #endif
@@ -406,8 +428,8 @@ heap_realloc_array(void *ptr, size_t size) {
   }
 
 #ifdef DO_MEMORY_USAGE
-#if defined(USE_MEMORY_DLMALLOC) || defined(USE_MEMORY_PTMALLOC2)
-  // dlmalloc may slightly overallocate, however.
+#if defined(USE_MEMORY_DLMALLOC) || defined(USE_MEMORY_PTMALLOC2) || defined(USE_MEMORY_THREAD_CACHE)
+  // The allocator may slightly overallocate, however.
   size = get_ptr_size(alloc1);
   inflated_size = size;
 #endif
@@ -486,6 +508,11 @@ heap_trim(size_t pad) {
     trimmed = true;
   }
   _lock.release();
+
+#elif defined(USE_MEMORY_THREAD_CACHE)
+  if (ThreadCacheAllocator::get_global_ptr()->trim(pad)) {
+    trimmed = true;
+  }
 #endif
 
 #ifdef WIN32
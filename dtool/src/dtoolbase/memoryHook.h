@@ -18,6 +18,7 @@
 #include "numeric_types.h"
 #include "atomicAdjust.h"
 #include "mutexImpl.h"
+#include "threadCacheAllocator.h"
 #include <map>
 
 class DeletedBufferChain;
@@ -5,6 +5,7 @@
 #include "pdtoa.cxx"
 #include "pstrtod.cxx"
 #include "register_type.cxx"
+#include "threadCacheAllocator.cxx"
 #include "typeHandle.cxx"
 #include "typeRegistry.cxx"
 #include "typeRegistryNode.cxx"
@@ -0,0 +1,211 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_alloc.cxx
+ * @date 2026-10-18
+ */
+
+#include "dtoolbase.h"
+#include "memoryHook.h"
+#include "atomicAdjust.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sys/time.h>
+#endif
+
+// A multithreaded benchmark of whichever allocator MemoryHook was built with.
+// Each thread keeps a table of live blocks, mostly small, and repeatedly
+// replaces a random one.  Half of the blocks each thread allocates are handed
+// to the next thread to free, as happens when objects are passed between the
+// App, Cull and Draw threads.
+
+static const int num_slots = 4096;
+static int num_ops = 1000000;
+static int num_threads = 4;
+
+class Worker {
+public:
+  int _index;
+  unsigned int _seed;
+  void *_slots[num_slots];
+
+  // Blocks handed to this thread by the previous one.
+  AtomicAdjust::Pointer _inbox[num_slots];
+};
+
+static Worker *workers;
+
+/**
+ * A small, fast random number generator, so that the benchmark doesn't
+ * measure the C library's rand().
+ */
+static unsigned int
+next_random(unsigned int &seed) {
+  seed = seed * 1664525 + 1013904223;
+  return seed >> 8;
+}
+
+/**
+ * Chooses a block size.  Most blocks are small, as they are in Panda; a few
+ * are large enough to go straight to the page heap.
+ */
+static size_t
+choose_size(unsigned int &seed) {
+  unsigned int r = next_random(seed);
+  switch (r % 16) {
+  case 0:
+    return 1024 + (r >> 4) % (64 * 1024);
+  case 1:
+  case 2:
+    return 256 + (r >> 4) % 768;
+  default:
+    return 8 + (r >> 4) % 248;
+  }
+}
+
+/**
+ * The body of each thread.
+ */
+static void
+run_worker(Worker *worker) {
+  Worker *next = &workers[(worker->_index + 1) % num_threads];
+
+  for (int i = 0; i < num_ops; ++i) {
+    int n = next_random(worker->_seed) % num_slots;
+
+    void *passed = AtomicAdjust::set_ptr(worker->_inbox[n], NULL);
+    if (passed != NULL) {
+      memory_hook->heap_free_array(passed);
+    }
+
+    void *ptr = worker->_slots[n];
+    if (ptr != NULL) {
+      if (n & 1) {
+        memory_hook->heap_free_array(ptr);
+      } else {
+        // Pass it along, freeing whatever the next thread hasn't yet taken.
+        void *old = AtomicAdjust::set_ptr(next->_inbox[n], ptr);
+        if (old != NULL) {
+          memory_hook->heap_free_array(old);
+        }
+      }
+    }
+    size_t size = choose_size(worker->_seed);
+    ptr = memory_hook->heap_alloc_array(size);
+    memset(ptr, 0, min(size, (size_t)64));
+    worker->_slots[n] = ptr;
+  }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI
+thread_func(LPVOID data) {
+  run_worker((Worker *)data);
+  return 0;
+}
+#else
+static void *
+thread_func(void *data) {
+  run_worker((Worker *)data);
+  return NULL;
+}
+#endif
+
+/**
+ * Returns the current time in seconds.
+ */
+static double
+get_time() {
+#ifdef _WIN32
+  LARGE_INTEGER count, frequency;
+  QueryPerformanceCounter(&count);
+  QueryPerformanceFrequency(&frequency);
+  return (double)count.QuadPart / (double)frequency.QuadPart;
+#else
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (double)tv.tv_sec + (double)tv.tv_usec / 1000000.0;
+#endif
+}
+
+int
+main(int argc, char *argv[]) {
+  if (argc > 1) {
+    num_threads = max(atoi(argv[1]), 1);
+  }
+  if (argc > 2) {
+    num_ops = max(atoi(argv[2]), 1);
+  }
+
+  init_memory_hook();
+  workers = new Worker[num_threads];
+  memset(workers, 0, sizeof(Worker) * num_threads);
+  for (int t = 0; t < num_threads; ++t) {
+    workers[t]._index = t;
+    workers[t]._seed = t * 7919 + 1;
+  }
+
+  double start = get_time();
+#ifdef _WIN32
+  HANDLE *threads = new HANDLE[num_threads];
+  for (int t = 0; t < num_threads; ++t) {
+    threads[t] = CreateThread(NULL, 0, &thread_func, &workers[t], 0, NULL);
+  }
+  WaitForMultipleObjects(num_threads, threads, TRUE, INFINITE);
+  for (int t = 0; t < num_threads; ++t) {
+    CloseHandle(threads[t]);
+  }
+#else
+  pthread_t *threads = new pthread_t[num_threads];
+  for (int t = 0; t < num_threads; ++t) {
+    pthread_create(&threads[t], NULL, &thread_func, &workers[t]);
+  }
+  for (int t = 0; t < num_threads; ++t) {
+    pthread_join(threads[t], NULL);
+  }
+#endif
+  double elapsed = get_time() - start;
+  delete[] threads;
+
+  double total_ops = (double)num_ops * num_threads;
+  cerr << num_threads << " threads, " << num_ops << " allocations each: "
+       << elapsed << " s, " << total_ops / elapsed / 1000000.0
+       << " million allocations per second\n";
+
+#ifdef USE_MEMORY_THREAD_CACHE
+  ThreadCacheAllocator *alloc = ThreadCacheAllocator::get_global_ptr();
+  cerr << "mapped " << alloc->get_mapped_size()
+       << ", released " << alloc->get_released_size()
+       << ", free pages " << alloc->get_free_span_size()
+       << ", central caches " << alloc->get_central_cache_size()
+       << ", thread caches " << alloc->get_thread_cache_size() << "\n";
+#endif
+
+  for (int t = 0; t < num_threads; ++t) {
+    for (int n = 0; n < num_slots; ++n) {
+      if (workers[t]._slots[n] != NULL) {
+        memory_hook->heap_free_array(workers[t]._slots[n]);
+      }
+      if (workers[t]._inbox[n] != NULL) {
+        memory_hook->heap_free_array(workers[t]._inbox[n]);
+      }
+    }
+  }
+  delete[] workers;
+
+  if (memory_hook->heap_trim(0)) {
+    cerr << "Trimmed heap.\n";
+  }
+  return 0;
+}
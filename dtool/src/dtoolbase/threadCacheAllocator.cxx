@@ -0,0 +1,1157 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file threadCacheAllocator.cxx
+ * @date 2026-10-18
+ */
+
+#include "threadCacheAllocator.h"
+
+#ifdef USE_MEMORY_THREAD_CACHE
+
+#include "memoryHook.h"
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#ifdef _WIN32
+
+// Windows case.
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif
+#include <windows.h>
+
+#else
+
+// Posix case.
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+
+#ifndef MAP_ANON
+#define MAP_ANON 0x1000
+#endif
+
+#ifdef HAVE_POSIX_THREADS
+#include <pthread.h>
+#endif
+
+#endif  // _WIN32
+
+ThreadCacheAllocator *TVOLATILE ThreadCacheAllocator::_global_ptr;
+
+// The calling thread's cache, or NULL if the thread hasn't used the allocator
+// yet.
+static THREAD_LOCAL void *thread_cache = NULL;
+
+// This is used only to be told when a thread exits, so that the blocks in its
+// cache can be given back.
+#ifdef _WIN32
+static DWORD thread_cache_key = FLS_OUT_OF_INDEXES;
+static VOID WINAPI fls_thread_exit(PVOID data);
+#elif defined(HAVE_POSIX_THREADS)
+static pthread_key_t thread_cache_key;
+#endif
+
+// If a thread cache holds more than this many bytes, each of its free lists
+// gives half of its blocks back to the central lists.
+static const size_t max_thread_cache_size = 4 * 1024 * 1024;
+
+// The default limit on the free pages kept by the page heap.
+static const size_t default_max_free_size = 32 * 1024 * 1024;
+
+// The page heap obtains at least this many pages from the system at a time.
+static const size_t min_grow_pages = 128;
+
+// The allocator's own bookkeeping is carved out of chunks of this size.
+static const size_t metadata_chunk_size = 128 * 1024;
+
+/**
+ * Called only by make_global_ptr(), in memory obtained directly from the
+ * system.
+ */
+ThreadCacheAllocator::
+ThreadCacheAllocator() :
+  _mapped_size(0),
+  _free_size(0),
+  _released_size(0),
+  _max_free_size(default_max_free_size),
+  _span_pool(NULL),
+  _metadata_next(NULL),
+  _metadata_remaining(0),
+  _cache_pool(NULL)
+{
+  memset(_page_map, 0, sizeof(_page_map));
+
+  for (size_t i = 0; i < max_pages; ++i) {
+    list_init(&_free[i]);
+    list_init(&_released[i]);
+  }
+  list_init(&_large_free);
+  list_init(&_large_released);
+
+  _caches._next = &_caches;
+  _caches._prev = &_caches;
+
+  init_size_classes();
+  for (size_t c = 0; c < max_size_classes; ++c) {
+    list_init(&_central[c]._nonempty);
+    _central[c]._num_free = 0;
+  }
+}
+
+/**
+ * Allocates a block of at least the indicated number of bytes, aligned to
+ * MEMORY_HOOK_ALIGNMENT.  Returns NULL if the memory is not available.
+ */
+void *ThreadCacheAllocator::
+alloc(size_t size) {
+  if (size > max_small_size) {
+    return alloc_large(size);
+  }
+
+  size_t size_class = _class_array[get_class_index(size)];
+  ThreadCache *cache = (ThreadCache *)thread_cache;
+  if (cache != (ThreadCache *)NULL) {
+    FreeList &list = cache->_lists[size_class];
+    void *result = list._head;
+    if (result != NULL) {
+      list._head = *(void **)result;
+      --list._length;
+      cache->_size -= _classes[size_class]._size;
+      return result;
+    }
+  }
+
+  return alloc_small(size_class);
+}
+
+/**
+ * Releases a block previously returned by alloc() or realloc().
+ */
+void ThreadCacheAllocator::
+free(void *ptr) {
+  if (ptr == NULL) {
+    return;
+  }
+
+  Span *span = get_span((uintptr_t)ptr >> page_shift);
+  assert(span != (Span *)NULL && span->_location == L_in_use);
+
+  size_t size_class = span->_size_class;
+  if (size_class == 0) {
+    _page_lock.acquire();
+    free_span(span);
+    _page_lock.release();
+    return;
+  }
+
+  ThreadCache *cache = get_thread_cache();
+  if (cache == (ThreadCache *)NULL) {
+    *(void **)ptr = NULL;
+    release_objects(size_class, ptr);
+    return;
+  }
+
+  const SizeClass &sc = _classes[size_class];
+  FreeList &list = cache->_lists[size_class];
+  *(void **)ptr = list._head;
+  list._head = ptr;
+  ++list._length;
+  cache->_size += sc._size;
+
+  if (list._length > list._max_length) {
+    release_to_central(cache, size_class, sc._batch_size);
+  }
+  if (cache->_size > max_thread_cache_size) {
+    scavenge_thread_cache(cache);
+  }
+}
+
+/**
+ * Resizes a block previously returned by alloc() or realloc(), moving it if
+ * necessary.  Returns NULL, leaving the original block untouched, if the
+ * memory is not available.
+ */
+void *ThreadCacheAllocator::
+realloc(void *ptr, size_t size) {
+  if (ptr == NULL) {
+    return alloc(size);
+  }
+
+  // If the block is already big enough, and not much too big, keep it.
+  size_t orig_size = get_ptr_size(ptr);
+  if (size <= orig_size && size >= orig_size / 2) {
+    return ptr;
+  }
+
+  void *result = alloc(size);
+  if (result == NULL) {
+    return NULL;
+  }
+  memcpy(result, ptr, min(size, orig_size));
+  free(ptr);
+  return result;
+}
+
+/**
+ * Returns the number of usable bytes in a block returned by alloc() or
+ * realloc().  This may be somewhat more than the number of bytes requested.
+ */
+size_t ThreadCacheAllocator::
+get_ptr_size(void *ptr) const {
+  Span *span = get_span((uintptr_t)ptr >> page_shift);
+  assert(span != (Span *)NULL && span->_location == L_in_use);
+
+  if (span->_size_class != 0) {
+    return _classes[span->_size_class]._size;
+  }
+  return span->_num_pages << page_shift;
+}
+
+/**
+ * Gives back the blocks cached by the calling thread, and returns all but pad
+ * bytes of the free pages to the system.  Returns true if any memory was
+ * returned.
+ */
+bool ThreadCacheAllocator::
+trim(size_t pad) {
+  ThreadCache *cache = (ThreadCache *)thread_cache;
+  if (cache != (ThreadCache *)NULL) {
+    for (size_t c = 1; c < _num_classes; ++c) {
+      release_to_central(cache, c, cache->_lists[c]._length);
+    }
+  }
+
+  _page_lock.acquire();
+  size_t orig_released_size = _released_size;
+  release_free_spans(pad);
+  bool trimmed = (_released_size > orig_released_size);
+  _page_lock.release();
+
+  return trimmed;
+}
+
+/**
+ * Returns the number of bytes in the free blocks held by the central free
+ * lists, that is, carved out of spans but not cached by any thread.
+ */
+size_t ThreadCacheAllocator::
+get_central_cache_size() const {
+  size_t total = 0;
+  for (size_t c = 1; c < _num_classes; ++c) {
+    CentralList &central = (CentralList &)_central[c];
+    central._lock.acquire();
+    total += central._num_free * _classes[c]._size;
+    central._lock.release();
+  }
+  return total;
+}
+
+/**
+ * Returns the number of bytes in the free blocks cached by all of the
+ * threads.  Since the threads don't lock their caches, this is only
+ * approximate.
+ */
+size_t ThreadCacheAllocator::
+get_thread_cache_size() const {
+  ((MutexImpl &)_page_lock).acquire();
+  size_t total = 0;
+  for (ThreadCache *cache = _caches._next; cache != &_caches; cache = cache->_next) {
+    total += cache->_size;
+  }
+  ((MutexImpl &)_page_lock).release();
+  return total;
+}
+
+/**
+ * Called when a thread that has used the allocator exits, to give back the
+ * blocks in its cache.
+ */
+void ThreadCacheAllocator::
+thread_exit(void *data) {
+  ThreadCache *cache = (ThreadCache *)data;
+  if (cache != (ThreadCache *)NULL && _global_ptr != (ThreadCacheAllocator *)NULL) {
+    thread_cache = NULL;
+    _global_ptr->destroy_thread_cache(cache);
+  }
+}
+
+#ifdef _WIN32
+/**
+ * The fiber-local storage callback, which is called when a thread exits.
+ */
+static VOID WINAPI
+fls_thread_exit(PVOID data) {
+  ThreadCacheAllocator::thread_exit(data);
+}
+#endif
+
+/**
+ * Returns the index into _class_array of the size class for a block of the
+ * indicated size.  Small sizes are indexed in steps of 8 bytes, larger ones
+ * in steps of 128 bytes.
+ */
+size_t ThreadCacheAllocator::
+get_class_index(size_t size) {
+  if (size <= 1024) {
+    return (size + 7) >> 3;
+  } else {
+    return (size + 127 + (120 << 7)) >> 7;
+  }
+}
+
+/**
+ * Sets up the table of size classes.  The classes are spaced no more than an
+ * eighth apart, so no more than about an eighth of a block is wasted.
+ */
+void ThreadCacheAllocator::
+init_size_classes() {
+  // Class 0 is reserved for spans that aren't divided into blocks.
+  memset(&_classes[0], 0, sizeof(SizeClass));
+  _num_classes = 1;
+
+  size_t size = MEMORY_HOOK_ALIGNMENT;
+  while (size <= max_small_size) {
+    assert(_num_classes < max_size_classes);
+    SizeClass &sc = _classes[_num_classes++];
+    sc._size = size;
+
+    // Choose the shortest span that wastes no more than an eighth of itself
+    // at the end.
+    size_t num_pages = 1;
+    while (((num_pages << page_shift) % size) > ((num_pages << page_shift) >> 3)) {
+      ++num_pages;
+    }
+    sc._num_pages = num_pages;
+
+    // Move blocks between the threads and the central lists about 64K at a
+    // time, within limits.
+    sc._batch_size = min(max((size_t)65536 / size, (size_t)2), (size_t)32);
+    sc._max_length = sc._batch_size * 8;
+
+    size_t next;
+    if (size < 128) {
+      next = size + MEMORY_HOOK_ALIGNMENT;
+    } else {
+      next = size + size / 8;
+      next = (next + MEMORY_HOOK_ALIGNMENT - 1) & ~(size_t)(MEMORY_HOOK_ALIGNMENT - 1);
+    }
+    // Above 1K, the sizes are looked up in steps of 128 bytes, so they may as
+    // well be multiples of 128.
+    if (size < 1024 && next > 1024) {
+      next = 1024;
+    } else if (next > 1024) {
+      next = (next + 127) & ~(size_t)127;
+    }
+    if (size < max_small_size && next > max_small_size) {
+      next = max_small_size;
+    }
+    size = next;
+  }
+
+  size_t c = 1;
+  for (size_t s = 0; s <= max_small_size; s += (s < 1024) ? 8 : 128) {
+    while (_classes[c]._size < s) {
+      ++c;
+    }
+    _class_array[get_class_index(s)] = (unsigned char)c;
+  }
+}
+
+/**
+ * Allocates a block of the indicated size class through the calling thread's
+ * cache, refilling the cache from the central list if necessary.
+ */
+void *ThreadCacheAllocator::
+alloc_small(size_t size_class) {
+  ThreadCache *cache = get_thread_cache();
+  if (cache == (ThreadCache *)NULL) {
+    void *result;
+    if (fetch_objects(size_class, 1, result) == 0) {
+      return NULL;
+    }
+    return result;
+  }
+
+  FreeList &list = cache->_lists[size_class];
+  if (list._head == NULL) {
+    fetch_from_central(cache, size_class);
+    if (list._head == NULL) {
+      return NULL;
+    }
+  }
+
+  void *result = list._head;
+  list._head = *(void **)result;
+  --list._length;
+  cache->_size -= _classes[size_class]._size;
+  return result;
+}
+
+/**
+ * Allocates a block too large for any size class directly from the page
+ * heap.
+ */
+void *ThreadCacheAllocator::
+alloc_large(size_t size) {
+  if (size > ~(size_t)0 - page_size) {
+    return NULL;
+  }
+  size_t num_pages = (size + page_size - 1) >> page_shift;
+
+  _page_lock.acquire();
+  Span *span = alloc_span(num_pages);
+  _page_lock.release();
+
+  if (span == (Span *)NULL) {
+    return NULL;
+  }
+  return (void *)(span->_start << page_shift);
+}
+
+/**
+ * Returns the calling thread's cache, creating it if necessary.  Returns NULL
+ * only if there is no memory for it.
+ */
+ThreadCacheAllocator::ThreadCache *ThreadCacheAllocator::
+get_thread_cache() {
+  ThreadCache *cache = (ThreadCache *)thread_cache;
+  if (cache == (ThreadCache *)NULL) {
+    cache = make_thread_cache();
+  }
+  return cache;
+}
+
+/**
+ * Creates a cache for the calling thread.
+ */
+ThreadCacheAllocator::ThreadCache *ThreadCacheAllocator::
+make_thread_cache() {
+  _page_lock.acquire();
+  ThreadCache *cache = _cache_pool;
+  if (cache != (ThreadCache *)NULL) {
+    _cache_pool = cache->_next;
+  } else {
+    cache = (ThreadCache *)alloc_metadata(sizeof(ThreadCache));
+    if (cache == (ThreadCache *)NULL) {
+      _page_lock.release();
+      return NULL;
+    }
+  }
+
+  memset(cache->_lists, 0, sizeof(cache->_lists));
+  for (size_t c = 1; c < _num_classes; ++c) {
+    cache->_lists[c]._max_length = _classes[c]._batch_size;
+  }
+  cache->_size = 0;
+
+  cache->_next = _caches._next;
+  cache->_prev = &_caches;
+  _caches._next->_prev = cache;
+  _caches._next = cache;
+  _page_lock.release();
+
+  thread_cache = cache;
+#ifdef _WIN32
+  if (thread_cache_key != FLS_OUT_OF_INDEXES) {
+    FlsSetValue(thread_cache_key, cache);
+  }
+#elif defined(HAVE_POSIX_THREADS)
+  pthread_setspecific(thread_cache_key, cache);
+#endif
+  return cache;
+}
+
+/**
+ * Refills the thread's empty free list for the indicated size class from the
+ * central list.  Each time this happens, the free list is allowed to grow a
+ * little longer before it must give blocks back, so that threads that
+ * allocate a lot of blocks of one size go to the central list less often.
+ */
+void ThreadCacheAllocator::
+fetch_from_central(ThreadCache *cache, size_t size_class) {
+  const SizeClass &sc = _classes[size_class];
+  FreeList &list = cache->_lists[size_class];
+  assert(list._head == NULL);
+
+  void *head;
+  size_t count = fetch_objects(size_class, sc._batch_size, head);
+  list._head = head;
+  list._length = count;
+  cache->_size += count * sc._size;
+
+  if (list._max_length < sc._max_length) {
+    list._max_length = min(list._max_length + sc._batch_size, sc._max_length);
+  }
+}
+
+/**
+ * Gives up to count blocks from the thread's free list for the indicated size
+ * class back to the central list.
+ */
+void ThreadCacheAllocator::
+release_to_central(ThreadCache *cache, size_t size_class, size_t count) {
+  FreeList &list = cache->_lists[size_class];
+  count = min(count, list._length);
+  if (count == 0) {
+    return;
+  }
+
+  void *head = list._head;
+  void *tail = head;
+  for (size_t i = 1; i < count; ++i) {
+    tail = *(void **)tail;
+  }
+  list._head = *(void **)tail;
+  *(void **)tail = NULL;
+  list._length -= count;
+  cache->_size -= count * _classes[size_class]._size;
+
+  release_objects(size_class, head);
+}
+
+/**
+ * Called when a thread's cache has grown too large.  Gives back half of the
+ * blocks in each free list, and lowers the limits on their lengths.
+ */
+void ThreadCacheAllocator::
+scavenge_thread_cache(ThreadCache *cache) {
+  for (size_t c = 1; c < _num_classes; ++c) {
+    FreeList &list = cache->_lists[c];
+    release_to_central(cache, c, (list._length + 1) / 2);
+    list._max_length = max(_classes[c]._batch_size, list._max_length / 2);
+  }
+}
+
+/**
+ * Gives back all of the blocks in the cache, and keeps the cache for reuse by
+ * some later thread.
+ */
+void ThreadCacheAllocator::
+destroy_thread_cache(ThreadCache *cache) {
+  for (size_t c = 1; c < _num_classes; ++c) {
+    release_to_central(cache, c, cache->_lists[c]._length);
+  }
+
+  _page_lock.acquire();
+  cache->_prev->_next = cache->_next;
+  cache->_next->_prev = cache->_prev;
+  cache->_prev = NULL;
+  cache->_next = _cache_pool;
+  _cache_pool = cache;
+  _page_lock.release();
+}
+
+/**
+ * Takes up to count free blocks of the indicated size class from the central
+ * list, carving up new spans as needed, and returns them as a linked list in
+ * head.  Returns the number of blocks taken, which is 0 only if there is no
+ * memory.
+ */
+size_t ThreadCacheAllocator::
+fetch_objects(size_t size_class, size_t count, void *&head) {
+  CentralList &central = _central[size_class];
+  head = NULL;
+  size_t fetched = 0;
+
+  central._lock.acquire();
+  while (fetched < count) {
+    if (list_empty(&central._nonempty) && !populate(size_class)) {
+      break;
+    }
+
+    Span *span = central._nonempty._next;
+    while (fetched < count && span->_objects != NULL) {
+      void *object = span->_objects;
+      span->_objects = *(void **)object;
+      *(void **)object = head;
+      head = object;
+      ++span->_refcount;
+      ++fetched;
+    }
+    if (span->_objects == NULL) {
+      list_remove(span);
+    }
+  }
+  central._num_free -= fetched;
+  central._lock.release();
+
+  return fetched;
+}
+
+/**
+ * Returns the blocks in the indicated linked list, which must all be of the
+ * indicated size class, to the spans they came from.  Spans that become
+ * entirely free are returned to the page heap.
+ */
+void ThreadCacheAllocator::
+release_objects(size_t size_class, void *head) {
+  CentralList &central = _central[size_class];
+  const SizeClass &sc = _classes[size_class];
+  size_t objects_per_span = (sc._num_pages << page_shift) / sc._size;
+
+  central._lock.acquire();
+  while (head != NULL) {
+    void *object = head;
+    head = *(void **)object;
+
+    Span *span = get_span((uintptr_t)object >> page_shift);
+    assert(span != (Span *)NULL && span->_size_class == size_class);
+    if (span->_objects == NULL) {
+      list_prepend(&central._nonempty, span);
+    }
+    *(void **)object = span->_objects;
+    span->_objects = object;
+    ++central._num_free;
+
+    if (--span->_refcount == 0) {
+      list_remove(span);
+      central._num_free -= objects_per_span;
+      _page_lock.acquire();
+      free_span(span);
+      _page_lock.release();
+    }
+  }
+  central._lock.release();
+}
+
+/**
+ * Gets a new span from the page heap for the central list of the indicated
+ * size class, and divides it into blocks.  The central list's lock must be
+ * held.  Returns false if there is no memory.
+ */
+bool ThreadCacheAllocator::
+populate(size_t size_class) {
+  CentralList &central = _central[size_class];
+  const SizeClass &sc = _classes[size_class];
+
+  _page_lock.acquire();
+  Span *span = alloc_span(sc._num_pages);
+  if (span != (Span *)NULL) {
+    // Every page of the span must map back to it, since a block may start
+    // on any of them.
+    span->_size_class = (unsigned char)size_class;
+    for (size_t i = 0; i < span->_num_pages; ++i) {
+      set_span(span->_start + i, span);
+    }
+  }
+  _page_lock.release();
+
+  if (span == (Span *)NULL) {
+    return false;
+  }
+
+  // Chain the blocks together in address order.
+  char *start = (char *)(span->_start << page_shift);
+  size_t num_objects = (sc._num_pages << page_shift) / sc._size;
+  void **tail = &span->_objects;
+  for (size_t i = 0; i < num_objects; ++i) {
+    char *object = start + i * sc._size;
+    *tail = object;
+    tail = (void **)object;
+  }
+  *tail = NULL;
+  span->_refcount = 0;
+
+  list_prepend(&central._nonempty, span);
+  central._num_free += num_objects;
+  return true;
+}
+
+/**
+ * Returns the span that contains the indicated page, or NULL if the page
+ * hasn't been allocated from the system.  For spans that aren't divided into
+ * blocks, only the first and last pages are guaranteed to map to the span.
+ */
+ThreadCacheAllocator::Span *ThreadCacheAllocator::
+get_span(uintptr_t page) const {
+  uintptr_t i1 = page >> (leaf_bits + mid_bits);
+  if (i1 >= ((uintptr_t)1 << root_bits)) {
+    return NULL;
+  }
+  Mid *mid = _page_map[i1];
+  if (mid == (Mid *)NULL) {
+    return NULL;
+  }
+  Leaf *leaf = (*mid)[(page >> leaf_bits) & (((uintptr_t)1 << mid_bits) - 1)];
+  if (leaf == (Leaf *)NULL) {
+    return NULL;
+  }
+  return (*leaf)[page & (((uintptr_t)1 << leaf_bits) - 1)];
+}
+
+/**
+ * Records that the indicated page belongs to the indicated span.  The page
+ * map must already have room for the page; see ensure_page_map().  The page
+ * heap lock must be held.
+ */
+void ThreadCacheAllocator::
+set_span(uintptr_t page, Span *span) {
+  Mid *mid = _page_map[page >> (leaf_bits + mid_bits)];
+  Leaf *leaf = (*mid)[(page >> leaf_bits) & (((uintptr_t)1 << mid_bits) - 1)];
+  (*leaf)[page & (((uintptr_t)1 << leaf_bits) - 1)] = span;
+}
+
+/**
+ * Allocates whatever nodes of the page map are needed to record the
+ * indicated range of pages.  Returns false if there is no memory, or if the
+ * pages lie outside of the address range the page map covers.
+ */
+bool ThreadCacheAllocator::
+ensure_page_map(uintptr_t start, size_t num_pages) {
+  uintptr_t end = start + num_pages;
+  uintptr_t page = start;
+  while (page < end) {
+    uintptr_t i1 = page >> (leaf_bits + mid_bits);
+    if (i1 >= ((uintptr_t)1 << root_bits)) {
+      return false;
+    }
+    if (_page_map[i1] == (Mid *)NULL) {
+      _page_map[i1] = (Mid *)alloc_metadata(sizeof(Mid));
+      if (_page_map[i1] == (Mid *)NULL) {
+        return false;
+      }
+    }
+    Leaf *&leaf = (*_page_map[i1])[(page >> leaf_bits) & (((uintptr_t)1 << mid_bits) - 1)];
+    if (leaf == (Leaf *)NULL) {
+      leaf = (Leaf *)alloc_metadata(sizeof(Leaf));
+      if (leaf == (Leaf *)NULL) {
+        return false;
+      }
+    }
+    page = ((page >> leaf_bits) + 1) << leaf_bits;
+  }
+  return true;
+}
+
+/**
+ * Takes a span of the indicated number of pages from the page heap, getting
+ * more memory from the system if necessary.  Prefers the smallest free span
+ * that will do, and pages that haven't been returned to the system.  The page
+ * heap lock must be held.  Returns NULL if there is no memory.
+ */
+ThreadCacheAllocator::Span *ThreadCacheAllocator::
+alloc_span(size_t num_pages) {
+  for (size_t i = num_pages; i < max_pages; ++i) {
+    if (!list_empty(&_free[i])) {
+      return carve_span(_free[i]._next, num_pages);
+    }
+    if (!list_empty(&_released[i])) {
+      return carve_span(_released[i]._next, num_pages);
+    }
+  }
+
+  Span *best = NULL;
+  Span *lists[2] = { &_large_free, &_large_released };
+  for (int li = 0; li < 2; ++li) {
+    for (Span *span = lists[li]->_next; span != lists[li]; span = span->_next) {
+      if (span->_num_pages >= num_pages &&
+          (best == (Span *)NULL || span->_num_pages < best->_num_pages)) {
+        best = span;
+      }
+    }
+  }
+  if (best != (Span *)NULL) {
+    return carve_span(best, num_pages);
+  }
+
+  if (!grow_heap(num_pages)) {
+    return NULL;
+  }
+  return alloc_span(num_pages);
+}
+
+/**
+ * Takes the indicated free span off its list and trims it to the indicated
+ * number of pages, putting the remainder back on the free lists.
+ */
+ThreadCacheAllocator::Span *ThreadCacheAllocator::
+carve_span(Span *span, size_t num_pages) {
+  remove_free_span(span);
+
+  size_t extra = span->_num_pages - num_pages;
+  if (extra > 0) {
+    Span *leftover = new_span();
+    if (leftover != (Span *)NULL) {
+      leftover->_start = span->_start + num_pages;
+      leftover->_num_pages = extra;
+      leftover->_location = span->_location;
+      set_span(leftover->_start, leftover);
+      set_span(leftover->_start + extra - 1, leftover);
+      add_free_span(leftover);
+      span->_num_pages = num_pages;
+    }
+  }
+
+  if (span->_location == L_released) {
+    size_t size = span->_num_pages << page_shift;
+    if (!os_recommit((void *)(span->_start << page_shift), size)) {
+      add_free_span(span);
+      return NULL;
+    }
+    if (memory_hook != (MemoryHook *)NULL) {
+      memory_hook->inc_heap(size);
+    }
+  }
+
+  span->_location = L_in_use;
+  span->_size_class = 0;
+  span->_objects = NULL;
+  span->_refcount = 0;
+  set_span(span->_start, span);
+  set_span(span->_start + span->_num_pages - 1, span);
+  return span;
+}
+
+/**
+ * Returns the span to the page heap, coalescing it with any free neighbors.
+ * The page heap lock must be held.
+ */
+void ThreadCacheAllocator::
+free_span(Span *span) {
+  span->_location = L_free;
+  span->_size_class = 0;
+  span->_objects = NULL;
+
+  // If only one of two neighbors has been returned to the system, the other
+  // is returned too, so that the whole of a free span is always in the same
+  // state.
+  Span *prev = get_span(span->_start - 1);
+  if (prev != (Span *)NULL && prev->_location != L_in_use) {
+    remove_free_span(prev);
+    if (prev->_location != span->_location) {
+      release_span(prev->_location == L_free ? prev : span);
+      prev->_location = L_released;
+      span->_location = L_released;
+    }
+    span->_start = prev->_start;
+    span->_num_pages += prev->_num_pages;
+    delete_span(prev);
+    set_span(span->_start, span);
+  }
+
+  Span *next = get_span(span->_start + span->_num_pages);
+  if (next != (Span *)NULL && next->_location != L_in_use) {
+    remove_free_span(next);
+    if (next->_location != span->_location) {
+      release_span(next->_location == L_free ? next : span);
+      next->_location = L_released;
+      span->_location = L_released;
+    }
+    span->_num_pages += next->_num_pages;
+    delete_span(next);
+    set_span(span->_start + span->_num_pages - 1, span);
+  }
+
+  add_free_span(span);
+
+  if (_free_size > _max_free_size) {
+    release_free_spans(_max_free_size);
+  }
+}
+
+/**
+ * Gets at least the indicated number of pages from the system and adds them
+ * to the page heap.  Returns false if there is no memory.
+ */
+bool ThreadCacheAllocator::
+grow_heap(size_t num_pages) {
+  size_t grow_pages = max(num_pages, min_grow_pages);
+  void *ptr = os_alloc(grow_pages << page_shift);
+  if (ptr == NULL && grow_pages > num_pages) {
+    grow_pages = num_pages;
+    ptr = os_alloc(grow_pages << page_shift);
+  }
+  if (ptr == NULL) {
+    return false;
+  }
+
+  uintptr_t start = (uintptr_t)ptr >> page_shift;
+  Span *span = new_span();
+  if (span == (Span *)NULL || !ensure_page_map(start, grow_pages)) {
+    os_free(ptr, grow_pages << page_shift);
+    if (span != (Span *)NULL) {
+      delete_span(span);
+    }
+    return false;
+  }
+
+  size_t size = grow_pages << page_shift;
+  _mapped_size += size;
+  if (memory_hook != (MemoryHook *)NULL) {
+    memory_hook->inc_heap(size);
+  }
+
+  span->_start = start;
+  span->_num_pages = grow_pages;
+  span->_location = L_in_use;
+  set_span(start, span);
+  set_span(start + grow_pages - 1, span);
+  free_span(span);
+  return true;
+}
+
+/**
+ * Returns the pages of the indicated free span, which must not be on any
+ * list, to the system.  The address space is kept, so the pages may be used
+ * again later.
+ */
+void ThreadCacheAllocator::
+release_span(Span *span) {
+  assert(span->_location == L_free);
+  size_t size = span->_num_pages << page_shift;
+  os_release((void *)(span->_start << page_shift), size);
+  span->_location = L_released;
+
+  if (memory_hook != (MemoryHook *)NULL) {
+    memory_hook->dec_heap(size);
+  }
+}
+
+/**
+ * Returns free spans to the system, largest first, until no more than
+ * max_free bytes of free pages remain.  The page heap lock must be held.
+ */
+void ThreadCacheAllocator::
+release_free_spans(size_t max_free) {
+  while (_free_size > max_free) {
+    Span *span;
+    if (!list_empty(&_large_free)) {
+      span = _large_free._next;
+    } else {
+      size_t i = max_pages - 1;
+      while (i > 0 && list_empty(&_free[i])) {
+        --i;
+      }
+      if (i == 0) {
+        break;
+      }
+      span = _free[i]._next;
+    }
+
+    remove_free_span(span);
+    release_span(span);
+    add_free_span(span);
+  }
+}
+
+/**
+ * Puts the indicated span on the free list appropriate to its length and
+ * location.
+ */
+void ThreadCacheAllocator::
+add_free_span(Span *span) {
+  size_t size = span->_num_pages << page_shift;
+  if (span->_location == L_free) {
+    list_prepend(span->_num_pages < max_pages ? &_free[span->_num_pages] : &_large_free, span);
+    _free_size += size;
+  } else {
+    assert(span->_location == L_released);
+    list_prepend(span->_num_pages < max_pages ? &_released[span->_num_pages] : &_large_released, span);
+    _released_size += size;
+  }
+}
+
+/**
+ * Takes the indicated span off of whichever free list it is on.
+ */
+void ThreadCacheAllocator::
+remove_free_span(Span *span) {
+  list_remove(span);
+  size_t size = span->_num_pages << page_shift;
+  if (span->_location == L_free) {
+    _free_size -= size;
+  } else {
+    _released_size -= size;
+  }
+}
+
+/**
+ * Returns a new, zeroed Span record.  The page heap lock must be held.
+ */
+ThreadCacheAllocator::Span *ThreadCacheAllocator::
+new_span() {
+  Span *span = _span_pool;
+  if (span != (Span *)NULL) {
+    _span_pool = span->_next;
+  } else {
+    span = (Span *)alloc_metadata(sizeof(Span));
+    if (span == (Span *)NULL) {
+      return NULL;
+    }
+  }
+  memset(span, 0, sizeof(Span));
+  return span;
+}
+
+/**
+ * Keeps the indicated Span record for reuse by new_span().
+ */
+void ThreadCacheAllocator::
+delete_span(Span *span) {
+  span->_next = _span_pool;
+  _span_pool = span;
+}
+
+/**
+ * Allocates zeroed memory for the allocator's own bookkeeping.  This memory
+ * is never freed.  The page heap lock must be held.
+ */
+void *ThreadCacheAllocator::
+alloc_metadata(size_t size) {
+  size = (size + 63) & ~(size_t)63;
+
+  if (size > _metadata_remaining) {
+    size_t chunk_size = max(size, metadata_chunk_size);
+    chunk_size = (chunk_size + page_size - 1) & ~(size_t)(page_size - 1);
+    void *chunk = os_alloc(chunk_size);
+    if (chunk == NULL) {
+      return NULL;
+    }
+    _mapped_size += chunk_size;
+    if (memory_hook != (MemoryHook *)NULL) {
+      memory_hook->inc_heap(chunk_size);
+    }
+    _metadata_next = (char *)chunk;
+    _metadata_remaining = chunk_size;
+  }
+
+  void *result = _metadata_next;
+  _metadata_next += size;
+  _metadata_remaining -= size;
+  return result;
+}
+
+/**
+ * Gets the indicated number of bytes of zeroed memory from the system,
+ * aligned to page_size.  Returns NULL if there is no memory.
+ */
+void *ThreadCacheAllocator::
+os_alloc(size_t size) {
+#ifdef _WIN32
+  // VirtualAlloc always returns memory aligned to at least 64K.
+  return VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+
+#else
+  // mmap only guarantees alignment to the system page size, so get a bit
+  // extra and unmap the ends.
+  size_t mapped_size = size + page_size;
+  char *ptr = (char *)mmap(NULL, mapped_size, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANON, -1, 0);
+  if (ptr == (char *)-1) {
+    return NULL;
+  }
+
+  char *aligned = (char *)(((uintptr_t)ptr + page_size - 1) & ~(uintptr_t)(page_size - 1));
+  if (aligned != ptr) {
+    munmap(ptr, aligned - ptr);
+  }
+  char *end = ptr + mapped_size;
+  if (aligned + size != end) {
+    munmap(aligned + size, end - (aligned + size));
+  }
+  return aligned;
+#endif  // _WIN32
+}
+
+/**
+ * Returns memory obtained from os_alloc() to the system entirely.
+ */
+void ThreadCacheAllocator::
+os_free(void *ptr, size_t size) {
+#ifdef _WIN32
+  VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+  munmap(ptr, size);
+#endif
+}
+
+/**
+ * Tells the system that the contents of the indicated pages are no longer
+ * needed, so that it may take the physical memory back.  The pages must be
+ * recommitted with os_recommit() before they are used again.
+ */
+void ThreadCacheAllocator::
+os_release(void *ptr, size_t size) {
+#ifdef _WIN32
+  // A span may cross the boundary between two allocations, which VirtualFree
+  // can't handle in a single call.
+  char *p = (char *)ptr;
+  while (size > 0) {
+    MEMORY_BASIC_INFORMATION info;
+    VirtualQuery(p, &info, sizeof(info));
+    size_t region_size = min(size, (size_t)((char *)info.BaseAddress + info.RegionSize - p));
+    VirtualFree(p, region_size, MEM_DECOMMIT);
+    p += region_size;
+    size -= region_size;
+  }
+
+#else
+  madvise(ptr, size, MADV_DONTNEED);
+#endif
+}
+
+/**
+ * Makes pages passed to os_release() usable again.  Returns false if there is
+ * no memory.
+ */
+bool ThreadCacheAllocator::
+os_recommit(void *ptr, size_t size) {
+#ifdef _WIN32
+  char *p = (char *)ptr;
+  while (size > 0) {
+    MEMORY_BASIC_INFORMATION info;
+    VirtualQuery(p, &info, sizeof(info));
+    size_t region_size = min(size, (size_t)((char *)info.BaseAddress + info.RegionSize - p));
+    if (VirtualAlloc(p, region_size, MEM_COMMIT, PAGE_READWRITE) == NULL) {
+      return false;
+    }
+    p += region_size;
+    size -= region_size;
+  }
+  return true;
+
+#else
+  // The pages are given new physical memory as soon as they are touched.
+  return true;
+#endif
+}
+
+/**
+ * Creates the global allocator, in memory obtained directly from the system,
+ * since there is nowhere else to get it from.
+ */
+void ThreadCacheAllocator::
+make_global_ptr() {
+  size_t size = (sizeof(ThreadCacheAllocator) + page_size - 1) & ~(size_t)(page_size - 1);
+  void *mem = os_alloc(size);
+  if (mem == NULL) {
+    abort();
+  }
+
+  ThreadCacheAllocator *ptr = new(mem) ThreadCacheAllocator;
+  void *result = AtomicAdjust::compare_and_exchange_ptr
+    ((void * TVOLATILE &)_global_ptr, (void *)NULL, (void *)ptr);
+  if (result != NULL) {
+    // Someone else got there first.
+    ptr->~ThreadCacheAllocator();
+    os_free(mem, size);
+    return;
+  }
+
+#ifdef _WIN32
+  thread_cache_key = FlsAlloc(&fls_thread_exit);
+#elif defined(HAVE_POSIX_THREADS)
+  pthread_key_create(&thread_cache_key, &thread_exit);
+#endif
+}
+
+#endif  // USE_MEMORY_THREAD_CACHE
@@ -0,0 +1,223 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file threadCacheAllocator.h
+ * @date 2026-10-18
+ */
+
+#ifndef THREADCACHEALLOCATOR_H
+#define THREADCACHEALLOCATOR_H
+
+#include "dtoolbase.h"
+
+#ifdef USE_MEMORY_THREAD_CACHE
+
+#include "mutexImpl.h"
+#include "atomicAdjust.h"
+
+/**
+ * A general-purpose memory allocator that keeps a cache of free blocks for
+ * each thread, so that most allocations and deallocations don't need to take
+ * any lock at all.  This is the allocator used by MemoryHook when Panda is
+ * built with USE_MEMORY_THREAD_CACHE.
+ *
+ * Small requests are rounded up to one of a fixed set of size classes.  Each
+ * thread keeps a free list for each size class, which is refilled from, and
+ * drained back to, a central free list for that size class in batches.  The
+ * central free lists carve their blocks out of spans of pages, which are
+ * obtained from a page heap that also serves the large requests directly.
+ * Free spans in the page heap are coalesced with their neighbors, and when
+ * there are more free pages than get_max_free_size() allows, the excess is
+ * returned to the system, though the address space is kept.
+ */
+class EXPCL_DTOOL ThreadCacheAllocator {
+private:
+  ThreadCacheAllocator();
+
+public:
+  INLINE static ThreadCacheAllocator *get_global_ptr();
+
+  void *alloc(size_t size);
+  void free(void *ptr);
+  void *realloc(void *ptr, size_t size);
+  size_t get_ptr_size(void *ptr) const;
+
+  bool trim(size_t pad);
+
+  INLINE void set_max_free_size(size_t max_free_size);
+  INLINE size_t get_max_free_size() const;
+
+  INLINE size_t get_mapped_size() const;
+  INLINE size_t get_released_size() const;
+  INLINE size_t get_free_span_size() const;
+  size_t get_central_cache_size() const;
+  size_t get_thread_cache_size() const;
+
+  static void thread_exit(void *data);
+
+private:
+  // The unit in which memory is obtained from the page heap.
+  enum {
+    page_shift = 13,
+    page_size = 1 << page_shift,
+  };
+
+  // Requests larger than this are served directly from the page heap.
+  static const size_t max_small_size = 32 * 1024;
+
+  // The page heap keeps a separate free list for each span length up to this
+  // many pages; longer spans go on a single list.
+  enum { max_pages = 128 };
+
+  enum { max_size_classes = 96 };
+  enum { class_array_size = ((max_small_size + 127 + (120 << 7)) >> 7) + 1 };
+
+  enum Location {
+    L_in_use,
+    L_free,
+    L_released,
+  };
+
+  class Span {
+  public:
+    uintptr_t _start;
+    size_t _num_pages;
+    Span *_next;
+    Span *_prev;
+
+    // The free blocks within a span that has been divided into blocks of a
+    // particular size class, and the number of blocks handed out.
+    void *_objects;
+    size_t _refcount;
+
+    unsigned char _size_class;
+    unsigned char _location;
+  };
+
+  class SizeClass {
+  public:
+    size_t _size;
+    size_t _num_pages;
+    size_t _batch_size;
+    size_t _max_length;
+  };
+
+  class CentralList {
+  public:
+    MutexImpl _lock;
+    Span _nonempty;
+    size_t _num_free;
+  };
+
+  class FreeList {
+  public:
+    void *_head;
+    size_t _length;
+    size_t _max_length;
+  };
+
+  class ThreadCache {
+  public:
+    FreeList _lists[max_size_classes];
+    TVOLATILE size_t _size;
+    ThreadCache *_next;
+    ThreadCache *_prev;
+  };
+
+  static size_t get_class_index(size_t size);
+  void init_size_classes();
+
+  void *alloc_small(size_t size_class);
+  void *alloc_large(size_t size);
+
+  ThreadCache *get_thread_cache();
+  ThreadCache *make_thread_cache();
+  void fetch_from_central(ThreadCache *cache, size_t size_class);
+  void release_to_central(ThreadCache *cache, size_t size_class, size_t count);
+  void scavenge_thread_cache(ThreadCache *cache);
+  void destroy_thread_cache(ThreadCache *cache);
+
+  size_t fetch_objects(size_t size_class, size_t count, void *&head);
+  void release_objects(size_t size_class, void *head);
+  bool populate(size_t size_class);
+
+  Span *get_span(uintptr_t page) const;
+  void set_span(uintptr_t page, Span *span);
+  bool ensure_page_map(uintptr_t start, size_t num_pages);
+
+  Span *alloc_span(size_t num_pages);
+  void free_span(Span *span);
+  Span *carve_span(Span *span, size_t num_pages);
+  bool grow_heap(size_t num_pages);
+  void release_span(Span *span);
+  void release_free_spans(size_t max_free);
+  Span *new_span();
+  void delete_span(Span *span);
+  void *alloc_metadata(size_t size);
+
+  INLINE static void list_init(Span *list);
+  INLINE static bool list_empty(const Span *list);
+  INLINE static void list_remove(Span *span);
+  INLINE static void list_prepend(Span *list, Span *span);
+  void add_free_span(Span *span);
+  void remove_free_span(Span *span);
+
+  static void *os_alloc(size_t size);
+  static void os_free(void *ptr, size_t size);
+  static void os_release(void *ptr, size_t size);
+  static bool os_recommit(void *ptr, size_t size);
+
+  static void make_global_ptr();
+
+private:
+  SizeClass _classes[max_size_classes];
+  size_t _num_classes;
+  unsigned char _class_array[class_array_size];
+
+  CentralList _central[max_size_classes];
+
+  // The page map, a three-level radix tree from page number to the span that
+  // contains it.  The nodes are allocated as needed and never freed.
+  enum {
+    address_bits = (sizeof(void *) == 8) ? 48 : 32,
+    page_bits = address_bits - page_shift,
+    leaf_bits = (page_bits + 2) / 3,
+    mid_bits = leaf_bits,
+    root_bits = page_bits - leaf_bits - mid_bits,
+  };
+  typedef Span *Leaf[1 << leaf_bits];
+  typedef Leaf *Mid[1 << mid_bits];
+  Mid *_page_map[1 << root_bits];
+
+  // Everything below is protected by the page heap lock.
+  MutexImpl _page_lock;
+  Span _free[max_pages];
+  Span _released[max_pages];
+  Span _large_free;
+  Span _large_released;
+
+  size_t _mapped_size;
+  size_t _free_size;
+  size_t _released_size;
+  size_t _max_free_size;
+
+  Span *_span_pool;
+  char *_metadata_next;
+  size_t _metadata_remaining;
+
+  ThreadCache _caches;
+  ThreadCache *_cache_pool;
+
+  static ThreadCacheAllocator *TVOLATILE _global_ptr;
+};
+
+#include "threadCacheAllocator.I"
+
+#endif  // USE_MEMORY_THREAD_CACHE
+
+#endif
@@ -56,6 +56,8 @@ PandaSystem() :
   set_system_tag("system", "malloc", "dlmalloc");
 #elif defined(USE_MEMORY_PTMALLOC2)
   set_system_tag("system", "malloc", "ptmalloc2");
+#elif defined(USE_MEMORY_THREAD_CACHE)
+  set_system_tag("system", "malloc", "thread-cache");
 #else
   set_system_tag("system", "malloc", "malloc");
 #endif
@@ -2140,6 +2140,7 @@ DTOOL_CONFIG=[
     ("REPORT_OPENSSL_ERRORS",          '1',                      '1'),
     ("USE_PANDAFILESTREAM",            '1',                      '1'),
     ("USE_DELETED_CHAIN",              '1',                      '1'),
+    ("USE_MEMORY_THREAD_CACHE",        'UNDEF',                  'UNDEF'),
     ("HAVE_GLX",                       'UNDEF',                  '1'),
     ("HAVE_WGL",                       '1',                      'UNDEF'),
     ("HAVE_DX9",                       'UNDEF',                  'UNDEF'),
@@ -5059,6 +5060,7 @@ if (PkgSkip("DIRECT")==0):
   OPTS=['DIR:direct/src/distributed', 'DIR:direct/src/dcparser', 'WITHINPANDA', 'BUILDING:DIRECT', 'OPENSSL', 'PYTHON']
   TargetAdd('p3distributed_config_distributed.obj', opts=OPTS, input='config_distributed.cxx')
   TargetAdd('p3distributed_cConnectionRepository.obj', opts=OPTS, input='cConnectionRepository.cxx')
+  TargetAdd('p3distributed_cInterestIndex.obj', opts=OPTS, input='cInterestIndex.cxx')
   TargetAdd('p3distributed_cDistributedSmoothNodeBase.obj', opts=OPTS, input='cDistributedSmoothNodeBase.cxx')
 
   OPTS=['DIR:direct/src/distributed', 'WITHINPANDA', 'OPENSSL', 'PYTHON']
@@ -5158,6 +5160,7 @@ if (PkgSkip("DIRECT")==0):
   TargetAdd('direct.pyd', input='p3dcparser_dcLexer.obj')
   TargetAdd('direct.pyd', input='p3distributed_config_distributed.obj')
   TargetAdd('direct.pyd', input='p3distributed_cConnectionRepository.obj')
+  TargetAdd('direct.pyd', input='p3distributed_cInterestIndex.obj')
   TargetAdd('direct.pyd', input='p3distributed_cDistributedSmoothNodeBase.obj')
 
   TargetAdd('direct.pyd', input='direct_module.obj')
@@ -6168,10 +6171,14 @@ if (PkgSkip("PANDATOOL")==0):
 
 if (PkgSkip("PANDATOOL")==0):
     OPTS=['DIR:pandatool/src/text-stats']
+    TargetAdd('text-stats_textCaptureReport.obj', opts=OPTS, input='textCaptureReport.cxx')
     TargetAdd('text-stats_textMonitor.obj', opts=OPTS, input='textMonitor.cxx')
     TargetAdd('text-stats_textStats.obj', opts=OPTS, input='textStats.cxx')
+    TargetAdd('text-stats_textTraceExport.obj', opts=OPTS, input='textTraceExport.cxx')
+    TargetAdd('text-stats.exe', input='text-stats_textCaptureReport.obj')
     TargetAdd('text-stats.exe', input='text-stats_textMonitor.obj')
     TargetAdd('text-stats.exe', input='text-stats_textStats.obj')
+    TargetAdd('text-stats.exe', input='text-stats_textTraceExport.obj')
     TargetAdd('text-stats.exe', input='libp3progbase.lib')
     TargetAdd('text-stats.exe', input='libp3pstatserver.lib')
     TargetAdd('text-stats.exe', input='libp3pandatoolbase.lib')
@@ -1458,6 +1458,10 @@ cull_to_bins(GraphicsOutput *win, GraphicsStateGuardian *gsg,
              DisplayRegion *dr, SceneSetup *scene_setup,
              CullResult *cull_result, Thread *current_thread) {
 
+  // The objects created by this traversal live until the frame has been
+  // drawn, so they are allocated from the CullResult's arena.
+  CullArena *prev_arena = CullArena::set_current(cull_result->get_arena());
+
   BinCullHandler cull_handler(cull_result);
   CallbackObject *cbobj = dr->get_cull_callback();
   if (cbobj != (CallbackObject *)NULL) {
@@ -1472,8 +1476,12 @@ cull_to_bins(GraphicsOutput *win, GraphicsStateGuardian *gsg,
     dr->do_cull(&cull_handler, scene_setup, gsg, current_thread);
   }
 
-  PStatTimer timer(_cull_sort_pcollector, current_thread);
-  cull_result->finish_cull(scene_setup, current_thread);
+  {
+    PStatTimer timer(_cull_sort_pcollector, current_thread);
+    cull_result->finish_cull(scene_setup, current_thread);
+  }
+
+  CullArena::set_current(prev_arena);
 }
 
 /**
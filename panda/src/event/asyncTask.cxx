@@ -13,6 +13,7 @@
 
 #include "asyncTask.h"
 #include "asyncTaskManager.h"
+#include "asyncTaskGraph.h"
 #include "config_event.h"
 #include "pt_Event.h"
 #include "throw_event.h"
@@ -37,6 +38,8 @@ AsyncTask(const string &name) :
   _servicing_thread(NULL),
   _manager(NULL),
   _chain(NULL),
+  _graph(NULL),
+  _graph_index(0),
   _start_time(0.0),
   _start_frame(0),
   _dt(0.0),
@@ -382,30 +385,53 @@ unlock_and_do_task() {
   nassertr(_manager != (AsyncTaskManager *)NULL, DS_done);
   PT(ClockObject) clock = _manager->get_clock();
 
-  Thread *current_thread = Thread::get_current_thread();
-  record_task(current_thread);
-
   // It's important to release the lock while the task is being serviced.
   _manager->_lock.release();
 
+  double dt;
+  DoneStatus status = do_task_timed(clock, dt);
+
+  // Now reacquire the lock (so we can return with the lock held).
+  _manager->_lock.acquire();
+
+  record_dt(dt);
+  return status;
+}
+
+/**
+ * Runs the task in the current thread, and returns the time it took in dt.
+ * Assumes the lock is *not* held.  The caller should later pass dt to
+ * record_dt(), with the lock held.
+ */
+AsyncTask::DoneStatus AsyncTask::
+do_task_timed(ClockObject *clock, double &dt) {
+  Thread *current_thread = Thread::get_current_thread();
+  record_task(current_thread);
+
   double start = clock->get_real_time();
   _task_pcollector.start();
   DoneStatus status = do_task();
   _task_pcollector.stop();
   double end = clock->get_real_time();
 
-  // Now reacquire the lock (so we can return with the lock held).
-  _manager->_lock.acquire();
+  clear_task(current_thread);
 
-  _dt = end - start;
+  dt = end - start;
+  return status;
+}
+
+/**
+ * Adds the time taken by one run of the task, as returned by do_task_timed(),
+ * to the task's statistics and to its chain's time in the current frame.
+ * Assumes the lock is held.
+ */
+void AsyncTask::
+record_dt(double dt) {
+  _dt = dt;
   _max_dt = max(_dt, _max_dt);
   _total_dt += _dt;
 
   _chain->_time_in_frame += _dt;
-
-  clear_task(current_thread);
-
-  return status;
 }
 
 /**
@@ -500,3 +526,22 @@ upon_death(AsyncTaskManager *manager, bool clean_exit) {
     throw_event(event);
   }
 }
+
+/**
+ * Calls upon_death(), and then, if the task was started by an
+ * AsyncTaskGraph, tells the graph that the task has finished.  upon_death()
+ * may be called twice for a task that is removed while it is running; the
+ * graph is only told once.
+ *
+ * This function is called with the lock *not* held.
+ */
+void AsyncTask::
+call_upon_death(AsyncTaskManager *manager, bool clean_exit) {
+  upon_death(manager, clean_exit);
+
+  AsyncTaskGraph *graph = (AsyncTaskGraph *)AtomicAdjust::set_ptr
+    ((void * TVOLATILE &)_graph, (void *)NULL);
+  if (graph != (AsyncTaskGraph *)NULL) {
+    graph->task_done(this, clean_exit);
+  }
+}
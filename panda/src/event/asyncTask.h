@@ -23,6 +23,8 @@
 
 class AsyncTaskManager;
 class AsyncTaskChain;
+class AsyncTaskGraph;
+class ClockObject;
 
 /**
  * This class represents a concrete task performed by an AsyncManager.
@@ -101,11 +103,14 @@ PUBLISHED:
 protected:
   void jump_to_task_chain(AsyncTaskManager *manager);
   DoneStatus unlock_and_do_task();
+  DoneStatus do_task_timed(ClockObject *clock, double &dt);
+  void record_dt(double dt);
 
   virtual bool is_runnable();
   virtual DoneStatus do_task();
   virtual void upon_birth(AsyncTaskManager *manager);
   virtual void upon_death(AsyncTaskManager *manager, bool clean_exit);
+  void call_upon_death(AsyncTaskManager *manager, bool clean_exit);
 
 protected:
   AtomicAdjust::Integer _task_id;
@@ -122,6 +127,11 @@ protected:
   AsyncTaskManager *_manager;
   AsyncTaskChain *_chain;
 
+  // The graph that started this task and is waiting for it to finish, if
+  // any.  This holds a reference to the graph.
+  AsyncTaskGraph *_graph;
+  int _graph_index;
+
   double _start_time;
   int _start_frame;
 
@@ -155,6 +165,7 @@ private:
   friend class AsyncTaskManager;
   friend class AsyncTaskChain;
   friend class AsyncTaskSequence;
+  friend class AsyncTaskGraph;
 };
 
 INLINE ostream &operator << (ostream &out, const AsyncTask &task) {
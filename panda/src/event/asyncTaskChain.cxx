@@ -15,6 +15,7 @@
 #include "asyncTaskManager.h"
 #include "event.h"
 #include "mutexHolder.h"
+#include "lightMutexHolder.h"
 #include "indent.h"
 #include "pStatClient.h"
 #include "pStatTimer.h"
@@ -28,6 +29,10 @@ TypeHandle AsyncTaskChain::_type_handle;
 PStatCollector AsyncTaskChain::_task_pcollector("Task");
 PStatCollector AsyncTaskChain::_wait_pcollector("Wait");
 
+// In work-stealing mode, the number of tasks a thread runs before it takes
+// the manager's lock to finish them off.
+static const size_t work_batch_size = 32;
+
 /**
  *
  */
@@ -38,6 +43,7 @@ AsyncTaskChain(AsyncTaskManager *manager, const string &name) :
   _cvar(manager->_lock),
   _tick_clock(false),
   _timeslice_priority(false),
+  _work_stealing(false),
   _num_threads(0),
   _thread_priority(TP_normal),
   _frame_budget(-1.0),
@@ -48,6 +54,8 @@ AsyncTaskChain(AsyncTaskManager *manager, const string &name) :
   _current_sort(-INT_MAX),
   _pickup_mode(false),
   _needs_cleanup(false),
+  _num_claimed(0),
+  _num_queued(0),
   _current_frame(0),
   _time_in_frame(0.0),
   _block_till_next_frame(false)
@@ -250,6 +258,40 @@ get_timeslice_priority() const {
   return _timeslice_priority;
 }
 
+/**
+ * Sets the work_stealing flag.  When this is true and the chain has more than
+ * one thread, the tasks of each sort value are divided among the threads,
+ * which run them without contending for the manager's lock, and idle threads
+ * take tasks from busy ones.  This is much faster for large numbers of short
+ * tasks, at the cost of only running each thread's share of the tasks in
+ * priority order.
+ *
+ * Work stealing is suspended while a frame budget is set, since the budget
+ * must be checked before each task is started.  This may require stopping
+ * the threads if they are already running.
+ */
+void AsyncTaskChain::
+set_work_stealing(bool work_stealing) {
+  MutexHolder holder(_manager->_lock);
+  if (_work_stealing != work_stealing) {
+    do_stop_threads();
+    _work_stealing = work_stealing;
+
+    if (_num_tasks != 0) {
+      do_start_threads();
+    }
+  }
+}
+
+/**
+ * Returns the work_stealing flag.  See set_work_stealing().
+ */
+bool AsyncTaskChain::
+get_work_stealing() const {
+  MutexHolder holder(_manager->_lock);
+  return _work_stealing;
+}
+
 /**
  * Stops any threads that are currently running.  If any tasks are still
  * pending and have not yet been picked up by a thread, they will not be
@@ -465,8 +507,13 @@ do_remove(AsyncTask *task) {
 
   switch (task->_state) {
   case AsyncTask::S_servicing:
-    // This task is being serviced.
-    task->_state = AsyncTask::S_servicing_removed;
+    if (remove_from_work_queues(task)) {
+      // It was only waiting on a work queue; it hasn't started yet.
+      cleanup_task(task, false, false);
+    } else {
+      // This task is being serviced.
+      task->_state = AsyncTask::S_servicing_removed;
+    }
     removed = true;
     break;
 
@@ -595,7 +642,7 @@ do_cleanup() {
   // Now go back and call the upon_death functions.
   _manager->_lock.release();
   for (ti = dead.begin(); ti != dead.end(); ++ti) {
-    (*ti)->upon_death(_manager, false);
+    (*ti)->call_upon_death(_manager, false);
   }
   _manager->_lock.acquire();
 
@@ -671,81 +718,305 @@ service_one_task(AsyncTaskChain::AsyncTaskChainThread *thread) {
     }
     task->_servicing_thread = NULL;
 
-    if (task->_chain == this) {
-      if (task->_state == AsyncTask::S_servicing_removed) {
-        // This task wants to kill itself.
-        cleanup_task(task, true, false);
+    finish_task(task, ds);
 
-      } else if (task->_chain_name != get_name()) {
-        // The task wants to jump to a different chain.
-        PT(AsyncTask) hold_task = task;
-        cleanup_task(task, false, false);
-        task->jump_to_task_chain(_manager);
+    if (task_cat.is_spam()) {
+      task_cat.spam()
+        << "Done servicing " << *task << " in "
+        << *Thread::get_current_thread() << "\n";
+    }
+  }
+  thread_consider_yield();
+}
 
-      } else {
-        switch (ds) {
-        case AsyncTask::DS_cont:
-          // The task is still alive; put it on the next frame's active queue.
-          task->_state = AsyncTask::S_active;
-          _next_active.push_back(task);
-          _cvar.notify_all();
-          break;
-
-        case AsyncTask::DS_again:
-          // The task wants to sleep again.
-          {
-            double now = _manager->_clock->get_frame_time();
-            task->_wake_time = now + task->get_delay();
-            task->_start_time = task->_wake_time;
-            task->_state = AsyncTask::S_sleeping;
-            _sleeping.push_back(task);
-            push_heap(_sleeping.begin(), _sleeping.end(), AsyncTaskSortWakeTime());
-            if (task_cat.is_spam()) {
-              task_cat.spam()
-                << "Sleeping " << *task << ", wake time at "
-                << task->_wake_time - now << "\n";
-            }
-            _cvar.notify_all();
-          }
-          break;
+/**
+ * Called after a task has been run to return it to the appropriate queue
+ * according to its return value, or to remove it from the chain.  Assumes
+ * the lock is held.
+ *
+ * Note that the lock may be temporarily released by this method.
+ */
+void AsyncTaskChain::
+finish_task(AsyncTask *task, AsyncTask::DoneStatus ds) {
+  if (task->_chain == this) {
+    if (task->_state == AsyncTask::S_servicing_removed) {
+      // This task wants to kill itself.
+      cleanup_task(task, true, false);
+
+    } else if (task->_chain_name != get_name()) {
+      // The task wants to jump to a different chain.
+      PT(AsyncTask) hold_task = task;
+      cleanup_task(task, false, false);
+      task->jump_to_task_chain(_manager);
 
-        case AsyncTask::DS_pickup:
-          // The task wants to run again this frame if possible.
-          task->_state = AsyncTask::S_active;
-          _this_active.push_back(task);
-          _cvar.notify_all();
-          break;
-
-        case AsyncTask::DS_interrupt:
-          // The task had an exception and wants to raise a big flag.
-          task->_state = AsyncTask::S_active;
-          _next_active.push_back(task);
-          if (_state == S_started) {
-            _state = S_interrupted;
-            _cvar.notify_all();
+    } else {
+      switch (ds) {
+      case AsyncTask::DS_cont:
+        // The task is still alive; put it on the next frame's active queue.
+        task->_state = AsyncTask::S_active;
+        _next_active.push_back(task);
+        _cvar.notify_all();
+        break;
+
+      case AsyncTask::DS_again:
+        // The task wants to sleep again.
+        {
+          double now = _manager->_clock->get_frame_time();
+          task->_wake_time = now + task->get_delay();
+          task->_start_time = task->_wake_time;
+          task->_state = AsyncTask::S_sleeping;
+          _sleeping.push_back(task);
+          push_heap(_sleeping.begin(), _sleeping.end(), AsyncTaskSortWakeTime());
+          if (task_cat.is_spam()) {
+            task_cat.spam()
+              << "Sleeping " << *task << ", wake time at "
+              << task->_wake_time - now << "\n";
           }
-          break;
-
-        default:
-          // The task has finished.
-          cleanup_task(task, true, true);
+          _cvar.notify_all();
+        }
+        break;
+
+      case AsyncTask::DS_pickup:
+        // The task wants to run again this frame if possible.
+        task->_state = AsyncTask::S_active;
+        _this_active.push_back(task);
+        _cvar.notify_all();
+        break;
+
+      case AsyncTask::DS_interrupt:
+        // The task had an exception and wants to raise a big flag.
+        task->_state = AsyncTask::S_active;
+        _next_active.push_back(task);
+        if (_state == S_started) {
+          _state = S_interrupted;
+          _cvar.notify_all();
         }
+        break;
+
+      default:
+        // The task has finished.
+        cleanup_task(task, true, true);
       }
-    } else {
-      task_cat.error()
-        << "Task is no longer on chain " << get_name()
-        << ": " << *task << "\n";
     }
+  } else {
+    task_cat.error()
+      << "Task is no longer on chain " << get_name()
+      << ": " << *task << "\n";
+  }
+}
 
-    if (task_cat.is_spam()) {
-      task_cat.spam()
-        << "Done servicing " << *task << " in "
-        << *Thread::get_current_thread() << "\n";
+/**
+ * Moves all of the tasks with the current sort value from the active queue
+ * to the work queues, in work-stealing mode.  The tasks are dealt out in
+ * priority order, so that each thread starts with the most important of its
+ * share.  Assumes the lock is held.
+ */
+void AsyncTaskChain::
+distribute_work() {
+  size_t num_queues = _work_queues.size();
+  nassertv(num_queues != 0);
+
+  pvector<TaskHeap> hands(num_queues);
+  size_t qi = 0;
+  int num_tasks = 0;
+  while (!_active.empty() && _active.front()->get_sort() == _current_sort) {
+    PT(AsyncTask) task = _active.front();
+    pop_heap(_active.begin(), _active.end(), AsyncTaskSortPriority());
+    _active.pop_back();
+
+    nassertd(task->_state == AsyncTask::S_active) continue;
+    task->_state = AsyncTask::S_servicing;
+    hands[qi].push_back(task);
+    qi = (qi + 1) % num_queues;
+    ++num_tasks;
+  }
+
+  _num_claimed += num_tasks;
+  AtomicAdjust::add(_num_queued, num_tasks);
+
+  for (qi = 0; qi < num_queues; ++qi) {
+    WorkQueue *queue = _work_queues[qi];
+    LightMutexHolder holder(queue->_lock);
+    queue->_tasks.insert(queue->_tasks.end(), hands[qi].begin(), hands[qi].end());
+  }
+
+  // Wake up the idle threads to take their share.
+  _cvar.notify_all();
+}
+
+/**
+ * The work-stealing counterpart of service_one_task(): runs tasks from the
+ * indicated thread's work queue, or stolen from the other threads' queues,
+ * with the lock released, and then finishes them all with the lock held
+ * again.  Assumes the lock is already held.
+ *
+ * Note that the lock may be temporarily released by this method.
+ */
+void AsyncTaskChain::
+service_work_queues(AsyncTaskChain::AsyncTaskChainThread *thread) {
+  if (!_active.empty() && _active.front()->get_sort() == _current_sort) {
+    distribute_work();
+  }
+
+  PT(ClockObject) clock = _manager->get_clock();
+  WorkQueue *queue = _work_queues[thread->_index];
+
+  _manager->_lock.release();
+
+  size_t num_run = 0;
+  PT(AsyncTask) task = pop_work(thread);
+  while (task != (AsyncTask *)NULL) {
+    DoneTask done;
+    done._status = task->do_task_timed(clock, done._dt);
+    done._task = task;
+    task = NULL;
+    {
+      LightMutexHolder holder(queue->_lock);
+      thread->_servicing = NULL;
+      queue->_done.push_back(done);
     }
+    if (++num_run >= work_batch_size) {
+      break;
+    }
+    task = pop_work(thread);
   }
+
+  _manager->_lock.acquire();
+
+  DoneTasks done;
+  {
+    LightMutexHolder holder(queue->_lock);
+    done.swap(queue->_done);
+  }
+
+  DoneTasks::iterator di;
+  for (di = done.begin(); di != done.end(); ++di) {
+    AsyncTask *task = (*di)._task;
+    --_num_claimed;
+    task->record_dt((*di)._dt);
+    finish_task(task, (*di)._status);
+  }
+
   thread_consider_yield();
 }
 
+/**
+ * Removes and returns the next task from the indicated thread's work queue,
+ * or, if that is empty, steals one from another thread's queue.  Returns
+ * NULL if there are no tasks left on any queue.  The lock need not be held.
+ */
+PT(AsyncTask) AsyncTaskChain::
+pop_work(AsyncTaskChain::AsyncTaskChainThread *thread) {
+  size_t num_queues = _work_queues.size();
+  for (size_t i = 0; i < num_queues; ++i) {
+    if (AtomicAdjust::get(_num_queued) == 0) {
+      break;
+    }
+
+    WorkQueue *queue = _work_queues[(thread->_index + i) % num_queues];
+    LightMutexHolder holder(queue->_lock);
+    if (!queue->_tasks.empty()) {
+      PT(AsyncTask) task;
+      if (i == 0) {
+        task = queue->_tasks.front();
+        queue->_tasks.pop_front();
+      } else {
+        task = queue->_tasks.back();
+        queue->_tasks.pop_back();
+      }
+      thread->_servicing = task;
+      AtomicAdjust::dec(_num_queued);
+      return task;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * Removes the indicated task from the work queue it is waiting on, if any.
+ * Returns true if it was removed, false if it was not found on any work
+ * queue, which means it has already been picked up by a thread.  Assumes the
+ * lock is held.
+ */
+bool AsyncTaskChain::
+remove_from_work_queues(AsyncTask *task) {
+  WorkQueues::iterator qi;
+  for (qi = _work_queues.begin(); qi != _work_queues.end(); ++qi) {
+    WorkQueue *queue = (*qi);
+    LightMutexHolder holder(queue->_lock);
+    pdeque< PT(AsyncTask) >::iterator ti =
+      find(queue->_tasks.begin(), queue->_tasks.end(), task);
+    if (ti != queue->_tasks.end()) {
+      queue->_tasks.erase(ti);
+      AtomicAdjust::dec(_num_queued);
+      --_num_claimed;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * Moves any tasks that are still waiting on the work queues back to the
+ * active queue, as when the threads are stopped.  Tasks that have already
+ * been picked up by a thread are not affected.  Assumes the lock is held.
+ */
+void AsyncTaskChain::
+reclaim_work_queues() {
+  WorkQueues::iterator qi;
+  for (qi = _work_queues.begin(); qi != _work_queues.end(); ++qi) {
+    WorkQueue *queue = (*qi);
+    LightMutexHolder holder(queue->_lock);
+    while (!queue->_tasks.empty()) {
+      PT(AsyncTask) task = queue->_tasks.front();
+      queue->_tasks.pop_front();
+      AtomicAdjust::dec(_num_queued);
+      --_num_claimed;
+
+      task->_state = AsyncTask::S_active;
+      _active.push_back(task);
+      push_heap(_active.begin(), _active.end(), AsyncTaskSortPriority());
+    }
+  }
+
+  _cvar.notify_all();
+}
+
+/**
+ * Adds the tasks that the threads are currently running to the indicated
+ * list, along with, in work-stealing mode, the tasks that are waiting on the
+ * work queues or waiting to be finished.  Assumes the lock is held.
+ */
+void AsyncTaskChain::
+get_servicing_tasks(TaskHeap &tasks) const {
+  // In work-stealing mode, the threads' _servicing pointers are protected by
+  // the work queue locks, so we must hold all of them.
+  WorkQueues::const_iterator qi;
+  for (qi = _work_queues.begin(); qi != _work_queues.end(); ++qi) {
+    (*qi)->_lock.acquire();
+  }
+
+  Threads::const_iterator thi;
+  for (thi = _threads.begin(); thi != _threads.end(); ++thi) {
+    AsyncTask *task = (*thi)->_servicing;
+    if (task != (AsyncTask *)NULL) {
+      tasks.push_back(task);
+    }
+  }
+
+  for (qi = _work_queues.begin(); qi != _work_queues.end(); ++qi) {
+    WorkQueue *queue = (*qi);
+    tasks.insert(tasks.end(), queue->_tasks.begin(), queue->_tasks.end());
+    DoneTasks::const_iterator di;
+    for (di = queue->_done.begin(); di != queue->_done.end(); ++di) {
+      tasks.push_back((*di)._task);
+    }
+    queue->_lock.release();
+  }
+}
+
 /**
  * Called internally when a task has completed (or been interrupted) and is
  * about to be removed from the active queue.  Assumes the lock is held.
@@ -777,7 +1048,7 @@ cleanup_task(AsyncTask *task, bool upon_death, bool clean_exit) {
 
   if (upon_death) {
     _manager->_lock.release();
-    task->upon_death(_manager, clean_exit);
+    task->call_upon_death(_manager, clean_exit);
     _manager->_lock.acquire();
   }
 }
@@ -793,6 +1064,7 @@ cleanup_task(AsyncTask *task, bool upon_death, bool clean_exit) {
 bool AsyncTaskChain::
 finish_sort_group() {
   nassertr(_num_busy_threads == 0, true);
+  nassertr(_num_claimed == 0, true);
 
   if (!_threads.empty()) {
     PStatClient::thread_tick(get_name());
@@ -1033,6 +1305,15 @@ do_stop_threads() {
     }
     _manager->_lock.acquire();
 
+    // Any tasks that were handed to the threads but not picked up go back on
+    // the active queue.
+    reclaim_work_queues();
+    WorkQueues::iterator qi;
+    for (qi = _work_queues.begin(); qi != _work_queues.end(); ++qi) {
+      delete (*qi);
+    }
+    _work_queues.clear();
+
     _state = S_initial;
 
     // There might be one busy "thread" still: the main thread.
@@ -1065,10 +1346,20 @@ do_start_threads() {
         ostringstream strm;
         strm << _manager->get_name() << "_" << get_name() << "_" << i;
         PT(AsyncTaskChainThread) thread = new AsyncTaskChainThread(strm.str(), this);
+        thread->_index = (int)_threads.size();
         if (thread->start(_thread_priority, true)) {
           _threads.push_back(thread);
         }
       }
+
+      // The threads can't look at the work queues until we release the lock,
+      // so it's safe to create them now.
+      if (_work_stealing && _threads.size() > 1) {
+        _work_queues.reserve(_threads.size());
+        for (size_t i = 0; i < _threads.size(); ++i) {
+          _work_queues.push_back(new WorkQueue);
+        }
+      }
     }
   }
 }
@@ -1081,14 +1372,13 @@ AsyncTaskCollection AsyncTaskChain::
 do_get_active_tasks() const {
   AsyncTaskCollection result;
 
-  Threads::const_iterator thi;
-  for (thi = _threads.begin(); thi != _threads.end(); ++thi) {
-    AsyncTask *task = (*thi)->_servicing;
-    if (task != (AsyncTask *)NULL) {
-      result.add_task(task);
-    }
-  }
+  TaskHeap servicing;
+  get_servicing_tasks(servicing);
   TaskHeap::const_iterator ti;
+  for (ti = servicing.begin(); ti != servicing.end(); ++ti) {
+    AsyncTask *task = (*ti);
+    result.add_task(task);
+  }
   for (ti = _active.begin(); ti != _active.end(); ++ti) {
     AsyncTask *task = (*ti);
     result.add_task(task);
@@ -1242,6 +1532,10 @@ do_write(ostream &out, int indent_level) const {
     indent(out, indent_level + 2)
       << "timeslice priority\n";
   }
+  if (_work_stealing) {
+    indent(out, indent_level + 2)
+      << "work stealing\n";
+  }
   if (_tick_clock) {
     indent(out, indent_level + 2)
       << "tick clock\n";
@@ -1270,13 +1564,7 @@ do_write(ostream &out, int indent_level) const {
   tasks.insert(tasks.end(), _this_active.begin(), _this_active.end());
   tasks.insert(tasks.end(), _next_active.begin(), _next_active.end());
 
-  Threads::const_iterator thi;
-  for (thi = _threads.begin(); thi != _threads.end(); ++thi) {
-    AsyncTask *task = (*thi)->_servicing;
-    if (task != (AsyncTask *)NULL) {
-      tasks.push_back(task);
-    }
-  }
+  get_servicing_tasks(tasks);
 
   double now = _manager->_clock->get_frame_time();
 
@@ -1364,7 +1652,8 @@ AsyncTaskChain::AsyncTaskChainThread::
 AsyncTaskChainThread(const string &name, AsyncTaskChain *chain) :
   Thread(name, chain->get_name()),
   _chain(chain),
-  _servicing(NULL)
+  _servicing(NULL),
+  _index(0)
 {
 }
 
@@ -1376,8 +1665,15 @@ thread_main() {
   MutexHolder holder(_chain->_manager->_lock);
   while (_chain->_state != S_shutdown && _chain->_state != S_interrupted) {
     thread_consider_yield();
-    if (!_chain->_active.empty() &&
-        _chain->_active.front()->get_sort() == _chain->_current_sort) {
+    if (_chain->_frame_budget >= 0.0 && AtomicAdjust::get(_chain->_num_queued) != 0) {
+      // A frame budget has been set since the tasks were handed out.  The
+      // budget must be checked before each task, so take them back.
+      _chain->reclaim_work_queues();
+    }
+
+    if ((!_chain->_active.empty() &&
+         _chain->_active.front()->get_sort() == _chain->_current_sort) ||
+        AtomicAdjust::get(_chain->_num_queued) != 0) {
 
       int frame = _chain->_manager->_clock->get_frame_count();
       if (_chain->_current_frame != frame) {
@@ -1407,7 +1703,11 @@ thread_main() {
 
       PStatTimer timer(_task_pcollector);
       _chain->_num_busy_threads++;
-      _chain->service_one_task(this);
+      if (_chain->_work_queues.empty() || _chain->_frame_budget >= 0.0) {
+        _chain->service_one_task(this);
+      } else {
+        _chain->service_work_queues(this);
+      }
       _chain->_num_busy_threads--;
       _chain->_cvar.notify_all();
 
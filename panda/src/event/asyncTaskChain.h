@@ -21,6 +21,8 @@
 #include "typedReferenceCount.h"
 #include "thread.h"
 #include "conditionVarFull.h"
+#include "lightMutex.h"
+#include "atomicAdjust.h"
 #include "pvector.h"
 #include "pdeque.h"
 #include "pStatCollector.h"
@@ -46,6 +48,13 @@ class AsyncTaskManager;
  * parallelism.  Tasks with different sort values are never run in parallel
  * together, but tasks with different priority values might be (if there is
  * more than one thread).
+ *
+ * If work stealing is enabled on a chain with more than one thread, each
+ * group of tasks with the same sort value is dealt out to the threads in
+ * priority order, and each thread runs its own tasks without taking the
+ * manager's lock, taking tasks from the other threads when it runs out.  This
+ * scales much better when there are many short tasks, but priority order is
+ * then only kept among the tasks given to each thread.
  */
 class EXPCL_PANDA_EVENT AsyncTaskChain : public TypedReferenceCount, public Namable {
 public:
@@ -72,6 +81,9 @@ PUBLISHED:
   void set_timeslice_priority(bool timeslice_priority);
   bool get_timeslice_priority() const;
 
+  BLOCKING void set_work_stealing(bool work_stealing);
+  bool get_work_stealing() const;
+
   BLOCKING void stop_threads();
   void start_threads();
   INLINE bool is_started() const;
@@ -104,6 +116,13 @@ protected:
   int find_task_on_heap(const TaskHeap &heap, AsyncTask *task) const;
 
   void service_one_task(AsyncTaskChainThread *thread);
+  void finish_task(AsyncTask *task, AsyncTask::DoneStatus ds);
+  void distribute_work();
+  void service_work_queues(AsyncTaskChainThread *thread);
+  PT(AsyncTask) pop_work(AsyncTaskChainThread *thread);
+  bool remove_from_work_queues(AsyncTask *task);
+  void reclaim_work_queues();
+  void get_servicing_tasks(TaskHeap &tasks) const;
   void cleanup_task(AsyncTask *task, bool upon_death, bool clean_exit);
   bool finish_sort_group();
   void filter_timeslice_priority();
@@ -128,6 +147,26 @@ protected:
 
     AsyncTaskChain *_chain;
     AsyncTask *_servicing;
+    int _index;
+  };
+
+  class DoneTask {
+  public:
+    PT(AsyncTask) _task;
+    AsyncTask::DoneStatus _status;
+    double _dt;
+  };
+  typedef pvector<DoneTask> DoneTasks;
+
+  // The tasks handed to one thread in work-stealing mode.  The owning thread
+  // takes tasks from the front; other threads steal from the back.  Tasks
+  // that have been run wait on _done until the owning thread next holds the
+  // manager's lock.
+  class WorkQueue {
+  public:
+    LightMutex _lock;
+    pdeque< PT(AsyncTask) > _tasks;
+    DoneTasks _done;
   };
 
   class AsyncTaskSortWakeTime {
@@ -151,6 +190,7 @@ protected:
   };
 
   typedef pvector< PT(AsyncTaskChainThread) > Threads;
+  typedef pvector<WorkQueue *> WorkQueues;
 
   AsyncTaskManager *_manager;
 
@@ -165,6 +205,7 @@ protected:
 
   bool _tick_clock;
   bool _timeslice_priority;
+  bool _work_stealing;
   int _num_threads;
   ThreadPriority _thread_priority;
   Threads _threads;
@@ -181,6 +222,13 @@ protected:
   bool _pickup_mode;
   bool _needs_cleanup;
 
+  // In work-stealing mode, the tasks that have been moved from _active to
+  // the work queues and not yet finished, and the number of those that are
+  // still waiting on the queues.
+  WorkQueues _work_queues;
+  int _num_claimed;
+  AtomicAdjust::Integer _num_queued;
+
   int _current_frame;
   double _time_in_frame;
   bool _block_till_next_frame;
@@ -0,0 +1,523 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file asyncTaskGraph.cxx
+ * @date 2026-10-18
+ */
+
+#include "asyncTaskGraph.h"
+#include "asyncTaskManager.h"
+#include "config_event.h"
+#include "mutexHolder.h"
+#include "clockObject.h"
+#include "indent.h"
+#include "atomicAdjust.h"
+
+TypeHandle AsyncTaskGraph::_type_handle;
+
+PStatCollector AsyncTaskGraph::_graph_pcollector("Task graph");
+
+/**
+ *
+ */
+AsyncTaskGraph::
+AsyncTaskGraph(const string &name) :
+  Namable(name),
+  _cvar(_lock),
+  _running(false),
+  _num_remaining(0),
+  _num_failed(0),
+  _start_time(0.0),
+  _elapsed_time(0.0),
+  _critical_path_time(0.0),
+  _critical_path_end(-1)
+{
+  PStatCollector graph_pcollector(_graph_pcollector, name.empty() ? "graph" : name);
+  _elapsed_pcollector = PStatCollector(graph_pcollector, "Elapsed");
+  _critical_path_pcollector = PStatCollector(graph_pcollector, "Critical path");
+}
+
+/**
+ *
+ */
+AsyncTaskGraph::
+~AsyncTaskGraph() {
+  // The tasks hold a reference to the graph while it is running.
+  nassertv(!_running);
+}
+
+/**
+ * Adds the indicated task to the graph, if it is not already there.  It is
+ * an error to modify the graph while it is running.
+ */
+void AsyncTaskGraph::
+add_task(AsyncTask *task) {
+  MutexHolder holder(_lock);
+  nassertv(!_running);
+  do_add_task(task);
+}
+
+/**
+ * Records that the indicated task may not be started until the prerequisite
+ * task has finished.  Either task is added to the graph if it is not already
+ * there.  It is an error to modify the graph while it is running.
+ */
+void AsyncTaskGraph::
+add_dependency(AsyncTask *task, AsyncTask *prerequisite) {
+  MutexHolder holder(_lock);
+  nassertv(!_running);
+  nassertv(task != prerequisite);
+
+  int n = do_add_task(task);
+  int p = do_add_task(prerequisite);
+  nassertv(n != -1 && p != -1);
+
+  Node &node = _nodes[n];
+  if (find(node._prerequisites.begin(), node._prerequisites.end(), p) ==
+      node._prerequisites.end()) {
+    node._prerequisites.push_back(p);
+    _nodes[p]._dependents.push_back(n);
+  }
+}
+
+/**
+ * Returns the number of tasks in the graph.
+ */
+int AsyncTaskGraph::
+get_num_tasks() const {
+  MutexHolder holder(_lock);
+  return _nodes.size();
+}
+
+/**
+ * Returns the nth task in the graph, in the order they were added.
+ */
+AsyncTask *AsyncTaskGraph::
+get_task(int n) const {
+  MutexHolder holder(_lock);
+  nassertr(n >= 0 && n < (int)_nodes.size(), NULL);
+  return _nodes[n]._task;
+}
+
+/**
+ * Returns the tasks that must finish before the indicated task may start.
+ */
+AsyncTaskCollection AsyncTaskGraph::
+get_prerequisites(AsyncTask *task) const {
+  MutexHolder holder(_lock);
+  AsyncTaskCollection result;
+
+  int n = find_node(task);
+  if (n != -1) {
+    const Node &node = _nodes[n];
+    pvector<int>::const_iterator pi;
+    for (pi = node._prerequisites.begin(); pi != node._prerequisites.end(); ++pi) {
+      result.add_task(_nodes[*pi]._task);
+    }
+  }
+  return result;
+}
+
+/**
+ * Removes all of the tasks from the graph.  It is an error to call this while
+ * the graph is running.
+ */
+void AsyncTaskGraph::
+clear() {
+  MutexHolder holder(_lock);
+  nassertv(!_running);
+  _nodes.clear();
+  _order.clear();
+  _critical_path_end = -1;
+}
+
+/**
+ * Starts running the graph on the indicated AsyncTaskManager.  The tasks
+ * that have no prerequisites are added to the manager immediately; the rest
+ * are added as their prerequisites finish.  Returns true on success, or
+ * false if the graph is already running or the dependencies form a cycle.
+ *
+ * The graph may be started again once it has finished.
+ */
+bool AsyncTaskGraph::
+start(AsyncTaskManager *manager) {
+  nassertr(manager != (AsyncTaskManager *)NULL, false);
+
+  pvector< PT(AsyncTask) > ready;
+  {
+    MutexHolder holder(_lock);
+    nassertr(!_running, false);
+
+    if (!sort_nodes()) {
+      task_cat.error()
+        << "Dependencies of " << *this << " form a cycle.\n";
+      return false;
+    }
+
+    Nodes::iterator ni;
+    for (ni = _nodes.begin(); ni != _nodes.end(); ++ni) {
+      AsyncTask *task = (*ni)._task;
+      nassertr(task->_state == AsyncTask::S_inactive &&
+               task->_graph == (AsyncTaskGraph *)NULL, false);
+    }
+
+    _manager = manager;
+    _running = true;
+    _num_remaining = _nodes.size();
+    _num_failed = 0;
+    _start_time = manager->get_clock()->get_real_time();
+    _critical_path_end = -1;
+
+    for (size_t i = 0; i < _nodes.size(); ++i) {
+      Node &node = _nodes[i];
+      AsyncTask *task = node._task;
+      node._num_pending = node._prerequisites.size();
+      node._done = false;
+      node._failed = false;
+      node._start_total_dt = task->_total_dt;
+      node._run_time = 0.0;
+
+      // Each task holds a reference to the graph until it finishes.
+      ref();
+      task->_graph_index = (int)i;
+      AtomicAdjust::set_ptr((void * TVOLATILE &)task->_graph, (void *)this);
+
+      if (node._num_pending == 0) {
+        ready.push_back(task);
+      }
+    }
+
+    if (_num_remaining == 0) {
+      finish_run();
+      return true;
+    }
+  }
+
+  pvector< PT(AsyncTask) >::iterator ti;
+  for (ti = ready.begin(); ti != ready.end(); ++ti) {
+    manager->add(*ti);
+  }
+  return true;
+}
+
+/**
+ * Returns true if the graph has been started and not all of its tasks have
+ * finished yet.
+ */
+bool AsyncTaskGraph::
+is_running() const {
+  MutexHolder holder(_lock);
+  return _running;
+}
+
+/**
+ * Blocks until all of the tasks in the graph have finished.  Returns
+ * immediately if the graph is not running.
+ *
+ * The tasks must be serviced by other threads, or by another thread calling
+ * AsyncTaskManager::poll(), while this thread waits.
+ */
+void AsyncTaskGraph::
+wait() {
+  MutexHolder holder(_lock);
+  while (_running) {
+    _cvar.wait();
+  }
+}
+
+/**
+ * Returns the number of tasks that did not finish cleanly in the last run of
+ * the graph, including those that were never started because a task they
+ * depend on did not finish cleanly.
+ */
+int AsyncTaskGraph::
+get_num_failed() const {
+  MutexHolder holder(_lock);
+  return _num_failed;
+}
+
+/**
+ * Returns the time in seconds from the start of the last run of the graph to
+ * the finish of its last task.
+ */
+double AsyncTaskGraph::
+get_elapsed_time() const {
+  MutexHolder holder(_lock);
+  return _elapsed_time;
+}
+
+/**
+ * Returns the total running time, in seconds, of the tasks along the longest
+ * path through the graph in its last run.  This is the least time the graph
+ * could take to run with unlimited threads; if it is much less than
+ * get_elapsed_time(), the graph is being held up by the available threads or
+ * by the tasks waiting for their turn on the chain.
+ */
+double AsyncTaskGraph::
+get_critical_path_time() const {
+  MutexHolder holder(_lock);
+  return _critical_path_time;
+}
+
+/**
+ * Returns the tasks along the longest path through the graph in its last
+ * run, in the order they ran.  See get_critical_path_time().
+ */
+AsyncTaskCollection AsyncTaskGraph::
+get_critical_path() const {
+  MutexHolder holder(_lock);
+
+  pvector<int> path;
+  for (int n = _critical_path_end; n != -1; n = _nodes[n]._path_prev) {
+    path.push_back(n);
+  }
+
+  AsyncTaskCollection result;
+  pvector<int>::reverse_iterator pi;
+  for (pi = path.rbegin(); pi != path.rend(); ++pi) {
+    result.add_task(_nodes[*pi]._task);
+  }
+  return result;
+}
+
+/**
+ *
+ */
+void AsyncTaskGraph::
+output(ostream &out) const {
+  out << get_type() << " " << get_name();
+}
+
+/**
+ *
+ */
+void AsyncTaskGraph::
+write(ostream &out, int indent_level) const {
+  MutexHolder holder(_lock);
+  indent(out, indent_level)
+    << get_type() << " " << get_name() << ", " << _nodes.size()
+    << " tasks";
+  if (_running) {
+    out << ", running, " << _num_remaining << " remaining";
+  }
+  out << "\n";
+
+  Nodes::const_iterator ni;
+  for (ni = _nodes.begin(); ni != _nodes.end(); ++ni) {
+    const Node &node = (*ni);
+    indent(out, indent_level + 2)
+      << *node._task;
+    if (!node._prerequisites.empty()) {
+      out << " after";
+      pvector<int>::const_iterator pi;
+      for (pi = node._prerequisites.begin(); pi != node._prerequisites.end(); ++pi) {
+        out << " " << _nodes[*pi]._task->get_name();
+      }
+    }
+    out << "\n";
+  }
+}
+
+/**
+ * Called by AsyncTask when a task belonging to the graph is removed from its
+ * manager.  Starts any tasks that were only waiting for this one.  This
+ * function is called with the manager's lock *not* held.
+ */
+void AsyncTaskGraph::
+task_done(AsyncTask *task, bool clean_exit) {
+  pvector< PT(AsyncTask) > ready;
+  PT(AsyncTaskManager) manager;
+  {
+    MutexHolder holder(_lock);
+    nassertv(_running);
+
+    int n = task->_graph_index;
+    nassertv(n >= 0 && n < (int)_nodes.size() && _nodes[n]._task == task);
+    Node &node = _nodes[n];
+    nassertv(!node._done);
+
+    if (!clean_exit) {
+      fail_node(n);
+
+    } else {
+      node._done = true;
+      node._run_time = task->_total_dt - node._start_total_dt;
+      --_num_remaining;
+
+      pvector<int>::const_iterator di;
+      for (di = node._dependents.begin(); di != node._dependents.end(); ++di) {
+        Node &dependent = _nodes[*di];
+        --dependent._num_pending;
+        if (dependent._num_pending == 0 && !dependent._done) {
+          ready.push_back(dependent._task);
+        }
+      }
+    }
+
+    manager = _manager;
+    if (_num_remaining == 0) {
+      finish_run();
+    }
+  }
+
+  pvector< PT(AsyncTask) >::iterator ti;
+  for (ti = ready.begin(); ti != ready.end(); ++ti) {
+    manager->add(*ti);
+  }
+
+  // Release the reference the task held while it was running.
+  unref_delete(this);
+}
+
+/**
+ * Returns the index of the node for the indicated task, or -1 if the task is
+ * not part of the graph.  Assumes the lock is held.
+ */
+int AsyncTaskGraph::
+find_node(AsyncTask *task) const {
+  for (int i = 0; i < (int)_nodes.size(); ++i) {
+    if (_nodes[i]._task == task) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/**
+ * The private implementation of add_task().  Returns the index of the new or
+ * existing node for the task.  Assumes the lock is held.
+ */
+int AsyncTaskGraph::
+do_add_task(AsyncTask *task) {
+  nassertr(task != (AsyncTask *)NULL, -1);
+  int n = find_node(task);
+  if (n == -1) {
+    n = (int)_nodes.size();
+    _nodes.push_back(Node());
+    Node &node = _nodes.back();
+    node._task = task;
+    node._num_pending = 0;
+    node._done = false;
+    node._failed = false;
+    node._start_total_dt = 0.0;
+    node._run_time = 0.0;
+    node._path_time = 0.0;
+    node._path_prev = -1;
+  }
+  return n;
+}
+
+/**
+ * Fills _order with the nodes sorted so that each comes after all of its
+ * prerequisites.  Returns false if this is not possible because the
+ * dependencies form a cycle.  Assumes the lock is held.
+ */
+bool AsyncTaskGraph::
+sort_nodes() {
+  size_t num_nodes = _nodes.size();
+  pvector<int> num_pending(num_nodes);
+
+  _order.clear();
+  _order.reserve(num_nodes);
+  for (size_t i = 0; i < num_nodes; ++i) {
+    num_pending[i] = _nodes[i]._prerequisites.size();
+    if (num_pending[i] == 0) {
+      _order.push_back((int)i);
+    }
+  }
+
+  // _order doubles as the queue of nodes whose prerequisites are all placed.
+  for (size_t oi = 0; oi < _order.size(); ++oi) {
+    const Node &node = _nodes[_order[oi]];
+    pvector<int>::const_iterator di;
+    for (di = node._dependents.begin(); di != node._dependents.end(); ++di) {
+      if (--num_pending[*di] == 0) {
+        _order.push_back(*di);
+      }
+    }
+  }
+
+  return _order.size() == num_nodes;
+}
+
+/**
+ * Marks the indicated node as failed, along with all of the nodes that
+ * depend on it, which will now never be started.  Assumes the lock is held.
+ */
+void AsyncTaskGraph::
+fail_node(int n) {
+  Node &node = _nodes[n];
+  if (node._done) {
+    return;
+  }
+
+  node._done = true;
+  node._failed = true;
+  --_num_remaining;
+  ++_num_failed;
+
+  if (node._num_pending != 0) {
+    // This task was never started, so it won't be calling task_done(); we
+    // must release its reference to the graph ourselves.  The task that
+    // called task_done() still holds one, so this can't be the last.
+    AtomicAdjust::set_ptr((void * TVOLATILE &)node._task->_graph, (void *)NULL);
+    unref();
+  }
+
+  pvector<int>::const_iterator di;
+  for (di = node._dependents.begin(); di != node._dependents.end(); ++di) {
+    fail_node(*di);
+  }
+}
+
+/**
+ * Called when the last task of a run has finished.  Computes the critical
+ * path and reports the timings.  Assumes the lock is held.
+ */
+void AsyncTaskGraph::
+finish_run() {
+  nassertv(_running);
+
+  _elapsed_time = _manager->get_clock()->get_real_time() - _start_time;
+
+  _critical_path_time = 0.0;
+  _critical_path_end = -1;
+  pvector<int>::const_iterator oi;
+  for (oi = _order.begin(); oi != _order.end(); ++oi) {
+    Node &node = _nodes[*oi];
+    node._path_time = 0.0;
+    node._path_prev = -1;
+    pvector<int>::const_iterator pi;
+    for (pi = node._prerequisites.begin(); pi != node._prerequisites.end(); ++pi) {
+      if (_nodes[*pi]._path_time > node._path_time || node._path_prev == -1) {
+        node._path_time = _nodes[*pi]._path_time;
+        node._path_prev = *pi;
+      }
+    }
+    node._path_time += node._run_time;
+
+    if (node._path_time > _critical_path_time || _critical_path_end == -1) {
+      _critical_path_time = node._path_time;
+      _critical_path_end = *oi;
+    }
+  }
+
+  _elapsed_pcollector.set_level(_elapsed_time);
+  _critical_path_pcollector.set_level(_critical_path_time);
+
+  if (task_cat.is_debug()) {
+    task_cat.debug()
+      << *this << " finished in " << _elapsed_time * 1000.0
+      << " ms, critical path " << _critical_path_time * 1000.0 << " ms, "
+      << _num_failed << " failed\n";
+  }
+
+  _manager = NULL;
+  _running = false;
+  _cvar.notify_all();
+}
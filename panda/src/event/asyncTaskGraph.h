@@ -0,0 +1,148 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file asyncTaskGraph.h
+ * @date 2026-10-18
+ */
+
+#ifndef ASYNCTASKGRAPH_H
+#define ASYNCTASKGRAPH_H
+
+#include "pandabase.h"
+
+#include "asyncTask.h"
+#include "asyncTaskCollection.h"
+#include "typedReferenceCount.h"
+#include "namable.h"
+#include "pmutex.h"
+#include "conditionVarFull.h"
+#include "pStatCollector.h"
+#include "pvector.h"
+
+class AsyncTaskManager;
+
+/**
+ * A set of tasks with dependencies between them.  When the graph is started,
+ * the tasks that depend on nothing are added to the AsyncTaskManager, and
+ * each other task is added as soon as all of the tasks it depends on have
+ * finished.  The tasks run on whatever task chains they name, so independent
+ * tasks may run in parallel on the threads of a chain.
+ *
+ * A task counts as finished when it is removed from the manager, normally by
+ * returning DS_done.  If a task is removed for any other reason, the tasks
+ * that depend on it are never run, and are counted as failed.
+ *
+ * A task that is added to a chain while that chain is running tasks with a
+ * higher sort value waits for the next epoch, so the tasks in a graph should
+ * usually all have the same sort value.  A task may belong to only one
+ * running graph at a time, and must not be added to the manager separately.
+ *
+ * When all of the tasks have finished, the time taken along the longest path
+ * through the graph, counting the time each task spent running, is available
+ * from get_critical_path_time(), and is reported to PStats along with the
+ * elapsed time, under "Task graph".
+ */
+class EXPCL_PANDA_EVENT AsyncTaskGraph : public TypedReferenceCount, public Namable {
+PUBLISHED:
+  explicit AsyncTaskGraph(const string &name = string());
+  virtual ~AsyncTaskGraph();
+
+  void add_task(AsyncTask *task);
+  void add_dependency(AsyncTask *task, AsyncTask *prerequisite);
+  int get_num_tasks() const;
+  AsyncTask *get_task(int n) const;
+  MAKE_SEQ(get_tasks, get_num_tasks, get_task);
+  AsyncTaskCollection get_prerequisites(AsyncTask *task) const;
+  void clear();
+
+  bool start(AsyncTaskManager *manager);
+  bool is_running() const;
+  BLOCKING void wait();
+
+  int get_num_failed() const;
+  double get_elapsed_time() const;
+  double get_critical_path_time() const;
+  AsyncTaskCollection get_critical_path() const;
+
+  virtual void output(ostream &out) const;
+  virtual void write(ostream &out, int indent_level = 0) const;
+
+public:
+  void task_done(AsyncTask *task, bool clean_exit);
+
+private:
+  int find_node(AsyncTask *task) const;
+  int do_add_task(AsyncTask *task);
+  bool sort_nodes();
+  void fail_node(int n);
+  void finish_run();
+
+  class Node {
+  public:
+    PT(AsyncTask) _task;
+    pvector<int> _prerequisites;
+    pvector<int> _dependents;
+
+    int _num_pending;
+    bool _done;
+    bool _failed;
+    double _start_total_dt;
+    double _run_time;
+
+    // The time along the longest path ending at this node, and the previous
+    // node on that path, or -1.
+    double _path_time;
+    int _path_prev;
+  };
+  typedef pvector<Node> Nodes;
+  Nodes _nodes;
+
+  // The nodes in an order in which each comes after its prerequisites.
+  pvector<int> _order;
+
+  Mutex _lock;
+  ConditionVarFull _cvar;
+
+  PT(AsyncTaskManager) _manager;
+  bool _running;
+  int _num_remaining;
+  int _num_failed;
+  double _start_time;
+  double _elapsed_time;
+  double _critical_path_time;
+  int _critical_path_end;
+
+  PStatCollector _elapsed_pcollector;
+  PStatCollector _critical_path_pcollector;
+
+  static PStatCollector _graph_pcollector;
+
+public:
+  static TypeHandle get_class_type() {
+    return _type_handle;
+  }
+  static void init_type() {
+    TypedReferenceCount::init_type();
+    register_type(_type_handle, "AsyncTaskGraph",
+                  TypedReferenceCount::get_class_type());
+  }
+  virtual TypeHandle get_type() const {
+    return get_class_type();
+  }
+  virtual TypeHandle force_init_type() {init_type(); return get_class_type();}
+
+private:
+  static TypeHandle _type_handle;
+};
+
+INLINE ostream &operator << (ostream &out, const AsyncTaskGraph &graph) {
+  graph.output(out);
+  return out;
+};
+
+#endif
@@ -339,7 +339,7 @@ remove(const AsyncTaskCollection &tasks) {
       }
       if (task->_chain->do_remove(task)) {
         _lock.release();
-        task->upon_death(this, false);
+        task->call_upon_death(this, false);
         _lock.acquire();
         ++num_removed;
       } else {
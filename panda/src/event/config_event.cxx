@@ -14,6 +14,7 @@
 #include "config_event.h"
 #include "asyncTask.h"
 #include "asyncTaskChain.h"
+#include "asyncTaskGraph.h"
 #include "asyncTaskManager.h"
 #include "asyncTaskPause.h"
 #include "asyncTaskSequence.h"
@@ -23,6 +24,7 @@
 #include "eventParameter.h"
 #include "genericAsyncTask.h"
 #include "pointerEventList.h"
+#include "virtualFileReadRequest.h"
 
 #include "dconfig.h"
 
@@ -30,9 +32,57 @@ Configure(config_event);
 NotifyCategoryDef(event, "");
 NotifyCategoryDef(task, "");
 
+ConfigVariableInt vfs_async_read_threads
+("vfs-async-read-threads", 2,
+ PRC_DESC("The number of threads that will be started to read files "
+          "passed to VirtualFileSystem::read_file_async(), other than "
+          "those that can be read directly by the kernel via io_uring.  "
+          "These threads are only started if the asynchronous interface "
+          "is used, and if threading support is compiled into Panda."));
+
+/**
+ * The task function that performs a VirtualFileReadRequest on one of the
+ * threads of the "vfs_read" task chain.
+ */
+static AsyncTask::DoneStatus
+read_file_task(GenericAsyncTask *task, void *user_data) {
+  ((VirtualFileReadRequest *)user_data)->do_read();
+  return AsyncTask::DS_done;
+}
+
+/**
+ * Releases the reference held on the request by read_file_task().  This is
+ * called even if the task is removed before it gets to run.
+ */
+static void
+read_file_task_death(GenericAsyncTask *task, bool clean_exit, void *user_data) {
+  unref_delete((VirtualFileReadRequest *)user_data);
+}
+
+/**
+ * Hands a VirtualFileReadRequest off to the "vfs_read" task chain, creating
+ * the chain if necessary.
+ */
+static void
+start_read_file_task(VirtualFileReadRequest *request) {
+  AsyncTaskManager *task_mgr = AsyncTaskManager::get_global_ptr();
+  if (task_mgr->find_task_chain("vfs_read") == NULL) {
+    PT(AsyncTaskChain) chain = task_mgr->make_task_chain("vfs_read");
+    chain->set_num_threads(vfs_async_read_threads);
+  }
+
+  request->ref();
+  PT(GenericAsyncTask) task =
+    new GenericAsyncTask(request->get_filename(), &read_file_task, request);
+  task->set_upon_death(&read_file_task_death);
+  task->set_task_chain("vfs_read");
+  task_mgr->add(task);
+}
+
 ConfigureFn(config_event) {
   AsyncTask::init_type();
   AsyncTaskChain::init_type();
+  AsyncTaskGraph::init_type();
   AsyncTaskManager::init_type();
   AsyncTaskPause::init_type();
   AsyncTaskSequence::init_type();
@@ -47,4 +97,6 @@ ConfigureFn(config_event) {
   ButtonEventList::register_with_read_factory();
   EventStoreInt::register_with_read_factory();
   EventStoreDouble::register_with_read_factory();
+
+  VirtualFileReadRequest::set_background_func(&start_read_file_task);
 }
@@ -17,8 +17,11 @@
 #include "pandabase.h"
 
 #include "notifyCategoryProxy.h"
+#include "configVariableInt.h"
 
 NotifyCategoryDecl(event, EXPCL_PANDA_EVENT, EXPTP_PANDA_EVENT);
 NotifyCategoryDecl(task, EXPCL_PANDA_EVENT, EXPTP_PANDA_EVENT);
 
+extern EXPCL_PANDA_EVENT ConfigVariableInt vfs_async_read_threads;
+
 #endif
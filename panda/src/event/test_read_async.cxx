@@ -0,0 +1,186 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_read_async.cxx
+ * @date 2026-10-19
+ */
+
+#include "pandabase.h"
+#include "asyncTaskManager.h"
+#include "virtualFileSystem.h"
+#include "virtualFileReadRequest.h"
+#include "load_prc_file.h"
+#include "genericThread.h"
+#include "atomicAdjust.h"
+
+// Reads a number of files with VirtualFileSystem::read_file_async() from
+// several threads at once, and checks that each one comes back intact.  The
+// plain files are read through io_uring, where the kernel supports it; the
+// compressed files can't be, and are handed off to the "vfs_read" task chain
+// instead.  Run with -t to disable io_uring, so that every file takes the
+// task chain.
+
+static int num_threads = 4;
+static int num_files = 50;
+static int num_rounds = 20;
+
+static pvector<Filename> filenames;
+static pvector<string> contents;
+static AtomicAdjust::Integer num_failures = 0;
+
+/**
+ * Returns the contents to write to the nth file.  The files are of various
+ * sizes, some of them larger than a single read.
+ */
+static string
+make_contents(int fi) {
+  ostringstream strm;
+  int num_lines = (fi * 997) % 20000 + 1;
+  for (int i = 0; i < num_lines; ++i) {
+    strm << "file " << fi << " line " << i << "\n";
+  }
+  return strm.str();
+}
+
+/**
+ * Checks that the request read the nth file correctly.
+ */
+static void
+check(VirtualFileReadRequest *request, int fi) {
+  const pvector<unsigned char> &data = request->get_data();
+  const string &expected = contents[fi];
+  if (!request->get_success() || data.size() != expected.size() ||
+      (!data.empty() && memcmp(&data[0], expected.data(), data.size()) != 0)) {
+    nout << "Wrong data read from " << filenames[fi] << "\n";
+    AtomicAdjust::inc(num_failures);
+  }
+}
+
+/**
+ * The body of each reading thread.  Each round starts a read of every file,
+ * and then collects them, half by polling and half by waiting.
+ */
+static void
+run_reader(void *data) {
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+  int offset = (int)(size_t)data;
+
+  for (int round = 0; round < num_rounds; ++round) {
+    pvector<PT(VirtualFileReadRequest)> requests;
+    for (int i = 0; i < num_files; ++i) {
+      int fi = (i + offset + round) % num_files;
+      PT(VirtualFileReadRequest) request =
+        vfs->read_file_async(filenames[fi], true);
+      if (request == (VirtualFileReadRequest *)NULL) {
+        nout << "Couldn't start reading " << filenames[fi] << "\n";
+        AtomicAdjust::inc(num_failures);
+      }
+      requests.push_back(request);
+    }
+
+    for (int i = 0; i < num_files; ++i) {
+      int fi = (i + offset + round) % num_files;
+      VirtualFileReadRequest *request = requests[i];
+      if (request == (VirtualFileReadRequest *)NULL) {
+        continue;
+      }
+      if ((i & 1) != 0) {
+        while (!request->is_ready()) {
+          Thread::force_yield();
+        }
+      }
+      request->wait();
+      check(request, fi);
+    }
+  }
+}
+
+int
+main(int argc, char *argv[]) {
+  if (argc > 1 && strcmp(argv[1], "-t") == 0) {
+    load_prc_file_data("", "vfs-async-io-uring 0");
+    --argc;
+    ++argv;
+  }
+  if (argc > 1) {
+    num_threads = max(atoi(argv[1]), 1);
+  }
+  if (argc > 2) {
+    nout << "test_read_async [-t] [threads]\n";
+    exit(1);
+  }
+  if (!Thread::is_threading_supported()) {
+    num_threads = 1;
+  }
+
+  // Loading the task system installs the function that hands reads off to
+  // the "vfs_read" task chain.
+  AsyncTaskManager::get_global_ptr();
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+
+  Filename dir = Filename::temporary("", "test_read_async");
+  dir.mkdir();
+  for (int fi = 0; fi < num_files; ++fi) {
+    ostringstream strm;
+    strm << "file" << fi << ".txt";
+    bool compress = false;
+#ifdef HAVE_ZLIB
+    if ((fi % 3) == 2) {
+      strm << ".pz";
+      compress = true;
+    }
+#endif
+    Filename filename(dir, strm.str());
+    contents.push_back(make_contents(fi));
+    if (!vfs->write_file(filename, contents.back(), compress)) {
+      nout << "Couldn't write " << filename << "\n";
+      exit(1);
+    }
+    if (compress) {
+      // Read it back by the name without the .pz extension.
+      filename = filename.get_fullpath_wo_extension();
+    }
+    filenames.push_back(filename);
+  }
+
+  if (num_threads == 1) {
+    run_reader((void *)0);
+
+  } else {
+    pvector<PT(GenericThread)> threads;
+    for (int t = 0; t < num_threads; ++t) {
+      ostringstream strm;
+      strm << "Reader " << t;
+      PT(GenericThread) thread =
+        new GenericThread(strm.str(), strm.str(), &run_reader,
+                          (void *)(size_t)(t * 7));
+      thread->start(TP_normal, true);
+      threads.push_back(thread);
+    }
+    for (int t = 0; t < num_threads; ++t) {
+      threads[t]->join();
+    }
+  }
+
+  for (int fi = 0; fi < num_files; ++fi) {
+    Filename filename = filenames[fi];
+    if (!filename.exists()) {
+      filename = filename.get_fullpath() + ".pz";
+    }
+    filename.unlink();
+  }
+  dir.rmdir();
+
+  if (num_failures != 0) {
+    nout << num_failures << " reads failed.\n";
+    return 1;
+  }
+  nout << num_threads << " threads read " << num_files << " files "
+       << num_rounds << " times each.\n";
+  return 0;
+}
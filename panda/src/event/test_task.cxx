@@ -14,7 +14,10 @@
 #include "pandabase.h"
 #include "asyncTask.h"
 #include "asyncTaskManager.h"
+#include "asyncTaskGraph.h"
 #include "perlinNoise2.h"
+#include "clockObject.h"
+#include "atomicAdjust.h"
 
 class MyTask : public AsyncTask {
 public:
@@ -43,11 +46,139 @@ public:
   int _repeat_count;
 };
 
+// A very short task, for measuring the overhead of the task chain itself.
+class SmallTask : public AsyncTask {
+public:
+  SmallTask(const string &name, int repeat_count) :
+    AsyncTask(name),
+    _repeat_count(repeat_count)
+  {
+  }
+  ALLOC_DELETED_CHAIN(SmallTask);
+
+  virtual DoneStatus do_task() {
+    // Do a tiny bit of work so the compiler can't throw the task away.
+    unsigned int hash = (unsigned int)_repeat_count;
+    for (int i = 0; i < 100; ++i) {
+      hash = hash * 1664525u + 1013904223u;
+    }
+    AtomicAdjust::add(_total, (AtomicAdjust::Integer)(hash & 1));
+
+    --_repeat_count;
+    if (_repeat_count > 0) {
+      return DS_cont;
+    }
+    return DS_done;
+  }
+
+  int _repeat_count;
+  static AtomicAdjust::Integer _total;
+};
+
+AtomicAdjust::Integer SmallTask::_total = 0;
+
 static const int grid_size = 10;
 static const int num_threads = 10;
 
+/**
+ * Runs the indicated number of small tasks, several times each, across
+ * several sort values and priorities, and reports how long it took.
+ */
+static double
+run_small_tasks(int num_tasks, int num_threads, bool work_stealing) {
+  PT(AsyncTaskManager) task_mgr = new AsyncTaskManager("bench_mgr");
+  PT(AsyncTaskChain) chain = task_mgr->make_task_chain("default");
+  chain->set_tick_clock(true);
+  chain->set_work_stealing(work_stealing);
+
+  for (int i = 0; i < num_tasks; ++i) {
+    ostringstream namestrm;
+    namestrm << "small_" << i;
+    PT(SmallTask) task = new SmallTask(namestrm.str(), 10);
+    task->set_sort(i % 4);
+    task->set_priority(i % 7);
+    task_mgr->add(task);
+  }
+
+  // The chain has no threads until now, so that none of the tasks could run
+  // before the clock started.
+  ClockObject *clock = ClockObject::get_global_clock();
+  double start = clock->get_real_time();
+  chain->set_num_threads(num_threads);
+  task_mgr->wait_for_tasks();
+  double elapsed = clock->get_real_time() - start;
+
+  task_mgr->cleanup();
+  return elapsed;
+}
+
+/**
+ * Compares the single shared queue against work stealing, for increasing
+ * numbers of threads.
+ */
+static void
+benchmark(int num_tasks) {
+  cerr << num_tasks << " small tasks, 10 epochs each:\n";
+  for (int threads = 1; threads <= 8; threads *= 2) {
+    double shared = run_small_tasks(num_tasks, threads, false);
+    double stealing = run_small_tasks(num_tasks, threads, true);
+    cerr << "  " << threads << " threads: shared queue " << shared * 1000.0
+         << " ms, work stealing " << stealing * 1000.0 << " ms\n";
+  }
+}
+
+/**
+ * Runs a graph of animation, skinning and cull tasks for several characters,
+ * each depending on the one before, with a final task that depends on all of
+ * the characters, and reports the elapsed and critical path times.
+ */
+static void
+run_graph(int num_characters) {
+  PT(AsyncTaskManager) task_mgr = new AsyncTaskManager("graph_mgr");
+  PT(AsyncTaskChain) chain = task_mgr->make_task_chain("default");
+  chain->set_num_threads(num_threads);
+
+  PT(AsyncTaskGraph) graph = new AsyncTaskGraph("characters");
+  PT(MyTask) finish = new MyTask("finish", 0.01, 1);
+  for (int i = 0; i < num_characters; ++i) {
+    ostringstream strm;
+    strm << "_" << i;
+    PT(MyTask) anim = new MyTask("anim" + strm.str(), 0.02, 1);
+    PT(MyTask) skin = new MyTask("skin" + strm.str(), 0.03, 1);
+    PT(MyTask) cull = new MyTask("cull" + strm.str(), 0.01, 1);
+    graph->add_dependency(skin, anim);
+    graph->add_dependency(cull, skin);
+    graph->add_dependency(finish, cull);
+  }
+
+  graph->start(task_mgr);
+  graph->wait();
+
+  cerr << *graph << ": " << graph->get_num_tasks() << " tasks, elapsed "
+       << graph->get_elapsed_time() * 1000.0 << " ms, critical path "
+       << graph->get_critical_path_time() * 1000.0 << " ms, "
+       << graph->get_num_failed() << " failed\n"
+       << "  critical path: " << graph->get_critical_path() << "\n";
+
+  task_mgr->cleanup();
+}
+
 int
 main(int argc, char *argv[]) {
+  if (argc > 1 && strcmp(argv[1], "-g") == 0) {
+    // test_task -g [num_characters]: run a task graph.
+    int num_characters = (argc > 2) ? atoi(argv[2]) : 20;
+    run_graph(num_characters);
+    exit(0);
+  }
+
+  if (argc > 1 && strcmp(argv[1], "-b") == 0) {
+    // test_task -b [num_tasks]: benchmark the scheduler with small tasks.
+    int num_tasks = (argc > 2) ? atoi(argv[2]) : 5000;
+    benchmark(num_tasks);
+    exit(0);
+  }
+
   PT(AsyncTaskManager) task_mgr = new AsyncTaskManager("task_mgr");
   PT(AsyncTaskChain) chain = task_mgr->make_task_chain("default");
   chain->set_tick_clock(true);
@@ -26,6 +26,7 @@
 #include "virtualFileMountMultifile.h"
 #include "virtualFileMountRamdisk.h"
 #include "virtualFileMountSystem.h"
+#include "virtualFileReadRequest.h"
 #include "virtualFileSimple.h"
 #include "fileReference.h"
 #include "temporaryFile.h"
@@ -72,6 +73,49 @@ ConfigVariableBool multifile_always_binary
           "or extracted in either binary or text mode, according to the "
           "set_binary() or set_text() flag on the Filename."));
 
+ConfigVariableBool multifile_mmap
+("multifile-mmap", false,
+ PRC_DESC("Set this true to map a Multifile that is opened for reading from "
+          "a file on disk into memory, so that its uncompressed subfiles can "
+          "be read without copying them through a stream buffer, and so that "
+          "several threads can read from it at once without locking.  Be "
+          "warned that if the file is truncated or patched while it is "
+          "mapped, for instance by a patcher or another process, reading "
+          "the part that has changed may crash the program with SIGBUS "
+          "(or an access violation on Windows), rather than fail with an "
+          "error.  Only enable this for Multifiles that are never modified "
+          "while they are in use."));
+
+ConfigVariableInt multifile_encode_threads
+("multifile-encode-threads", 0,
+ PRC_DESC("The number of threads that may be used to compress new "
+          "subfiles when a Multifile is written.  The data is still "
+          "written to the Multifile in order.  Encrypted subfiles are "
+          "always encoded on the calling thread.  Set this to 0 to use as "
+          "many threads as the hardware supports, or to 1 to do all of the "
+          "work on the calling thread."));
+
+ConfigVariableInt multifile_encode_buffer_size
+("multifile-encode-buffer-size", 64 * 1024 * 1024,
+ PRC_DESC("The approximate number of bytes of source data that may be "
+          "compressed ahead of time, in memory, while "
+          "multifile-encode-threads is greater than 1."));
+
+ConfigVariableBool vfs_async_io_uring
+("vfs-async-io-uring", true,
+ PRC_DESC("On Linux, VirtualFileSystem::read_file_async() submits reads of "
+          "files on disk, and of uncompressed subfiles of multifiles on "
+          "disk, directly to the kernel via io_uring, if the kernel supports "
+          "it.  Set this false to read them on a background thread instead, "
+          "like all other files."));
+
+ConfigVariableInt vfs_async_queue_depth
+("vfs-async-queue-depth", 64,
+ PRC_DESC("The number of entries in the io_uring submission queue used by "
+          "read_file_async().  Roughly twice this many reads may be in "
+          "flight at once; beyond that, reads are done on a background "
+          "thread."));
+
 ConfigVariableBool collect_tcp
 ("collect-tcp", false,
  PRC_DESC("Set this true to enable accumulation of several small consecutive "
@@ -112,6 +156,7 @@ init_libexpress() {
   VirtualFileMountMultifile::init_type();
   VirtualFileMountRamdisk::init_type();
   VirtualFileMountSystem::init_type();
+  VirtualFileReadRequest::init_type();
   VirtualFileSimple::init_type();
   FileReference::init_type();
   TemporaryFile::init_type();
@@ -54,6 +54,11 @@ extern ConfigVariableInt patchfile_zone_size;
 
 extern ConfigVariableBool keep_temporary_files;
 extern ConfigVariableBool multifile_always_binary;
+extern ConfigVariableBool multifile_mmap;
+extern ConfigVariableInt multifile_encode_threads;
+extern ConfigVariableInt multifile_encode_buffer_size;
+extern ConfigVariableBool vfs_async_io_uring;
+extern ConfigVariableInt vfs_async_queue_depth;
 
 extern EXPCL_PANDAEXPRESS ConfigVariableBool collect_tcp;
 extern EXPCL_PANDAEXPRESS ConfigVariableDouble collect_tcp_interval;
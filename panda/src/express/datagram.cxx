@@ -34,6 +34,7 @@ Datagram::
 void Datagram::
 clear() {
   _data.clear();
+  _small_length = 0;
 }
 
 /**
@@ -100,14 +101,16 @@ pad_bytes(size_t size) {
   nassertv((int)size >= 0);
 
   if (_data == (uchar *)NULL) {
-    // Create a new array.
-    _data = PTA_uchar::empty_array(0);
+    if ((size_t)_small_length + size <= small_buffer_size) {
+      // It still fits within the Datagram.
+      memset(_small_data + _small_length, 0, size);
+      _small_length += (unsigned char)size;
+      return;
+    }
+    make_array(_small_length + max(size, (size_t)small_buffer_size));
 
   } else if (_data.get_ref_count() != 1) {
-    // Copy on write.
-    PTA_uchar new_data = PTA_uchar::empty_array(0);
-    new_data.v() = _data.v();
-    _data = new_data;
+    copy_on_write();
   }
 
   // Now append the data.
@@ -116,10 +119,7 @@ pad_bytes(size_t size) {
   // the further comments in append_data(), below.  _data.reserve(_data.size()
   // + size);
 
-  while (size > 0) {
-    _data.push_back('\0');
-    --size;
-  }
+  _data.v().insert(_data.v().end(), size, (uchar)0);
 }
 
 /**
@@ -130,14 +130,18 @@ append_data(const void *data, size_t size) {
   nassertv((int)size >= 0);
 
   if (_data == (uchar *)NULL) {
-    // Create a new array.
-    _data = PTA_uchar::empty_array(0);
+    if ((size_t)_small_length + size <= small_buffer_size) {
+      // It still fits within the Datagram.
+      memcpy(_small_data + _small_length, data, size);
+      _small_length += (unsigned char)size;
+      return;
+    }
+    // It has outgrown the Datagram; move it to a new array, with some room
+    // to grow further.
+    make_array(_small_length + max(size, (size_t)small_buffer_size));
 
   } else if (_data.get_ref_count() != 1) {
-    // Copy on write.
-    PTA_uchar new_data = PTA_uchar::empty_array(0);
-    new_data.v() = _data.v();
-    _data = new_data;
+    copy_on_write();
   }
 
   // Now append the data.
@@ -159,9 +163,65 @@ void Datagram::
 assign(const void *data, size_t size) {
   nassertv((int)size >= 0);
 
+  if (size <= small_buffer_size) {
+    _data.clear();
+    memcpy(_small_data, data, size);
+    _small_length = (unsigned char)size;
+    return;
+  }
+
   _data = PTA_uchar::empty_array(0);
   _data.v().insert(_data.v().end(), (const unsigned char *)data,
                    (const unsigned char *)data + size);
+  _small_length = 0;
+}
+
+/**
+ * Ensures that the datagram can hold at least the indicated total number of
+ * bytes without allocating more memory.  This is worth calling once, before
+ * building up a datagram whose final size is known in advance; it should not
+ * be called before each individual append.
+ */
+void Datagram::
+reserve(size_t size) {
+  if (_data == (uchar *)NULL) {
+    if (size <= small_buffer_size) {
+      // It already fits.
+      return;
+    }
+    make_array(size);
+
+  } else {
+    if (_data.get_ref_count() != 1) {
+      copy_on_write();
+    }
+    _data.v().reserve(size);
+  }
+}
+
+/**
+ * Moves the data stored within the Datagram to a new array with room for at
+ * least the indicated number of bytes.
+ */
+void Datagram::
+make_array(size_t capacity) {
+  nassertv(_data == (uchar *)NULL);
+
+  _data = PTA_uchar::empty_array(0);
+  _data.v().reserve(max(capacity, (size_t)_small_length));
+  _data.v().insert(_data.v().end(), _small_data, _small_data + _small_length);
+  _small_length = 0;
+}
+
+/**
+ * Replaces the data array, which is shared with another Datagram or
+ * PTA_uchar, with a copy of it.
+ */
+void Datagram::
+copy_on_write() {
+  PTA_uchar new_data = PTA_uchar::empty_array(0);
+  new_data.v() = _data.v();
+  _data = new_data;
 }
 
 /**
@@ -34,6 +34,10 @@
  *
  * A Datagram is itself headerless; it is simply a collection of data
  * elements.
+ *
+ * A small datagram keeps its data within the Datagram object itself, and
+ * allocates no memory, until it grows too large or its data is requested as a
+ * PTA_uchar.
  */
 class EXPCL_PANDAEXPRESS Datagram : public TypedObject {
 PUBLISHED:
@@ -89,6 +93,7 @@ PUBLISHED:
   INLINE void append_data(const string &data);
 
   void assign(const void *data, size_t size);
+  void reserve(size_t size);
 
   INLINE string get_message() const;
   INLINE const void *get_data() const;
@@ -109,8 +114,21 @@ PUBLISHED:
   void output(ostream &out) const;
   void write(ostream &out, unsigned int indent=0) const;
 
+public:
+  INLINE bool has_array() const;
+  INLINE void *modify_data();
+
 private:
+  void make_array(size_t capacity);
+  void copy_on_write();
+
+  enum { small_buffer_size = 40 };
+
+  // The data is stored in _data if it is not NULL, and in _small_data
+  // otherwise.
   PTA_uchar _data;
+  unsigned char _small_data[small_buffer_size];
+  unsigned char _small_length;
   bool _stdfloat_double;
 
 public:
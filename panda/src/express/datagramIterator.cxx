@@ -15,6 +15,7 @@
 #include "pnotify.h"
 
 TypeHandle DatagramIterator::_type_handle;
+const Datagram DatagramIterator::_empty_datagram;
 
 /**
  * Extracts a variable-length string.
@@ -24,10 +25,10 @@ get_string() {
   // First, get the length of the string
   uint16_t s_len = get_uint16();
 
-  nassertr(_datagram != (const Datagram *)NULL, "");
-  nassertr(_current_index + s_len <= _datagram->get_length(), "");
+  nassertr(has_data(), "");
+  nassertr(_current_index + s_len <= get_buffer_size(), "");
 
-  const char *ptr = (const char *)_datagram->get_data();
+  const char *ptr = get_buffer();
   size_t last_index = _current_index;
 
   _current_index += s_len;
@@ -43,10 +44,10 @@ get_string32() {
   // First, get the length of the string
   uint32_t s_len = get_uint32();
 
-  nassertr(_datagram != (const Datagram *)NULL, "");
-  nassertr(_current_index + s_len <= _datagram->get_length(), "");
+  nassertr(has_data(), "");
+  nassertr(_current_index + s_len <= get_buffer_size(), "");
 
-  const char *ptr = (const char *)_datagram->get_data();
+  const char *ptr = get_buffer();
   size_t last_index = _current_index;
 
   _current_index += s_len;
@@ -59,11 +60,11 @@ get_string32() {
  */
 string DatagramIterator::
 get_z_string() {
-  nassertr(_datagram != (const Datagram *)NULL, "");
+  nassertr(has_data(), "");
 
   // First, determine the length of the string.
-  const char *ptr = (const char *)_datagram->get_data();
-  size_t length = _datagram->get_length();
+  const char *ptr = get_buffer();
+  size_t length = get_buffer_size();
   size_t p = _current_index;
   while (p < length && ptr[p] != '\0') {
     ++p;
@@ -82,10 +83,10 @@ get_z_string() {
  */
 string DatagramIterator::
 get_fixed_string(size_t size) {
-  nassertr(_datagram != (const Datagram *)NULL, "");
-  nassertr(_current_index + size <= _datagram->get_length(), "");
+  nassertr(has_data(), "");
+  nassertr(_current_index + size <= get_buffer_size(), "");
 
-  const char *ptr = (const char *)_datagram->get_data();
+  const char *ptr = get_buffer();
   string s(ptr + _current_index, size);
 
   _current_index += size;
@@ -102,8 +103,8 @@ get_wstring() {
   // First, get the length of the string
   uint32_t s_len = get_uint32();
 
-  nassertr(_datagram != (const Datagram *)NULL, wstring());
-  nassertr(_current_index + s_len * 2 <= _datagram->get_length(), wstring());
+  nassertr(has_data(), wstring());
+  nassertr(_current_index + s_len * 2 <= get_buffer_size(), wstring());
 
   wstring result;
   result.reserve(s_len);
@@ -122,10 +123,10 @@ get_wstring() {
 string DatagramIterator::
 extract_bytes(size_t size) {
   nassertr((int)size >= 0, "");
-  nassertr(_datagram != (const Datagram *)NULL, "");
-  nassertr(_current_index + size <= _datagram->get_length(), "");
+  nassertr(has_data(), "");
+  nassertr(_current_index + size <= get_buffer_size(), "");
 
-  const char *ptr = (const char *)_datagram->get_data();
+  const char *ptr = get_buffer();
   size_t last_index = _current_index;
 
   _current_index += size;
@@ -142,10 +143,10 @@ extract_bytes(size_t size) {
 size_t DatagramIterator::
 extract_bytes(unsigned char *into, size_t size) {
   nassertr((int)size >= 0, 0);
-  nassertr(_datagram != (const Datagram *)NULL, 0);
-  nassertr(_current_index + size <= _datagram->get_length(), 0);
+  nassertr(has_data(), 0);
+  nassertr(_current_index + size <= get_buffer_size(), 0);
 
-  const char *ptr = (const char *)_datagram->get_data();
+  const char *ptr = get_buffer();
   memcpy(into, ptr + _current_index, size);
 
   _current_index += size;
@@ -175,6 +176,8 @@ write(ostream &out, unsigned int indent) const {
     out<<""<<" / 0x"<<(void*)_current_index<<" (of 0x"
       <<(void*)(get_datagram().get_length())<<")\n";
     get_datagram().write(out, indent+2);
+  } else if (_view_data != NULL) {
+    out<<""<<" (of "<<_view_length<<" bytes of external memory)\n";
   } else {
     out<<""<<" (_datagram is null)\n";
   }
@@ -23,10 +23,16 @@
  * A class to retrieve the individual data elements previously stored in a
  * Datagram.  Elements may be retrieved one at a time; it is up to the caller
  * to know the correct type and order of each element.
+ *
+ * From C++, an iterator may also be constructed over a block of memory that
+ * is not stored in a Datagram, to read it in place without copying it.
  */
 class EXPCL_PANDAEXPRESS DatagramIterator {
 public:
+  INLINE DatagramIterator(const void *data, size_t size, size_t offset = 0);
   INLINE void assign(Datagram &datagram, size_t offset = 0);
+  INLINE void assign(const void *data, size_t size, size_t offset = 0);
+  INLINE const void *get_current_data() const;
 
 PUBLISHED:
   INLINE DatagramIterator();
@@ -75,9 +81,21 @@ PUBLISHED:
   void write(ostream &out, unsigned int indent=0) const;
 
 private:
+  INLINE bool has_data() const;
+  INLINE const char *get_buffer() const;
+  INLINE size_t get_buffer_size() const;
+
   const Datagram *_datagram;
+
+  // The memory being read, if there is no _datagram.
+  const char *_view_data;
+  size_t _view_length;
+
   size_t _current_index;
 
+  // Returned by get_datagram() when there is no _datagram.
+  static const Datagram _empty_datagram;
+
 public:
   static TypeHandle get_class_type() {
     return _type_handle;
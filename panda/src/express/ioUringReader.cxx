@@ -0,0 +1,485 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file ioUringReader.cxx
+ * @date 2026-10-18
+ */
+
+#include "ioUringReader.h"
+
+#ifdef HAVE_IO_URING
+
+#include "virtualFileReadRequest.h"
+#include "config_express.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <errno.h>
+
+AtomicAdjust::Pointer IoUringReader::_global_ptr = NULL;
+char IoUringReader::_unavailable;
+
+// The longest time, in nanoseconds, that wait() sleeps in the kernel before
+// looking again to see whether another thread has collected its completion.
+static const long long max_sleep_ns = 1000000;
+
+/**
+ * A thin wrapper around the io_uring_setup system call.
+ */
+static int
+sys_io_uring_setup(unsigned int entries, struct io_uring_params *params) {
+  return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+/**
+ * A thin wrapper around the io_uring_enter system call.
+ */
+static int
+sys_io_uring_enter(int fd, unsigned int to_submit, unsigned int min_complete,
+                   unsigned int flags) {
+  return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+                      flags, NULL, 0);
+}
+
+/**
+ * Calls io_uring_enter to wait for at least one completion, but for no
+ * longer than the indicated number of nanoseconds.
+ */
+static int
+sys_io_uring_wait(int fd, long long timeout_ns) {
+  struct __kernel_timespec ts;
+  ts.tv_sec = timeout_ns / 1000000000;
+  ts.tv_nsec = timeout_ns % 1000000000;
+
+  struct io_uring_getevents_arg arg;
+  memset(&arg, 0, sizeof(arg));
+  arg.ts = (__u64)(uintptr_t)&ts;
+  return (int)syscall(__NR_io_uring_enter, fd, 0, 1,
+                      IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                      &arg, sizeof(arg));
+}
+
+/**
+ *
+ */
+IoUringReader::
+IoUringReader() :
+  _ring_fd(-1),
+  _sq_ptr(MAP_FAILED),
+  _sq_size(0),
+  _sqes((struct io_uring_sqe *)MAP_FAILED),
+  _sqes_size(0),
+  _cq_ptr(MAP_FAILED),
+  _cq_size(0),
+  _max_in_flight(0),
+  _num_in_flight(0),
+  _num_sleepers(0),
+  _wake_pending(false),
+  _read_supported(true)
+{
+}
+
+/**
+ *
+ */
+IoUringReader::
+~IoUringReader() {
+  if (_cq_ptr != MAP_FAILED && _cq_ptr != _sq_ptr) {
+    munmap(_cq_ptr, _cq_size);
+  }
+  if (_sq_ptr != MAP_FAILED) {
+    munmap(_sq_ptr, _sq_size);
+  }
+  if (_sqes != (struct io_uring_sqe *)MAP_FAILED) {
+    munmap(_sqes, _sqes_size);
+  }
+  if (_ring_fd >= 0) {
+    close(_ring_fd);
+  }
+}
+
+/**
+ * Creates the ring, with room for the indicated number of submissions, and
+ * maps its queues into memory.  Returns true on success, or false if the
+ * kernel does not support io_uring (or forbids it).
+ */
+bool IoUringReader::
+setup(unsigned int entries) {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  _ring_fd = sys_io_uring_setup(entries, &params);
+  if (_ring_fd < 0) {
+    if (express_cat.is_debug()) {
+      express_cat.debug()
+        << "io_uring is not available: " << strerror(errno) << "\n";
+    }
+    return false;
+  }
+
+  if ((params.features & IORING_FEAT_EXT_ARG) == 0) {
+    // The kernel predates 5.11, and can't wait with a timeout.
+    if (express_cat.is_debug()) {
+      express_cat.debug()
+        << "io_uring is too old to use.\n";
+    }
+    return false;
+  }
+
+  _sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+  _cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    // Both queues live in the same mapping.
+    _sq_size = max(_sq_size, _cq_size);
+  }
+
+  _sq_ptr = mmap(NULL, _sq_size, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_SQ_RING);
+  if (_sq_ptr == MAP_FAILED) {
+    return false;
+  }
+
+  if (single_mmap) {
+    _cq_ptr = _sq_ptr;
+  } else {
+    _cq_ptr = mmap(NULL, _cq_size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_CQ_RING);
+    if (_cq_ptr == MAP_FAILED) {
+      return false;
+    }
+  }
+
+  _sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  _sqes = (struct io_uring_sqe *)
+    mmap(NULL, _sqes_size, PROT_READ | PROT_WRITE,
+         MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_SQES);
+  if (_sqes == (struct io_uring_sqe *)MAP_FAILED) {
+    return false;
+  }
+
+  char *sq = (char *)_sq_ptr;
+  _sq_head = (unsigned int *)(sq + params.sq_off.head);
+  _sq_tail = (unsigned int *)(sq + params.sq_off.tail);
+  _sq_mask = *(unsigned int *)(sq + params.sq_off.ring_mask);
+  _sq_array = (unsigned int *)(sq + params.sq_off.array);
+
+  char *cq = (char *)_cq_ptr;
+  _cq_head = (unsigned int *)(cq + params.cq_off.head);
+  _cq_tail = (unsigned int *)(cq + params.cq_off.tail);
+  _cq_mask = *(unsigned int *)(cq + params.cq_off.ring_mask);
+  _cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+  // Leave room in the completion queue for the one no-op we may submit to
+  // wake up a sleeping thread.
+  _max_in_flight = params.cq_entries - 1;
+  return true;
+}
+
+/**
+ * Returns the one global IoUringReader, creating it if necessary.  Returns
+ * NULL if io_uring is disabled or not supported by the kernel, in which case
+ * the caller should read the file some other way.
+ */
+IoUringReader *IoUringReader::
+get_global_ptr() {
+  void *ptr = AtomicAdjust::get_ptr(_global_ptr);
+  if (ptr == NULL) {
+    IoUringReader *reader = NULL;
+    if (vfs_async_io_uring) {
+      reader = new IoUringReader;
+      if (!reader->setup((unsigned int)max((int)vfs_async_queue_depth, 1))) {
+        delete reader;
+        reader = NULL;
+      }
+    }
+
+    void *new_ptr = (reader != NULL) ? (void *)reader : (void *)&_unavailable;
+    ptr = AtomicAdjust::compare_and_exchange_ptr(_global_ptr, NULL, new_ptr);
+    if (ptr == NULL) {
+      // We won the race to create it.
+      ptr = new_ptr;
+    } else {
+      // Some other thread got there first.
+      delete reader;
+    }
+  }
+
+  if (ptr == (void *)&_unavailable) {
+    return NULL;
+  }
+  return (IoUringReader *)ptr;
+}
+
+/**
+ * Starts reading the indicated request, whose _fd, _file_start and _data
+ * have already been set up.  Returns true if the read is now in flight, or
+ * false if it could not be submitted, in which case the caller should read
+ * the file some other way.
+ */
+bool IoUringReader::
+submit(VirtualFileReadRequest *request) {
+  _lock.acquire();
+  if (!_read_supported) {
+    release_lock();
+    return false;
+  }
+
+  if (_num_in_flight >= _max_in_flight) {
+    // Make room if we can.
+    reap();
+    if (_num_in_flight >= _max_in_flight) {
+      release_lock();
+      return false;
+    }
+  }
+
+  // This must be set before the read is submitted, since another thread may
+  // collect the completion as soon as we do.
+  AtomicAdjust::set(request->_state, VirtualFileReadRequest::S_reading);
+  request->_bytes_read = 0;
+  if (!submit_read(request)) {
+    AtomicAdjust::set(request->_state, VirtualFileReadRequest::S_pending);
+    release_lock();
+    return false;
+  }
+
+  // The ring holds a reference to the request until it completes.
+  request->ref();
+  request->_in_ring = true;
+  ++_num_in_flight;
+  release_lock();
+  return true;
+}
+
+/**
+ * Collects any reads that have completed, without waiting.
+ */
+void IoUringReader::
+poll() {
+  _lock.acquire();
+  reap();
+  release_lock();
+}
+
+/**
+ * Blocks until the indicated request is no longer being read by the ring.
+ * Either it has finished, or it has been handed off to be read some other
+ * way, in which case the caller should wait for it in that way.
+ */
+void IoUringReader::
+wait(VirtualFileReadRequest *request) {
+  _lock.acquire();
+  while (request->_in_ring) {
+    if (reap() != 0) {
+      continue;
+    }
+
+    // Nothing has completed yet.  Sleep in the kernel until something does,
+    // but not while holding the lock, so that other threads may submit
+    // reads in the meantime.  If another thread collects our completion
+    // first, it will post a no-op to wake up a sleeping thread, but the
+    // kernel wakes only one of them, so the rest of us must not sleep for
+    // long.
+    ++_num_sleepers;
+    release_lock();
+    sys_io_uring_wait(_ring_fd, max_sleep_ns);
+    _lock.acquire();
+    --_num_sleepers;
+  }
+  release_lock();
+}
+
+/**
+ * Adds one entry to the submission queue, and tells the kernel about it.
+ * Returns true on success.  Assumes the lock is held.
+ */
+bool IoUringReader::
+submit_sqe(int opcode, int fd, void *addr, unsigned int len,
+           uint64_t offset, uint64_t user_data) {
+  unsigned int tail = *_sq_tail;
+  unsigned int index = tail & _sq_mask;
+
+  struct io_uring_sqe *sqe = &_sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = (__u8)opcode;
+  sqe->fd = fd;
+  sqe->addr = (__u64)(uintptr_t)addr;
+  sqe->len = len;
+  sqe->off = offset;
+  sqe->user_data = user_data;
+  _sq_array[index] = index;
+
+  __atomic_store_n(_sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+  int result;
+  do {
+    result = sys_io_uring_enter(_ring_fd, 1, 0, 0);
+  } while (result < 0 && errno == EINTR);
+
+  if (result < 0 && __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE) == tail) {
+    // The kernel didn't take it.  Since we are the only thread that submits,
+    // we can simply take it back.
+    express_cat.warning()
+      << "io_uring_enter failed: " << strerror(errno) << "\n";
+    __atomic_store_n(_sq_tail, tail, __ATOMIC_RELEASE);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Submits a read of the remainder of the indicated request's data.  Assumes
+ * the lock is held.
+ */
+bool IoUringReader::
+submit_read(VirtualFileReadRequest *request) {
+  size_t remaining = request->_data.size() - request->_bytes_read;
+
+  // A single read is limited to what fits in an int.
+  unsigned int len = (unsigned int)min(remaining, (size_t)0x40000000);
+  return submit_sqe(IORING_OP_READ, request->_fd,
+                    &request->_data[request->_bytes_read], len,
+                    request->_file_start + request->_bytes_read,
+                    (uint64_t)(uintptr_t)request);
+}
+
+/**
+ * Processes all of the entries in the completion queue.  Returns the number
+ * of requests that left the ring as a result.  Assumes the lock is held.
+ */
+int IoUringReader::
+reap() {
+  int num_finished = 0;
+
+  unsigned int head = *_cq_head;
+  while (head != __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE)) {
+    struct io_uring_cqe *cqe = &_cqes[head & _cq_mask];
+    VirtualFileReadRequest *request =
+      (VirtualFileReadRequest *)(uintptr_t)cqe->user_data;
+    int res = cqe->res;
+    ++head;
+    __atomic_store_n(_cq_head, head, __ATOMIC_RELEASE);
+
+    if (request == NULL) {
+      // This was the no-op submitted to wake up a sleeping thread.
+      _wake_pending = false;
+      continue;
+    }
+
+    complete(request, res);
+    if (!request->_in_ring) {
+      ++num_finished;
+      --_num_in_flight;
+      unref_delete(request);
+    }
+  }
+
+  if (num_finished != 0 && _num_sleepers != 0 && !_wake_pending) {
+    // Some other thread may have been waiting for one of the requests we
+    // just collected.  Post a no-op completion to wake it up.  Only one is
+    // ever in the ring, since that is all the room we left for it in the
+    // completion queue.
+    _wake_pending = submit_sqe(IORING_OP_NOP, -1, NULL, 0, 0, 0);
+  }
+
+  return num_finished;
+}
+
+/**
+ * Handles the completion of one read on behalf of the indicated request.  If
+ * there is more to read, submits another read; otherwise, finishes the
+ * request, and clears its _in_ring flag.  Assumes the lock is held.
+ */
+void IoUringReader::
+complete(VirtualFileReadRequest *request, int res) {
+  if (res == -EINTR || res == -EAGAIN) {
+    // Try that again.
+    if (submit_read(request)) {
+      return;
+    }
+    divert(request);
+    return;
+  }
+
+  if (res == -EINVAL || res == -EOPNOTSUPP) {
+    // The kernel predates IORING_OP_READ.  Don't try again.
+    _read_supported = false;
+    divert(request);
+    return;
+  }
+
+  if (res > 0) {
+    request->_bytes_read += res;
+    if (request->_bytes_read < request->_data.size()) {
+      // A short read; ask for the rest.
+      if (submit_read(request)) {
+        return;
+      }
+      divert(request);
+      return;
+    }
+  } else if (res == 0) {
+    // The file is shorter than it was when we started.
+    request->_data.resize(request->_bytes_read);
+  }
+
+  close(request->_fd);
+  request->_fd = -1;
+  request->_in_ring = false;
+  request->_success = (res >= 0);
+  if (!request->_success) {
+    express_cat.info()
+      << "Unable to read " << request->get_filename() << ": "
+      << strerror(-res) << "\n";
+    request->_data.clear();
+  }
+  AtomicAdjust::set(request->_state, VirtualFileReadRequest::S_done);
+}
+
+/**
+ * Gives up on reading the indicated request through the ring, and queues it
+ * to be handed off to be read some other way, once the lock is released.
+ * Assumes the lock is held.
+ */
+void IoUringReader::
+divert(VirtualFileReadRequest *request) {
+  close(request->_fd);
+  request->_fd = -1;
+  request->_in_ring = false;
+  AtomicAdjust::set(request->_state, VirtualFileReadRequest::S_pending);
+
+  // The request may not be started here, since that may read the whole file
+  // or take the task manager's lock.  The queue holds a reference to it
+  // until then.
+  request->ref();
+  _diverted.push_back(request);
+}
+
+/**
+ * Releases the lock, and then hands off any requests that were diverted
+ * while it was held.  Assumes the lock is held.
+ */
+void IoUringReader::
+release_lock() {
+  if (_diverted.empty()) {
+    _lock.release();
+    return;
+  }
+
+  pvector<VirtualFileReadRequest *> diverted;
+  diverted.swap(_diverted);
+  _lock.release();
+
+  pvector<VirtualFileReadRequest *>::iterator ri;
+  for (ri = diverted.begin(); ri != diverted.end(); ++ri) {
+    (*ri)->start_background();
+    unref_delete(*ri);
+  }
+}
+
+#endif  // HAVE_IO_URING
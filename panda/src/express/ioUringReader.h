@@ -0,0 +1,119 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file ioUringReader.h
+ * @date 2026-10-18
+ */
+
+#ifndef IOURINGREADER_H
+#define IOURINGREADER_H
+
+#include "pandabase.h"
+
+// io_uring is available on Linux 5.1 and later, but we need the timed waits
+// that were added in 5.11.  We talk to the kernel directly, rather than
+// through liburing, so all we need are the kernel headers.
+#if defined(__linux__) && !defined(CPPPARSER) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#if defined(__NR_io_uring_setup) && defined(IORING_ENTER_EXT_ARG)
+#define HAVE_IO_URING 1
+#endif
+#endif
+#endif
+
+#ifdef HAVE_IO_URING
+
+#include "mutexImpl.h"
+#include "atomicAdjust.h"
+#include "pvector.h"
+
+class VirtualFileReadRequest;
+
+/**
+ * Submits the reads of VirtualFileReadRequests to the kernel through a
+ * single io_uring shared by all threads, and collects the results.
+ *
+ * There is no thread waiting on the completion queue; completions are
+ * collected by whichever thread next polls or waits on a request.  A thread
+ * that waits sleeps in the kernel for a bounded time only, since the
+ * completion it is waiting for may be collected by some other thread.
+ */
+class EXPCL_PANDAEXPRESS IoUringReader {
+private:
+  IoUringReader();
+  ~IoUringReader();
+
+  bool setup(unsigned int entries);
+
+public:
+  static IoUringReader *get_global_ptr();
+
+  bool submit(VirtualFileReadRequest *request);
+  void poll();
+  void wait(VirtualFileReadRequest *request);
+
+private:
+  bool submit_sqe(int opcode, int fd, void *addr, unsigned int len,
+                  uint64_t offset, uint64_t user_data);
+  bool submit_read(VirtualFileReadRequest *request);
+  int reap();
+  void complete(VirtualFileReadRequest *request, int res);
+  void divert(VirtualFileReadRequest *request);
+  void release_lock();
+
+  MutexImpl _lock;
+  int _ring_fd;
+
+  // The submission queue, and the array of entries it indexes into.
+  void *_sq_ptr;
+  size_t _sq_size;
+  unsigned int *_sq_head;
+  unsigned int *_sq_tail;
+  unsigned int _sq_mask;
+  unsigned int *_sq_array;
+  struct io_uring_sqe *_sqes;
+  size_t _sqes_size;
+
+  // The completion queue.  This may share a mapping with the submission
+  // queue, in which case _cq_ptr is NULL.
+  void *_cq_ptr;
+  size_t _cq_size;
+  unsigned int *_cq_head;
+  unsigned int *_cq_tail;
+  unsigned int _cq_mask;
+  struct io_uring_cqe *_cqes;
+
+  unsigned int _max_in_flight;
+  unsigned int _num_in_flight;
+
+  // The number of threads blocked in io_uring_enter() in wait(), without
+  // holding the lock.
+  int _num_sleepers;
+
+  // True while a no-op submitted to wake up a sleeping thread is still in
+  // the ring.  There is never more than one.
+  bool _wake_pending;
+
+  // Requests that could not be read through the ring, which are waiting to
+  // be handed off once the lock is released.
+  pvector<VirtualFileReadRequest *> _diverted;
+
+  // Set false if the kernel turns out not to support IORING_OP_READ.
+  bool _read_supported;
+
+  // Points to the IoUringReader, once it has been created, or to
+  // _unavailable if io_uring could not be set up.
+  static AtomicAdjust::Pointer _global_ptr;
+  static char _unavailable;
+};
+
+#endif  // HAVE_IO_URING
+
+#endif
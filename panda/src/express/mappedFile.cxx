@@ -0,0 +1,244 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file mappedFile.cxx
+ * @date 2026-10-18
+ */
+
+#include "mappedFile.h"
+#include "config_express.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ *
+ */
+MappedFile::
+MappedFile() :
+  _data(NULL),
+  _size(0),
+  _writable(false),
+  _base(NULL),
+  _base_size(0)
+{
+#ifdef _WIN32
+  _handle = NULL;
+#endif
+}
+
+/**
+ *
+ */
+MappedFile::
+~MappedFile() {
+  close();
+}
+
+/**
+ * Don't try to copy MappedFiles.
+ */
+MappedFile::
+MappedFile(const MappedFile &copy) {
+  nassertv(false);
+}
+
+/**
+ * Don't try to copy MappedFiles.
+ */
+void MappedFile::
+operator = (const MappedFile &copy) {
+  nassertv(false);
+}
+
+/**
+ * Maps size bytes of the indicated file, beginning at byte start, into
+ * memory for reading.  Returns true on success, false on failure (for
+ * instance, if the file is too large to fit into the address space).
+ */
+bool MappedFile::
+open(const Filename &filename, streampos start, size_t size) {
+  close();
+  if (size == 0) {
+    return false;
+  }
+
+#ifdef _WIN32
+  wstring os_specific = filename.to_os_specific_w();
+  HANDLE file = CreateFileW(os_specific.c_str(), GENERIC_READ,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                            NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  // The mapping must begin on an allocation-granularity boundary.
+  SYSTEM_INFO sysinfo;
+  GetSystemInfo(&sysinfo);
+  unsigned long long offset = (unsigned long long)(streamoff)start;
+  unsigned long long base_offset = offset - (offset % sysinfo.dwAllocationGranularity);
+  size_t lead = (size_t)(offset - base_offset);
+
+  HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(file);
+  if (mapping == NULL) {
+    return false;
+  }
+
+  void *base = MapViewOfFile(mapping, FILE_MAP_READ,
+                             (DWORD)(base_offset >> 32),
+                             (DWORD)(base_offset & 0xffffffff),
+                             lead + size);
+  if (base == NULL) {
+    CloseHandle(mapping);
+    return false;
+  }
+  _handle = mapping;
+
+#else
+  string os_specific = filename.to_os_specific();
+  int fd = ::open(os_specific.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  // The mapping must begin on a page boundary.
+  off_t offset = (off_t)(streamoff)start;
+  off_t page_size = (off_t)sysconf(_SC_PAGESIZE);
+  off_t base_offset = offset - (offset % page_size);
+  size_t lead = (size_t)(offset - base_offset);
+
+  void *base = mmap(NULL, lead + size, PROT_READ, MAP_SHARED, fd, base_offset);
+  ::close(fd);
+  if (base == MAP_FAILED) {
+    return false;
+  }
+#endif
+
+  _base = base;
+  _base_size = lead + size;
+  _data = (const unsigned char *)base + lead;
+  _size = size;
+
+  if (express_cat.is_debug()) {
+    express_cat.debug()
+      << "Mapped " << size << " bytes of " << filename << " at "
+      << (void *)_data << "\n";
+  }
+  return true;
+}
+
+/**
+ * Maps the first size bytes of the indicated file into memory for reading
+ * and writing, creating the file if it does not exist, and extending it with
+ * zero bytes if it is shorter than that.  Changes made through
+ * get_write_data() are seen at once by every other process that has the same
+ * file mapped, and are written back to the file by the operating system in
+ * its own time.  Returns true on success, false on failure.
+ */
+bool MappedFile::
+open_read_write(const Filename &filename, size_t size) {
+  close();
+  if (size == 0) {
+    return false;
+  }
+
+#ifdef _WIN32
+  wstring os_specific = filename.to_os_specific_w();
+  HANDLE file = CreateFileW(os_specific.c_str(), GENERIC_READ | GENERIC_WRITE,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                            NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  // Asking for a mapping larger than the file extends the file.
+  unsigned long long map_size = (unsigned long long)size;
+  HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READWRITE,
+                                      (DWORD)(map_size >> 32),
+                                      (DWORD)(map_size & 0xffffffff), NULL);
+  CloseHandle(file);
+  if (mapping == NULL) {
+    return false;
+  }
+
+  void *base = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+  if (base == NULL) {
+    CloseHandle(mapping);
+    return false;
+  }
+  _handle = mapping;
+
+#else
+  string os_specific = filename.to_os_specific();
+  int fd = ::open(os_specific.c_str(), O_RDWR | O_CREAT, 0666);
+  if (fd < 0) {
+    return false;
+  }
+
+  // Never shrink the file; another process may have mapped more of it.
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      (st.st_size < (off_t)size && ftruncate(fd, (off_t)size) != 0)) {
+    ::close(fd);
+    return false;
+  }
+
+  void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (base == MAP_FAILED) {
+    return false;
+  }
+#endif
+
+  _base = base;
+  _base_size = size;
+  _data = (const unsigned char *)base;
+  _size = size;
+  _writable = true;
+
+  if (express_cat.is_debug()) {
+    express_cat.debug()
+      << "Mapped " << size << " bytes of " << filename
+      << " for writing at " << (void *)_data << "\n";
+  }
+  return true;
+}
+
+/**
+ * Unmaps the file, if it is mapped.  Any MappedFileView objects keep the
+ * MappedFile alive, so this should not be called while there may still be
+ * views into the file.
+ */
+void MappedFile::
+close() {
+  if (_base != NULL) {
+#ifdef _WIN32
+    UnmapViewOfFile(_base);
+    CloseHandle((HANDLE)_handle);
+    _handle = NULL;
+#else
+    munmap(_base, _base_size);
+#endif
+    _base = NULL;
+    _base_size = 0;
+  }
+  _data = NULL;
+  _size = 0;
+  _writable = false;
+}
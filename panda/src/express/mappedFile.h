@@ -0,0 +1,86 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file mappedFile.h
+ * @date 2026-10-18
+ */
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include "pandabase.h"
+#include "referenceCount.h"
+#include "pointerTo.h"
+#include "filename.h"
+
+/**
+ * A memory mapping of a byte range within a file on disk.  The filename is
+ * understood as a physical file on disk, and not to be looked up via the vfs.
+ *
+ * This is used to read uncompressed data, such as the subfiles of a
+ * Multifile, directly out of the operating system's page cache, without
+ * copying it through a stream buffer first.  A whole file may also be mapped
+ * for writing, in which case the mapping is shared with every other process
+ * that maps the same file.
+ */
+class EXPCL_PANDAEXPRESS MappedFile : public ReferenceCount {
+public:
+  MappedFile();
+  ~MappedFile();
+
+private:
+  MappedFile(const MappedFile &copy);
+  void operator = (const MappedFile &copy);
+
+public:
+  bool open(const Filename &filename, streampos start, size_t size);
+  bool open_read_write(const Filename &filename, size_t size);
+  void close();
+
+  INLINE bool is_open() const;
+  INLINE const unsigned char *get_data() const;
+  INLINE unsigned char *get_write_data() const;
+  INLINE size_t get_size() const;
+
+private:
+  const unsigned char *_data;
+  size_t _size;
+  bool _writable;
+
+  // The actual mapping, which begins at an aligned offset at or before
+  // _data.
+  void *_base;
+  size_t _base_size;
+#ifdef _WIN32
+  void *_handle;
+#endif
+};
+
+/**
+ * A window into a MappedFile.  The view holds a reference to the mapping, so
+ * the memory it points to remains valid for as long as the view exists.
+ */
+class EXPCL_PANDAEXPRESS MappedFileView {
+public:
+  INLINE MappedFileView();
+  INLINE MappedFileView(const MappedFile *file, size_t start, size_t size);
+
+  INLINE bool is_valid() const;
+  INLINE const unsigned char *get_data() const;
+  INLINE size_t get_size() const;
+  INLINE void clear();
+
+private:
+  CPT(MappedFile) _file;
+  const unsigned char *_data;
+  size_t _size;
+};
+
+#include "mappedFile.I"
+
+#endif
@@ -0,0 +1,43 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file mappedStream.h
+ * @date 2026-10-18
+ */
+
+#ifndef MAPPEDSTREAM_H
+#define MAPPEDSTREAM_H
+
+#include "pandabase.h"
+#include "mappedStreamBuf.h"
+
+/**
+ * An istream object that reads from a MappedFileView.  The stream's get area
+ * points directly into the mapped memory, so no intermediate buffer is
+ * involved, and unlike an ISubStream, several of these may read from the
+ * same file at once without contending for a lock.
+ */
+class EXPCL_PANDAEXPRESS IMappedStream : public istream {
+public:
+  INLINE IMappedStream();
+  INLINE IMappedStream(const MappedFileView &view);
+
+#if _MSC_VER >= 1800
+  INLINE IMappedStream(const IMappedStream &copy) = delete;
+#endif
+
+  INLINE IMappedStream &open(const MappedFileView &view);
+  INLINE IMappedStream &close();
+
+private:
+  MappedStreamBuf _buf;
+};
+
+#include "mappedStream.I"
+
+#endif
@@ -0,0 +1,120 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file mappedStreamBuf.cxx
+ * @date 2026-10-18
+ */
+
+#include "mappedStreamBuf.h"
+#include "pnotify.h"
+
+/**
+ *
+ */
+MappedStreamBuf::
+MappedStreamBuf() {
+  setg(NULL, NULL, NULL);
+}
+
+/**
+ *
+ */
+MappedStreamBuf::
+~MappedStreamBuf() {
+  close();
+}
+
+/**
+ *
+ */
+void MappedStreamBuf::
+open(const MappedFileView &view) {
+  _view = view;
+
+  // The whole view is the get area; the stream never needs to refill it.
+  char *begin = (char *)_view.get_data();
+  setg(begin, begin, begin + _view.get_size());
+}
+
+/**
+ *
+ */
+void MappedStreamBuf::
+close() {
+  _view.clear();
+  setg(NULL, NULL, NULL);
+}
+
+/**
+ * Implements seeking within the stream.
+ */
+streampos MappedStreamBuf::
+seekoff(streamoff off, ios_seekdir dir, ios_openmode which) {
+  if ((which & ios::in) == 0) {
+    return EOF;
+  }
+
+  streamoff new_pos;
+  switch (dir) {
+  case ios::beg:
+    new_pos = off;
+    break;
+
+  case ios::cur:
+    new_pos = (streamoff)(gptr() - eback()) + off;
+    break;
+
+  case ios::end:
+    new_pos = (streamoff)(egptr() - eback()) + off;
+    break;
+
+  default:
+    // Shouldn't get here.
+    return EOF;
+  }
+
+  if (new_pos < 0 || new_pos > (streamoff)(egptr() - eback())) {
+    // Can't seek outside of the view.
+    return EOF;
+  }
+
+  setg(eback(), eback() + (size_t)new_pos, egptr());
+  return new_pos;
+}
+
+/**
+ * Implements seeking to an absolute position within the stream.  Some
+ * streambuf implementations do not route this through seekoff() by
+ * themselves.
+ */
+streampos MappedStreamBuf::
+seekpos(streampos pos, ios_openmode which) {
+  return seekoff(pos, ios::beg, which);
+}
+
+/**
+ * Returns the number of characters that may be read without blocking, which
+ * is everything that remains in the view.
+ */
+streamsize MappedStreamBuf::
+showmanyc() {
+  return (streamsize)(egptr() - gptr());
+}
+
+/**
+ * Called by the system istream implementation when its internal buffer needs
+ * more characters.  Since the entire view is already in the buffer, this
+ * only happens at the end of the view.
+ */
+int MappedStreamBuf::
+underflow() {
+  if (gptr() < egptr()) {
+    return (unsigned char)*gptr();
+  }
+  return EOF;
+}
@@ -0,0 +1,41 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file mappedStreamBuf.h
+ * @date 2026-10-18
+ */
+
+#ifndef MAPPEDSTREAMBUF_H
+#define MAPPEDSTREAMBUF_H
+
+#include "pandabase.h"
+#include "mappedFile.h"
+
+/**
+ * The streambuf object that implements IMappedStream.
+ */
+class EXPCL_PANDAEXPRESS MappedStreamBuf : public streambuf {
+public:
+  MappedStreamBuf();
+  virtual ~MappedStreamBuf();
+
+  void open(const MappedFileView &view);
+  void close();
+
+  virtual streampos seekoff(streamoff off, ios_seekdir dir, ios_openmode which);
+  virtual streampos seekpos(streampos pos, ios_openmode which);
+
+protected:
+  virtual streamsize showmanyc();
+  virtual int underflow();
+
+private:
+  MappedFileView _view;
+};
+
+#endif
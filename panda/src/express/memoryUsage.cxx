@@ -36,6 +36,23 @@ MemoryUsage *MemoryUsage::_global_ptr;
 // recursive entry.
 bool MemoryUsage::_recursion_protect = false;
 
+// The counter that each thread's allocations are added to, if
+// count-allocs-by-collector is set.
+static THREAD_LOCAL MemoryUsage::AllocCounter *current_alloc_counter = NULL;
+
+/**
+ * Adds an allocation of the indicated size to the calling thread's current
+ * AllocCounter, if it has one.
+ */
+static INLINE void
+count_alloc(size_t size) {
+  MemoryUsage::AllocCounter *counter = current_alloc_counter;
+  if (counter != (MemoryUsage::AllocCounter *)NULL) {
+    ++(counter->_count);
+    counter->_size += size;
+  }
+}
+
 // The cutoff ages, in seconds, for the various buckets in the AgeHistogram.
 double MemoryUsage::AgeHistogram::_cutoff[MemoryUsage::AgeHistogram::num_buckets] = {
   0.0,
@@ -184,6 +201,10 @@ heap_alloc_single(size_t size) {
     }
 
   } else {
+    if (_count_allocs) {
+      count_alloc(size);
+    }
+
     if (_track_memory_usage) {
       ptr = MemoryHook::heap_alloc_single(size);
       /*
@@ -250,6 +271,10 @@ heap_alloc_array(size_t size) {
     }
 
   } else {
+    if (_count_allocs) {
+      count_alloc(size);
+    }
+
     if (_track_memory_usage) {
       ptr = MemoryHook::heap_alloc_array(size);
       /*
@@ -284,6 +309,10 @@ heap_realloc_array(void *ptr, size_t size) {
     }
 
   } else {
+    if (_count_allocs) {
+      count_alloc(size);
+    }
+
     if (_track_memory_usage) {
       get_global_ptr()->ns_remove_void_pointer(ptr);
       ptr = MemoryHook::heap_realloc_array(ptr, size);
@@ -460,6 +489,14 @@ MemoryUsage(const MemoryHook &copy) : MemoryHook(copy) {
 
   _count_memory_usage = false;
 
+  _count_allocs = ConfigVariableBool
+    ("count-allocs-by-collector", false,
+     PRC_DESC("Set this true to count the heap allocations made by each "
+              "thread under each PStatCollector, and report them to PStats "
+              "as levels, under \"Allocations\" and \"Allocated\".  Much "
+              "cheaper than track-memory-usage, but the count is only for the "
+              "innermost collector running when the allocation is made."));
+
   int64_t max_heap_size = ConfigVariableInt64
     ("max-heap-size", 0,
      PRC_DESC("If this is nonzero, it is the maximum number of bytes expected "
@@ -489,6 +526,27 @@ MemoryUsage(const MemoryHook &copy) : MemoryHook(copy) {
   _total_size = 0;
 }
 
+/**
+ * Makes the indicated counter, which may be NULL, the one that the calling
+ * thread's heap allocations are counted in from now on, and returns the
+ * previous one.  The counter must remain valid until it is replaced.
+ */
+MemoryUsage::AllocCounter *MemoryUsage::
+set_alloc_counter(AllocCounter *counter) {
+  AllocCounter *prev = current_alloc_counter;
+  current_alloc_counter = counter;
+  return prev;
+}
+
+/**
+ * Returns the counter that the calling thread's heap allocations are counted
+ * in, or NULL if there is none.
+ */
+MemoryUsage::AllocCounter *MemoryUsage::
+get_alloc_counter() {
+  return current_alloc_counter;
+}
+
 /**
  * Initializes the global MemoryUsage pointer.
  */
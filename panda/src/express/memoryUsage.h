@@ -54,6 +54,20 @@ public:
 
   virtual void mark_pointer(void *ptr, size_t orig_size, ReferenceCount *ref_ptr);
 
+  // If count-allocs-by-collector is set, each heap allocation is counted in
+  // the AllocCounter that is current for the allocating thread, if any.
+  // PStatClient uses this to report the allocations made under each
+  // collector.
+  class AllocCounter {
+  public:
+    size_t _count;
+    size_t _size;
+  };
+
+  INLINE static bool is_counting_allocs();
+  static AllocCounter *set_alloc_counter(AllocCounter *counter);
+  static AllocCounter *get_alloc_counter();
+
 #if (defined(WIN32_VC) || defined(WIN64_VC)) && defined(_DEBUG)
   static int win32_malloc_hook(int alloc_type, void *ptr,
                                size_t size, int block_use, long request,
@@ -187,6 +201,7 @@ private:
   bool _track_memory_usage;
   bool _startup_track_memory_usage;
   bool _count_memory_usage;
+  bool _count_allocs;
   bool _report_memory_usage;
   double _report_memory_interval;
   double _last_report_time;
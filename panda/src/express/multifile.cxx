@@ -19,6 +19,7 @@
 #include "datagram.h"
 #include "zStream.h"
 #include "encryptStream.h"
+#include "mappedStream.h"
 #include "virtualFileSystem.h"
 #include "virtualFile.h"
 
@@ -104,6 +105,7 @@ Multifile() :
 
   _read = (IStreamWrapper *)NULL;
   _write = (ostream *)NULL;
+  _mapping.clear();
   _offset = 0;
   _owns_stream = false;
   _next_index = 0;
@@ -185,7 +187,23 @@ open_read(const Filename &multifile_name, const streampos &offset) {
   _owns_stream = true;
   _multifile_name = multifile_name;
   _offset = offset;
-  return read_index();
+  if (!read_index()) {
+    return false;
+  }
+
+  if (multifile_mmap) {
+    // If the Multifile lives in a file on disk (possibly within some other
+    // file), map it into memory.  If that fails, we fall back to reading it
+    // through the stream.
+    SubfileInfo info;
+    if (vfile->get_system_info(info) && !info.is_empty()) {
+      PT(MappedFile) mapping = new MappedFile;
+      if (mapping->open(info.get_filename(), info.get_start(), (size_t)info.get_size())) {
+        _mapping = mapping;
+      }
+    }
+  }
+  return true;
 }
 
 /**
@@ -347,6 +365,7 @@ close() {
 
   _read = (IStreamWrapper *)NULL;
   _write = (ostream *)NULL;
+  _mapping.clear();
   _offset = 0;
   _owns_stream = false;
   _next_index = 0;
@@ -1203,9 +1222,15 @@ flush() {
     nassertr(_next_index == _write->tellp(), false);
     _next_index = pad_to_streampos(_next_index);
 
-    // All right, now write out each subfile's data.
-    for (pi = _new_subfiles.begin(); pi != _new_subfiles.end(); ++pi) {
-      Subfile *subfile = (*pi);
+    // All right, now write out each subfile's data.  The subfiles that need
+    // to be compressed are compressed in parallel first, a batch at a time,
+    // and then written out in order.
+    size_t encoded_end = 0;
+    for (size_t si = 0; si < _new_subfiles.size(); ++si) {
+      if (si >= encoded_end) {
+        encoded_end = encode_new_subfiles(si);
+      }
+      Subfile *subfile = _new_subfiles[si];
 
       if (_read != (IStreamWrapper *)NULL) {
         _read->acquire();
@@ -1921,6 +1946,7 @@ read_subfile(int index, pvector<unsigned char> &result) {
   result.reserve(subfile->_uncompressed_length);
 
   bool success = true;
+  MappedFileView view;
   if (subfile->_flags & (SF_encrypted | SF_compressed)) {
     // If the subfile is encrypted or compressed, we can't read it directly.
     // Fall back to the generic implementation.
@@ -1932,6 +1958,11 @@ read_subfile(int index, pvector<unsigned char> &result) {
     success = VirtualFile::simple_read_file(in, result);
     close_read_subfile(in);
 
+  } else if (map_subfile_data(subfile, view)) {
+    // If the Multifile is mapped into memory, we can copy the data straight
+    // out of the mapping.
+    result.assign(view.get_data(), view.get_data() + view.get_size());
+
   } else {
     // But if the subfile is just a plain file, we can just read the data
     // directly from the Multifile, without paying the cost of an ISubStream.
@@ -1970,6 +2001,29 @@ read_subfile(int index, pvector<unsigned char> &result) {
   return true;
 }
 
+/**
+ * If the indicated subfile is stored uncompressed and unencrypted, and the
+ * Multifile has been mapped into memory (see multifile-mmap), fills in view
+ * with the subfile's data, without copying it, and returns true.  Otherwise,
+ * returns false, and the subfile must be read with read_subfile() or
+ * open_read_subfile() instead.
+ *
+ * The view remains valid even after the Multifile is closed.
+ */
+bool Multifile::
+get_subfile_view(int index, MappedFileView &view) const {
+  nassertr(index >= 0 && index < (int)_subfiles.size(), false);
+  const Subfile *subfile = _subfiles[index];
+
+  if (subfile->_source != (istream *)NULL ||
+      !subfile->_source_filename.empty() ||
+      (subfile->_flags & (SF_encrypted | SF_compressed)) != 0) {
+    return false;
+  }
+
+  return map_subfile_data(subfile, view);
+}
+
 /**
  * Assumes the _write pointer is at the indicated fpos, rounds the fpos up to
  * the next legitimate address (using normalize_streampos()), and writes
@@ -2041,6 +2095,79 @@ add_new_subfile(Subfile *subfile, int compression_level) {
   _new_subfiles.push_back(subfile);
 }
 
+// The bookkeeping shared between the threads that encode a batch of new
+// subfiles.  The subfiles vary widely in size, so rather than dividing them
+// up ahead of time, each thread claims the next one as soon as it is done
+// with the previous one.
+class Multifile::EncodeJob {
+public:
+  PendingSubfiles _subfiles;
+  size_t _next;
+  MutexImpl _lock;
+  Multifile *_multifile;
+};
+
+/**
+ * Compresses a batch of the subfiles in _new_subfiles, beginning at the
+ * indicated index, using up to multifile-encode-threads threads.  The results are held in memory until write_data() copies them
+ * into the Multifile.  Returns the index of the first subfile after the
+ * batch.
+ */
+size_t Multifile::
+encode_new_subfiles(size_t begin) {
+  if (multifile_encode_threads == 1) {
+    // Don't bother; write_data() will encode each subfile as it goes.
+    return _new_subfiles.size();
+  }
+
+  EncodeJob job;
+  job._next = 0;
+  job._multifile = this;
+
+  size_t max_buffer_size = (size_t)max((int)multifile_encode_buffer_size, 0);
+  size_t buffer_size = 0;
+  size_t end = begin;
+  while (end < _new_subfiles.size()) {
+    Subfile *subfile = _new_subfiles[end];
+    if (subfile->needs_encoding()) {
+      size_t source_size = (size_t)max(subfile->_source_filename.get_file_size(), (streamsize)0);
+      if (!job._subfiles.empty() && buffer_size + source_size > max_buffer_size) {
+        break;
+      }
+      buffer_size += source_size;
+      job._subfiles.push_back(subfile);
+    }
+    ++end;
+  }
+
+  if (job._subfiles.size() > 1) {
+    (*global_parallel_for)(&encode_subfiles_worker, &job,
+                           (int)job._subfiles.size(), multifile_encode_threads);
+  }
+  return end;
+}
+
+/**
+ * The thread function that encodes the subfiles of an EncodeJob.  Each
+ * invocation ignores the range it is given, and instead keeps claiming
+ * subfiles from the job until there are none left.
+ */
+void Multifile::
+encode_subfiles_worker(void *data, int, int) {
+  EncodeJob *job = (EncodeJob *)data;
+
+  while (true) {
+    job->_lock.acquire();
+    size_t si = job->_next++;
+    job->_lock.release();
+
+    if (si >= job->_subfiles.size()) {
+      return;
+    }
+    job->_subfiles[si]->encode_data(job->_multifile);
+  }
+}
+
 /**
  * This variant of open_read_subfile() is used internally only, and accepts a
  * pointer to the internal Subfile object, which is assumed to be valid and
@@ -2051,12 +2178,20 @@ open_read_subfile(Subfile *subfile) {
   nassertr(subfile->_source == (istream *)NULL &&
            subfile->_source_filename.empty(), NULL);
 
-  // Return an ISubStream object that references into the open Multifile
-  // istream.
   nassertr(subfile->_data_start != (streampos)0, NULL);
-  istream *stream =
-    new ISubStream(_read, _offset + subfile->_data_start,
-                   _offset + subfile->_data_start + (streampos)subfile->_data_length);
+  istream *stream;
+  MappedFileView view;
+  if (map_subfile_data(subfile, view)) {
+    // Return an IMappedStream that reads directly from the mapped Multifile.
+    stream = new IMappedStream(view);
+
+  } else {
+    // Return an ISubStream object that references into the open Multifile
+    // istream.
+    stream =
+      new ISubStream(_read, _offset + subfile->_data_start,
+                     _offset + subfile->_data_start + (streampos)subfile->_data_length);
+  }
 
   if ((subfile->_flags & SF_encrypted) != 0) {
 #ifndef HAVE_OPENSSL
@@ -2107,6 +2242,27 @@ open_read_subfile(Subfile *subfile) {
   return stream;
 }
 
+/**
+ * Fills in view with the raw data of the indicated subfile, as it is stored
+ * within the Multifile, if the Multifile has been mapped into memory.
+ * Returns false if it has not.
+ */
+bool Multifile::
+map_subfile_data(const Subfile *subfile, MappedFileView &view) const {
+  if (_mapping == (MappedFile *)NULL) {
+    return false;
+  }
+
+  size_t start = (size_t)(streamoff)(_offset + subfile->_data_start);
+  if (start > _mapping->get_size() ||
+      subfile->_data_length > _mapping->get_size() - start) {
+    return false;
+  }
+
+  view = MappedFileView(_mapping, start, subfile->_data_length);
+  return true;
+}
+
 /**
  * Returns the standard form of the subfile name.
  */
@@ -2629,7 +2785,8 @@ write_data(ostream &write, istream *read, streampos fpos,
 
   istream *source = _source;
   pifstream source_file;
-  if (source == (istream *)NULL && !_source_filename.empty()) {
+  if (source == (istream *)NULL && !_source_filename.empty() &&
+      !_has_encoded_data) {
     // If we have a filename, open it up and read that.
     if (!_source_filename.open_read(source_file)) {
       // Unable to open the source file.
@@ -2643,7 +2800,15 @@ write_data(ostream &write, istream *read, streampos fpos,
     }
   }
 
-  if (source == (istream *)NULL) {
+  if (_has_encoded_data) {
+    // The data has already been compressed and/or encrypted by
+    // encode_data(); we only have to copy it in.
+    write.write(_encoded_data.data(), _encoded_data.size());
+    _data_length = _encoded_data.size();
+    _encoded_data = string();
+    _has_encoded_data = false;
+
+  } else if (source == (istream *)NULL) {
     // We don't have any source data.  Perhaps we're reading from an already-
     // packed Subfile (e.g.  during repack()).
     if (read == (istream *)NULL) {
@@ -2652,57 +2817,31 @@ write_data(ostream &write, istream *read, streampos fpos,
         << "No source for subfile " << _name << ".\n";
       _flags |= SF_data_invalid;
     } else {
-      // Read the data from the original Multifile.
+      // Read the data from the original Multifile, a buffer at a time.
+      static const size_t buffer_size = 4096;
+      char buffer[buffer_size];
+
       read->seekg(_data_start + multifile->_offset);
-      for (size_t p = 0; p < _data_length; p++) {
-        int byte = read->get();
-        if (read->eof() || read->fail()) {
+      size_t remaining = _data_length;
+      while (remaining != 0) {
+        size_t num_bytes = min(buffer_size, remaining);
+        read->read(buffer, num_bytes);
+        if ((size_t)read->gcount() != num_bytes) {
           // Unexpected EOF or other failure on the source file.
           express_cat.info()
             << "Unexpected EOF for subfile " << _name << ".\n";
           _flags |= SF_data_invalid;
           break;
         }
-        write.put(byte);
+        write.write(buffer, num_bytes);
+        remaining -= num_bytes;
       }
     }
   } else {
     // We do have source data.  Copy it in, and also measure its length.
-    ostream *putter = &write;
     bool delete_putter = false;
-
-#ifndef HAVE_OPENSSL
-    // Without OpenSSL, we can't support encryption.  The flag had better not
-    // be set.
-    nassertr((_flags & SF_encrypted) == 0, fpos);
-
-#else  // HAVE_OPENSSL
-    if ((_flags & SF_encrypted) != 0) {
-      // Write it encrypted.
-      OEncryptStream *encrypt = new OEncryptStream;
-      encrypt->set_iteration_count(multifile->_encryption_iteration_count);
-      encrypt->open(putter, delete_putter, multifile->_encryption_password);
-
-      putter = encrypt;
-      delete_putter = true;
-
-      // Also write the encrypt_header to the beginning of the encrypted
-      // stream, so we can validate the password on decryption.
-      putter->write(_encrypt_header, _encrypt_header_size);
-    }
-#endif  // HAVE_OPENSSL
-
-#ifndef HAVE_ZLIB
-    // Without ZLIB, we can't support compression.  The flag had better not be
-    // set.
-    nassertr((_flags & SF_compressed) == 0, fpos);
-#else  // HAVE_ZLIB
-    if ((_flags & SF_compressed) != 0) {
-      // Write it compressed.
-      putter = new OCompressStream(putter, delete_putter, _compression_level);
-      delete_putter = true;
-    }
-#endif  // HAVE_ZLIB
+    ostream *putter = open_encoder(&write, delete_putter, multifile);
+    nassertr(putter != (ostream *)NULL, fpos);
 
     streampos write_start = fpos;
     _uncompressed_length = 0;
@@ -2807,6 +2946,115 @@ write_data(ostream &write, istream *read, streampos fpos,
   return fpos + (streampos)_data_length;
 }
 
+/**
+ * Returns true if the subfile's data is still to be read from a file on disk
+ * and compressed, so that encode_data() may usefully be called on it from
+ * another thread.
+ *
+ * Encrypted subfiles are left for write_data() to encrypt on the calling
+ * thread, since OpenSSL is not safe to use from several threads at once
+ * unless the application has installed its locking callbacks.
+ */
+bool Multifile::Subfile::
+needs_encoding() const {
+  return (_source == (istream *)NULL && !_source_filename.empty() &&
+          !_has_encoded_data &&
+          (_flags & SF_compressed) != 0 &&
+          (_flags & (SF_encrypted | SF_signature)) == 0);
+}
+
+/**
+ * Reads the subfile's source file, and compresses and/or encrypts it into a
+ * buffer in memory, to be copied into the Multifile later by write_data().
+ * This does not touch the Multifile's streams, so it may be called for
+ * several subfiles at once from different threads.
+ *
+ * If the source file cannot be read, this does nothing, and leaves it to
+ * write_data() to report the error.
+ */
+void Multifile::Subfile::
+encode_data(Multifile *multifile) {
+  pifstream source_file;
+  if (!_source_filename.open_read(source_file)) {
+    return;
+  }
+
+  ostringstream dest;
+  bool delete_putter = false;
+  ostream *putter = open_encoder(&dest, delete_putter, multifile);
+  nassertv(putter != (ostream *)NULL);
+
+  static const size_t buffer_size = 4096;
+  char buffer[buffer_size];
+
+  size_t uncompressed_length = 0;
+  source_file.read(buffer, buffer_size);
+  size_t count = source_file.gcount();
+  while (count != 0) {
+    uncompressed_length += count;
+    putter->write(buffer, count);
+    source_file.read(buffer, buffer_size);
+    count = source_file.gcount();
+  }
+
+  if (delete_putter) {
+    delete putter;
+  }
+
+  _encoded_data = dest.str();
+  _uncompressed_length = uncompressed_length;
+  _has_encoded_data = true;
+}
+
+/**
+ * Returns an ostream that encrypts and/or compresses the data written to it,
+ * according to the subfile's flags, and passes the result on to the
+ * indicated stream.  If delete_dest is set true on return, the caller should
+ * delete the returned stream when it is done writing; otherwise, the returned
+ * stream is dest itself.  Returns NULL if the required library is not
+ * compiled in.
+ */
+ostream *Multifile::Subfile::
+open_encoder(ostream *dest, bool &delete_dest, Multifile *multifile) {
+  ostream *putter = dest;
+  delete_dest = false;
+
+#ifndef HAVE_OPENSSL
+  // Without OpenSSL, we can't support encryption.  The flag had better not be
+  // set.
+  nassertr((_flags & SF_encrypted) == 0, NULL);
+
+#else  // HAVE_OPENSSL
+  if ((_flags & SF_encrypted) != 0) {
+    // Write it encrypted.
+    OEncryptStream *encrypt = new OEncryptStream;
+    encrypt->set_iteration_count(multifile->_encryption_iteration_count);
+    encrypt->open(putter, delete_dest, multifile->_encryption_password);
+
+    putter = encrypt;
+    delete_dest = true;
+
+    // Also write the encrypt_header to the beginning of the encrypted stream,
+    // so we can validate the password on decryption.
+    putter->write(_encrypt_header, _encrypt_header_size);
+  }
+#endif  // HAVE_OPENSSL
+
+#ifndef HAVE_ZLIB
+  // Without ZLIB, we can't support compression.  The flag had better not be
+  // set.
+  nassertr((_flags & SF_compressed) == 0, NULL);
+#else  // HAVE_ZLIB
+  if ((_flags & SF_compressed) != 0) {
+    // Write it compressed.
+    putter = new OCompressStream(putter, delete_dest, _compression_level);
+    delete_dest = true;
+  }
+#endif  // HAVE_ZLIB
+
+  return putter;
+}
+
 /**
  * Seeks within the indicate pfstream back to the index record and rewrites
  * just the _data_start and _data_length part of the index record.
@@ -19,6 +19,7 @@
 #include "config_express.h"
 #include "streamWrapper.h"
 #include "subStream.h"
+#include "mappedFile.h"
 #include "filename.h"
 #include "ordered_vector.h"
 #include "indirectLess.h"
@@ -159,6 +160,7 @@ public:
 
   bool read_subfile(int index, string &result);
   bool read_subfile(int index, pvector<unsigned char> &result);
+  bool get_subfile_view(int index, MappedFileView &view) const;
 
 private:
   enum SubfileFlags {
@@ -181,6 +183,10 @@ private:
                           Multifile *multifile);
     streampos write_data(ostream &write, istream *read, streampos fpos,
                          Multifile *multifile);
+    bool needs_encoding() const;
+    void encode_data(Multifile *multifile);
+    ostream *open_encoder(ostream *dest, bool &delete_dest,
+                          Multifile *multifile);
     void rewrite_index_data_start(ostream &write, Multifile *multifile);
     void rewrite_index_flags(ostream &write);
     INLINE bool is_deleted() const;
@@ -200,6 +206,8 @@ private:
     Filename _source_filename;
     int _flags;
     int _compression_level;  // Not preserved on disk.
+    string _encoded_data;    // Not preserved on disk.
+    bool _has_encoded_data;  // Not preserved on disk.
 #ifdef HAVE_OPENSSL
     EVP_PKEY *_pkey;         // Not preserved on disk.
 #endif
@@ -211,7 +219,11 @@ private:
   streampos pad_to_streampos(streampos fpos);
 
   void add_new_subfile(Subfile *subfile, int compression_level);
+  class EncodeJob;
+  size_t encode_new_subfiles(size_t begin);
+  static void encode_subfiles_worker(void *data, int begin, int end);
   istream *open_read_subfile(Subfile *subfile);
+  bool map_subfile_data(const Subfile *subfile, MappedFileView &view) const;
   string standardize_subfile_name(const string &subfile_name) const;
 
   void clear_subfiles();
@@ -237,6 +249,7 @@ private:
   streampos _offset;
   IStreamWrapper *_read;
   ostream *_write;
+  PT(MappedFile) _mapping;
   bool _owns_stream;
   streampos _next_index;
   streampos _last_index;
@@ -13,6 +13,10 @@
 #include "fileReference.cxx"
 #include "hashGeneratorBase.cxx"
 #include "hashVal.cxx"
+#include "ioUringReader.cxx"
+#include "mappedFile.cxx"
+#include "mappedStream.cxx"
+#include "mappedStreamBuf.cxx"
 #include "memoryInfo.cxx"
 #include "memoryUsage.cxx"
 #include "memoryUsagePointerCounts.cxx"
@@ -0,0 +1,106 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_lookup_cache.cxx
+ * @date 2026-10-19
+ */
+
+#include "pandabase.h"
+#include "virtualFileSystem.h"
+#include "trueClock.h"
+#include "filename.h"
+
+// Checks that the VirtualFileSystem remembers a failed lookup on disk, under
+// the root mount, for vfs-lookup-cache-lifetime seconds, once that has been
+// set to something other than its default of 0.  The file is
+// written behind the VirtualFileSystem's back, so the only way the second
+// lookup can fail is by being answered from the cache.
+
+static int num_failures = 0;
+
+/**
+ * Reports whether the file was found as expected.
+ */
+static void
+check(const char *step, VirtualFileSystem *vfs, const Filename &filename,
+      bool expected) {
+  bool found = vfs->exists(filename);
+  nout << step << ": " << (found ? "found" : "not found");
+  if (found != expected) {
+    nout << " (expected " << (expected ? "found" : "not found") << ")";
+    ++num_failures;
+  }
+  nout << "\n";
+}
+
+/**
+ * Writes the file directly to disk, without going through the
+ * VirtualFileSystem.
+ */
+static void
+write_file(const Filename &filename) {
+  Filename path(filename);
+  path.set_text();
+  pofstream out;
+  if (!path.open_write(out)) {
+    nout << "Couldn't write " << path << "\n";
+    exit(1);
+  }
+  out << "test\n";
+}
+
+/**
+ * Waits for the indicated number of seconds.
+ */
+static void
+wait_for(double seconds) {
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double end = clock->get_short_time() + seconds;
+  while (clock->get_short_time() < end) {
+  }
+}
+
+int
+main(int argc, char *argv[]) {
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+  double lifetime = 0.5;
+  vfs->vfs_lookup_cache_lifetime.set_value(lifetime);
+
+  Filename filename = Filename::temporary("", "test_lookup_cache");
+  filename.unlink();
+
+  check("before writing", vfs, filename, false);
+
+  write_file(filename);
+  check("written on disk, miss still cached", vfs, filename, false);
+
+  vfs->clear_lookup_cache();
+  check("after clear_lookup_cache", vfs, filename, true);
+
+  filename.unlink();
+  check("deleted on disk", vfs, filename, false);
+  write_file(filename);
+  check("written again, miss still cached", vfs, filename, false);
+
+  wait_for(lifetime * 1.5);
+  check("after the lifetime", vfs, filename, true);
+
+  filename.unlink();
+  vfs->vfs_lookup_cache_lifetime.set_value(0.0);
+  check("lifetime 0, deleted on disk", vfs, filename, false);
+  write_file(filename);
+  check("lifetime 0, written again", vfs, filename, true);
+
+  filename.unlink();
+  if (num_failures != 0) {
+    nout << num_failures << " checks failed.\n";
+    return 1;
+  }
+  nout << "All checks passed.\n";
+  return 0;
+}
@@ -372,6 +372,18 @@ read_file(pvector<unsigned char> &result, bool auto_unwrap) const {
   return false;
 }
 
+/**
+ * Fills in view with the contents of the file, without copying it, if the
+ * file can be mapped directly into memory; for instance, if it is an
+ * uncompressed subfile of a Multifile on disk.  Returns true on success, or
+ * false if the file cannot be mapped, in which case it must be read with
+ * read_file() or open_read_file() instead.
+ */
+bool VirtualFile::
+map_file(MappedFileView &view) const {
+  return false;
+}
+
 /**
  * Writes the indicated data to the file, if it is writable.  Returns true on
  * success, false otherwise.
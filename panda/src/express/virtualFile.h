@@ -18,6 +18,7 @@
 
 #include "filename.h"
 #include "subfileInfo.h"
+#include "mappedFile.h"
 #include "pointerTo.h"
 #include "typedReferenceCount.h"
 #include "ordered_vector.h"
@@ -86,6 +87,7 @@ public:
   INLINE void set_original_filename(const Filename &filename);
   bool read_file(string &result, bool auto_unwrap) const;
   virtual bool read_file(pvector<unsigned char> &result, bool auto_unwrap) const;
+  virtual bool map_file(MappedFileView &view) const;
   virtual bool write_file(const unsigned char *data, size_t data_size, bool auto_wrap);
 
   static bool simple_read_file(istream *stream, pvector<unsigned char> &result);
@@ -118,6 +118,17 @@ is_writable(const Filename &file) const {
   return false;
 }
 
+/**
+ * Returns true if files may appear within this mount without going through
+ * the VirtualFileSystem, for instance because they are written to disk by
+ * some other means.  The VirtualFileSystem is more careful about remembering
+ * that a file doesn't exist within such a mount.
+ */
+bool VirtualFileMount::
+can_change_externally() const {
+  return true;
+}
+
 /**
  * Fills up the indicated pvector with the contents of the file, if it is a
  * regular file.  Returns true on success, false otherwise.
@@ -150,6 +161,17 @@ read_file(const Filename &file, bool do_uncompress,
   return okflag;
 }
 
+/**
+ * Fills in view with the contents of the file, without copying it, if the
+ * file is a regular file that can be mapped directly into memory.  Returns
+ * true on success, or false if the file cannot be mapped, in which case it
+ * must be read with read_file() or open_read_file() instead.
+ */
+bool VirtualFileMount::
+map_file(const Filename &file, MappedFileView &view) const {
+  return false;
+}
+
 /**
  * Writes the indicated data to the file, if it is a writable file.  Returns
  * true on success, false otherwise.
@@ -52,9 +52,11 @@ public:
   virtual bool is_directory(const Filename &file) const=0;
   virtual bool is_regular_file(const Filename &file) const=0;
   virtual bool is_writable(const Filename &file) const;
+  virtual bool can_change_externally() const;
 
   virtual bool read_file(const Filename &file, bool do_uncompress,
                          pvector<unsigned char> &result) const;
+  virtual bool map_file(const Filename &file, MappedFileView &view) const;
   virtual bool write_file(const Filename &file, bool do_compress,
                           const unsigned char *data, size_t data_size);
 
@@ -53,6 +53,16 @@ is_regular_file(const Filename &file) const {
   return (_multifile->find_subfile(file) >= 0);
 }
 
+/**
+ * Returns true if files may appear within this mount without going through
+ * the VirtualFileSystem.  This is only possible if the Multifile has been
+ * opened for writing.
+ */
+bool VirtualFileMountMultifile::
+can_change_externally() const {
+  return _multifile->is_write_valid();
+}
+
 /**
  * Fills up the indicated pvector with the contents of the file, if it is a
  * regular file.  Returns true on success, false otherwise.
@@ -80,6 +90,21 @@ read_file(const Filename &file, bool do_uncompress,
   return _multifile->read_subfile(subfile_index, result);
 }
 
+/**
+ * Fills in view with the contents of the file, without copying it, if the
+ * subfile is stored uncompressed and unencrypted and the Multifile has been
+ * mapped into memory.  Returns true on success, false otherwise.
+ */
+bool VirtualFileMountMultifile::
+map_file(const Filename &file, MappedFileView &view) const {
+  int subfile_index = _multifile->find_subfile(file);
+  if (subfile_index < 0) {
+    return false;
+  }
+
+  return _multifile->get_subfile_view(subfile_index, view);
+}
+
 /**
  * Opens the file for reading, if it exists.  Returns a newly allocated
  * istream on success (which you should eventually delete when you are done
@@ -34,9 +34,11 @@ public:
   virtual bool has_file(const Filename &file) const;
   virtual bool is_directory(const Filename &file) const;
   virtual bool is_regular_file(const Filename &file) const;
+  virtual bool can_change_externally() const;
 
   virtual bool read_file(const Filename &file, bool do_uncompress,
                          pvector<unsigned char> &result) const;
+  virtual bool map_file(const Filename &file, MappedFileView &view) const;
 
   virtual istream *open_read_file(const Filename &file) const;
   virtual streamsize get_file_size(const Filename &file, istream *stream) const;
@@ -156,6 +156,35 @@ is_writable(const Filename &file) const {
   return pathname.is_writable();
 }
 
+/**
+ * Fills in view with the contents of the file, by mapping it into memory.
+ * Returns true on success, false otherwise.
+ */
+bool VirtualFileMountSystem::
+map_file(const Filename &file, MappedFileView &view) const {
+#ifdef WIN32
+  // First ensure that the file exists to validate its case.
+  if (VirtualFileSystem::get_global_ptr()->vfs_case_sensitive) {
+    if (!has_file(file)) {
+      return false;
+    }
+  }
+#endif  // WIN32
+  Filename pathname(_physical_filename, file);
+  streamsize size = pathname.get_file_size();
+  if (size <= 0 || !pathname.is_regular_file()) {
+    return false;
+  }
+
+  PT(MappedFile) mapping = new MappedFile;
+  if (!mapping->open(pathname, 0, (size_t)size)) {
+    return false;
+  }
+
+  view = MappedFileView(mapping, 0, mapping->get_size());
+  return true;
+}
+
 /**
  * Opens the file for reading, if it exists.  Returns a newly allocated
  * istream on success (which you should eventually delete when you are done
@@ -38,6 +38,8 @@ public:
   virtual bool is_regular_file(const Filename &file) const;
   virtual bool is_writable(const Filename &file) const;
 
+  virtual bool map_file(const Filename &file, MappedFileView &view) const;
+
   virtual istream *open_read_file(const Filename &file) const;
   virtual ostream *open_write_file(const Filename &file, bool truncate);
   virtual ostream *open_append_file(const Filename &file);
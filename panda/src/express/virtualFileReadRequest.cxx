@@ -0,0 +1,196 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file virtualFileReadRequest.cxx
+ * @date 2026-10-18
+ */
+
+#include "virtualFileReadRequest.h"
+#include "virtualFileSimple.h"
+#include "ioUringReader.h"
+#include "subfileInfo.h"
+#include "config_express.h"
+#include "dcast.h"
+
+#ifdef HAVE_IO_URING
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+TypeHandle VirtualFileReadRequest::_type_handle;
+VirtualFileReadRequest::BackgroundFunc *VirtualFileReadRequest::_background_func = NULL;
+
+/**
+ * Creates a request to read the indicated file.  The read does not begin
+ * until start() is called.
+ */
+VirtualFileReadRequest::
+VirtualFileReadRequest(VirtualFile *file, bool auto_unwrap) :
+  _file(file),
+  _auto_unwrap(auto_unwrap),
+  _success(false),
+  _state(S_pending),
+  _in_ring(false),
+  _fd(-1),
+  _file_start(0),
+  _bytes_read(0)
+{
+}
+
+/**
+ *
+ */
+VirtualFileReadRequest::
+~VirtualFileReadRequest() {
+  nassertv(!_in_ring);
+}
+
+/**
+ * Returns true if the read has finished, successfully or otherwise, or false
+ * if it is still in progress.  This never blocks.
+ */
+bool VirtualFileReadRequest::
+is_ready() const {
+  if (AtomicAdjust::get(_state) == S_done) {
+    return true;
+  }
+
+#ifdef HAVE_IO_URING
+  if (AtomicAdjust::get(_state) == S_reading) {
+    // The read is in the ring, and nobody else has collected its completion
+    // yet.  See if we can.
+    IoUringReader::get_global_ptr()->poll();
+  }
+#endif
+
+  return AtomicAdjust::get(_state) == S_done;
+}
+
+/**
+ * Blocks until the read has finished.  If it has not yet been started by a
+ * background thread, it is performed on the calling thread instead.
+ */
+void VirtualFileReadRequest::
+wait() {
+#ifdef HAVE_IO_URING
+  if (AtomicAdjust::get(_state) == S_reading) {
+    IoUringReader::get_global_ptr()->wait(this);
+  }
+#endif
+
+  // If the read was handed off to a background thread, this waits for that
+  // thread to finish it, or does it here if it hasn't started yet.
+  do_read();
+}
+
+/**
+ * Begins reading the file.  This is normally called only by
+ * VirtualFileSystem::read_file_async().
+ */
+void VirtualFileReadRequest::
+start() {
+  if (!start_io_uring()) {
+    start_background();
+  }
+}
+
+/**
+ * Reads the file on the current thread, unless it has already been read (or
+ * is being read by the ring).  If another thread is in the middle of reading
+ * it, blocks until that thread is done.
+ *
+ * This is called by the background thread to which the request was handed
+ * off; it may also be called by any other thread that needs the data right
+ * away.
+ */
+void VirtualFileReadRequest::
+do_read() {
+  _read_lock.acquire();
+  if (AtomicAdjust::get(_state) == S_pending) {
+    _success = _file->read_file(_data, _auto_unwrap);
+    AtomicAdjust::set(_state, S_done);
+  }
+  _read_lock.release();
+}
+
+/**
+ * Specifies the function that is used to hand requests off to a background
+ * thread, when they can't be read through io_uring.  If this is NULL, such
+ * requests are read immediately by start().
+ */
+void VirtualFileReadRequest::
+set_background_func(BackgroundFunc *func) {
+  _background_func = func;
+}
+
+/**
+ * Attempts to submit the read to the kernel via io_uring.  This is possible
+ * only if the data can be read verbatim from a byte range of a file on disk.
+ * Returns true if the read is now in flight, or false if it must be read some
+ * other way.
+ */
+bool VirtualFileReadRequest::
+start_io_uring() {
+#ifdef HAVE_IO_URING
+  IoUringReader *reader = IoUringReader::get_global_ptr();
+  if (reader == (IoUringReader *)NULL) {
+    return false;
+  }
+
+  // If the file needs to be decompressed, we need the stream interface.
+  if (_file->is_of_type(VirtualFileSimple::get_class_type()) &&
+      DCAST(VirtualFileSimple, _file.p())->is_implicit_pz_file()) {
+    return false;
+  }
+  if (_auto_unwrap) {
+    string extension = _file->get_filename().get_extension();
+    if (extension == "pz" || extension == "gz") {
+      return false;
+    }
+  }
+
+  SubfileInfo info;
+  if (!_file->get_system_info(info) || info.is_empty() ||
+      info.get_size() <= 0) {
+    return false;
+  }
+
+  Filename pathname = info.get_filename();
+  string os_specific = pathname.to_os_specific();
+  _fd = open(os_specific.c_str(), O_RDONLY | O_CLOEXEC);
+  if (_fd < 0) {
+    return false;
+  }
+
+  _file_start = (uint64_t)info.get_start();
+  _data.resize((size_t)info.get_size());
+  if (!reader->submit(this)) {
+    close(_fd);
+    _fd = -1;
+    _data.clear();
+    return false;
+  }
+  return true;
+
+#else
+  return false;
+#endif  // HAVE_IO_URING
+}
+
+/**
+ * Hands the request off to a background thread, if one is available, or
+ * reads it immediately otherwise.
+ */
+void VirtualFileReadRequest::
+start_background() {
+  if (_background_func != NULL) {
+    (*_background_func)(this);
+  } else {
+    do_read();
+  }
+}
@@ -0,0 +1,117 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file virtualFileReadRequest.h
+ * @date 2026-10-18
+ */
+
+#ifndef VIRTUALFILEREADREQUEST_H
+#define VIRTUALFILEREADREQUEST_H
+
+#include "pandabase.h"
+#include "typedReferenceCount.h"
+#include "virtualFile.h"
+#include "pointerTo.h"
+#include "pvector.h"
+#include "mutexImpl.h"
+#include "atomicAdjust.h"
+
+/**
+ * A handle on the contents of a file that are being read in the background,
+ * as returned by VirtualFileSystem::read_file_async().
+ *
+ * Code running in an AsyncTask may poll is_ready() each epoch, and collect
+ * the data once it returns true; other code may simply call wait().  Many
+ * requests may be outstanding at once.  On Linux, files on disk and
+ * uncompressed subfiles of Multifiles on disk are read via io_uring where the
+ * kernel supports it; anything else is read on a background thread, if one
+ * is available, or on the calling thread otherwise.
+ */
+class EXPCL_PANDAEXPRESS VirtualFileReadRequest : public TypedReferenceCount {
+public:
+  VirtualFileReadRequest(VirtualFile *file, bool auto_unwrap);
+
+PUBLISHED:
+  virtual ~VirtualFileReadRequest();
+
+  INLINE VirtualFile *get_file() const;
+  INLINE const Filename &get_filename() const;
+
+  bool is_ready() const;
+  BLOCKING void wait();
+
+  INLINE bool get_success() const;
+  INLINE size_t get_data_size() const;
+
+public:
+  INLINE const pvector<unsigned char> &get_data() const;
+  INLINE void take_data(pvector<unsigned char> &result);
+
+  void start();
+  void do_read();
+
+  // A function that arranges for do_read() to be called on some other
+  // thread.  The task system installs one of these at startup.
+  typedef void BackgroundFunc(VirtualFileReadRequest *request);
+  static void set_background_func(BackgroundFunc *func);
+
+private:
+  bool start_io_uring();
+  void start_background();
+
+  enum State {
+    S_pending,
+    S_reading,
+    S_done,
+  };
+
+  PT(VirtualFile) _file;
+  bool _auto_unwrap;
+  pvector<unsigned char> _data;
+  bool _success;
+
+  // One of the State values; this is read without holding a lock to see if
+  // the request is finished.  S_reading means it is in the io_uring.
+  AtomicAdjust::Integer _state;
+
+  // Held by whichever thread is performing do_read(), so that any other
+  // thread calling wait() blocks until it is done.
+  MutexImpl _read_lock;
+
+  // The following are used only while the request is being read via
+  // io_uring, and are protected by the IoUringReader's lock.
+  bool _in_ring;
+  int _fd;
+  uint64_t _file_start;
+  size_t _bytes_read;
+
+  static BackgroundFunc *_background_func;
+
+public:
+  static TypeHandle get_class_type() {
+    return _type_handle;
+  }
+  static void init_type() {
+    TypedReferenceCount::init_type();
+    register_type(_type_handle, "VirtualFileReadRequest",
+                  TypedReferenceCount::get_class_type());
+  }
+  virtual TypeHandle get_type() const {
+    return get_class_type();
+  }
+  virtual TypeHandle force_init_type() {init_type(); return get_class_type();}
+
+private:
+  static TypeHandle _type_handle;
+
+  friend class IoUringReader;
+};
+
+#include "virtualFileReadRequest.I"
+
+#endif
@@ -379,6 +379,21 @@ read_file(pvector<unsigned char> &result, bool auto_unwrap) const {
   return _mount->read_file(local_filename, do_uncompress, result);
 }
 
+/**
+ * Fills in view with the contents of the file, without copying it, if the
+ * file can be mapped directly into memory.  Returns true on success, false
+ * otherwise.
+ */
+bool VirtualFileSimple::
+map_file(MappedFileView &view) const {
+  if (_implicit_pz_file) {
+    // The file must be decompressed first.
+    return false;
+  }
+
+  return _mount->map_file(_local_filename, view);
+}
+
 /**
  * Writes the indicated data to the file, if it is writable.  Returns true on
  * success, false otherwise.
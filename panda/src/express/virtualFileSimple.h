@@ -64,6 +64,7 @@ public:
   virtual bool atomic_read_contents(string &contents) const;
 
   virtual bool read_file(pvector<unsigned char> &result, bool auto_unwrap) const;
+  virtual bool map_file(MappedFileView &view) const;
   virtual bool write_file(const unsigned char *data, size_t data_size, bool auto_wrap);
 
 protected:
@@ -24,6 +24,7 @@
 #include "config_express.h"
 #include "executionEnvironment.h"
 #include "pset.h"
+#include "trueClock.h"
 
 VirtualFileSystem *VirtualFileSystem::_global_ptr = NULL;
 
@@ -62,10 +63,33 @@ VirtualFileSystem() :
             "will implicitly retrieve a file named 'dirname/mytex.jpg' "
             "within the multifile /c/files/foo.mf, even if the multifile "
             "has not already been mounted.  This makes all of your multifiles "
-            "act like directories."))
+            "act like directories.")),
+  vfs_lookup_cache_size
+  ("vfs-lookup-cache-size", 1024,
+   PRC_DESC("The maximum number of pathnames that the VirtualFileSystem "
+            "will remember it has failed to find, so that repeated searches "
+            "for files that don't exist (for instance, along the model-path) "
+            "can fail immediately.  The cache is cleared whenever a file "
+            "system is mounted or unmounted, or a file is created through "
+            "the VirtualFileSystem.  Set this to 0 to disable it.")),
+  vfs_lookup_cache_lifetime
+  ("vfs-lookup-cache-lifetime", 0.0,
+   PRC_DESC("The number of seconds for which a failed lookup is remembered "
+            "when the pathname falls within a mount whose contents may "
+            "change without the VirtualFileSystem's knowledge, such as a "
+            "directory on disk, which includes the root mount.  This is 0 "
+            "by default, so that such lookups always look on disk again.  "
+            "Setting it to a fraction of a second saves repeated searches "
+            "along the model-path for files that aren't there, but a file "
+            "written to disk by some other means, such as another process "
+            "or Python's open(), may then go unseen for up to this long "
+            "after a failed attempt to find it, unless clear_lookup_cache() "
+            "is called.  Failed lookups within read-only multifiles "
+            "are remembered regardless of this setting."))
 {
   _cwd = "/";
   _mount_seq = 0;
+  _index_seq = 0;
 }
 
 /**
@@ -722,6 +746,21 @@ write(ostream &out) const {
 }
 
 
+/**
+ * Forgets all of the pathnames that the VirtualFileSystem remembers having
+ * failed to find.  This is done automatically when anything is mounted or
+ * unmounted, or when a file is created through the VirtualFileSystem; you
+ * only need to call it if vfs-lookup-cache-lifetime is nonzero and a file has
+ * been written to disk by other means, or if a mounted Multifile has been
+ * modified directly.
+ */
+void VirtualFileSystem::
+clear_lookup_cache() {
+  _lock.acquire();
+  do_clear_lookup_cache();
+  _lock.release();
+}
+
 /**
  * Returns the default global VirtualFileSystem.  You may create your own
  * personal VirtualFileSystem objects and use them for whatever you like, but
@@ -850,6 +889,29 @@ open_read_file(const Filename &filename, bool auto_unwrap) const {
   return str;
 }
 
+/**
+ * Begins reading the entire contents of the indicated file in the background,
+ * and returns a handle that may be polled or waited on to collect the data.
+ * Many reads may be in progress at once.  Returns NULL if the file does not
+ * exist.
+ *
+ * The file is looked up immediately; only reading its contents happens in
+ * the background.  If auto_unwrap is true, an explicitly-named .pz file is
+ * automatically decompressed, as with read_file().
+ */
+PT(VirtualFileReadRequest) VirtualFileSystem::
+read_file_async(const Filename &filename, bool auto_unwrap) const {
+  PT(VirtualFile) file = get_file(filename, false);
+  if (file == (VirtualFile *)NULL || !file->is_regular_file()) {
+    return NULL;
+  }
+
+  PT(VirtualFileReadRequest) request =
+    new VirtualFileReadRequest(file, auto_unwrap);
+  request->start();
+  return request;
+}
+
 /**
  * Closes a file opened by a previous call to open_read_file().  This really
  * just deletes the istream pointer, but it is recommended to use this
@@ -1149,19 +1211,42 @@ do_get_file(const Filename &filename, int open_flags) const {
   // Also transparently look for a regular file suffixed .pz.
   Filename strpath_pz = strpath + ".pz";
 
-  // Now scan all the mount points, from the back (since later mounts override
-  // more recent ones), until a match is found.
+  VirtualFileSystem *self = (VirtualFileSystem *)this;
+  if (_index_seq != _mount_seq) {
+    self->rebuild_mount_index();
+  }
+
+  bool creating =
+    (open_flags & (OF_create_file | OF_make_directory | OF_allow_nonexist)) != 0;
+  if (creating) {
+    // A file may be about to appear where there wasn't one before.
+    self->do_clear_lookup_cache();
+
+  } else if (self->check_lookup_cache(strpath)) {
+    // We already know this file doesn't exist.
+    return NULL;
+  }
+
+  // Now scan the mount points that might contain this file, from the back
+  // (since later mounts override more recent ones), until a match is found.
   PT(VirtualFile) found_file = NULL;
   VirtualFileComposite *composite_file = NULL;
+  bool may_change = false;
 
-  // We use an index instead of an iterator, since the vector might change if
+  // We iterate over a list of indices, since the vector might change if
   // implicit mounts are added during this loop.
   unsigned int start_seq = _mount_seq;
 
-  size_t i = _mounts.size();
-  while (i > 0) {
-    --i;
-    VirtualFileMount *mount = _mounts[i];
+  pvector<size_t> candidates;
+  get_candidate_mounts(candidates, strpath);
+
+  size_t ci = 0;
+  while (ci < candidates.size()) {
+    VirtualFileMount *mount = _mounts[candidates[ci]];
+    ++ci;
+    if (mount->can_change_externally()) {
+      may_change = true;
+    }
     Filename mount_point = mount->get_mount_point();
     if (strpath == mount_point) {
       // Here's an exact match on the mount point.  This filename is the root
@@ -1185,9 +1270,7 @@ do_get_file(const Filename &filename, int open_flags) const {
       }
 #endif  // HAVE_ZLIB
 
-    } else if (strpath.length() > mount_point.length() &&
-               mount_point == strpath.substr(0, mount_point.length()) &&
-               strpath[mount_point.length()] == '/') {
+    } else {
       // This pathname falls within this mount system.
       Filename local_filename = strpath.substr(mount_point.length() + 1);
       Filename local_filename_pz = strpath_pz.substr(mount_point.length() + 1);
@@ -1210,7 +1293,9 @@ do_get_file(const Filename &filename, int open_flags) const {
     // the above operations, start over from the beginning of the loop.
     if (start_seq != _mount_seq) {
       start_seq = _mount_seq;
-      i = _mounts.size();
+      self->rebuild_mount_index();
+      get_candidate_mounts(candidates, strpath);
+      ci = 0;
     }
   }
 
@@ -1226,6 +1311,10 @@ do_get_file(const Filename &filename, int open_flags) const {
     }
   }
 
+  if (found_file == (VirtualFile *)NULL && !creating) {
+    self->record_lookup_miss(strpath, may_change);
+  }
+
   return found_file;
 }
 
@@ -1349,3 +1438,131 @@ consider_mount_mf(const Filename &filename) {
   // Recurse.
   return consider_mount_mf(dirname);
 }
+
+/**
+ * Rebuilds _mount_index from the current list of mounts.  Since the set of
+ * files visible through the file system may have changed, this also clears
+ * the lookup cache.
+ *
+ * Assumes the lock is already held.
+ */
+void VirtualFileSystem::
+rebuild_mount_index() {
+  _mount_index.clear();
+  for (size_t i = 0; i < _mounts.size(); ++i) {
+    const string &mount_point = _mounts[i]->get_mount_point().get_fullpath();
+    _mount_index[mount_point].push_back(i);
+  }
+  _index_seq = _mount_seq;
+
+  do_clear_lookup_cache();
+}
+
+/**
+ * Fills candidates with the indices of the mounts that might contain the
+ * indicated pathname (given relative to the root, without the initial
+ * slash), in descending order.  These are the mounts at the root, at the
+ * pathname itself, or at any of its parent directories.
+ *
+ * Assumes the lock is already held, and that the mount index is current.
+ */
+void VirtualFileSystem::
+get_candidate_mounts(pvector<size_t> &candidates, const string &path) const {
+  candidates.clear();
+
+  // Look up each prefix of the pathname that ends at a directory boundary,
+  // beginning with the empty string for the root mount point.
+  size_t end = 0;
+  while (true) {
+    MountIndex::const_iterator mi = _mount_index.find(path.substr(0, end));
+    if (mi != _mount_index.end()) {
+      candidates.insert(candidates.end(), (*mi).second.begin(), (*mi).second.end());
+    }
+    if (end >= path.length()) {
+      break;
+    }
+    end = path.find('/', end + 1);
+    if (end == string::npos) {
+      end = path.length();
+    }
+  }
+
+  sort(candidates.begin(), candidates.end(), greater<size_t>());
+}
+
+/**
+ * Returns true if the indicated pathname is in the lookup cache, meaning it
+ * is already known not to exist.  Expired entries are removed as they are
+ * encountered.
+ *
+ * Assumes the lock is already held.
+ */
+bool VirtualFileSystem::
+check_lookup_cache(const string &path) {
+  if (_lookup_cache.empty()) {
+    return false;
+  }
+
+  LookupCache::iterator ci = _lookup_cache.find(path);
+  if (ci == _lookup_cache.end()) {
+    return false;
+  }
+
+  double expires = (*ci).second;
+  if (expires != 0.0 &&
+      TrueClock::get_global_ptr()->get_short_time() >= expires) {
+    // It's time to look again.  The name stays in _lookup_cache_order until
+    // it reaches the front; it does no harm there.
+    _lookup_cache.erase(ci);
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Records that the indicated pathname was not found.  If may_change is true,
+ * one of the mounts that was searched may acquire the file without our
+ * knowledge, so the entry expires after vfs-lookup-cache-lifetime seconds.
+ *
+ * Assumes the lock is already held.
+ */
+void VirtualFileSystem::
+record_lookup_miss(const string &path, bool may_change) {
+  int max_size = vfs_lookup_cache_size;
+  if (max_size <= 0) {
+    return;
+  }
+
+  double expires = 0.0;
+  if (may_change) {
+    double lifetime = vfs_lookup_cache_lifetime;
+    if (lifetime <= 0.0) {
+      return;
+    }
+    expires = TrueClock::get_global_ptr()->get_short_time() + lifetime;
+  }
+
+  pair<LookupCache::iterator, bool> result =
+    _lookup_cache.insert(LookupCache::value_type(path, expires));
+  if (!result.second) {
+    (*result.first).second = expires;
+    return;
+  }
+
+  _lookup_cache_order.push_back(path);
+  while ((int)_lookup_cache_order.size() > max_size) {
+    _lookup_cache.erase(_lookup_cache_order.front());
+    _lookup_cache_order.pop_front();
+  }
+}
+
+/**
+ * The private implementation of clear_lookup_cache().  Assumes the lock is
+ * already held.
+ */
+void VirtualFileSystem::
+do_clear_lookup_cache() {
+  _lookup_cache.clear();
+  _lookup_cache_order.clear();
+}
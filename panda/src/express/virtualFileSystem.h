@@ -19,12 +19,15 @@
 #include "virtualFile.h"
 #include "virtualFileMount.h"
 #include "virtualFileList.h"
+#include "virtualFileReadRequest.h"
 #include "filename.h"
 #include "dSearchPath.h"
 #include "pointerTo.h"
 #include "config_express.h"
 #include "mutexImpl.h"
 #include "pvector.h"
+#include "pdeque.h"
+#include "pmap.h"
 
 class Multifile;
 class VirtualFileComposite;
@@ -92,12 +95,14 @@ PUBLISHED:
   INLINE void ls_all(const Filename &filename) const;
 
   void write(ostream &out) const;
+  void clear_lookup_cache();
 
   static VirtualFileSystem *get_global_ptr();
 
   EXTENSION(BLOCKING PyObject *read_file(const Filename &filename, bool auto_unwrap) const);
   BLOCKING istream *open_read_file(const Filename &filename, bool auto_unwrap) const;
   BLOCKING static void close_read_file(istream *stream);
+  PT(VirtualFileReadRequest) read_file_async(const Filename &filename, bool auto_unwrap) const;
 
   EXTENSION(BLOCKING PyObject *write_file(const Filename &filename, PyObject *data, bool auto_wrap));
   BLOCKING ostream *open_write_file(const Filename &filename, bool auto_wrap, bool truncate);
@@ -145,6 +150,8 @@ public:
   ConfigVariableBool vfs_case_sensitive;
   ConfigVariableBool vfs_implicit_pz;
   ConfigVariableBool vfs_implicit_mf;
+  ConfigVariableInt vfs_lookup_cache_size;
+  ConfigVariableDouble vfs_lookup_cache_lifetime;
 
 private:
   Filename normalize_mount_point(const Filename &mount_point) const;
@@ -157,11 +164,32 @@ private:
                       int open_flags) const;
   bool consider_mount_mf(const Filename &filename);
 
+  void rebuild_mount_index();
+  void get_candidate_mounts(pvector<size_t> &candidates,
+                            const string &path) const;
+  bool check_lookup_cache(const string &path);
+  void record_lookup_miss(const string &path, bool may_change);
+  void do_clear_lookup_cache();
+
   MutexImpl _lock;
   typedef pvector<PT(VirtualFileMount) > Mounts;
   Mounts _mounts;
   unsigned int _mount_seq;
 
+  // The indices within _mounts of the mounts at each mount point, in
+  // ascending order.  This is rebuilt whenever _index_seq falls behind
+  // _mount_seq.
+  typedef phash_map<string, pvector<size_t>, string_hash> MountIndex;
+  MountIndex _mount_index;
+  unsigned int _index_seq;
+
+  // The pathnames recently found not to exist, each with the time at which
+  // the entry expires, or 0 if it doesn't.  _lookup_cache_order records the
+  // order in which they were added, so the oldest can be evicted first.
+  typedef phash_map<string, double, string_hash> LookupCache;
+  LookupCache _lookup_cache;
+  pdeque<string> _lookup_cache_order;
+
   Filename _cwd;
 
   static VirtualFileSystem *_global_ptr;
@@ -120,9 +120,9 @@ ConfigVariableBool driver_compress_textures
           "or results by setting this true.  Setting it true may also "
           "allow you to take advantage of some exotic compression algorithm "
           "other than DXT1/3/5 that your graphics driver supports, but "
-          "which is unknown to Panda.  If the libsquish library is not "
-          "compiled into Panda, textures cannot be compressed in-memory, "
-          "and will always be handed to the graphics driver, regardless "
+          "which is unknown to Panda.  Panda can compress DXT1/3/5 and "
+          "RGTC textures in-memory by itself; textures in other formats "
+          "will always be handed to the graphics driver, regardless "
           "of this setting."));
 
 ConfigVariableBool driver_generate_mipmaps
@@ -131,6 +131,25 @@ ConfigVariableBool driver_generate_mipmaps
           "automatically in all cases, if supported.  Set it false "
           "to generate mipmaps in software when possible."));
 
+ConfigVariableInt mipmap_generation_threads
+("mipmap-generation-threads", 0,
+ PRC_DESC("The number of threads that may be used to generate the mipmap "
+          "levels of a large texture in software, when driver-generate-"
+          "mipmaps is false or when Texture::generate_ram_mipmap_images() "
+          "is called explicitly.  The rows and pages of each level are "
+          "divided among the threads.  Set this to 0 to use as many "
+          "threads as the hardware supports, or to 1 to generate all "
+          "mipmaps on the calling thread."));
+
+ConfigVariableInt texture_compression_threads
+("texture-compression-threads", 0,
+ PRC_DESC("The number of threads that may be used to compress or decompress "
+          "a large texture in software, for instance when compressed-"
+          "textures is true and driver-compress-textures is false.  The "
+          "block rows of each mipmap level are divided among the threads.  "
+          "Set this to 0 to use as many threads as the hardware supports, "
+          "or to 1 to do all of the work on the calling thread."));
+
 ConfigVariableBool vertex_buffers
 ("vertex-buffers", true,
  PRC_DESC("Set this true to allow the use of vertex buffers (or buffer "
@@ -38,6 +38,8 @@ extern EXPCL_PANDA_GOBJ ConfigVariableList exclude_texture_scale;
 extern EXPCL_PANDA_GOBJ ConfigVariableBool keep_texture_ram;
 extern EXPCL_PANDA_GOBJ ConfigVariableBool driver_compress_textures;
 extern EXPCL_PANDA_GOBJ ConfigVariableBool driver_generate_mipmaps;
+extern EXPCL_PANDA_GOBJ ConfigVariableInt mipmap_generation_threads;
+extern EXPCL_PANDA_GOBJ ConfigVariableInt texture_compression_threads;
 extern EXPCL_PANDA_GOBJ ConfigVariableBool vertex_buffers;
 extern EXPCL_PANDA_GOBJ ConfigVariableBool vertex_arrays;
 extern EXPCL_PANDA_GOBJ ConfigVariableBool display_lists;
@@ -0,0 +1,148 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_texture_compress.cxx
+ * @date 2026-10-18
+ */
+
+#include "texture.h"
+#include "pnmImage.h"
+#include "trueClock.h"
+#include "cmath.h"
+
+// Measures the throughput and the quality (as PSNR) of the in-memory texture
+// compressors, for each supported compression mode and quality level.  An
+// image filename may be given on the command line; otherwise a synthetic
+// image is used.
+
+static const int num_iterations = 4;
+
+/**
+ * Returns the peak signal-to-noise ratio of b relative to a, in dB.
+ */
+static double
+compute_psnr(CPTA_uchar a, CPTA_uchar b) {
+  if (a.size() != b.size() || a.empty()) {
+    return 0.0;
+  }
+  double sum = 0.0;
+  for (size_t i = 0; i < a.size(); ++i) {
+    double d = (double)a[i] - (double)b[i];
+    sum += d * d;
+  }
+  double mse = sum / (double)a.size();
+  if (mse == 0.0) {
+    return 99.0;
+  }
+  return 10.0 * log10(255.0 * 255.0 / mse);
+}
+
+/**
+ * Compresses and decompresses the texture num_iterations times, and reports
+ * the results.
+ */
+static void
+run_test(Texture *source, Texture::CompressionMode compression,
+         Texture::QualityLevel quality_level) {
+  CPTA_uchar original = source->get_ram_image();
+  double megabytes = (double)original.size() / (1024.0 * 1024.0);
+
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double compress_time = 0.0;
+  double uncompress_time = 0.0;
+  PT(Texture) tex;
+
+  for (int i = 0; i < num_iterations; ++i) {
+    tex = source->make_copy();
+
+    double start = clock->get_short_time();
+    if (!tex->compress_ram_image(compression, quality_level)) {
+      nout << "  " << compression << " " << quality_level
+           << ": not supported\n";
+      return;
+    }
+    double mid = clock->get_short_time();
+    tex->uncompress_ram_image();
+    double end = clock->get_short_time();
+
+    compress_time += mid - start;
+    uncompress_time += end - mid;
+  }
+
+  nout << "  " << compression << " " << quality_level << ": "
+       << megabytes * num_iterations / compress_time << " MB/s compress, "
+       << megabytes * num_iterations / uncompress_time << " MB/s uncompress, "
+       << compute_psnr(original, tex->get_ram_image()) << " dB\n";
+}
+
+/**
+ * Runs all of the tests on the given texture.
+ */
+static void
+run_tests(Texture *source, Texture::CompressionMode *modes, int num_modes) {
+  nout << source->get_x_size() << " x " << source->get_y_size() << ", "
+       << source->get_num_components() << " components:\n";
+
+  static const Texture::QualityLevel levels[] = {
+    Texture::QL_fastest, Texture::QL_normal, Texture::QL_best,
+  };
+
+  for (int m = 0; m < num_modes; ++m) {
+    for (int l = 0; l < 3; ++l) {
+      run_test(source, modes[m], levels[l]);
+    }
+  }
+}
+
+int
+main(int argc, char *argv[]) {
+  PNMImage image;
+  if (argc > 1) {
+    if (!image.read(Filename::from_os_specific(argv[1]))) {
+      nout << "Unable to read " << argv[1] << "\n";
+      return 1;
+    }
+    image.add_alpha();
+
+  } else {
+    // Make up an image with smooth gradients, some noise and hard edges.
+    image.clear(1024, 1024, 4);
+    for (int y = 0; y < image.get_y_size(); ++y) {
+      for (int x = 0; x < image.get_x_size(); ++x) {
+        float noise = (float)((x * 7919 + y * 104729) % 61) / 1220.0f;
+        image.set_xel(x, y,
+                      (float)x / image.get_x_size() + noise,
+                      (float)y / image.get_y_size(),
+                      0.5f + 0.4f * csin(x * 0.05f + y * 0.03f));
+        image.set_alpha(x, y, ((x / 32 + y / 32) & 1) ? 1.0f : 0.0f);
+      }
+    }
+  }
+
+  PT(Texture) tex = new Texture("rgba");
+  tex->load(image);
+  tex->set_minfilter(SamplerState::FT_linear);
+
+  Texture::CompressionMode rgba_modes[] = {
+    Texture::CM_dxt1, Texture::CM_dxt3, Texture::CM_dxt5,
+  };
+  run_tests(tex, rgba_modes, 3);
+
+  PNMImage two_channel(image.get_x_size(), image.get_y_size(), 2);
+  two_channel.copy_sub_image(image, 0, 0);
+  PT(Texture) rg_tex = new Texture("rg");
+  rg_tex->load(two_channel);
+  rg_tex->set_minfilter(SamplerState::FT_linear);
+
+  Texture::CompressionMode rg_modes[] = {
+    Texture::CM_rgtc,
+  };
+  run_tests(rg_tex, rg_modes, 1);
+
+  return 0;
+}
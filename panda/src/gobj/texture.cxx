@@ -42,6 +42,7 @@
 #include "streamReader.h"
 #include "texturePeeker.h"
 #include "convert_srgb.h"
+#include "parallelFor.h"
 
 #ifdef HAVE_SQUISH
 #include <squish.h>
@@ -49,6 +50,11 @@
 
 #include <stddef.h>
 
+#if defined(__SSE2__) || (_M_IX86_FP >= 2) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define TEXTURE_MIPMAP_SSE2 1
+#endif
+
 ConfigVariableEnum<Texture::QualityLevel> texture_quality_level
 ("texture-quality-level", Texture::QL_normal,
  PRC_DESC("This specifies a global quality level for all textures.  You "
@@ -64,6 +70,88 @@ TypeHandle Texture::_type_handle;
 TypeHandle Texture::CData::_type_handle;
 AutoTextureScale Texture::_textures_power_2 = ATS_unspecified;
 
+/**
+ * Converts an IEEE 754 half-precision float, as stored in a T_half_float
+ * texture, to a single-precision float.
+ */
+static float
+half_to_float(uint16_t h) {
+  union {
+    uint32_t _i;
+    float _f;
+  } v;
+
+  uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+  uint32_t exponent = (h >> 10) & 0x1f;
+  uint32_t mantissa = h & 0x3ff;
+
+  if (exponent == 0x1f) {
+    // Infinity or NaN.
+    v._i = sign | 0x7f800000 | (mantissa << 13);
+  } else if (exponent != 0) {
+    // A normalized number.
+    v._i = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  } else if (mantissa != 0) {
+    // A denormalized number, which is normalized as a float.
+    exponent = 113;
+    while ((mantissa & 0x400) == 0) {
+      mantissa <<= 1;
+      --exponent;
+    }
+    v._i = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+  } else {
+    v._i = sign;
+  }
+  return v._f;
+}
+
+/**
+ * Converts a single-precision float to an IEEE 754 half-precision float,
+ * rounding to the nearest representable value.
+ */
+static uint16_t
+float_to_half(float f) {
+  union {
+    float _f;
+    uint32_t _i;
+  } v;
+  v._f = f;
+
+  uint16_t sign = (uint16_t)((v._i >> 16) & 0x8000);
+  int exponent = (int)((v._i >> 23) & 0xff) - 112;
+  uint32_t mantissa = v._i & 0x7fffff;
+
+  if (exponent >= 0x1f) {
+    if (((v._i >> 23) & 0xff) == 0xff && mantissa != 0) {
+      // NaN.
+      return sign | 0x7e00;
+    }
+    // Overflow; this becomes infinity.
+    return sign | 0x7c00;
+
+  } else if (exponent <= 0) {
+    if (exponent < -10) {
+      // Too small even for a denormal; flush to zero.
+      return sign;
+    }
+    // A denormalized half.
+    mantissa |= 0x800000;
+    int shift = 14 - exponent;
+    uint32_t half_mantissa = mantissa >> shift;
+    if ((mantissa >> (shift - 1)) & 1) {
+      ++half_mantissa;
+    }
+    return sign | (uint16_t)half_mantissa;
+  }
+
+  uint16_t h = sign | (uint16_t)(exponent << 10) | (uint16_t)(mantissa >> 13);
+  if (mantissa & 0x1000) {
+    // Round up; this may carry into the exponent, which is what we want.
+    ++h;
+  }
+  return h;
+}
+
 // Stuff to read and write DDS files.
 
 // little-endian, of course
@@ -5876,77 +5964,14 @@ do_compress_ram_image(CData *cdata, Texture::CompressionMode compression,
 
   if (compression == CM_rgtc) {
     // We should compress RGTC ourselves, as squish does not support it.
-    if (cdata->_component_type != T_unsigned_byte) {
-      return false;
-    }
-
-    if (!do_has_all_ram_mipmap_images(cdata)) {
-      // If we're about to compress the RAM image, we should ensure that we
-      // have all of the mipmap levels first.
-      do_generate_ram_mipmap_images(cdata, false);
-    }
-
-    RamImages compressed_ram_images;
-    compressed_ram_images.resize(cdata->_ram_images.size());
-
-    for (size_t n = 0; n < cdata->_ram_images.size(); ++n) {
-      const RamImage *uncompressed_image = &cdata->_ram_images[n];
-
-      int x_size = do_get_expected_mipmap_x_size(cdata, n);
-      int y_size = do_get_expected_mipmap_y_size(cdata, n);
-      int num_pages = do_get_expected_mipmap_num_pages(cdata, n);
-
-      // It is important that we handle image sizes that aren't a multiple of
-      // the block size, since this method may be used to compress mipmaps,
-      // which go all the way to 1x1.  Pad the image if necessary.
-      RamImage temp_image;
-      if ((x_size | y_size) & 0x3) {
-        int virtual_x_size = x_size;
-        int virtual_y_size = y_size;
-        x_size = (x_size + 3) & ~0x3;
-        y_size = (y_size + 3) & ~0x3;
-
-        temp_image._page_size = x_size * y_size * cdata->_num_components;
-        temp_image._image = PTA_uchar::empty_array(temp_image._page_size * num_pages);
-
-        for (int z = 0; z < num_pages; ++z) {
-          unsigned char *dest = temp_image._image.p() + z * temp_image._page_size;
-          unsigned const char *src = uncompressed_image->_image.p() + z * uncompressed_image->_page_size;
-
-          for (int y = 0; y < virtual_y_size; ++y) {
-            memcpy(dest, src, virtual_x_size);
-            src += virtual_x_size;
-            dest += x_size;
-          }
-        }
-
-        uncompressed_image = &temp_image;
-      }
-
-      // Create a new image to hold the compressed texture pages.
-      RamImage &compressed_image = compressed_ram_images[n];
-      compressed_image._page_size = (x_size * y_size * cdata->_num_components) >> 1;
-      compressed_image._image = PTA_uchar::empty_array(compressed_image._page_size * num_pages);
-
-      if (cdata->_num_components == 1) {
-        do_compress_ram_image_bc4(*uncompressed_image, compressed_image,
-                                  x_size, y_size, num_pages);
-      } else if (cdata->_num_components == 2) {
-        do_compress_ram_image_bc5(*uncompressed_image, compressed_image,
-                                  x_size, y_size, num_pages);
-      } else {
-        // Invalid.
-        return false;
-      }
-    }
-
-    cdata->_ram_images.swap(compressed_ram_images);
-    cdata->_ram_image_compression = CM_rgtc;
-    return true;
+    return do_compress_ram_image_blocks(cdata, compression, quality_level);
   }
 
 #ifdef HAVE_SQUISH
-  if (cdata->_texture_type != TT_3d_texture &&
+  // Our own DXT encoder is faster than squish and better than its range fit,
+  // but squish's iterative cluster fit still gives the best results.
+  if (quality_level == QL_best &&
+      cdata->_texture_type != TT_3d_texture &&
       cdata->_texture_type != TT_2d_texture_array &&
       cdata->_component_type == T_unsigned_byte) {
     int squish_flags = 0;
@@ -5969,25 +5994,7 @@ do_compress_ram_image(CData *cdata, Texture::CompressionMode compression,
 
     if (squish_flags != 0) {
       // This compression mode is supported by squish; use it.
-      switch (quality_level) {
-      case QL_fastest:
-        squish_flags |= squish::kColourRangeFit;
-        break;
-
-      case QL_normal:
-        // ColourClusterFit is just too slow for everyday use.
-        squish_flags |= squish::kColourRangeFit;
-        // squish_flags |= squish::kColourClusterFit;
-        break;
-
-      case QL_best:
-        squish_flags |= squish::kColourIterativeClusterFit;
-        break;
-
-      default:
-        break;
-      }
-
+      squish_flags |= squish::kColourIterativeClusterFit;
       if (do_squish(cdata, compression, squish_flags)) {
         return true;
       }
@@ -5995,6 +6002,12 @@ do_compress_ram_image(CData *cdata, Texture::CompressionMode compression,
   }
 #endif  // HAVE_SQUISH
 
+  if (cdata->_texture_type != TT_3d_texture &&
+      cdata->_texture_type != TT_2d_texture_array) {
+    // Fall back to our own DXT encoder.
+    return do_compress_ram_image_blocks(cdata, compression, quality_level);
+  }
+
   return false;
 }
 
@@ -6007,34 +6020,7 @@ do_uncompress_ram_image(CData *cdata) {
 
   if (cdata->_ram_image_compression == CM_rgtc) {
     // We should decompress RGTC ourselves, as squish doesn't support it.
-    RamImages uncompressed_ram_images;
-    uncompressed_ram_images.resize(cdata->_ram_images.size());
-
-    for (size_t n = 0; n < cdata->_ram_images.size(); ++n) {
-      const RamImage &compressed_image = cdata->_ram_images[n];
-
-      int x_size = do_get_expected_mipmap_x_size(cdata, n);
-      int y_size = do_get_expected_mipmap_y_size(cdata, n);
-      int num_pages = do_get_expected_mipmap_num_pages(cdata, n);
-
-      RamImage &uncompressed_image = uncompressed_ram_images[n];
-      uncompressed_image._page_size = do_get_expected_ram_mipmap_page_size(cdata, n);
-      uncompressed_image._image = PTA_uchar::empty_array(uncompressed_image._page_size * num_pages);
-
-      if (cdata->_num_components == 1) {
-        do_uncompress_ram_image_bc4(compressed_image, uncompressed_image,
-                                    x_size, y_size, num_pages);
-      } else if (cdata->_num_components == 2) {
-        do_uncompress_ram_image_bc5(compressed_image, uncompressed_image,
-                                    x_size, y_size, num_pages);
-      } else {
-        // Invalid.
-        return false;
-      }
-    }
-    cdata->_ram_images.swap(uncompressed_ram_images);
-    cdata->_ram_image_compression = CM_off;
-    return true;
+    return do_uncompress_ram_image_blocks(cdata);
   }
 
 #ifdef HAVE_SQUISH
@@ -6067,578 +6053,946 @@ do_uncompress_ram_image(CData *cdata) {
     }
   }
 #endif  // HAVE_SQUISH
-  return false;
+
+  // Otherwise, decompress DXT ourselves.
+  return do_uncompress_ram_image_blocks(cdata);
 }
 
-/**
- * Compresses a RAM image using BC4 compression.
- */
-void Texture::
-do_compress_ram_image_bc4(const RamImage &uncompressed_image,
-                          RamImage &compressed_image,
-                          int x_size, int y_size, int num_pages) {
-  int x_blocks = (x_size >> 2);
-  int y_blocks = (y_size >> 2);
+// The bookkeeping shared between the threads that compress or decompress one
+// mipmap level.  Each thread processes a range of block rows, numbered
+// consecutively across all of the pages.
+struct Texture::BlockCodecJob {
+  CompressionMode _compression;
+  int _num_components;
+  int _refine_passes;
 
-  // NB. This algorithm isn't fully optimal, since it doesn't try to make use
-  // of the secondary interpolation mode supported by BC4.  This is not
-  // important for most textures, but it may be added in the future.
+  int _x_size, _y_size;
+  int _x_blocks, _y_blocks;
+  size_t _block_size;
 
-  nassertv((size_t)x_blocks * (size_t)y_blocks * 4 * 4 <= uncompressed_image._page_size);
-  nassertv((size_t)x_size * (size_t)y_size == uncompressed_image._page_size);
+  unsigned char *_compressed;
+  size_t _compressed_page_size;
+  unsigned char *_uncompressed;
+  size_t _uncompressed_page_size;
+};
 
-  static const int remap[] = {1, 7, 6, 5, 4, 3, 2, 0};
+/**
+ * Divides the block rows of a mipmap level among several threads, according
+ * to texture-compression-threads, but only if there are enough blocks to make
+ * it worthwhile.
+ */
+static void
+run_block_codec(ParallelForFunc *func, void *job,
+                int num_block_rows, int blocks_per_row) {
+  // Don't spawn a thread for fewer than this many blocks.
+  static const size_t min_blocks_per_thread = 1024;
 
-  for (int z = 0; z < num_pages; ++z) {
-    unsigned char *dest = compressed_image._image.p() + z * compressed_image._page_size;
-    unsigned const char *src = uncompressed_image._image.p() + z * uncompressed_image._page_size;
-
-    // Convert one 4 x 4 block at a time.
-    for (int y = 0; y < y_blocks; ++y) {
-      for (int x = 0; x < x_blocks; ++x) {
-        int a, b, c, d;
-        float fac, add;
-        unsigned char minv, maxv;
-        unsigned const char *blk = src;
-
-        // Find the minimum and maximum value in the block.
-        minv = blk[0];
-        maxv = blk[0];
-        minv = min(blk[1], minv); maxv = max(blk[1], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[3], minv); maxv = max(blk[3], maxv);
-        blk += x_size;
-        minv = min(blk[0], minv); maxv = max(blk[0], maxv);
-        minv = min(blk[1], minv); maxv = max(blk[1], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[3], minv); maxv = max(blk[3], maxv);
-        blk += x_size;
-        minv = min(blk[0], minv); maxv = max(blk[0], maxv);
-        minv = min(blk[1], minv); maxv = max(blk[1], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[3], minv); maxv = max(blk[3], maxv);
-        blk += x_size;
-        minv = min(blk[0], minv); maxv = max(blk[0], maxv);
-        minv = min(blk[1], minv); maxv = max(blk[1], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[3], minv); maxv = max(blk[3], maxv);
-
-        // Now calculate the index for each pixel.
-        blk = src;
-        if (maxv > minv) {
-          fac = 7.5f / (maxv - minv);
-        } else {
-          fac = 0;
-        }
-        add = -minv * fac;
-        a = (remap[(int)(blk[0] * fac + add)])
-          | (remap[(int)(blk[1] * fac + add)] << 3)
-          | (remap[(int)(blk[2] * fac + add)] << 6)
-          | (remap[(int)(blk[3] * fac + add)] << 9);
-        blk += x_size;
-        b = (remap[(int)(blk[0] * fac + add)] << 4)
-          | (remap[(int)(blk[1] * fac + add)] << 7)
-          | (remap[(int)(blk[2] * fac + add)] << 10)
-          | (remap[(int)(blk[3] * fac + add)] << 13);
-        blk += x_size;
-        c = (remap[(int)(blk[0] * fac + add)])
-          | (remap[(int)(blk[1] * fac + add)] << 3)
-          | (remap[(int)(blk[2] * fac + add)] << 6)
-          | (remap[(int)(blk[3] * fac + add)] << 9);
-        blk += x_size;
-        d = (remap[(int)(blk[0] * fac + add)] << 4)
-          | (remap[(int)(blk[1] * fac + add)] << 7)
-          | (remap[(int)(blk[2] * fac + add)] << 10)
-          | (remap[(int)(blk[3] * fac + add)] << 13);
-
-        *(dest++) = maxv;
-        *(dest++) = minv;
-        *(dest++) = a & 0xff;
-        *(dest++) = (a >> 8) | (b & 0xf0);
-        *(dest++) = b >> 8;
-        *(dest++) = c & 0xff;
-        *(dest++) = (c >> 8) | (d & 0xf0);
-        *(dest++) = d >> 8;
-
-        // Advance to the beginning of the next 4x4 block.
-        src += 4;
-      }
-      src += x_size * 3;
-    }
-    Thread::consider_yield();
+  int num_threads = texture_compression_threads;
+  if (num_threads <= 0) {
+    num_threads = Thread::get_num_supported_threads();
   }
+  size_t total_blocks = (size_t)num_block_rows * (size_t)blocks_per_row;
+  num_threads = (int)min((size_t)num_threads, total_blocks / min_blocks_per_thread);
+
+  parallel_for(func, job, num_block_rows, max(num_threads, 1), "CompressTexture");
 }
 
 /**
- * Compresses a RAM image using BC5 compression.
+ * Expands a 5:6:5 packed color into 8-bit RGB components.
  */
-void Texture::
-do_compress_ram_image_bc5(const RamImage &uncompressed_image,
-                          RamImage &compressed_image,
-                          int x_size, int y_size, int num_pages) {
-  int x_blocks = (x_size >> 2);
-  int y_blocks = (y_size >> 2);
-  int stride = x_size * 2;
-
-  // BC5 uses the same compression algorithm as BC4, except repeated for two
-  // channels.
-
-  nassertv((size_t)x_blocks * (size_t)y_blocks * 4 * 4 * 2 <= uncompressed_image._page_size);
-  nassertv((size_t)stride * (size_t)y_size == uncompressed_image._page_size);
-
-  static const int remap[] = {1, 7, 6, 5, 4, 3, 2, 0};
+static inline void
+bc_unpack_565(unsigned int color, int rgb[3]) {
+  int r = (color >> 11) & 0x1f;
+  int g = (color >> 5) & 0x3f;
+  int b = color & 0x1f;
+  rgb[0] = (r << 3) | (r >> 2);
+  rgb[1] = (g << 2) | (g >> 4);
+  rgb[2] = (b << 3) | (b >> 2);
+}
 
-  for (int z = 0; z < num_pages; ++z) {
-    unsigned char *dest = compressed_image._image.p() + z * compressed_image._page_size;
-    unsigned const char *src = uncompressed_image._image.p() + z * uncompressed_image._page_size;
-
-    // Convert one 4 x 4 block at a time.
-    for (int y = 0; y < y_blocks; ++y) {
-      for (int x = 0; x < x_blocks; ++x) {
-        int a, b, c, d;
-        float fac, add;
-        unsigned char minv, maxv;
-        unsigned const char *blk = src;
-
-        // Find the minimum and maximum red value in the block.
-        minv = blk[0];
-        maxv = blk[0];
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[4], minv); maxv = max(blk[4], maxv);
-        minv = min(blk[6], minv); maxv = max(blk[6], maxv);
-        blk += stride;
-        minv = min(blk[0], minv); maxv = max(blk[0], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[4], minv); maxv = max(blk[4], maxv);
-        minv = min(blk[6], minv); maxv = max(blk[6], maxv);
-        blk += stride;
-        minv = min(blk[0], minv); maxv = max(blk[0], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[4], minv); maxv = max(blk[4], maxv);
-        minv = min(blk[6], minv); maxv = max(blk[6], maxv);
-        blk += stride;
-        minv = min(blk[0], minv); maxv = max(blk[0], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[4], minv); maxv = max(blk[4], maxv);
-        minv = min(blk[6], minv); maxv = max(blk[6], maxv);
-
-        // Now calculate the index for each pixel.
-        if (maxv > minv) {
-          fac = 7.5f / (maxv - minv);
-        } else {
-          fac = 0;
-        }
-        add = -minv * fac;
-        blk = src;
-        a = (remap[(int)(blk[0] * fac + add)])
-          | (remap[(int)(blk[2] * fac + add)] << 3)
-          | (remap[(int)(blk[4] * fac + add)] << 6)
-          | (remap[(int)(blk[6] * fac + add)] << 9);
-        blk += stride;
-        b = (remap[(int)(blk[0] * fac + add)] << 4)
-          | (remap[(int)(blk[2] * fac + add)] << 7)
-          | (remap[(int)(blk[4] * fac + add)] << 10)
-          | (remap[(int)(blk[6] * fac + add)] << 13);
-        blk += stride;
-        c = (remap[(int)(blk[0] * fac + add)])
-          | (remap[(int)(blk[2] * fac + add)] << 3)
-          | (remap[(int)(blk[4] * fac + add)] << 6)
-          | (remap[(int)(blk[6] * fac + add)] << 9);
-        blk += stride;
-        d = (remap[(int)(blk[0] * fac + add)] << 4)
-          | (remap[(int)(blk[2] * fac + add)] << 7)
-          | (remap[(int)(blk[4] * fac + add)] << 10)
-          | (remap[(int)(blk[6] * fac + add)] << 13);
-
-        *(dest++) = maxv;
-        *(dest++) = minv;
-        *(dest++) = a & 0xff;
-        *(dest++) = (a >> 8) | (b & 0xf0);
-        *(dest++) = b >> 8;
-        *(dest++) = c & 0xff;
-        *(dest++) = (c >> 8) | (d & 0xf0);
-        *(dest++) = d >> 8;
-
-        // Find the minimum and maximum green value in the block.
-        blk = src + 1;
-        minv = blk[0];
-        maxv = blk[0];
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[4], minv); maxv = max(blk[4], maxv);
-        minv = min(blk[6], minv); maxv = max(blk[6], maxv);
-        blk += stride;
-        minv = min(blk[0], minv); maxv = max(blk[0], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[4], minv); maxv = max(blk[4], maxv);
-        minv = min(blk[6], minv); maxv = max(blk[6], maxv);
-        blk += stride;
-        minv = min(blk[0], minv); maxv = max(blk[0], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[4], minv); maxv = max(blk[4], maxv);
-        minv = min(blk[6], minv); maxv = max(blk[6], maxv);
-        blk += stride;
-        minv = min(blk[0], minv); maxv = max(blk[0], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[4], minv); maxv = max(blk[4], maxv);
-        minv = min(blk[6], minv); maxv = max(blk[6], maxv);
-
-        // Now calculate the index for each pixel.
-        if (maxv > minv) {
-          fac = 7.5f / (maxv - minv);
-        } else {
-          fac = 0;
-        }
-        add = -minv * fac;
-        blk = src + 1;
-        a = (remap[(int)(blk[0] * fac + add)])
-          | (remap[(int)(blk[2] * fac + add)] << 3)
-          | (remap[(int)(blk[4] * fac + add)] << 6)
-          | (remap[(int)(blk[6] * fac + add)] << 9);
-        blk += stride;
-        b = (remap[(int)(blk[0] * fac + add)] << 4)
-          | (remap[(int)(blk[2] * fac + add)] << 7)
-          | (remap[(int)(blk[4] * fac + add)] << 10)
-          | (remap[(int)(blk[6] * fac + add)] << 13);
-        blk += stride;
-        c = (remap[(int)(blk[0] * fac + add)])
-          | (remap[(int)(blk[2] * fac + add)] << 3)
-          | (remap[(int)(blk[4] * fac + add)] << 6)
-          | (remap[(int)(blk[6] * fac + add)] << 9);
-        blk += stride;
-        d = (remap[(int)(blk[0] * fac + add)] << 4)
-          | (remap[(int)(blk[2] * fac + add)] << 7)
-          | (remap[(int)(blk[4] * fac + add)] << 10)
-          | (remap[(int)(blk[6] * fac + add)] << 13);
-
-        *(dest++) = maxv;
-        *(dest++) = minv;
-        *(dest++) = a & 0xff;
-        *(dest++) = (a >> 8) | (b & 0xf0);
-        *(dest++) = b >> 8;
-        *(dest++) = c & 0xff;
-        *(dest++) = (c >> 8) | (d & 0xf0);
-        *(dest++) = d >> 8;
-
-        // Advance to the beginning of the next 4x4 block.
-        src += 8;
-      }
-      src += stride * 3;
-    }
-    Thread::consider_yield();
-  }
+/**
+ * Rounds an RGB color in the range 0..255 to the nearest 5:6:5 packed color.
+ */
+static inline unsigned int
+bc_pack_565(const float rgb[3]) {
+  int r = (int)(rgb[0] * (31.0f / 255.0f) + 0.5f);
+  int g = (int)(rgb[1] * (63.0f / 255.0f) + 0.5f);
+  int b = (int)(rgb[2] * (31.0f / 255.0f) + 0.5f);
+  r = max(0, min(r, 31));
+  g = max(0, min(g, 63));
+  b = max(0, min(b, 31));
+  return (r << 11) | (g << 5) | b;
 }
 
 /**
- * Decompresses a RAM image compressed using BC4.
+ * Fills in the palette that a BC1 color block with the given endpoints
+ * decodes to.  When three_color is true, the fourth entry is black (and
+ * transparent, in DXT1).
  */
-void Texture::
-do_uncompress_ram_image_bc4(const RamImage &compressed_image,
-                            RamImage &uncompressed_image,
-                            int x_size, int y_size, int num_pages) {
-  int x_blocks = (x_size >> 2);
-  int y_blocks = (y_size >> 2);
-
-  for (int z = 0; z < num_pages; ++z) {
-    unsigned char *dest = uncompressed_image._image.p() + z * uncompressed_image._page_size;
-    unsigned const char *src = compressed_image._image.p() + z * compressed_image._page_size;
-
-    // Unconvert one 4 x 4 block at a time.
-    uint8_t tbl[8];
-    for (int y = 0; y < y_blocks; ++y) {
-      for (int x = 0; x < x_blocks; ++x) {
-        unsigned char *blk = dest;
-        tbl[0] = src[0];
-        tbl[1] = src[1];
-        if (tbl[0] > tbl[1]) {
-          tbl[2] = (tbl[0] * 6 + tbl[1] * 1) / 7.0f;
-          tbl[3] = (tbl[0] * 5 + tbl[1] * 2) / 7.0f;
-          tbl[4] = (tbl[0] * 4 + tbl[1] * 3) / 7.0f;
-          tbl[5] = (tbl[0] * 3 + tbl[1] * 4) / 7.0f;
-          tbl[6] = (tbl[0] * 2 + tbl[1] * 5) / 7.0f;
-          tbl[7] = (tbl[0] * 1 + tbl[1] * 6) / 7.0f;
-        } else {
-          tbl[2] = (tbl[0] * 4 + tbl[1] * 1) / 5.0f;
-          tbl[3] = (tbl[0] * 3 + tbl[1] * 2) / 5.0f;
-          tbl[4] = (tbl[0] * 2 + tbl[1] * 3) / 5.0f;
-          tbl[5] = (tbl[0] * 1 + tbl[1] * 4) / 5.0f;
-          tbl[6] = 0;
-          tbl[7] = 255;
-        }
-        int v = src[2] + (src[3] << 8) + (src[4] << 16);
-        blk[0] = tbl[v & 0x7];
-        blk[1] = tbl[(v & 0x000038) >> 3];
-        blk[2] = tbl[(v & 0x0001c0) >> 6];
-        blk[3] = tbl[(v & 0x000e00) >> 9];
-        blk += x_size;
-        blk[0] = tbl[(v & 0x007000) >> 12];
-        blk[1] = tbl[(v & 0x038000) >> 15];
-        blk[2] = tbl[(v & 0x1c0000) >> 18];
-        blk[3] = tbl[(v & 0xe00000) >> 21];
-        blk += x_size;
-        v = src[5] + (src[6] << 8) + (src[7] << 16);
-        blk[0] = tbl[v & 0x7];
-        blk[1] = tbl[(v & 0x000038) >> 3];
-        blk[2] = tbl[(v & 0x0001c0) >> 6];
-        blk[3] = tbl[(v & 0x000e00) >> 9];
-        blk += x_size;
-        blk[0] = tbl[(v & 0x007000) >> 12];
-        blk[1] = tbl[(v & 0x038000) >> 15];
-        blk[2] = tbl[(v & 0x1c0000) >> 18];
-        blk[3] = tbl[(v & 0xe00000) >> 21];
-        src += 8;
-        dest += 4;
-      }
-      dest += x_size * 3;
+static void
+bc1_make_palette(unsigned int c0, unsigned int c1, bool three_color,
+                 int palette[4][3]) {
+  bc_unpack_565(c0, palette[0]);
+  bc_unpack_565(c1, palette[1]);
+  for (int i = 0; i < 3; ++i) {
+    if (three_color) {
+      palette[2][i] = (palette[0][i] + palette[1][i]) / 2;
+      palette[3][i] = 0;
+    } else {
+      palette[2][i] = (palette[0][i] * 2 + palette[1][i]) / 3;
+      palette[3][i] = (palette[0][i] + palette[1][i] * 2) / 3;
     }
-    Thread::consider_yield();
   }
 }
 
 /**
- * Decompresses a RAM image compressed using BC5.
+ * Assigns each of the opaque pixels of a block to the nearest of the first
+ * num_entries palette entries, and each of the transparent pixels to entry 3.
+ * Returns the packed 2-bit indices, and stores the total squared error.
  */
-void Texture::
-do_uncompress_ram_image_bc5(const RamImage &compressed_image,
-                            RamImage &uncompressed_image,
-                            int x_size, int y_size, int num_pages) {
-  int x_blocks = (x_size >> 2);
-  int y_blocks = (y_size >> 2);
-  int stride = x_size * 2;
-
-  for (int z = 0; z < num_pages; ++z) {
-    unsigned char *dest = uncompressed_image._image.p() + z * uncompressed_image._page_size;
-    unsigned const char *src = compressed_image._image.p() + z * compressed_image._page_size;
-
-    // Unconvert one 4 x 4 block at a time.
-    uint8_t red[8];
-    uint8_t grn[8];
-    for (int y = 0; y < y_blocks; ++y) {
-      for (int x = 0; x < x_blocks; ++x) {
-        unsigned char *blk = dest;
-        red[0] = src[0];
-        red[1] = src[1];
-        if (red[0] > red[1]) {
-          red[2] = (red[0] * 6 + red[1] * 1) / 7.0f;
-          red[3] = (red[0] * 5 + red[1] * 2) / 7.0f;
-          red[4] = (red[0] * 4 + red[1] * 3) / 7.0f;
-          red[5] = (red[0] * 3 + red[1] * 4) / 7.0f;
-          red[6] = (red[0] * 2 + red[1] * 5) / 7.0f;
-          red[7] = (red[0] * 1 + red[1] * 6) / 7.0f;
-        } else {
-          red[2] = (red[0] * 4 + red[1] * 1) / 5.0f;
-          red[3] = (red[0] * 3 + red[1] * 2) / 5.0f;
-          red[4] = (red[0] * 2 + red[1] * 3) / 5.0f;
-          red[5] = (red[0] * 1 + red[1] * 4) / 5.0f;
-          red[6] = 0;
-          red[7] = 255;
-        }
-        grn[0] = src[8];
-        grn[1] = src[9];
-        if (grn[0] > grn[1]) {
-          grn[2] = (grn[0] * 6 + grn[1] * 1) / 7.0f;
-          grn[3] = (grn[0] * 5 + grn[1] * 2) / 7.0f;
-          grn[4] = (grn[0] * 4 + grn[1] * 3) / 7.0f;
-          grn[5] = (grn[0] * 3 + grn[1] * 4) / 7.0f;
-          grn[6] = (grn[0] * 2 + grn[1] * 5) / 7.0f;
-          grn[7] = (grn[0] * 1 + grn[1] * 6) / 7.0f;
-        } else {
-          grn[2] = (grn[0] * 4 + grn[1] * 1) / 5.0f;
-          grn[3] = (grn[0] * 3 + grn[1] * 2) / 5.0f;
-          grn[4] = (grn[0] * 2 + grn[1] * 3) / 5.0f;
-          grn[5] = (grn[0] * 1 + grn[1] * 4) / 5.0f;
-          grn[6] = 0;
-          grn[7] = 255;
-        }
-        int r = src[2] + (src[3] << 8) + (src[4] << 16);
-        int g = src[10] + (src[11] << 8) + (src[12] << 16);
-        blk[0] = red[r & 0x7];
-        blk[1] = grn[g & 0x7];
-        blk[2] = red[(r & 0x000038) >> 3];
-        blk[3] = grn[(g & 0x000038) >> 3];
-        blk[4] = red[(r & 0x0001c0) >> 6];
-        blk[5] = grn[(g & 0x0001c0) >> 6];
-        blk[6] = red[(r & 0x000e00) >> 9];
-        blk[7] = grn[(g & 0x000e00) >> 9];
-        blk += stride;
-        blk[0] = red[(r & 0x007000) >> 12];
-        blk[1] = grn[(g & 0x007000) >> 12];
-        blk[2] = red[(r & 0x038000) >> 15];
-        blk[3] = grn[(g & 0x038000) >> 15];
-        blk[4] = red[(r & 0x1c0000) >> 18];
-        blk[5] = grn[(g & 0x1c0000) >> 18];
-        blk[6] = red[(r & 0xe00000) >> 21];
-        blk[7] = grn[(g & 0xe00000) >> 21];
-        blk += stride;
-        r = src[5] + (src[6] << 8) + (src[7] << 16);
-        g = src[13] + (src[14] << 8) + (src[15] << 16);
-        blk[0] = red[r & 0x7];
-        blk[1] = grn[g & 0x7];
-        blk[2] = red[(r & 0x000038) >> 3];
-        blk[3] = grn[(g & 0x000038) >> 3];
-        blk[4] = red[(r & 0x0001c0) >> 6];
-        blk[5] = grn[(g & 0x0001c0) >> 6];
-        blk[6] = red[(r & 0x000e00) >> 9];
-        blk[7] = grn[(g & 0x000e00) >> 9];
-        blk += stride;
-        blk[0] = red[(r & 0x007000) >> 12];
-        blk[1] = grn[(g & 0x007000) >> 12];
-        blk[2] = red[(r & 0x038000) >> 15];
-        blk[3] = grn[(g & 0x038000) >> 15];
-        blk[4] = red[(r & 0x1c0000) >> 18];
-        blk[5] = grn[(g & 0x1c0000) >> 18];
-        blk[6] = red[(r & 0xe00000) >> 21];
-        blk[7] = grn[(g & 0xe00000) >> 21];
-        src += 16;
-        dest += 8;
+static unsigned int
+bc1_match_colors(const unsigned char rgba[16][4], int transparent,
+                 const int palette[4][3], int num_entries, int &error) {
+  unsigned int indices = 0;
+  error = 0;
+  for (int p = 0; p < 16; ++p) {
+    if (transparent & (1 << p)) {
+      indices |= 3u << (p * 2);
+      continue;
+    }
+    int best = 0;
+    int best_dist = INT_MAX;
+    for (int e = 0; e < num_entries; ++e) {
+      int dr = rgba[p][0] - palette[e][0];
+      int dg = rgba[p][1] - palette[e][1];
+      int db = rgba[p][2] - palette[e][2];
+      int dist = dr * dr + dg * dg + db * db;
+      if (dist < best_dist) {
+        best_dist = dist;
+        best = e;
       }
-      dest += stride * 3;
     }
-    Thread::consider_yield();
+    indices |= (unsigned int)best << (p * 2);
+    error += best_dist;
   }
+  return indices;
 }
 
 /**
- *
+ * Computes the pair of colors that best reproduces the opaque pixels of the
+ * block in the least-squares sense, given the palette entry that has been
+ * chosen for each pixel.  Returns false if the system is degenerate.
  */
-bool Texture::
-do_has_all_ram_mipmap_images(const CData *cdata) const {
-  if (cdata->_ram_images.empty() || cdata->_ram_images[0]._image.empty()) {
-    // If we don't even have a base image, the answer is no.
+static bool
+bc1_fit_endpoints(const unsigned char rgba[16][4], int transparent,
+                  unsigned int indices, bool three_color,
+                  float end0[3], float end1[3]) {
+  static const float weights4[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+  static const float weights3[4] = {1.0f, 0.0f, 0.5f, 0.0f};
+  const float *weights = three_color ? weights3 : weights4;
+
+  float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+  float ax[3] = {0.0f, 0.0f, 0.0f};
+  float bx[3] = {0.0f, 0.0f, 0.0f};
+  for (int p = 0; p < 16; ++p) {
+    if (transparent & (1 << p)) {
+      continue;
+    }
+    float a = weights[(indices >> (p * 2)) & 3];
+    float b = 1.0f - a;
+    aa += a * a;
+    ab += a * b;
+    bb += b * b;
+    for (int i = 0; i < 3; ++i) {
+      ax[i] += a * rgba[p][i];
+      bx[i] += b * rgba[p][i];
+    }
+  }
+
+  float det = aa * bb - ab * ab;
+  if (det < 1.0e-6f) {
     return false;
   }
-  if (!uses_mipmaps()) {
-    // If we have a base image and don't require mipmapping, the answer is
-    // yes.
-    return true;
+  float inv_det = 1.0f / det;
+  for (int i = 0; i < 3; ++i) {
+    end0[i] = max(0.0f, min((ax[i] * bb - bx[i] * ab) * inv_det, 255.0f));
+    end1[i] = max(0.0f, min((bx[i] * aa - ax[i] * ab) * inv_det, 255.0f));
   }
+  return true;
+}
 
-  // Check that we have enough mipmap levels to meet the size requirements.
-  int size = max(cdata->_x_size, max(cdata->_y_size, cdata->_z_size));
-  int n = 0;
-  int x = 1;
-  while (x < size) {
-    x = (x << 1);
-    ++n;
-    if (n >= (int)cdata->_ram_images.size() || cdata->_ram_images[n]._image.empty()) {
-      return false;
-    }
+/**
+ * Orders the endpoints of a BC1 block so that they select the intended
+ * palette mode, and finds the best indices for that palette.
+ */
+static unsigned int
+bc1_try_endpoints(const unsigned char rgba[16][4], int transparent,
+                  bool three_color, unsigned int &c0, unsigned int &c1,
+                  int &error) {
+  // The decoder selects the three-color mode when c0 <= c1.
+  if (three_color ? (c0 > c1) : (c0 < c1)) {
+    swap(c0, c1);
   }
+  bool decoded_three_color = (c0 <= c1);
 
-  return true;
+  int palette[4][3];
+  bc1_make_palette(c0, c1, decoded_three_color, palette);
+  return bc1_match_colors(rgba, transparent, palette,
+                          decoded_three_color ? 3 : 4, error);
 }
 
 /**
- * Considers whether the z_size (or num_views) should automatically be
- * adjusted when the user loads a new page.  Returns true if the z size is
- * valid, false otherwise.
- *
- * Assumes the lock is already held.
+ * Encodes a 4x4 block of RGBA pixels as a BC1 color block.  If dxt1_alpha is
+ * true, pixels with an alpha value below 128 are encoded as transparent
+ * black, as only DXT1 allows.  The endpoints are initially chosen along the
+ * principal axis of the colors in the block, and then refined the given
+ * number of times by a least-squares fit.
  */
-bool Texture::
-do_reconsider_z_size(CData *cdata, int z, const LoaderOptions &options) {
-  if (z >= cdata->_z_size * cdata->_num_views) {
-    bool num_views_specified = true;
-    if (options.get_texture_flags() & LoaderOptions::TF_multiview) {
-      // This flag is false if is a multiview texture with a specified number
-      // of views.  It is true if it is not a multiview texture, or if it is
-      // but the number of views is explicitly specified.
-      num_views_specified = (options.get_texture_num_views() != 0);
+static void
+bc1_encode_block(unsigned char *dest, const unsigned char rgba[16][4],
+                 bool dxt1_alpha, int refine_passes) {
+  int transparent = 0;
+  if (dxt1_alpha) {
+    for (int p = 0; p < 16; ++p) {
+      if (rgba[p][3] < 128) {
+        transparent |= (1 << p);
+      }
     }
+  }
+  bool three_color = (transparent != 0);
 
-    if (num_views_specified &&
-        (cdata->_texture_type == Texture::TT_3d_texture ||
-         cdata->_texture_type == Texture::TT_2d_texture_array)) {
-      // If we're loading a page past _z_size, treat it as an implicit request
-      // to enlarge _z_size.  However, this is only legal if this is, in fact,
-      // a 3-d texture or a 2d texture array (cube maps always have z_size 6,
-      // and other types have z_size 1).
-      nassertr(cdata->_num_views != 0, false);
-      cdata->_z_size = (z / cdata->_num_views) + 1;
+  unsigned int c0 = 0;
+  unsigned int c1 = 0;
+  unsigned int indices = 0;
+  int error = 0;
 
-    } else if (cdata->_z_size != 0) {
-      // In the case of a 2-d texture or cube map, or a 3-d texture with an
-      // unspecified _num_views, assume we're loading views of a multiview
-      // texture.
-      cdata->_num_views = (z / cdata->_z_size) + 1;
+  if (transparent == 0xffff) {
+    // The whole block is transparent.
+    indices = 0xffffffff;
 
-    } else {
-      // The first image loaded sets an implicit z-size.
-      cdata->_z_size = 1;
+  } else {
+    // Find the mean and the covariance of the opaque colors.
+    int count = 0;
+    float mean[3] = {0.0f, 0.0f, 0.0f};
+    for (int p = 0; p < 16; ++p) {
+      if ((transparent & (1 << p)) == 0) {
+        mean[0] += rgba[p][0];
+        mean[1] += rgba[p][1];
+        mean[2] += rgba[p][2];
+        ++count;
+      }
+    }
+    mean[0] /= count;
+    mean[1] /= count;
+    mean[2] /= count;
+
+    float cov[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    for (int p = 0; p < 16; ++p) {
+      if ((transparent & (1 << p)) == 0) {
+        float r = rgba[p][0] - mean[0];
+        float g = rgba[p][1] - mean[1];
+        float b = rgba[p][2] - mean[2];
+        cov[0] += r * r;
+        cov[1] += r * g;
+        cov[2] += r * b;
+        cov[3] += g * g;
+        cov[4] += g * b;
+        cov[5] += b * b;
+      }
+    }
+
+    // A few power iterations give a good enough estimate of the principal
+    // axis.
+    float axis[3] = {1.0f, 1.0f, 1.0f};
+    for (int iter = 0; iter < 4; ++iter) {
+      float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+      float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+      float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+      float m = max(fabsf(x), max(fabsf(y), fabsf(z)));
+      if (m < 1.0e-6f) {
+        break;
+      }
+      axis[0] = x / m;
+      axis[1] = y / m;
+      axis[2] = z / m;
+    }
+
+    // Pick the extreme opaque pixels along that axis as the endpoints.
+    int min_p = -1;
+    int max_p = -1;
+    float min_d = 0.0f;
+    float max_d = 0.0f;
+    for (int p = 0; p < 16; ++p) {
+      if ((transparent & (1 << p)) == 0) {
+        float d = rgba[p][0] * axis[0] + rgba[p][1] * axis[1] + rgba[p][2] * axis[2];
+        if (min_p < 0 || d < min_d) {
+          min_d = d;
+          min_p = p;
+        }
+        if (max_p < 0 || d > max_d) {
+          max_d = d;
+          max_p = p;
+        }
+      }
     }
 
-    // Increase the size of the data buffer to make room for the new texture
-    // level.
-    do_allocate_pages(cdata);
+    float end0[3] = {(float)rgba[max_p][0], (float)rgba[max_p][1], (float)rgba[max_p][2]};
+    float end1[3] = {(float)rgba[min_p][0], (float)rgba[min_p][1], (float)rgba[min_p][2]};
+    c0 = bc_pack_565(end0);
+    c1 = bc_pack_565(end1);
+    indices = bc1_try_endpoints(rgba, transparent, three_color, c0, c1, error);
+
+    for (int pass = 0; pass < refine_passes && error > 0; ++pass) {
+      if (!bc1_fit_endpoints(rgba, transparent, indices, c0 <= c1, end0, end1)) {
+        break;
+      }
+      unsigned int new_c0 = bc_pack_565(end0);
+      unsigned int new_c1 = bc_pack_565(end1);
+      int new_error;
+      unsigned int new_indices =
+        bc1_try_endpoints(rgba, transparent, three_color, new_c0, new_c1, new_error);
+      if (new_error >= error) {
+        break;
+      }
+      c0 = new_c0;
+      c1 = new_c1;
+      indices = new_indices;
+      error = new_error;
+    }
   }
 
-  return true;
+  dest[0] = c0 & 0xff;
+  dest[1] = c0 >> 8;
+  dest[2] = c1 & 0xff;
+  dest[3] = c1 >> 8;
+  dest[4] = indices & 0xff;
+  dest[5] = (indices >> 8) & 0xff;
+  dest[6] = (indices >> 16) & 0xff;
+  dest[7] = indices >> 24;
 }
 
 /**
- * Called internally by do_reconsider_z_size() to allocate new memory in
- * _ram_images[0] for the new number of pages.
- *
- * Assumes the lock is already held.
+ * Decodes a BC1 color block into 4x4 RGBA pixels.  If dxt1_alpha is true, the
+ * three-color mode is honored, and its fourth entry decodes to transparent
+ * black; otherwise (as in DXT3 and DXT5) the alpha values are left alone.
  */
-void Texture::
-do_allocate_pages(CData *cdata) {
-  size_t new_size = do_get_expected_ram_image_size(cdata);
-  if (!cdata->_ram_images.empty() &&
-      !cdata->_ram_images[0]._image.empty() &&
-      new_size > cdata->_ram_images[0]._image.size()) {
-    cdata->_ram_images[0]._image.insert(cdata->_ram_images[0]._image.end(), new_size - cdata->_ram_images[0]._image.size(), 0);
-    nassertv(cdata->_ram_images[0]._image.size() == new_size);
+static void
+bc1_decode_block(unsigned char rgba[16][4], const unsigned char *src,
+                 bool dxt1_alpha) {
+  unsigned int c0 = src[0] | (src[1] << 8);
+  unsigned int c1 = src[2] | (src[3] << 8);
+  unsigned int indices = src[4] | (src[5] << 8) | (src[6] << 16) | ((unsigned int)src[7] << 24);
+  bool three_color = dxt1_alpha && (c0 <= c1);
+
+  int palette[4][3];
+  bc1_make_palette(c0, c1, three_color, palette);
+
+  for (int p = 0; p < 16; ++p) {
+    int e = (indices >> (p * 2)) & 3;
+    rgba[p][0] = palette[e][0];
+    rgba[p][1] = palette[e][1];
+    rgba[p][2] = palette[e][2];
+    if (dxt1_alpha) {
+      rgba[p][3] = (three_color && e == 3) ? 0 : 255;
+    }
   }
 }
 
 /**
- * Resets the internal Texture properties when a new image file is loaded.
- * Returns true if the new image is valid, false otherwise.
+ * Encodes 16 values as a BC4 block, which is also the format of the alpha
+ * block of DXT5 and of each channel of BC5.
  *
- * Assumes the lock is already held.
+ * NB. This algorithm isn't fully optimal, since it doesn't try to make use of
+ * the secondary interpolation mode supported by BC4.  This is not important
+ * for most textures, but it may be added in the future.
  */
-bool Texture::
-do_reconsider_image_properties(CData *cdata, int x_size, int y_size, int num_components,
-                               Texture::ComponentType component_type, int z,
-                               const LoaderOptions &options) {
-  if (!cdata->_loaded_from_image || num_components != cdata->_num_components || component_type != cdata->_component_type) {
-    // Come up with a default format based on the number of channels.  But
-    // only do this the first time the file is loaded, or if the number of
-    // channels in the image changes on subsequent loads.
-
-    // TODO: handle sRGB properly
-    switch (num_components) {
-    case 1:
-      cdata->_format = F_luminance;
-      break;
+static void
+bc4_encode_block(unsigned char *dest, const unsigned char values[16]) {
+  static const int remap[] = {1, 7, 6, 5, 4, 3, 2, 0};
 
-    case 2:
-      cdata->_format = F_luminance_alpha;
-      break;
+  // Find the minimum and maximum value in the block.
+  unsigned char minv = values[0];
+  unsigned char maxv = values[0];
+  for (int p = 1; p < 16; ++p) {
+    minv = min(values[p], minv);
+    maxv = max(values[p], maxv);
+  }
 
-    case 3:
-      cdata->_format = F_rgb;
-      break;
+  // Now calculate the index for each pixel.
+  float fac, add;
+  if (maxv > minv) {
+    fac = 7.5f / (maxv - minv);
+  } else {
+    fac = 0;
+  }
+  add = -minv * fac;
+
+  unsigned int lo = 0;
+  unsigned int hi = 0;
+  for (int p = 0; p < 8; ++p) {
+    lo |= remap[(int)(values[p] * fac + add)] << (p * 3);
+    hi |= remap[(int)(values[p + 8] * fac + add)] << (p * 3);
+  }
+
+  dest[0] = maxv;
+  dest[1] = minv;
+  dest[2] = lo & 0xff;
+  dest[3] = (lo >> 8) & 0xff;
+  dest[4] = lo >> 16;
+  dest[5] = hi & 0xff;
+  dest[6] = (hi >> 8) & 0xff;
+  dest[7] = hi >> 16;
+}
+
+/**
+ * Decodes a BC4 block into 16 values.
+ */
+static void
+bc4_decode_block(unsigned char values[16], const unsigned char *src) {
+  int a = src[0];
+  int b = src[1];
+  unsigned char tbl[8];
+  tbl[0] = a;
+  tbl[1] = b;
+  if (a > b) {
+    tbl[2] = (a * 6 + b * 1) / 7;
+    tbl[3] = (a * 5 + b * 2) / 7;
+    tbl[4] = (a * 4 + b * 3) / 7;
+    tbl[5] = (a * 3 + b * 4) / 7;
+    tbl[6] = (a * 2 + b * 5) / 7;
+    tbl[7] = (a * 1 + b * 6) / 7;
+  } else {
+    tbl[2] = (a * 4 + b * 1) / 5;
+    tbl[3] = (a * 3 + b * 2) / 5;
+    tbl[4] = (a * 2 + b * 3) / 5;
+    tbl[5] = (a * 1 + b * 4) / 5;
+    tbl[6] = 0;
+    tbl[7] = 255;
+  }
 
-    case 4:
-      cdata->_format = F_rgba;
-      break;
+  unsigned int lo = src[2] | (src[3] << 8) | (src[4] << 16);
+  unsigned int hi = src[5] | (src[6] << 8) | (src[7] << 16);
+  for (int p = 0; p < 8; ++p) {
+    values[p] = tbl[(lo >> (p * 3)) & 0x7];
+    values[p + 8] = tbl[(hi >> (p * 3)) & 0x7];
+  }
+}
 
-    default:
-      // Eh?
-      nassertr(false, false);
-      cdata->_format = F_rgb;
+/**
+ * Copies the 4x4 block of pixels at the indicated block position out of an
+ * uncompressed page.  Pixels that fall beyond the edge of the image, as they
+ * will in the smallest mipmap levels, replicate the nearest edge pixel.
+ */
+static void
+fetch_block(unsigned char block[16][4], const unsigned char *page,
+            int x_size, int y_size, int num_components, int bx, int by) {
+  for (int p = 0; p < 16; ++p) {
+    int xi = min(bx * 4 + (p & 3), x_size - 1);
+    int yi = min(by * 4 + (p >> 2), y_size - 1);
+    const unsigned char *s = page + ((size_t)yi * x_size + xi) * num_components;
+    for (int c = 0; c < num_components; ++c) {
+      block[p][c] = s[c];
     }
   }
+}
 
-  if (!cdata->_loaded_from_image) {
-    if ((options.get_texture_flags() & LoaderOptions::TF_allow_1d) &&
-        cdata->_texture_type == TT_2d_texture && x_size != 1 && y_size == 1) {
-      // If we're loading an Nx1 size texture, infer a 1-d texture type.
-      cdata->_texture_type = TT_1d_texture;
+/**
+ * The inverse of fetch_block(); pixels that fall beyond the edge of the image
+ * are discarded.
+ */
+static void
+store_block(unsigned char *page, const unsigned char block[16][4],
+            int x_size, int y_size, int num_components, int bx, int by) {
+  for (int p = 0; p < 16; ++p) {
+    int xi = bx * 4 + (p & 3);
+    int yi = by * 4 + (p >> 2);
+    if (xi < x_size && yi < y_size) {
+      unsigned char *d = page + ((size_t)yi * x_size + xi) * num_components;
+      for (int c = 0; c < num_components; ++c) {
+        d[c] = block[p][c];
+      }
     }
+  }
+}
 
-#ifndef NDEBUG
+/**
+ * Compresses a RAM image using the built-in encoders for the DXT1, DXT3,
+ * DXT5 and RGTC (BC4 or BC5) formats.  The block rows of all of the pages of
+ * each mipmap level are divided among several threads.  Returns true on
+ * success, false if the image is not in a format that can be compressed this
+ * way.
+ */
+bool Texture::
+do_compress_ram_image_blocks(CData *cdata, Texture::CompressionMode compression,
+                             Texture::QualityLevel quality_level) {
+  if (cdata->_component_type != T_unsigned_byte) {
+    return false;
+  }
+
+  BlockCodecJob job;
+  job._compression = compression;
+  job._num_components = cdata->_num_components;
+
+  switch (compression) {
+  case CM_dxt1:
+    job._block_size = 8;
+    break;
+
+  case CM_dxt3:
+  case CM_dxt5:
+    job._block_size = 16;
+    break;
+
+  case CM_rgtc:
+    if (cdata->_num_components != 1 && cdata->_num_components != 2) {
+      // Invalid.
+      return false;
+    }
+    job._block_size = cdata->_num_components * 8;
+    break;
+
+  default:
+    return false;
+  }
+
+  switch (quality_level) {
+  case QL_fastest:
+    job._refine_passes = 0;
+    break;
+
+  case QL_best:
+    job._refine_passes = 8;
+    break;
+
+  default:
+    job._refine_passes = 2;
+    break;
+  }
+
+  if (!do_has_all_ram_mipmap_images(cdata)) {
+    // If we're about to compress the RAM image, we should ensure that we have
+    // all of the mipmap levels first.
+    do_generate_ram_mipmap_images(cdata, false);
+  }
+
+  RamImages compressed_ram_images;
+  compressed_ram_images.resize(cdata->_ram_images.size());
+
+  for (size_t n = 0; n < cdata->_ram_images.size(); ++n) {
+    const RamImage &uncompressed_image = cdata->_ram_images[n];
+    int num_pages = do_get_expected_mipmap_num_pages(cdata, n);
+
+    // It is important that we handle image sizes that aren't a multiple of
+    // the block size, since this method may be used to compress mipmaps,
+    // which go all the way to 1x1.
+    job._x_size = do_get_expected_mipmap_x_size(cdata, n);
+    job._y_size = do_get_expected_mipmap_y_size(cdata, n);
+    job._x_blocks = (job._x_size + 3) >> 2;
+    job._y_blocks = (job._y_size + 3) >> 2;
+
+    // Create a new image to hold the compressed texture pages.
+    RamImage &compressed_image = compressed_ram_images[n];
+    compressed_image._page_size = (size_t)job._x_blocks * (size_t)job._y_blocks * job._block_size;
+    compressed_image._image = PTA_uchar::empty_array(compressed_image._page_size * num_pages);
+
+    job._compressed = compressed_image._image.p();
+    job._compressed_page_size = compressed_image._page_size;
+    job._uncompressed = (unsigned char *)uncompressed_image._image.p();
+    job._uncompressed_page_size = uncompressed_image._page_size;
+
+    run_block_codec(&compress_block_rows, &job, num_pages * job._y_blocks,
+                    job._x_blocks);
+  }
+
+  cdata->_ram_images.swap(compressed_ram_images);
+  cdata->_ram_image_compression = compression;
+  return true;
+}
+
+/**
+ * The inverse of do_compress_ram_image_blocks().
+ */
+bool Texture::
+do_uncompress_ram_image_blocks(CData *cdata) {
+  if (cdata->_component_type != T_unsigned_byte) {
+    return false;
+  }
+
+  BlockCodecJob job;
+  job._compression = cdata->_ram_image_compression;
+  job._num_components = cdata->_num_components;
+  job._refine_passes = 0;
+
+  switch (job._compression) {
+  case CM_dxt1:
+    job._block_size = 8;
+    break;
+
+  case CM_dxt3:
+  case CM_dxt5:
+    job._block_size = 16;
+    break;
+
+  case CM_rgtc:
+    if (cdata->_num_components != 1 && cdata->_num_components != 2) {
+      // Invalid.
+      return false;
+    }
+    job._block_size = cdata->_num_components * 8;
+    break;
+
+  default:
+    return false;
+  }
+
+  RamImages uncompressed_ram_images;
+  uncompressed_ram_images.resize(cdata->_ram_images.size());
+
+  for (size_t n = 0; n < cdata->_ram_images.size(); ++n) {
+    const RamImage &compressed_image = cdata->_ram_images[n];
+    int num_pages = do_get_expected_mipmap_num_pages(cdata, n);
+
+    job._x_size = do_get_expected_mipmap_x_size(cdata, n);
+    job._y_size = do_get_expected_mipmap_y_size(cdata, n);
+    job._x_blocks = (job._x_size + 3) >> 2;
+    job._y_blocks = (job._y_size + 3) >> 2;
+
+    if (compressed_image._page_size < (size_t)job._x_blocks * (size_t)job._y_blocks * job._block_size) {
+      gobj_cat.error()
+        << "Compressed RAM image for " << get_name() << " is too small.\n";
+      return false;
+    }
+
+    RamImage &uncompressed_image = uncompressed_ram_images[n];
+    uncompressed_image._page_size = do_get_expected_ram_mipmap_page_size(cdata, n);
+    uncompressed_image._image = PTA_uchar::empty_array(uncompressed_image._page_size * num_pages);
+
+    job._compressed = (unsigned char *)compressed_image._image.p();
+    job._compressed_page_size = compressed_image._page_size;
+    job._uncompressed = uncompressed_image._image.p();
+    job._uncompressed_page_size = uncompressed_image._page_size;
+
+    run_block_codec(&uncompress_block_rows, &job, num_pages * job._y_blocks,
+                    job._x_blocks);
+  }
+
+  cdata->_ram_images.swap(uncompressed_ram_images);
+  cdata->_ram_image_compression = CM_off;
+  return true;
+}
+
+/**
+ * Compresses the block rows [begin, end) of a BlockCodecJob.  Called by
+ * parallel_for(), possibly from several threads at once.
+ */
+void Texture::
+compress_block_rows(void *data, int begin, int end) {
+  const BlockCodecJob &job = *(const BlockCodecJob *)data;
+  int num_components = job._num_components;
+
+  for (int row = begin; row < end; ++row) {
+    int z = row / job._y_blocks;
+    int by = row % job._y_blocks;
+    const unsigned char *page = job._uncompressed + z * job._uncompressed_page_size;
+    unsigned char *dest = job._compressed + z * job._compressed_page_size
+      + (size_t)by * job._x_blocks * job._block_size;
+
+    for (int bx = 0; bx < job._x_blocks; ++bx) {
+      unsigned char block[16][4];
+      fetch_block(block, page, job._x_size, job._y_size, num_components, bx, by);
+
+      if (job._compression == CM_rgtc) {
+        unsigned char values[16];
+        for (int c = 0; c < num_components; ++c) {
+          for (int p = 0; p < 16; ++p) {
+            values[p] = block[p][c];
+          }
+          bc4_encode_block(dest, values);
+          dest += 8;
+        }
+        continue;
+      }
+
+      // Convert the pixels to RGBA, the same way do_squish() does.
+      unsigned char rgba[16][4];
+      for (int p = 0; p < 16; ++p) {
+        switch (num_components) {
+        case 1:
+          rgba[p][0] = rgba[p][1] = rgba[p][2] = block[p][0];
+          rgba[p][3] = 255;
+          break;
+
+        case 2:
+          rgba[p][0] = rgba[p][1] = rgba[p][2] = block[p][0];
+          rgba[p][3] = block[p][1];
+          break;
+
+        case 3:
+          rgba[p][0] = block[p][2];
+          rgba[p][1] = block[p][1];
+          rgba[p][2] = block[p][0];
+          rgba[p][3] = 255;
+          break;
+
+        default:
+          rgba[p][0] = block[p][2];
+          rgba[p][1] = block[p][1];
+          rgba[p][2] = block[p][0];
+          rgba[p][3] = block[p][3];
+          break;
+        }
+      }
+
+      if (job._compression == CM_dxt3) {
+        // Explicit 4-bit alpha.
+        for (int p = 0; p < 16; p += 2) {
+          int a0 = (rgba[p][3] * 15 + 127) / 255;
+          int a1 = (rgba[p + 1][3] * 15 + 127) / 255;
+          *(dest++) = a0 | (a1 << 4);
+        }
+
+      } else if (job._compression == CM_dxt5) {
+        // Interpolated alpha, which is encoded just like BC4.
+        unsigned char alpha[16];
+        for (int p = 0; p < 16; ++p) {
+          alpha[p] = rgba[p][3];
+        }
+        bc4_encode_block(dest, alpha);
+        dest += 8;
+      }
+
+      bc1_encode_block(dest, rgba, job._compression == CM_dxt1 && num_components != 3,
+                       job._refine_passes);
+      dest += 8;
+    }
+  }
+}
+
+/**
+ * Decompresses the block rows [begin, end) of a BlockCodecJob.  Called by
+ * parallel_for(), possibly from several threads at once.
+ */
+void Texture::
+uncompress_block_rows(void *data, int begin, int end) {
+  const BlockCodecJob &job = *(const BlockCodecJob *)data;
+  int num_components = job._num_components;
+
+  for (int row = begin; row < end; ++row) {
+    int z = row / job._y_blocks;
+    int by = row % job._y_blocks;
+    unsigned char *page = job._uncompressed + z * job._uncompressed_page_size;
+    const unsigned char *src = job._compressed + z * job._compressed_page_size
+      + (size_t)by * job._x_blocks * job._block_size;
+
+    for (int bx = 0; bx < job._x_blocks; ++bx) {
+      unsigned char block[16][4];
+
+      if (job._compression == CM_rgtc) {
+        unsigned char values[16];
+        for (int c = 0; c < num_components; ++c) {
+          bc4_decode_block(values, src);
+          src += 8;
+          for (int p = 0; p < 16; ++p) {
+            block[p][c] = values[p];
+          }
+        }
+        store_block(page, block, job._x_size, job._y_size, num_components, bx, by);
+        continue;
+      }
+
+      unsigned char rgba[16][4];
+      if (job._compression == CM_dxt3) {
+        for (int p = 0; p < 16; p += 2) {
+          rgba[p][3] = (src[p >> 1] & 0x0f) * 17;
+          rgba[p + 1][3] = (src[p >> 1] >> 4) * 17;
+        }
+        src += 8;
+
+      } else if (job._compression == CM_dxt5) {
+        unsigned char alpha[16];
+        bc4_decode_block(alpha, src);
+        src += 8;
+        for (int p = 0; p < 16; ++p) {
+          rgba[p][3] = alpha[p];
+        }
+      }
+
+      bc1_decode_block(rgba, src, job._compression == CM_dxt1);
+      src += 8;
+
+      // Convert the pixels back from RGBA, the same way do_unsquish() does.
+      for (int p = 0; p < 16; ++p) {
+        switch (num_components) {
+        case 1:
+          block[p][0] = rgba[p][1];
+          break;
+
+        case 2:
+          block[p][0] = rgba[p][1];
+          block[p][1] = rgba[p][3];
+          break;
+
+        case 3:
+          block[p][2] = rgba[p][0];
+          block[p][1] = rgba[p][1];
+          block[p][0] = rgba[p][2];
+          break;
+
+        default:
+          block[p][2] = rgba[p][0];
+          block[p][1] = rgba[p][1];
+          block[p][0] = rgba[p][2];
+          block[p][3] = rgba[p][3];
+          break;
+        }
+      }
+      store_block(page, block, job._x_size, job._y_size, num_components, bx, by);
+    }
+  }
+}
+
+/**
+ *
+ */
+bool Texture::
+do_has_all_ram_mipmap_images(const CData *cdata) const {
+  if (cdata->_ram_images.empty() || cdata->_ram_images[0]._image.empty()) {
+    // If we don't even have a base image, the answer is no.
+    return false;
+  }
+  if (!uses_mipmaps()) {
+    // If we have a base image and don't require mipmapping, the answer is
+    // yes.
+    return true;
+  }
+
+  // Check that we have enough mipmap levels to meet the size requirements.
+  int size = max(cdata->_x_size, max(cdata->_y_size, cdata->_z_size));
+  int n = 0;
+  int x = 1;
+  while (x < size) {
+    x = (x << 1);
+    ++n;
+    if (n >= (int)cdata->_ram_images.size() || cdata->_ram_images[n]._image.empty()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Considers whether the z_size (or num_views) should automatically be
+ * adjusted when the user loads a new page.  Returns true if the z size is
+ * valid, false otherwise.
+ *
+ * Assumes the lock is already held.
+ */
+bool Texture::
+do_reconsider_z_size(CData *cdata, int z, const LoaderOptions &options) {
+  if (z >= cdata->_z_size * cdata->_num_views) {
+    bool num_views_specified = true;
+    if (options.get_texture_flags() & LoaderOptions::TF_multiview) {
+      // This flag is false if is a multiview texture with a specified number
+      // of views.  It is true if it is not a multiview texture, or if it is
+      // but the number of views is explicitly specified.
+      num_views_specified = (options.get_texture_num_views() != 0);
+    }
+
+    if (num_views_specified &&
+        (cdata->_texture_type == Texture::TT_3d_texture ||
+         cdata->_texture_type == Texture::TT_2d_texture_array)) {
+      // If we're loading a page past _z_size, treat it as an implicit request
+      // to enlarge _z_size.  However, this is only legal if this is, in fact,
+      // a 3-d texture or a 2d texture array (cube maps always have z_size 6,
+      // and other types have z_size 1).
+      nassertr(cdata->_num_views != 0, false);
+      cdata->_z_size = (z / cdata->_num_views) + 1;
+
+    } else if (cdata->_z_size != 0) {
+      // In the case of a 2-d texture or cube map, or a 3-d texture with an
+      // unspecified _num_views, assume we're loading views of a multiview
+      // texture.
+      cdata->_num_views = (z / cdata->_z_size) + 1;
+
+    } else {
+      // The first image loaded sets an implicit z-size.
+      cdata->_z_size = 1;
+    }
+
+    // Increase the size of the data buffer to make room for the new texture
+    // level.
+    do_allocate_pages(cdata);
+  }
+
+  return true;
+}
+
+/**
+ * Called internally by do_reconsider_z_size() to allocate new memory in
+ * _ram_images[0] for the new number of pages.
+ *
+ * Assumes the lock is already held.
+ */
+void Texture::
+do_allocate_pages(CData *cdata) {
+  size_t new_size = do_get_expected_ram_image_size(cdata);
+  if (!cdata->_ram_images.empty() &&
+      !cdata->_ram_images[0]._image.empty() &&
+      new_size > cdata->_ram_images[0]._image.size()) {
+    cdata->_ram_images[0]._image.insert(cdata->_ram_images[0]._image.end(), new_size - cdata->_ram_images[0]._image.size(), 0);
+    nassertv(cdata->_ram_images[0]._image.size() == new_size);
+  }
+}
+
+/**
+ * Resets the internal Texture properties when a new image file is loaded.
+ * Returns true if the new image is valid, false otherwise.
+ *
+ * Assumes the lock is already held.
+ */
+bool Texture::
+do_reconsider_image_properties(CData *cdata, int x_size, int y_size, int num_components,
+                               Texture::ComponentType component_type, int z,
+                               const LoaderOptions &options) {
+  if (!cdata->_loaded_from_image || num_components != cdata->_num_components || component_type != cdata->_component_type) {
+    // Come up with a default format based on the number of channels.  But
+    // only do this the first time the file is loaded, or if the number of
+    // channels in the image changes on subsequent loads.
+
+    // TODO: handle sRGB properly
+    switch (num_components) {
+    case 1:
+      cdata->_format = F_luminance;
+      break;
+
+    case 2:
+      cdata->_format = F_luminance_alpha;
+      break;
+
+    case 3:
+      cdata->_format = F_rgb;
+      break;
+
+    case 4:
+      cdata->_format = F_rgba;
+      break;
+
+    default:
+      // Eh?
+      nassertr(false, false);
+      cdata->_format = F_rgb;
+    }
+  }
+
+  if (!cdata->_loaded_from_image) {
+    if ((options.get_texture_flags() & LoaderOptions::TF_allow_1d) &&
+        cdata->_texture_type == TT_2d_texture && x_size != 1 && y_size == 1) {
+      // If we're loading an Nx1 size texture, infer a 1-d texture type.
+      cdata->_texture_type = TT_1d_texture;
+    }
+
+#ifndef NDEBUG
     switch (cdata->_texture_type) {
     case TT_1d_texture:
     case TT_buffer_texture:
@@ -9053,6 +9407,50 @@ compare_images(const PNMImage &a, const PNMImage &b) {
   return (average_delta <= simple_image_threshold);
 }
 
+// The bookkeeping shared between the threads that generate one mipmap level.
+// Each thread processes a range of destination rows, numbered consecutively
+// across all of the pages (and, for a 3-d texture, all of the views).
+struct Texture::MipmapFilterJob {
+  Filter2DComponent *_filter_2d_component;
+  Filter2DComponent *_filter_2d_alpha;
+  Filter3DComponent *_filter_3d_component;
+  Filter3DComponent *_filter_3d_alpha;
+  bool _rgba8_sse2;
+
+  unsigned char *_to;
+  const unsigned char *_from;
+
+  size_t _pixel_size;
+  int _num_color_components;
+  bool _alpha;
+
+  int _x_size, _y_size, _z_size;
+  int _to_x_size, _to_y_size, _to_z_size;
+  size_t _row_size, _page_size, _view_size;
+  size_t _to_row_size, _to_page_size, _to_view_size;
+};
+
+/**
+ * Divides the rows of a mipmap level among several threads, according to
+ * mipmap-generation-threads, but only if there is enough work to make it
+ * worthwhile.
+ */
+static void
+run_mipmap_filter(ParallelForFunc *func, void *job,
+                  int num_rows, size_t to_row_size) {
+  // Don't spawn a thread for less than this many bytes of output.
+  static const size_t min_bytes_per_thread = 64 * 1024;
+
+  int num_threads = mipmap_generation_threads;
+  if (num_threads <= 0) {
+    num_threads = Thread::get_num_supported_threads();
+  }
+  size_t total_bytes = (size_t)num_rows * to_row_size;
+  num_threads = (int)min((size_t)num_threads, total_bytes / min_bytes_per_thread);
+
+  parallel_for(func, job, num_rows, max(num_threads, 1), "GenerateMipmaps");
+}
+
 /**
  * Generates the next mipmap level from the previous one.  If there are
  * multiple pages (e.g.  a cube map), generates each page independently.
@@ -9070,18 +9468,35 @@ do_filter_2d_mipmap_pages(const CData *cdata,
   Filter2DComponent *filter_alpha;
 
   if (is_srgb(cdata->_format)) {
-    // We currently only support sRGB mipmap generation for unsigned byte
-    // textures, due to our use of a lookup table.
-    nassertv(cdata->_component_type == T_unsigned_byte);
+    // The color components are decoded to linear space, averaged, and then
+    // encoded again.
+    switch (cdata->_component_type) {
+    case T_unsigned_byte:
+      if (has_sse2_sRGB_encode()) {
+        filter_component = &filter_2d_unsigned_byte_srgb_sse2;
+      } else {
+        filter_component = &filter_2d_unsigned_byte_srgb;
+      }
+      // Alpha is always linear.
+      filter_alpha = &filter_2d_unsigned_byte;
+      break;
 
-    if (has_sse2_sRGB_encode()) {
-      filter_component = &filter_2d_unsigned_byte_srgb_sse2;
-    } else {
-      filter_component = &filter_2d_unsigned_byte_srgb;
-    }
+    case T_unsigned_short:
+      filter_component = &filter_2d_unsigned_short_srgb;
+      filter_alpha = &filter_2d_unsigned_short;
+      break;
 
-    // Alpha is always linear.
-    filter_alpha = &filter_2d_unsigned_byte;
+    case T_float:
+      filter_component = &filter_2d_float_srgb;
+      filter_alpha = &filter_2d_float;
+      break;
+
+    default:
+      gobj_cat.error()
+        << "Unable to generate mipmaps for 2D sRGB texture with component type "
+        << cdata->_component_type << "!";
+      return;
+    }
 
   } else {
     switch (cdata->_component_type) {
@@ -9097,112 +9512,89 @@ do_filter_2d_mipmap_pages(const CData *cdata,
       filter_component = &filter_2d_float;
       break;
 
-    default:
-      gobj_cat.error()
-        << "Unable to generate mipmaps for 2D texture with component type "
-        << cdata->_component_type << "!";
-      return;
-    }
-    filter_alpha = filter_component;
-  }
+    case T_byte:
+      filter_component = &filter_2d_byte;
+      break;
 
-  size_t pixel_size = cdata->_num_components * cdata->_component_width;
-  size_t row_size = (size_t)x_size * pixel_size;
+    case T_short:
+      filter_component = &filter_2d_short;
+      break;
 
-  int to_x_size = max(x_size >> 1, 1);
-  int to_y_size = max(y_size >> 1, 1);
+    case T_int:
+      filter_component = &filter_2d_int;
+      break;
 
-  size_t to_row_size = (size_t)to_x_size * pixel_size;
-  to._page_size = (size_t)to_y_size * to_row_size;
-  to._image = PTA_uchar::empty_array(to._page_size * cdata->_z_size * cdata->_num_views, get_class_type());
+    case T_unsigned_int:
+      filter_component = &filter_2d_unsigned_int;
+      break;
 
-  bool alpha = has_alpha(cdata->_format);
-  int num_color_components = cdata->_num_components;
-  if (alpha) {
-    --num_color_components;
-  }
+    case T_half_float:
+      filter_component = &filter_2d_half_float;
+      break;
 
-  int num_pages = cdata->_z_size * cdata->_num_views;
-  for (int z = 0; z < num_pages; ++z) {
-    // For each level.
-    unsigned char *p = to._image.p() + z * to._page_size;
-    nassertv(p <= to._image.p() + to._image.size() + to._page_size);
-    const unsigned char *q = from._image.p() + z * from._page_size;
-    nassertv(q <= from._image.p() + from._image.size() + from._page_size);
-    if (y_size != 1) {
-      int y;
-      for (y = 0; y < y_size - 1; y += 2) {
-        // For each row.
-        nassertv(p == to._image.p() + z * to._page_size + (y / 2) * to_row_size);
-        nassertv(q == from._image.p() + z * from._page_size + y * row_size);
-        if (x_size != 1) {
-          int x;
-          for (x = 0; x < x_size - 1; x += 2) {
-            // For each pixel.
-            for (int c = 0; c < num_color_components; ++c) {
-              // For each component.
-              filter_component(p, q, pixel_size, row_size);
-            }
-            if (alpha) {
-              filter_alpha(p, q, pixel_size, row_size);
-            }
-            q += pixel_size;
-          }
-          if (x < x_size) {
-            // Skip the last odd pixel.
-            q += pixel_size;
-          }
-        } else {
-          // Just one pixel.
-          for (int c = 0; c < num_color_components; ++c) {
-            // For each component.
-            filter_component(p, q, 0, row_size);
-          }
-          if (alpha) {
-            filter_alpha(p, q, 0, row_size);
-          }
-        }
-        q += row_size;
-        Thread::consider_yield();
-      }
-      if (y < y_size) {
-        // Skip the last odd row.
-        q += row_size;
-      }
-    } else {
-      // Just one row.
-      if (x_size != 1) {
-        int x;
-        for (x = 0; x < x_size - 1; x += 2) {
-          // For each pixel.
-          for (int c = 0; c < num_color_components; ++c) {
-            // For each component.
-            filter_component(p, q, pixel_size, 0);
-          }
-          if (alpha) {
-            filter_alpha(p, q, pixel_size, 0);
-          }
-          q += pixel_size;
-        }
-        if (x < x_size) {
-          // Skip the last odd pixel.
-          q += pixel_size;
-        }
-      } else {
-        // Just one pixel.
-        for (int c = 0; c < num_color_components; ++c) {
-          // For each component.
-          filter_component(p, q, 0, 0);
-        }
-        if (alpha) {
-          filter_alpha(p, q, pixel_size, 0);
-        }
-      }
+    default:
+      gobj_cat.error()
+        << "Unable to generate mipmaps for 2D texture with component type "
+        << cdata->_component_type << "!";
+      return;
     }
+    filter_alpha = filter_component;
+  }
+
+  size_t pixel_size = cdata->_num_components * cdata->_component_width;
+  size_t row_size = (size_t)x_size * pixel_size;
+
+  int to_x_size = max(x_size >> 1, 1);
+  int to_y_size = max(y_size >> 1, 1);
 
-    nassertv(p == to._image.p() + (z + 1) * to._page_size);
-    nassertv(q == from._image.p() + (z + 1) * from._page_size);
+  size_t to_row_size = (size_t)to_x_size * pixel_size;
+  to._page_size = (size_t)to_y_size * to_row_size;
+  to._image = PTA_uchar::empty_array(to._page_size * cdata->_z_size * cdata->_num_views, get_class_type());
+
+  bool alpha = has_alpha(cdata->_format);
+  int num_color_components = cdata->_num_components;
+  if (alpha) {
+    --num_color_components;
   }
+
+  int num_pages = cdata->_z_size * cdata->_num_views;
+  nassertv(from._image.size() >= from._page_size * num_pages);
+  nassertv(from._page_size >= (size_t)y_size * row_size);
+
+  MipmapFilterJob job;
+  job._filter_2d_component = filter_component;
+  job._filter_2d_alpha = filter_alpha;
+  job._filter_3d_component = NULL;
+  job._filter_3d_alpha = NULL;
+  job._to = to._image.p();
+  job._from = from._image.p();
+  job._pixel_size = pixel_size;
+  job._num_color_components = num_color_components;
+  job._alpha = alpha;
+  job._x_size = x_size;
+  job._y_size = y_size;
+  job._z_size = num_pages;
+  job._to_x_size = to_x_size;
+  job._to_y_size = to_y_size;
+  job._to_z_size = num_pages;
+  job._row_size = row_size;
+  job._page_size = from._page_size;
+  job._view_size = 0;
+  job._to_row_size = to_row_size;
+  job._to_page_size = to._page_size;
+  job._to_view_size = 0;
+
+  // The most common case by far--four unsigned bytes per pixel, all of them
+  // linear--has a vectorized implementation.
+  job._rgba8_sse2 = false;
+#ifdef TEXTURE_MIPMAP_SSE2
+  job._rgba8_sse2 = (filter_component == &filter_2d_unsigned_byte &&
+                     filter_alpha == &filter_2d_unsigned_byte &&
+                     pixel_size == 4 && x_size > 1 && y_size > 1);
+#endif
+
+  run_mipmap_filter(&filter_2d_mipmap_rows, &job, num_pages * to_y_size,
+                    to_row_size);
 }
 
 /**
@@ -9222,18 +9614,35 @@ do_filter_3d_mipmap_level(const CData *cdata,
   Filter3DComponent *filter_alpha;
 
   if (is_srgb(cdata->_format)) {
-    // We currently only support sRGB mipmap generation for unsigned byte
-    // textures, due to our use of a lookup table.
-    nassertv(cdata->_component_type == T_unsigned_byte);
+    // The color components are decoded to linear space, averaged, and then
+    // encoded again.
+    switch (cdata->_component_type) {
+    case T_unsigned_byte:
+      if (has_sse2_sRGB_encode()) {
+        filter_component = &filter_3d_unsigned_byte_srgb_sse2;
+      } else {
+        filter_component = &filter_3d_unsigned_byte_srgb;
+      }
+      // Alpha is always linear.
+      filter_alpha = &filter_3d_unsigned_byte;
+      break;
 
-    if (has_sse2_sRGB_encode()) {
-      filter_component = &filter_3d_unsigned_byte_srgb_sse2;
-    } else {
-      filter_component = &filter_3d_unsigned_byte_srgb;
-    }
+    case T_unsigned_short:
+      filter_component = &filter_3d_unsigned_short_srgb;
+      filter_alpha = &filter_3d_unsigned_short;
+      break;
+
+    case T_float:
+      filter_component = &filter_3d_float_srgb;
+      filter_alpha = &filter_3d_float;
+      break;
 
-    // Alpha is always linear.
-    filter_alpha = &filter_3d_unsigned_byte;
+    default:
+      gobj_cat.error()
+        << "Unable to generate mipmaps for 3D sRGB texture with component type "
+        << cdata->_component_type << "!";
+      return;
+    }
 
   } else {
     switch (cdata->_component_type) {
@@ -9249,6 +9658,26 @@ do_filter_3d_mipmap_level(const CData *cdata,
       filter_component = &filter_3d_float;
       break;
 
+    case T_byte:
+      filter_component = &filter_3d_byte;
+      break;
+
+    case T_short:
+      filter_component = &filter_3d_short;
+      break;
+
+    case T_int:
+      filter_component = &filter_3d_int;
+      break;
+
+    case T_unsigned_int:
+      filter_component = &filter_3d_unsigned_int;
+      break;
+
+    case T_half_float:
+      filter_component = &filter_3d_half_float;
+      break;
+
     default:
       gobj_cat.error()
         << "Unable to generate mipmaps for 3D texture with component type "
@@ -9279,171 +9708,166 @@ do_filter_3d_mipmap_level(const CData *cdata,
     --num_color_components;
   }
 
-  for (int view = 0; view < cdata->_num_views; ++view) {
-    unsigned char *start_to = to._image.p() + view * to_view_size;
-    const unsigned char *start_from = from._image.p() + view * view_size;
-    nassertv(start_to + to_view_size <= to._image.p() + to._image.size());
-    nassertv(start_from + view_size <= from._image.p() + from._image.size());
-    unsigned char *p = start_to;
-    const unsigned char *q = start_from;
-    if (z_size != 1) {
-      int z;
-      for (z = 0; z < z_size - 1; z += 2) {
-        // For each level.
-        nassertv(p == start_to + (z / 2) * to_page_size);
-        nassertv(q == start_from + z * page_size);
-        if (y_size != 1) {
-          int y;
-          for (y = 0; y < y_size - 1; y += 2) {
-            // For each row.
-            nassertv(p == start_to + (z / 2) * to_page_size + (y / 2) * to_row_size);
-            nassertv(q == start_from + z * page_size + y * row_size);
-            if (x_size != 1) {
-              int x;
-              for (x = 0; x < x_size - 1; x += 2) {
-                // For each pixel.
-                for (int c = 0; c < num_color_components; ++c) {
-                  // For each component.
-                  filter_component(p, q, pixel_size, row_size, page_size);
-                }
-                if (alpha) {
-                  filter_alpha(p, q, pixel_size, row_size, page_size);
-                }
-                q += pixel_size;
-              }
-              if (x < x_size) {
-                // Skip the last odd pixel.
-                q += pixel_size;
-              }
-            } else {
-              // Just one pixel.
-              for (int c = 0; c < num_color_components; ++c) {
-                // For each component.
-                filter_component(p, q, 0, row_size, page_size);
-              }
-              if (alpha) {
-                filter_alpha(p, q, 0, row_size, page_size);
-              }
-            }
-            q += row_size;
-            Thread::consider_yield();
-          }
-          if (y < y_size) {
-            // Skip the last odd row.
-            q += row_size;
-          }
-        } else {
-          // Just one row.
-          if (x_size != 1) {
-            int x;
-            for (x = 0; x < x_size - 1; x += 2) {
-              // For each pixel.
-              for (int c = 0; c < num_color_components; ++c) {
-                // For each component.
-                filter_component(p, q, pixel_size, 0, page_size);
-              }
-              if (alpha) {
-                filter_alpha(p, q, pixel_size, 0, page_size);
-              }
-              q += pixel_size;
-            }
-            if (x < x_size) {
-              // Skip the last odd pixel.
-              q += pixel_size;
-            }
-          } else {
-            // Just one pixel.
-            for (int c = 0; c < num_color_components; ++c) {
-              // For each component.
-              filter_component(p, q, 0, 0, page_size);
-            }
-            if (alpha) {
-              filter_alpha(p, q, 0, 0, page_size);
-            }
-          }
-        }
-        q += page_size;
+  nassertv(from._image.size() >= view_size * cdata->_num_views);
+
+  MipmapFilterJob job;
+  job._filter_2d_component = NULL;
+  job._filter_2d_alpha = NULL;
+  job._filter_3d_component = filter_component;
+  job._filter_3d_alpha = filter_alpha;
+  job._rgba8_sse2 = false;
+  job._to = to._image.p();
+  job._from = from._image.p();
+  job._pixel_size = pixel_size;
+  job._num_color_components = num_color_components;
+  job._alpha = alpha;
+  job._x_size = x_size;
+  job._y_size = y_size;
+  job._z_size = z_size;
+  job._to_x_size = to_x_size;
+  job._to_y_size = to_y_size;
+  job._to_z_size = to_z_size;
+  job._row_size = row_size;
+  job._page_size = page_size;
+  job._view_size = view_size;
+  job._to_row_size = to_row_size;
+  job._to_page_size = to_page_size;
+  job._to_view_size = to_view_size;
+
+  run_mipmap_filter(&filter_3d_mipmap_rows, &job,
+                    cdata->_num_views * to_z_size * to_y_size, to_row_size);
+}
+
+#ifdef TEXTURE_MIPMAP_SSE2
+/**
+ * Averages two rows of four-byte pixels into one row of half the width,
+ * treating each byte as an independent unsigned component.  This produces
+ * exactly the same result as filter_2d_unsigned_byte(), eight components at a
+ * time.
+ */
+static void
+filter_2d_rgba8_row_sse2(unsigned char *p, const unsigned char *q,
+                         size_t row_size, int to_x_size) {
+  const unsigned char *q2 = q + row_size;
+  const __m128i zero = _mm_setzero_si128();
+
+  int x = 0;
+  for (; x + 2 <= to_x_size; x += 2) {
+    // Four source pixels from each row make two destination pixels.
+    __m128i a = _mm_loadu_si128((const __m128i *)(q + x * 8));
+    __m128i b = _mm_loadu_si128((const __m128i *)(q2 + x * 8));
+
+    // Sum vertically, widening to 16 bits.
+    __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero),
+                               _mm_unpacklo_epi8(b, zero));
+    __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero),
+                               _mm_unpackhi_epi8(b, zero));
+
+    // Now sum each pair of horizontally adjacent pixels.
+    lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+    hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+    __m128i sum = _mm_srli_epi16(_mm_unpacklo_epi64(lo, hi), 2);
+
+    _mm_storel_epi64((__m128i *)(p + x * 4), _mm_packus_epi16(sum, sum));
+  }
+
+  for (; x < to_x_size; ++x) {
+    const unsigned char *r = q + x * 8;
+    const unsigned char *r2 = q2 + x * 8;
+    for (int c = 0; c < 4; ++c) {
+      p[x * 4 + c] = (unsigned char)
+        (((unsigned int)r[c] + (unsigned int)r[c + 4] +
+          (unsigned int)r2[c] + (unsigned int)r2[c + 4]) >> 2);
+    }
+  }
+}
+#endif  // TEXTURE_MIPMAP_SSE2
+
+/**
+ * Generates the destination rows [begin, end) of a 2-d mipmap level, as set
+ * up by do_filter_2d_mipmap_pages().  The rows of all the pages are numbered
+ * consecutively.  This may be called from a worker thread.
+ */
+void Texture::
+filter_2d_mipmap_rows(void *data, int begin, int end) {
+  const MipmapFilterJob &job = *(const MipmapFilterJob *)data;
+
+  // If the source level is only one pixel wide or high, we average that one
+  // pixel with itself.
+  size_t pixel_step = (job._x_size != 1) ? job._pixel_size : 0;
+  size_t row_step = (job._y_size != 1) ? job._row_size : 0;
+
+  for (int i = begin; i < end; ++i) {
+    int z = i / job._to_y_size;
+    int y = i % job._to_y_size;
+
+    unsigned char *p = job._to + z * job._to_page_size + y * job._to_row_size;
+    const unsigned char *q = job._from + z * job._page_size + y * 2 * row_step;
+
+#ifdef TEXTURE_MIPMAP_SSE2
+    if (job._rgba8_sse2) {
+      filter_2d_rgba8_row_sse2(p, q, job._row_size, job._to_x_size);
+      continue;
+    }
+#endif
+
+    for (int x = 0; x < job._to_x_size; ++x) {
+      // For each pixel.
+      for (int c = 0; c < job._num_color_components; ++c) {
+        // For each component.
+        job._filter_2d_component(p, q, pixel_step, row_step);
       }
-      if (z < z_size) {
-        // Skip the last odd page.
-        q += page_size;
+      if (job._alpha) {
+        job._filter_2d_alpha(p, q, pixel_step, row_step);
       }
-    } else {
-      // Just one page.
-      if (y_size != 1) {
-        int y;
-        for (y = 0; y < y_size - 1; y += 2) {
-          // For each row.
-          nassertv(p == start_to + (y / 2) * to_row_size);
-          nassertv(q == start_from + y * row_size);
-          if (x_size != 1) {
-            int x;
-            for (x = 0; x < x_size - 1; x += 2) {
-              // For each pixel.
-              for (int c = 0; c < num_color_components; ++c) {
-                // For each component.
-                filter_component(p, q, pixel_size, row_size, 0);
-              }
-              if (alpha) {
-                filter_alpha(p, q, pixel_size, row_size, 0);
-              }
-              q += pixel_size;
-            }
-            if (x < x_size) {
-              // Skip the last odd pixel.
-              q += pixel_size;
-            }
-          } else {
-            // Just one pixel.
-            for (int c = 0; c < num_color_components; ++c) {
-              // For each component.
-              filter_component(p, q, 0, row_size, 0);
-            }
-            if (alpha) {
-              filter_alpha(p, q, 0, row_size, 0);
-            }
-          }
-          q += row_size;
-          Thread::consider_yield();
-        }
-        if (y < y_size) {
-          // Skip the last odd row.
-          q += row_size;
-        }
-      } else {
-        // Just one row.
-        if (x_size != 1) {
-          int x;
-          for (x = 0; x < x_size - 1; x += 2) {
-            // For each pixel.
-            for (int c = 0; c < num_color_components; ++c) {
-              // For each component.
-              filter_component(p, q, pixel_size, 0, 0);
-            }
-            if (alpha) {
-              filter_alpha(p, q, pixel_size, 0, 0);
-            }
-            q += pixel_size;
-          }
-          if (x < x_size) {
-            // Skip the last odd pixel.
-            q += pixel_size;
-          }
-        } else {
-          // Just one pixel.
-          for (int c = 0; c < num_color_components; ++c) {
-            // For each component.
-            filter_component(p, q, 0, 0, 0);
-          }
-          if (alpha) {
-            filter_alpha(p, q, 0, 0, 0);
-          }
-        }
+      // Skip the second pixel of the pair.
+      q += pixel_step;
+    }
+
+    nassertv(p == job._to + z * job._to_page_size + (y + 1) * job._to_row_size);
+    Thread::consider_yield();
+  }
+}
+
+/**
+ * Generates the destination rows [begin, end) of a 3-d mipmap level, as set
+ * up by do_filter_3d_mipmap_level().  The rows of all the pages of all the
+ * views are numbered consecutively.  This may be called from a worker thread.
+ */
+void Texture::
+filter_3d_mipmap_rows(void *data, int begin, int end) {
+  const MipmapFilterJob &job = *(const MipmapFilterJob *)data;
+
+  size_t pixel_step = (job._x_size != 1) ? job._pixel_size : 0;
+  size_t row_step = (job._y_size != 1) ? job._row_size : 0;
+  size_t page_step = (job._z_size != 1) ? job._page_size : 0;
+
+  int rows_per_view = job._to_z_size * job._to_y_size;
+
+  for (int i = begin; i < end; ++i) {
+    int view = i / rows_per_view;
+    int z = (i % rows_per_view) / job._to_y_size;
+    int y = i % job._to_y_size;
+
+    unsigned char *p = job._to + view * job._to_view_size +
+      z * job._to_page_size + y * job._to_row_size;
+    const unsigned char *q = job._from + view * job._view_size +
+      z * 2 * page_step + y * 2 * row_step;
+
+    for (int x = 0; x < job._to_x_size; ++x) {
+      // For each pixel.
+      for (int c = 0; c < job._num_color_components; ++c) {
+        // For each component.
+        job._filter_3d_component(p, q, pixel_step, row_step, page_step);
+      }
+      if (job._alpha) {
+        job._filter_3d_alpha(p, q, pixel_step, row_step, page_step);
       }
+      // Skip the second pixel of the pair.
+      q += pixel_step;
     }
 
-    nassertv(p == start_to + to_z_size * to_page_size);
-    nassertv(q == start_from + z_size * page_size);
+    Thread::consider_yield();
   }
 }
 
@@ -9633,6 +10057,270 @@ filter_3d_float(unsigned char *&p, const unsigned char *&q,
   q += 4;
 }
 
+/**
+ * Averages a 2x2 block of pixel components into a single pixel component, for
+ * producing the next mipmap level.  Increments p and q to the next component.
+ */
+void Texture::
+filter_2d_float_srgb(unsigned char *&p, const unsigned char *&q,
+                     size_t pixel_size, size_t row_size) {
+  float result = (decode_sRGB_float(*(float *)&q[0]) +
+                  decode_sRGB_float(*(float *)&q[pixel_size]) +
+                  decode_sRGB_float(*(float *)&q[row_size]) +
+                  decode_sRGB_float(*(float *)&q[pixel_size + row_size]));
+
+  *(float *)p = encode_sRGB_float(result * 0.25f);
+  p += 4;
+  q += 4;
+}
+
+/**
+ * Averages a 2x2 block of pixel components into a single pixel component, for
+ * producing the next mipmap level.  Increments p and q to the next component.
+ */
+void Texture::
+filter_2d_unsigned_short_srgb(unsigned char *&p, const unsigned char *&q,
+                              size_t pixel_size, size_t row_size) {
+  const float scale = 1.0f / 65535.0f;
+  float result = (decode_sRGB_float(*(unsigned short *)&q[0] * scale) +
+                  decode_sRGB_float(*(unsigned short *)&q[pixel_size] * scale) +
+                  decode_sRGB_float(*(unsigned short *)&q[row_size] * scale) +
+                  decode_sRGB_float(*(unsigned short *)&q[pixel_size + row_size] * scale));
+
+  store_unscaled_short(p, (int)(encode_sRGB_float(result * 0.25f) * 65535.0f + 0.5f));
+  q += 2;
+}
+
+/**
+ * Averages a 2x2 block of pixel components into a single pixel component, for
+ * producing the next mipmap level.  Increments p and q to the next component.
+ */
+void Texture::
+filter_2d_byte(unsigned char *&p, const unsigned char *&q,
+               size_t pixel_size, size_t row_size) {
+  int result = ((int)(signed char)q[0] +
+                (int)(signed char)q[pixel_size] +
+                (int)(signed char)q[row_size] +
+                (int)(signed char)q[pixel_size + row_size]) / 4;
+  *p = (unsigned char)(signed char)result;
+  ++p;
+  ++q;
+}
+
+/**
+ * Averages a 2x2 block of pixel components into a single pixel component, for
+ * producing the next mipmap level.  Increments p and q to the next component.
+ */
+void Texture::
+filter_2d_short(unsigned char *&p, const unsigned char *&q,
+                size_t pixel_size, size_t row_size) {
+  int result = ((int)*(short *)&q[0] +
+                (int)*(short *)&q[pixel_size] +
+                (int)*(short *)&q[row_size] +
+                (int)*(short *)&q[pixel_size + row_size]) / 4;
+  *(short *)p = (short)result;
+  p += 2;
+  q += 2;
+}
+
+/**
+ * Averages a 2x2 block of pixel components into a single pixel component, for
+ * producing the next mipmap level.  Increments p and q to the next component.
+ */
+void Texture::
+filter_2d_int(unsigned char *&p, const unsigned char *&q,
+              size_t pixel_size, size_t row_size) {
+  int64_t result = ((int64_t)*(int32_t *)&q[0] +
+                    (int64_t)*(int32_t *)&q[pixel_size] +
+                    (int64_t)*(int32_t *)&q[row_size] +
+                    (int64_t)*(int32_t *)&q[pixel_size + row_size]) / 4;
+  *(int32_t *)p = (int32_t)result;
+  p += 4;
+  q += 4;
+}
+
+/**
+ * Averages a 2x2 block of pixel components into a single pixel component, for
+ * producing the next mipmap level.  Increments p and q to the next component.
+ */
+void Texture::
+filter_2d_unsigned_int(unsigned char *&p, const unsigned char *&q,
+                       size_t pixel_size, size_t row_size) {
+  uint64_t result = ((uint64_t)*(uint32_t *)&q[0] +
+                     (uint64_t)*(uint32_t *)&q[pixel_size] +
+                     (uint64_t)*(uint32_t *)&q[row_size] +
+                     (uint64_t)*(uint32_t *)&q[pixel_size + row_size]) >> 2;
+  *(uint32_t *)p = (uint32_t)result;
+  p += 4;
+  q += 4;
+}
+
+/**
+ * Averages a 2x2 block of pixel components into a single pixel component, for
+ * producing the next mipmap level.  Increments p and q to the next component.
+ */
+void Texture::
+filter_2d_half_float(unsigned char *&p, const unsigned char *&q,
+                     size_t pixel_size, size_t row_size) {
+  float result = (half_to_float(*(uint16_t *)&q[0]) +
+                  half_to_float(*(uint16_t *)&q[pixel_size]) +
+                  half_to_float(*(uint16_t *)&q[row_size]) +
+                  half_to_float(*(uint16_t *)&q[pixel_size + row_size]));
+  *(uint16_t *)p = float_to_half(result * 0.25f);
+  p += 2;
+  q += 2;
+}
+
+/**
+ * Averages a 2x2x2 block of pixel components into a single pixel component,
+ * for producing the next mipmap level.  Increments p and q to the next
+ * component.
+ */
+void Texture::
+filter_3d_float_srgb(unsigned char *&p, const unsigned char *&q,
+                     size_t pixel_size, size_t row_size, size_t page_size) {
+  float result = (decode_sRGB_float(*(float *)&q[0]) +
+                  decode_sRGB_float(*(float *)&q[pixel_size]) +
+                  decode_sRGB_float(*(float *)&q[row_size]) +
+                  decode_sRGB_float(*(float *)&q[pixel_size + row_size]) +
+                  decode_sRGB_float(*(float *)&q[page_size]) +
+                  decode_sRGB_float(*(float *)&q[pixel_size + page_size]) +
+                  decode_sRGB_float(*(float *)&q[row_size + page_size]) +
+                  decode_sRGB_float(*(float *)&q[pixel_size + row_size + page_size]));
+
+  *(float *)p = encode_sRGB_float(result * 0.125f);
+  p += 4;
+  q += 4;
+}
+
+/**
+ * Averages a 2x2x2 block of pixel components into a single pixel component,
+ * for producing the next mipmap level.  Increments p and q to the next
+ * component.
+ */
+void Texture::
+filter_3d_unsigned_short_srgb(unsigned char *&p, const unsigned char *&q,
+                              size_t pixel_size, size_t row_size,
+                              size_t page_size) {
+  const float scale = 1.0f / 65535.0f;
+  float result = (decode_sRGB_float(*(unsigned short *)&q[0] * scale) +
+                  decode_sRGB_float(*(unsigned short *)&q[pixel_size] * scale) +
+                  decode_sRGB_float(*(unsigned short *)&q[row_size] * scale) +
+                  decode_sRGB_float(*(unsigned short *)&q[pixel_size + row_size] * scale) +
+                  decode_sRGB_float(*(unsigned short *)&q[page_size] * scale) +
+                  decode_sRGB_float(*(unsigned short *)&q[pixel_size + page_size] * scale) +
+                  decode_sRGB_float(*(unsigned short *)&q[row_size + page_size] * scale) +
+                  decode_sRGB_float(*(unsigned short *)&q[pixel_size + row_size + page_size] * scale));
+
+  store_unscaled_short(p, (int)(encode_sRGB_float(result * 0.125f) * 65535.0f + 0.5f));
+  q += 2;
+}
+
+/**
+ * Averages a 2x2x2 block of pixel components into a single pixel component,
+ * for producing the next mipmap level.  Increments p and q to the next
+ * component.
+ */
+void Texture::
+filter_3d_byte(unsigned char *&p, const unsigned char *&q,
+               size_t pixel_size, size_t row_size, size_t page_size) {
+  int result = ((int)(signed char)q[0] +
+                (int)(signed char)q[pixel_size] +
+                (int)(signed char)q[row_size] +
+                (int)(signed char)q[pixel_size + row_size] +
+                (int)(signed char)q[page_size] +
+                (int)(signed char)q[pixel_size + page_size] +
+                (int)(signed char)q[row_size + page_size] +
+                (int)(signed char)q[pixel_size + row_size + page_size]) / 8;
+  *p = (unsigned char)(signed char)result;
+  ++p;
+  ++q;
+}
+
+/**
+ * Averages a 2x2x2 block of pixel components into a single pixel component,
+ * for producing the next mipmap level.  Increments p and q to the next
+ * component.
+ */
+void Texture::
+filter_3d_short(unsigned char *&p, const unsigned char *&q,
+                size_t pixel_size, size_t row_size, size_t page_size) {
+  int result = ((int)*(short *)&q[0] +
+                (int)*(short *)&q[pixel_size] +
+                (int)*(short *)&q[row_size] +
+                (int)*(short *)&q[pixel_size + row_size] +
+                (int)*(short *)&q[page_size] +
+                (int)*(short *)&q[pixel_size + page_size] +
+                (int)*(short *)&q[row_size + page_size] +
+                (int)*(short *)&q[pixel_size + row_size + page_size]) / 8;
+  *(short *)p = (short)result;
+  p += 2;
+  q += 2;
+}
+
+/**
+ * Averages a 2x2x2 block of pixel components into a single pixel component,
+ * for producing the next mipmap level.  Increments p and q to the next
+ * component.
+ */
+void Texture::
+filter_3d_int(unsigned char *&p, const unsigned char *&q,
+              size_t pixel_size, size_t row_size, size_t page_size) {
+  int64_t result = ((int64_t)*(int32_t *)&q[0] +
+                    (int64_t)*(int32_t *)&q[pixel_size] +
+                    (int64_t)*(int32_t *)&q[row_size] +
+                    (int64_t)*(int32_t *)&q[pixel_size + row_size] +
+                    (int64_t)*(int32_t *)&q[page_size] +
+                    (int64_t)*(int32_t *)&q[pixel_size + page_size] +
+                    (int64_t)*(int32_t *)&q[row_size + page_size] +
+                    (int64_t)*(int32_t *)&q[pixel_size + row_size + page_size]) / 8;
+  *(int32_t *)p = (int32_t)result;
+  p += 4;
+  q += 4;
+}
+
+/**
+ * Averages a 2x2x2 block of pixel components into a single pixel component,
+ * for producing the next mipmap level.  Increments p and q to the next
+ * component.
+ */
+void Texture::
+filter_3d_unsigned_int(unsigned char *&p, const unsigned char *&q,
+                       size_t pixel_size, size_t row_size, size_t page_size) {
+  uint64_t result = ((uint64_t)*(uint32_t *)&q[0] +
+                     (uint64_t)*(uint32_t *)&q[pixel_size] +
+                     (uint64_t)*(uint32_t *)&q[row_size] +
+                     (uint64_t)*(uint32_t *)&q[pixel_size + row_size] +
+                     (uint64_t)*(uint32_t *)&q[page_size] +
+                     (uint64_t)*(uint32_t *)&q[pixel_size + page_size] +
+                     (uint64_t)*(uint32_t *)&q[row_size + page_size] +
+                     (uint64_t)*(uint32_t *)&q[pixel_size + row_size + page_size]) >> 3;
+  *(uint32_t *)p = (uint32_t)result;
+  p += 4;
+  q += 4;
+}
+
+/**
+ * Averages a 2x2x2 block of pixel components into a single pixel component,
+ * for producing the next mipmap level.  Increments p and q to the next
+ * component.
+ */
+void Texture::
+filter_3d_half_float(unsigned char *&p, const unsigned char *&q,
+                     size_t pixel_size, size_t row_size, size_t page_size) {
+  float result = (half_to_float(*(uint16_t *)&q[0]) +
+                  half_to_float(*(uint16_t *)&q[pixel_size]) +
+                  half_to_float(*(uint16_t *)&q[row_size]) +
+                  half_to_float(*(uint16_t *)&q[pixel_size + row_size]) +
+                  half_to_float(*(uint16_t *)&q[page_size]) +
+                  half_to_float(*(uint16_t *)&q[pixel_size + page_size]) +
+                  half_to_float(*(uint16_t *)&q[row_size + page_size]) +
+                  half_to_float(*(uint16_t *)&q[pixel_size + row_size + page_size]));
+  *(uint16_t *)p = float_to_half(result * 0.125f);
+  p += 2;
+  q += 2;
+}
+
 /**
  * Invokes the squish library to compress the RAM image(s).
  */
@@ -700,14 +700,13 @@ protected:
                              GraphicsStateGuardianBase *gsg);
   bool do_uncompress_ram_image(CData *cdata);
 
-  static void do_compress_ram_image_bc4(const RamImage &src, RamImage &dest,
-                                        int x_size, int y_size, int z_size);
-  static void do_compress_ram_image_bc5(const RamImage &src, RamImage &dest,
-                                        int x_size, int y_size, int z_size);
-  static void do_uncompress_ram_image_bc4(const RamImage &src, RamImage &dest,
-                                          int x_size, int y_size, int z_size);
-  static void do_uncompress_ram_image_bc5(const RamImage &src, RamImage &dest,
-                                          int x_size, int y_size, int z_size);
+  bool do_compress_ram_image_blocks(CData *cdata, CompressionMode compression,
+                                    QualityLevel quality_level);
+  bool do_uncompress_ram_image_blocks(CData *cdata);
+
+  struct BlockCodecJob;
+  static void compress_block_rows(void *data, int begin, int end);
+  static void uncompress_block_rows(void *data, int begin, int end);
   bool do_has_all_ram_mipmap_images(const CData *cdata) const;
 
   bool do_reconsider_z_size(CData *cdata, int z, const LoaderOptions &options);
@@ -866,6 +865,10 @@ private:
                                  RamImage &to, const RamImage &from,
                                  int x_size, int y_size, int z_size) const;
 
+  struct MipmapFilterJob;
+  static void filter_2d_mipmap_rows(void *data, int begin, int end);
+  static void filter_3d_mipmap_rows(void *data, int begin, int end);
+
   typedef void Filter2DComponent(unsigned char *&p,
                                  const unsigned char *&q,
                                  size_t pixel_size, size_t row_size);
@@ -889,6 +892,22 @@ private:
                                        size_t pixel_size, size_t row_size);
   static void filter_2d_float(unsigned char *&p, const unsigned char *&q,
                               size_t pixel_size, size_t row_size);
+  static void filter_2d_float_srgb(unsigned char *&p, const unsigned char *&q,
+                                   size_t pixel_size, size_t row_size);
+  static void filter_2d_unsigned_short_srgb(unsigned char *&p,
+                                            const unsigned char *&q,
+                                            size_t pixel_size, size_t row_size);
+  static void filter_2d_byte(unsigned char *&p, const unsigned char *&q,
+                             size_t pixel_size, size_t row_size);
+  static void filter_2d_short(unsigned char *&p, const unsigned char *&q,
+                              size_t pixel_size, size_t row_size);
+  static void filter_2d_int(unsigned char *&p, const unsigned char *&q,
+                            size_t pixel_size, size_t row_size);
+  static void filter_2d_unsigned_int(unsigned char *&p,
+                                     const unsigned char *&q,
+                                     size_t pixel_size, size_t row_size);
+  static void filter_2d_half_float(unsigned char *&p, const unsigned char *&q,
+                                   size_t pixel_size, size_t row_size);
 
   static void filter_3d_unsigned_byte(unsigned char *&p,
                                       const unsigned char *&q,
@@ -908,6 +927,29 @@ private:
                                        size_t page_size);
   static void filter_3d_float(unsigned char *&p, const unsigned char *&q,
                               size_t pixel_size, size_t row_size, size_t page_size);
+  static void filter_3d_float_srgb(unsigned char *&p, const unsigned char *&q,
+                                   size_t pixel_size, size_t row_size,
+                                   size_t page_size);
+  static void filter_3d_unsigned_short_srgb(unsigned char *&p,
+                                            const unsigned char *&q,
+                                            size_t pixel_size, size_t row_size,
+                                            size_t page_size);
+  static void filter_3d_byte(unsigned char *&p, const unsigned char *&q,
+                             size_t pixel_size, size_t row_size,
+                             size_t page_size);
+  static void filter_3d_short(unsigned char *&p, const unsigned char *&q,
+                              size_t pixel_size, size_t row_size,
+                              size_t page_size);
+  static void filter_3d_int(unsigned char *&p, const unsigned char *&q,
+                            size_t pixel_size, size_t row_size,
+                            size_t page_size);
+  static void filter_3d_unsigned_int(unsigned char *&p,
+                                     const unsigned char *&q,
+                                     size_t pixel_size, size_t row_size,
+                                     size_t page_size);
+  static void filter_3d_half_float(unsigned char *&p, const unsigned char *&q,
+                                   size_t pixel_size, size_t row_size,
+                                   size_t page_size);
 
   bool do_squish(CData *cdata, CompressionMode compression, int squish_flags);
   bool do_unsquish(CData *cdata, int squish_flags);
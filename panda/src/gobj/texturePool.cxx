@@ -278,11 +278,7 @@ ns_load_texture(const Filename &orig_filename, int primary_file_num_channels,
   }
 
   if (cache->get_cache_compressed_textures() && tex->has_compression()) {
-#ifndef HAVE_SQUISH
-    bool needs_driver_compression = true;
-#else
     bool needs_driver_compression = driver_compress_textures;
-#endif // HAVE_SQUISH
     if (needs_driver_compression) {
       // We don't want to save the uncompressed version; we'll save the
       // compressed version when it becomes available.
@@ -407,11 +403,7 @@ ns_load_texture(const Filename &orig_filename,
   }
 
   if (cache->get_cache_compressed_textures() && tex->has_compression()) {
-#ifndef HAVE_SQUISH
-    bool needs_driver_compression = true;
-#else
     bool needs_driver_compression = driver_compress_textures;
-#endif // HAVE_SQUISH
     if (needs_driver_compression) {
       // We don't want to save the uncompressed version; we'll save the
       // compressed version when it becomes available.
@@ -519,11 +511,7 @@ ns_load_3d_texture(const Filename &filename_pattern,
   }
 
   if (cache->get_cache_compressed_textures() && tex->has_compression()) {
-#ifndef HAVE_SQUISH
-    bool needs_driver_compression = true;
-#else
     bool needs_driver_compression = driver_compress_textures;
-#endif // HAVE_SQUISH
     if (needs_driver_compression) {
       // We don't want to save the uncompressed version; we'll save the
       // compressed version when it becomes available.
@@ -623,11 +611,7 @@ ns_load_2d_texture_array(const Filename &filename_pattern,
   }
 
   if (cache->get_cache_compressed_textures() && tex->has_compression()) {
-#ifndef HAVE_SQUISH
-    bool needs_driver_compression = true;
-#else
     bool needs_driver_compression = driver_compress_textures;
-#endif // HAVE_SQUISH
     if (needs_driver_compression) {
       // We don't want to save the uncompressed version; we'll save the
       // compressed version when it becomes available.
@@ -722,11 +706,7 @@ ns_load_cube_map(const Filename &filename_pattern, bool read_mipmaps,
   }
 
   if (cache->get_cache_compressed_textures() && tex->has_compression()) {
-#ifndef HAVE_SQUISH
-    bool needs_driver_compression = true;
-#else
     bool needs_driver_compression = driver_compress_textures;
-#endif // HAVE_SQUISH
     if (needs_driver_compression) {
       // We don't want to save the uncompressed version; we'll save the
       // compressed version when it becomes available.
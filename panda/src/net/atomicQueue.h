@@ -0,0 +1,103 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file atomicQueue.h
+ * @date 2026-10-18
+ */
+
+#ifndef ATOMICQUEUE_H
+#define ATOMICQUEUE_H
+
+#include "pandabase.h"
+#include "atomicAdjust.h"
+
+/**
+ * A bounded FIFO queue that any number of threads may push onto and pop from
+ * at the same time without taking a lock.  It is a ring of slots, each with
+ * its own sequence number that tells the producers and consumers whose turn
+ * it is to use the slot.
+ *
+ * The ring is allocated by the first push(), with room for at least as many
+ * things as the max_size passed to it.  It cannot grow after that, so a
+ * larger max_size passed to a later push() is limited by the ring's size.
+ *
+ * Each Thing lives in its own heap-allocated node, so that the slots stay
+ * small.  Nodes are kept on a second ring for reuse when they are popped, so
+ * that a queue in steady use doesn't allocate any memory.  Things are moved
+ * in and out of the nodes where possible.  This class does not block; see
+ * DatagramQueue for the waiting.
+ */
+template<class Thing>
+class AtomicQueue {
+public:
+  AtomicQueue();
+  ~AtomicQueue();
+
+  bool push(const Thing &thing, int max_size);
+#ifdef USE_MOVE_SEMANTICS
+  bool push(Thing &&thing, int max_size);
+#endif
+  bool pop(Thing &result);
+
+  INLINE int size() const;
+  INLINE bool empty() const;
+
+private:
+  class Slot {
+  public:
+    AtomicAdjust::Integer _seq;
+    Thing *_node;
+  };
+
+  class Ring {
+  public:
+    Ring(int capacity);
+    ~Ring();
+
+    bool push(Thing *node, int max_size);
+    Thing *pop();
+    INLINE int size() const;
+
+    // The positions of the head and tail, and the sequence numbers of the
+    // slots, count up forever, and wrap around when they overflow, which a
+    // 32-bit Integer may well do.  So they are only ever compared by their
+    // difference, and all of the arithmetic on them is done unsigned.
+    INLINE static AtomicAdjust::Integer
+    advance(AtomicAdjust::Integer pos, AtomicAdjust::Integer count);
+    INLINE static AtomicAdjust::Integer
+    distance(AtomicAdjust::Integer from, AtomicAdjust::Integer to);
+
+    // The producers and the consumers each get their own cache line.
+    AtomicAdjust::Integer _tail;
+    char _pad0[64 - sizeof(AtomicAdjust::Integer)];
+    AtomicAdjust::Integer _head;
+    char _pad1[64 - sizeof(AtomicAdjust::Integer)];
+
+    int _capacity;
+    AtomicAdjust::Integer _mask;
+    Slot *_slots;
+  };
+
+  class Storage {
+  public:
+    INLINE Storage(int capacity);
+
+    Ring _queue;
+    Ring _spare_nodes;
+  };
+
+  Storage *get_storage(int max_size);
+  INLINE Thing *alloc_node(Storage *storage);
+  INLINE void free_node(Storage *storage, Thing *node);
+
+  AtomicAdjust::Pointer _storage;
+};
+
+#include "atomicQueue.I"
+
+#endif
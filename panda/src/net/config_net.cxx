@@ -142,6 +142,32 @@ ConfigVariableEnum<ThreadPriority> net_thread_priority
  PRC_DESC("The default thread priority when creating threaded readers "
           "or writers."));
 
+ConfigVariableBool net_use_epoll
+("net-use-epoll", true,
+ PRC_DESC("On Linux, ConnectionReaders and ConnectionListeners use epoll "
+          "to wait for activity on their sockets, which scales to many "
+          "thousands of connections.  Set this false to use select() "
+          "instead, as on other platforms.  This only affects readers "
+          "created after the change."));
+
+ConfigVariableInt net_udp_batch_size
+("net-udp-batch-size", 32,
+ PRC_DESC("The maximum number of UDP datagrams to receive, or to send from "
+          "a threaded ConnectionWriter, with a single system call, on "
+          "platforms that support this (currently Linux).  The upper limit "
+          "is 64.  Set this to 1 to read and write one datagram at a time."));
+
+ConfigVariableInt net_datagram_pool_size
+("net-datagram-pool-size", 1024,
+ PRC_DESC("The maximum number of unused NetDatagram arrays that are kept "
+          "around for reuse by later datagrams.  Set this to 0 to disable "
+          "the pool."));
+
+ConfigVariableInt net_datagram_pool_max_buffer
+("net-datagram-pool-max-buffer", 4096,
+ PRC_DESC("Arrays that have grown larger than this number of bytes are not "
+          "kept in the NetDatagram pool, but freed as usual."));
+
 
 /**
  * Initializes the library.  This must be called at least once before any of
@@ -22,6 +22,15 @@
 #include "configVariableEnum.h"
 #include "threadPriority.h"
 
+// On Linux, recvmmsg() and sendmmsg() can move many UDP datagrams with a
+// single system call.
+#if defined(__linux__) && !defined(CPPPARSER)
+#define HAVE_MMSG 1
+#endif
+
+// The upper limit on net-udp-batch-size.
+static const int max_udp_batch_size = 64;
+
 // Configure variables for net package.
 
 NotifyCategoryDecl(net, EXPCL_PANDA_NET, EXPTP_PANDA_NET);
@@ -37,6 +46,10 @@ extern ConfigVariableInt net_max_read_per_epoch;
 extern ConfigVariableInt net_max_write_per_epoch;
 
 extern ConfigVariableEnum<ThreadPriority> net_thread_priority;
+extern ConfigVariableBool net_use_epoll;
+extern ConfigVariableInt net_udp_batch_size;
+extern ConfigVariableInt net_datagram_pool_size;
+extern ConfigVariableInt net_datagram_pool_max_buffer;
 
 extern EXPCL_PANDA_NET void init_libnet();
 
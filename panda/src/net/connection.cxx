@@ -25,7 +25,14 @@
 #include "socket_tcp.h"
 #include "socket_udp.h"
 #include "dcast.h"
+#include "pStatCollector.h"
 
+#ifdef HAVE_MMSG
+#include <sys/socket.h>
+#include <errno.h>
+
+static PStatCollector _udp_send_batch_pcollector("Net:UDP send batch");
+#endif
 
 /**
  * Creates a connection.  Normally this constructor should not be used
@@ -303,9 +310,8 @@ send_datagram(const NetDatagram &datagram, int tcp_header_size) {
 
     LightReMutexHolder holder(_write_mutex);
     DatagramUDPHeader header(datagram);
-    string data;
-    data += header.get_header();
-    data += datagram.get_message();
+    string data = header.get_header();
+    data.append((const char *)datagram.get_data(), datagram.get_length());
 
     if (net_cat.is_debug()) {
       header.verify_datagram(datagram);
@@ -345,7 +351,7 @@ send_datagram(const NetDatagram &datagram, int tcp_header_size) {
 
   LightReMutexHolder holder(_write_mutex);
   _queued_data += header.get_header();
-  _queued_data += datagram.get_message();
+  _queued_data.append((const char *)datagram.get_data(), datagram.get_length());
   _queued_count++;
 
   if (net_cat.is_debug()) {
@@ -374,22 +380,23 @@ send_raw_datagram(const NetDatagram &datagram) {
     Socket_UDP *udp;
     DCAST_INTO_R(udp, _socket, false);
 
-    string data = datagram.get_message();
+    const char *data = (const char *)datagram.get_data();
+    int length = (int)datagram.get_length();
 
     LightReMutexHolder holder(_write_mutex);
     Socket_Address addr = datagram.get_address().get_addr();
-    bool okflag = udp->SendTo(data, addr);
+    bool okflag = udp->SendTo(data, length, addr);
 #if defined(HAVE_THREADS) && defined(SIMPLE_THREADS)
     while (!okflag && udp->GetLastError() == LOCAL_BLOCKING_ERROR && udp->Active()) {
       Thread::force_yield();
-      okflag = udp->SendTo(data, addr);
+      okflag = udp->SendTo(data, length, addr);
     }
 #endif  // SIMPLE_THREADS
 
     if (net_cat.is_spam()) {
       net_cat.spam()
         << "Sent UDP datagram with "
-        << data.size() << " bytes to " << (void *)this
+        << length << " bytes to " << (void *)this
         << ", ok = " << okflag << "\n";
     }
 
@@ -398,7 +405,7 @@ send_raw_datagram(const NetDatagram &datagram) {
 
   // We might queue up TCP packets for later sending.
   LightReMutexHolder holder(_write_mutex);
-  _queued_data += datagram.get_message();
+  _queued_data.append((const char *)datagram.get_data(), datagram.get_length());
   _queued_count++;
 
   if (!_collect_tcp ||
@@ -409,6 +416,106 @@ send_raw_datagram(const NetDatagram &datagram) {
   return true;
 }
 
+/**
+ * This method is intended only to be called by ConnectionWriter.  It sends a
+ * series of UDP datagrams, each to its own address, with or without their
+ * headers according to raw_mode.  Where sendmmsg() is available, this is
+ * done with as few system calls as possible.
+ *
+ * Returns true if all of the datagrams were sent successfully.
+ */
+bool Connection::
+send_udp_datagrams(const NetDatagram *datagrams, int num_datagrams,
+                   bool raw_mode) {
+  nassertr(_socket != (Socket_IP *)NULL, false);
+  nassertr(_socket->is_exact_type(Socket_UDP::get_class_type()), false);
+
+#ifdef HAVE_MMSG
+  if (num_datagrams > 1) {
+    struct mmsghdr msgs[max_udp_batch_size];
+    struct iovec iov[max_udp_batch_size * 2];
+    string headers[max_udp_batch_size];
+
+    bool okflag = true;
+    LightReMutexHolder holder(_write_mutex);
+
+    int start = 0;
+    while (start < num_datagrams) {
+      int count = min(num_datagrams - start, max_udp_batch_size);
+
+      // Each message is gathered from its header, if any, and its data.
+      memset(msgs, 0, sizeof(struct mmsghdr) * count);
+      for (int i = 0; i < count; ++i) {
+        const NetDatagram &datagram = datagrams[start + i];
+        struct msghdr &hdr = msgs[i].msg_hdr;
+        struct iovec *vec = &iov[i * 2];
+        hdr.msg_iov = vec;
+
+        if (!raw_mode) {
+          DatagramUDPHeader header(datagram);
+          headers[i] = header.get_header();
+          vec->iov_base = (void *)headers[i].data();
+          vec->iov_len = headers[i].size();
+          ++vec;
+        }
+        vec->iov_base = (void *)datagram.get_data();
+        vec->iov_len = datagram.get_length();
+        hdr.msg_iovlen = (vec - hdr.msg_iov) + 1;
+
+        const struct sockaddr *addr =
+          &datagram.get_address().get_addr().GetAddressInfo();
+        hdr.msg_name = (void *)addr;
+        hdr.msg_namelen = SA_SIZEOF(addr);
+      }
+
+      // sendmmsg() may send fewer messages than we asked for; keep going
+      // until all of them are sent.
+      int sent = 0;
+      while (sent < count) {
+        int result = sendmmsg(_socket->GetSocket(), msgs + sent, count - sent, 0);
+        if (result > 0) {
+          _udp_send_batch_pcollector.set_level(result);
+          sent += result;
+
+        } else if (errno == EINTR) {
+          continue;
+
+#if defined(HAVE_THREADS) && defined(SIMPLE_THREADS)
+        } else if (errno == LOCAL_BLOCKING_ERROR && _socket->Active()) {
+          Thread::force_yield();
+#endif  // SIMPLE_THREADS
+
+        } else {
+          // The first remaining message could not be sent.  Skip it, so that
+          // one bad address doesn't hold up the rest.
+          okflag = false;
+          ++sent;
+        }
+      }
+
+      if (net_cat.is_spam()) {
+        net_cat.spam()
+          << "Sent " << count << " UDP datagrams to " << (void *)this
+          << ", ok = " << okflag << "\n";
+      }
+      start += count;
+    }
+
+    return check_send_error(okflag);
+  }
+#endif  // HAVE_MMSG
+
+  bool okflag = true;
+  for (int i = 0; i < num_datagrams; ++i) {
+    if (raw_mode) {
+      okflag = send_raw_datagram(datagrams[i]) && okflag;
+    } else {
+      okflag = send_datagram(datagrams[i], 0) && okflag;
+    }
+  }
+  return okflag;
+}
+
 /**
  * The private implementation of flush(), this assumes the _write_mutex is
  * already held.
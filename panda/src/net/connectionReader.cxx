@@ -14,6 +14,7 @@
 #include "connectionReader.h"
 #include "dcast.h"
 #include "connectionManager.h"
+#include "datagramBufferPool.h"
 #include "netDatagram.h"
 #include "datagramTCPHeader.h"
 #include "datagramUDPHeader.h"
@@ -26,9 +27,36 @@
 #include "pnotify.h"
 #include "atomicAdjust.h"
 #include "config_downloader.h"
+#include "pStatCollector.h"
+
+#ifdef HAVE_EPOLL
+#include <sys/epoll.h>
+#include <poll.h>
+#include <errno.h>
+#endif
 
 static const int read_buffer_size = maximum_udp_datagram + datagram_udp_header_size;
 
+#ifdef HAVE_EPOLL
+// The maximum number of events collected by a single call to epoll_wait().
+static const int max_epoll_events = 256;
+#endif
+
+#ifdef HAVE_MMSG
+#include <sys/socket.h>
+#include <errno.h>
+
+// The arguments to recvmmsg(), kept with each UDP socket.
+struct UDPBatch {
+  struct mmsghdr _msgs[max_udp_batch_size];
+  struct iovec _iov[max_udp_batch_size];
+  struct sockaddr_storage _addrs[max_udp_batch_size];
+  char _buffers[max_udp_batch_size][read_buffer_size];
+};
+
+static PStatCollector _udp_receive_batch_pcollector("Net:UDP receive batch");
+#endif  // HAVE_MMSG
+
 /**
  *
  */
@@ -38,6 +66,18 @@ SocketInfo(const PT(Connection) &connection) :
 {
   _busy = false;
   _error = false;
+  _registered = false;
+  _udp_batch = NULL;
+}
+
+/**
+ *
+ */
+ConnectionReader::SocketInfo::
+~SocketInfo() {
+#ifdef HAVE_MMSG
+  delete (UDPBatch *)_udp_batch;
+#endif
 }
 
 /**
@@ -102,6 +142,7 @@ ConnectionReader(ConnectionManager *manager, int num_threads,
 
   _raw_mode = false;
   _tcp_header_size = tcp_header_size;
+  _udp_batch_size = max(1, min((int)net_udp_batch_size, max_udp_batch_size));
   _polling = (num_threads <= 0);
 
   _shutdown = false;
@@ -111,6 +152,21 @@ ConnectionReader(ConnectionManager *manager, int num_threads,
 
   _currently_polling_thread = -1;
 
+  _epoll_fd = -1;
+  _epoll_events = NULL;
+#ifdef HAVE_EPOLL
+  if (net_use_epoll) {
+    _epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (_epoll_fd < 0) {
+      net_cat.warning()
+        << "Unable to create epoll instance, using select() instead: "
+        << strerror(errno) << "\n";
+    } else {
+      _epoll_events = PANDA_MALLOC_ARRAY(max_epoll_events * sizeof(struct epoll_event));
+    }
+  }
+#endif  // HAVE_EPOLL
+
   string reader_thread_name = thread_name;
   if (thread_name.empty()) {
     reader_thread_name = "ReaderThread";
@@ -156,6 +212,13 @@ ConnectionReader::
       sinfo->_connection.clear();
     }
   }
+
+#ifdef HAVE_EPOLL
+  if (_epoll_fd >= 0) {
+    close(_epoll_fd);
+    PANDA_FREE_ARRAY(_epoll_events);
+  }
+#endif
 }
 
 /**
@@ -185,7 +248,9 @@ add_connection(Connection *connection) {
     }
   }
 
-  _sockets.push_back(new SocketInfo(connection));
+  SocketInfo *sinfo = new SocketInfo(connection);
+  _sockets.push_back(sinfo);
+  register_socket(sinfo);
 
   return true;
 }
@@ -212,6 +277,7 @@ remove_connection(Connection *connection) {
     return false;
   }
 
+  unregister_socket(*si);
   _removed_sockets.push_back(*si);
   _sockets.erase(si);
 
@@ -384,6 +450,21 @@ flush_read_connection(Connection *connection) {
   // available on just this one socket; we can do this right here in this
   // thread, since we've already removed this connection from the reader.
 
+#ifdef HAVE_EPOLL
+  // We use poll() here, since the socket may be beyond the reach of select().
+  struct pollfd pfd;
+  pfd.fd = sinfo.get_socket()->GetSocket();
+  pfd.events = POLLIN;
+  int num_results = ::poll(&pfd, 1, 0);
+  while (num_results != 0) {
+    sinfo._busy = true;
+    if (!process_incoming_data(&sinfo)) {
+      break;
+    }
+    num_results = ::poll(&pfd, 1, 0);
+  }
+
+#else
   Socket_fdset fdset;
   fdset.clear();
   fdset.setForSocket(*(sinfo.get_socket()));
@@ -396,6 +477,7 @@ flush_read_connection(Connection *connection) {
     fdset.setForSocket(*(sinfo.get_socket()));
     num_results = fdset.WaitForRead(true, 0);
   }
+#endif  // HAVE_EPOLL
 }
 
 /**
@@ -419,6 +501,24 @@ finish_socket(SocketInfo *sinfo) {
 
   // By marking the SocketInfo nonbusy, we make it available for future polls.
   sinfo->_busy = false;
+
+  if (_epoll_fd >= 0) {
+    // With epoll, we also have to ask to hear about it again.
+    rearm_socket(sinfo);
+  }
+}
+
+/**
+ * Called by the UDP reading code when several datagrams have been read at
+ * once.  The default implementation simply passes each one to
+ * receive_datagram(); a subclass may override this to handle them more
+ * efficiently as a group.
+ */
+void ConnectionReader::
+receive_datagrams(const NetDatagram *datagrams, int num_datagrams) {
+  for (int i = 0; i < num_datagrams; ++i) {
+    receive_datagram(datagrams[i]);
+  }
 }
 
 /**
@@ -448,6 +548,12 @@ process_incoming_data(SocketInfo *sinfo) {
  */
 bool ConnectionReader::
 process_incoming_udp_data(SocketInfo *sinfo) {
+#ifdef HAVE_MMSG
+  if (_udp_batch_size > 1) {
+    return process_incoming_udp_batch(sinfo);
+  }
+#endif
+
   Socket_UDP *socket;
   DCAST_INTO_R(socket, sinfo->get_socket(), false);
   Socket_Address addr;
@@ -519,6 +625,109 @@ process_incoming_udp_data(SocketInfo *sinfo) {
   return true;
 }
 
+/**
+ * Reads as many datagrams as are waiting on the UDP socket, up to
+ * net-udp-batch-size, with a single call to recvmmsg(), and delivers them all
+ * to receive_datagrams().  This serves in place of both
+ * process_incoming_udp_data() and process_raw_incoming_udp_data().
+ */
+bool ConnectionReader::
+process_incoming_udp_batch(SocketInfo *sinfo) {
+#ifdef HAVE_MMSG
+  Socket_UDP *socket;
+  DCAST_INTO_R(socket, sinfo->get_socket(), false);
+
+  UDPBatch *batch = (UDPBatch *)sinfo->_udp_batch;
+  if (batch == (UDPBatch *)NULL) {
+    batch = new UDPBatch;
+    sinfo->_udp_batch = batch;
+  }
+
+  memset(batch->_msgs, 0, sizeof(struct mmsghdr) * _udp_batch_size);
+  for (int i = 0; i < _udp_batch_size; ++i) {
+    batch->_iov[i].iov_base = batch->_buffers[i];
+    batch->_iov[i].iov_len = read_buffer_size;
+    struct msghdr &hdr = batch->_msgs[i].msg_hdr;
+    hdr.msg_name = &batch->_addrs[i];
+    hdr.msg_namelen = sizeof(struct sockaddr_storage);
+    hdr.msg_iov = &batch->_iov[i];
+    hdr.msg_iovlen = 1;
+  }
+
+  // We don't wait for more datagrams than are already there.
+  int num_read;
+  do {
+    num_read = recvmmsg(socket->GetSocket(), batch->_msgs, _udp_batch_size,
+                        MSG_DONTWAIT, NULL);
+  } while (num_read < 0 && errno == EINTR);
+
+  if (num_read <= 0) {
+    // Either there was nothing to read after all, or the socket has failed.
+    finish_socket(sinfo);
+    return false;
+  }
+
+  _udp_receive_batch_pcollector.set_level(num_read);
+
+  // Copy the datagrams out of the buffers before we release the socket to
+  // the other threads.
+  pvector<NetDatagram> datagrams;
+  datagrams.reserve(num_read);
+
+  for (int i = 0; i < num_read; ++i) {
+    char *buffer = batch->_buffers[i];
+    int bytes_read = (int)batch->_msgs[i].msg_len;
+    Socket_Address addr(batch->_addrs[i]);
+
+    if (_raw_mode) {
+      datagrams.push_back(NetDatagram(buffer, bytes_read));
+
+    } else {
+      if (bytes_read < datagram_udp_header_size) {
+        net_cat.error()
+          << "Did not read entire header, discarding UDP datagram.\n";
+        continue;
+      }
+
+      DatagramUDPHeader header(buffer);
+      NetDatagram datagram(buffer + datagram_udp_header_size,
+                           bytes_read - datagram_udp_header_size);
+      if (!header.verify_datagram(datagram)) {
+        net_cat.error()
+          << "Ignoring invalid UDP datagram.\n";
+        continue;
+      }
+      datagrams.push_back(datagram);
+    }
+
+    NetDatagram &datagram = datagrams.back();
+    datagram.set_connection(sinfo->_connection);
+    datagram.set_address(NetAddress(addr));
+
+    if (net_cat.is_spam()) {
+      net_cat.spam()
+        << "Received UDP datagram with " << bytes_read
+        << " bytes on " << (void *)datagram.get_connection()
+        << " from " << datagram.get_address() << "\n";
+    }
+  }
+
+  finish_socket(sinfo);
+
+  if (_shutdown) {
+    return false;
+  }
+
+  if (!datagrams.empty()) {
+    receive_datagrams(&datagrams[0], (int)datagrams.size());
+  }
+  return true;
+
+#else
+  return false;
+#endif  // HAVE_MMSG
+}
+
 /**
  *
  */
@@ -573,6 +782,7 @@ process_incoming_tcp_data(SocketInfo *sinfo) {
 
   // We have to loop until the entire datagram is read.
   NetDatagram datagram;
+  datagram.set_array(DatagramBufferPool::get_buffer());
 
   while (!_shutdown && (int)datagram.get_length() < size) {
     int bytes_read;
@@ -657,6 +867,12 @@ process_incoming_tcp_data(SocketInfo *sinfo) {
  */
 bool ConnectionReader::
 process_raw_incoming_udp_data(SocketInfo *sinfo) {
+#ifdef HAVE_MMSG
+  if (_udp_batch_size > 1) {
+    return process_incoming_udp_batch(sinfo);
+  }
+#endif
+
   Socket_UDP *socket;
   DCAST_INTO_R(socket, sinfo->get_socket(), false);
   Socket_Address addr;
@@ -793,6 +1009,10 @@ thread_run(int thread_index) {
  */
 ConnectionReader::SocketInfo *ConnectionReader::
 get_next_available_socket(bool allow_block, int current_thread_index) {
+  if (_epoll_fd >= 0) {
+    return get_next_available_epoll_socket(allow_block, current_thread_index);
+  }
+
   // Go to sleep on the select() mutex.  This guarantees that only one thread
   // is in this function at a time.
   MutexHolder holder(_select_mutex);
@@ -893,8 +1113,18 @@ rebuild_select_list() {
 
   // This is also a fine time to delete the contents of the _removed_sockets
   // list.
+  delete_removed_sockets();
+}
+
+/**
+ * Deletes the SocketInfo objects on the _removed_sockets list that are no
+ * longer busy.  Assumes _sockets_mutex is held.
+ */
+void ConnectionReader::
+delete_removed_sockets() {
   if (!_removed_sockets.empty()) {
     Sockets still_busy_sockets;
+    Sockets::const_iterator si;
     for (si = _removed_sockets.begin(); si != _removed_sockets.end(); ++si) {
       SocketInfo *sinfo = (*si);
       if (sinfo->_busy) {
@@ -914,6 +1144,13 @@ rebuild_select_list() {
  */
 void ConnectionReader::
 accumulate_fdset(Socket_fdset &fdset) {
+  if (_epoll_fd >= 0) {
+    // The epoll instance itself becomes readable when any of its sockets
+    // have activity.
+    fdset.setForSocketNative(_epoll_fd);
+    return;
+  }
+
   LightMutexHolder holder(_sockets_mutex);
   Sockets::const_iterator si;
   for (si = _sockets.begin(); si != _sockets.end(); ++si) {
@@ -923,3 +1160,150 @@ accumulate_fdset(Socket_fdset &fdset) {
     }
   }
 }
+
+/**
+ * The epoll equivalent of get_next_available_socket().  Returns the next
+ * socket reported by the last call to epoll_wait(), or makes a new call if
+ * they have all been handed out.
+ */
+ConnectionReader::SocketInfo *ConnectionReader::
+get_next_available_epoll_socket(bool allow_block, int current_thread_index) {
+#ifdef HAVE_EPOLL
+  MutexHolder holder(_select_mutex);
+  struct epoll_event *events = (struct epoll_event *)_epoll_events;
+
+  do {
+    // First, hand out any results of the previous epoll_wait() call.
+    while (!_shutdown && _next_index < _num_results) {
+      SocketInfo *sinfo = (SocketInfo *)events[_next_index].data.ptr;
+      _next_index++;
+
+      LightMutexHolder sockets_holder(_sockets_mutex);
+      if (sinfo->_registered) {
+        // Some noise on this socket.  It won't be reported again until it is
+        // rearmed by finish_socket().
+        sinfo->_busy = true;
+        return sinfo;
+      }
+      // Otherwise, the socket was removed after the event was reported.
+    }
+
+    bool interrupted;
+    do {
+      interrupted = false;
+      AtomicAdjust::set(_currently_polling_thread, current_thread_index);
+
+      {
+        // None of the removed sockets can be referenced by _epoll_events any
+        // more, so we can delete the ones that aren't busy.
+        LightMutexHolder sockets_holder(_sockets_mutex);
+        delete_removed_sockets();
+      }
+
+      _num_results = 0;
+      _next_index = 0;
+
+      if (!_shutdown) {
+        int timeout = (int)(get_net_max_block() * 1000.0);
+        if (!allow_block) {
+          timeout = 0;
+        }
+#if defined(HAVE_THREADS) && defined(SIMPLE_THREADS)
+        timeout = 0;
+#endif
+        _num_results = epoll_wait(_epoll_fd, events, max_epoll_events, timeout);
+        if (_num_results < 0 && errno == EINTR) {
+          _num_results = 0;
+        }
+      }
+
+      if (_num_results == 0 && allow_block) {
+        // If we reached net_max_block, go back and reconsider.
+        interrupted = true;
+        Thread::force_yield();
+
+      } else if (_num_results < 0) {
+        net_cat.error()
+          << "epoll_wait failed: " << strerror(errno) << "\n";
+        _num_results = 0;
+        Thread::force_yield();
+        return (SocketInfo *)NULL;
+      }
+    } while (!_shutdown && interrupted);
+
+    AtomicAdjust::set(_currently_polling_thread, current_thread_index);
+  } while (!_shutdown && _num_results > 0);
+#endif  // HAVE_EPOLL
+
+  return (SocketInfo *)NULL;
+}
+
+/**
+ * Adds the indicated socket to the epoll instance, if there is one.  Assumes
+ * _sockets_mutex is held.
+ */
+void ConnectionReader::
+register_socket(SocketInfo *sinfo) {
+#ifdef HAVE_EPOLL
+  if (_epoll_fd < 0) {
+    return;
+  }
+
+  // The socket is registered one-shot, so that it is reported to only one
+  // thread at a time; finish_socket() rearms it once it has been read.
+  struct epoll_event event;
+  event.events = EPOLLIN | EPOLLET | EPOLLONESHOT;
+  event.data.ptr = sinfo;
+  if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, sinfo->get_socket()->GetSocket(),
+                &event) < 0) {
+    net_cat.error()
+      << "Unable to monitor socket: " << strerror(errno) << "\n";
+    return;
+  }
+  sinfo->_registered = true;
+#endif  // HAVE_EPOLL
+}
+
+/**
+ * Removes the indicated socket from the epoll instance, if it was added.
+ * Assumes _sockets_mutex is held.
+ */
+void ConnectionReader::
+unregister_socket(SocketInfo *sinfo) {
+#ifdef HAVE_EPOLL
+  if (!sinfo->_registered) {
+    return;
+  }
+  sinfo->_registered = false;
+
+  // This may fail if the socket has already been closed, which removes it
+  // from the epoll instance anyway.
+  struct epoll_event event;
+  epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, sinfo->get_socket()->GetSocket(), &event);
+#endif  // HAVE_EPOLL
+}
+
+/**
+ * Asks the epoll instance to report the indicated socket again, after it has
+ * been read.  If more data is already waiting, it is reported right away.
+ */
+void ConnectionReader::
+rearm_socket(SocketInfo *sinfo) {
+#ifdef HAVE_EPOLL
+  LightMutexHolder holder(_sockets_mutex);
+  if (!sinfo->_registered || sinfo->_error) {
+    return;
+  }
+
+  struct epoll_event event;
+  event.events = EPOLLIN | EPOLLET | EPOLLONESHOT;
+  event.data.ptr = sinfo;
+  if (epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, sinfo->get_socket()->GetSocket(),
+                &event) < 0) {
+    if (net_cat.is_debug()) {
+      net_cat.debug()
+        << "Unable to rearm socket: " << strerror(errno) << "\n";
+    }
+  }
+#endif  // HAVE_EPOLL
+}
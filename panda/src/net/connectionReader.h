@@ -26,6 +26,13 @@
 #include "socket_fdset.h"
 #include "atomicAdjust.h"
 
+// On Linux, the sockets are monitored with epoll instead of select(), which
+// can't handle more than FD_SETSIZE sockets and must rescan all of them on
+// every call.
+#if defined(__linux__) && !defined(CPPPARSER)
+#define HAVE_EPOLL 1
+#endif
+
 class NetDatagram;
 class ConnectionManager;
 class Socket_Address;
@@ -85,16 +92,27 @@ PUBLISHED:
 protected:
   virtual void flush_read_connection(Connection *connection);
   virtual void receive_datagram(const NetDatagram &datagram)=0;
+  virtual void receive_datagrams(const NetDatagram *datagrams,
+                                 int num_datagrams);
 
   class SocketInfo {
   public:
     SocketInfo(const PT(Connection) &connection);
+    ~SocketInfo();
     bool is_udp() const;
     Socket_IP *get_socket() const;
 
     PT(Connection) _connection;
     bool _busy;
     bool _error;
+
+    // True while the socket is registered with the epoll instance.  This is
+    // protected by _sockets_mutex.
+    bool _registered;
+
+    // The buffers for reading a batch of UDP datagrams at once, allocated the
+    // first time they are needed.  These may only be used while _busy.
+    void *_udp_batch;
   };
   typedef pvector<SocketInfo *> Sockets;
 
@@ -121,16 +139,25 @@ protected:
 
 private:
   void thread_run(int thread_index);
+  bool process_incoming_udp_batch(SocketInfo *sinfo);
 
   SocketInfo *get_next_available_socket(bool allow_block,
                                         int current_thread_index);
 
   void rebuild_select_list();
+  void delete_removed_sockets();
   void accumulate_fdset(Socket_fdset &fdset);
 
+  SocketInfo *get_next_available_epoll_socket(bool allow_block,
+                                              int current_thread_index);
+  void register_socket(SocketInfo *sinfo);
+  void unregister_socket(SocketInfo *sinfo);
+  void rearm_socket(SocketInfo *sinfo);
+
 private:
   bool _raw_mode;
   int _tcp_header_size;
+  int _udp_batch_size;
   bool _shutdown;
 
   class ReaderThread : public Thread {
@@ -153,6 +180,13 @@ private:
   Sockets _selecting_sockets;
   int _next_index;
   int _num_results;
+
+  // If this is not -1, the sockets are monitored by this epoll instance
+  // instead, and _fdset and _selecting_sockets are not used.  Each socket is
+  // registered as one-shot, and is rearmed by finish_socket(); the results
+  // of the last epoll_wait() are kept in _epoll_events.
+  int _epoll_fd;
+  void *_epoll_events;
   // Threads go to sleep on this mutex waiting for their chance to read a
   // socket.
   Mutex _select_mutex;
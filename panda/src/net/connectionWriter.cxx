@@ -155,7 +155,7 @@ send(const Datagram &datagram, const PT(Connection) &connection, bool block) {
       return connection->send_datagram(copy, _tcp_header_size);
     }
   } else {
-    return _queue.insert(copy, block);
+    return _queue.insert(MOVE(copy), block);
   }
 }
 
@@ -199,7 +199,7 @@ send(const Datagram &datagram, const PT(Connection) &connection,
       return connection->send_datagram(copy, _tcp_header_size);
     }
   } else {
-    return _queue.insert(copy, block);
+    return _queue.insert(MOVE(copy), block);
   }
 }
 
@@ -320,13 +320,43 @@ void ConnectionWriter::
 thread_run(int thread_index) {
   nassertv(!_immediate);
 
-  NetDatagram datagram;
-  while (_queue.extract(datagram)) {
-    if (_raw_mode) {
-      datagram.get_connection()->send_raw_datagram(datagram);
-    } else {
-      datagram.get_connection()->send_datagram(datagram, _tcp_header_size);
+  int batch_size = max(1, min((int)net_udp_batch_size, max_udp_batch_size));
+  if (batch_size <= 1) {
+    NetDatagram datagram;
+    while (_queue.extract(datagram)) {
+      if (_raw_mode) {
+        datagram.get_connection()->send_raw_datagram(datagram);
+      } else {
+        datagram.get_connection()->send_datagram(datagram, _tcp_header_size);
+      }
+      Thread::consider_yield();
+    }
+    return;
+  }
+
+  // Take everything that's waiting on the queue at once, so that runs of UDP
+  // datagrams on the same socket can be sent together.
+  pvector<NetDatagram> batch;
+  while (_queue.extract_batch(batch, batch_size)) {
+    size_t i = 0;
+    while (i < batch.size()) {
+      Connection *connection = batch[i].get_connection();
+      size_t end = i + 1;
+
+      if (connection->get_socket()->is_exact_type(Socket_UDP::get_class_type())) {
+        while (end < batch.size() && batch[end].get_connection() == connection) {
+          ++end;
+        }
+        connection->send_udp_datagrams(&batch[i], (int)(end - i), _raw_mode);
+
+      } else if (_raw_mode) {
+        connection->send_raw_datagram(batch[i]);
+      } else {
+        connection->send_datagram(batch[i], _tcp_header_size);
+      }
+      i = end;
     }
+    batch.clear();
     Thread::consider_yield();
   }
 }
@@ -0,0 +1,98 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file datagramBufferPool.cxx
+ * @date 2026-10-18
+ */
+
+#include "datagramBufferPool.h"
+#include "netDatagram.h"
+#include "config_net.h"
+
+AtomicAdjust::Pointer DatagramBufferPool::_pool = NULL;
+AtomicAdjust::Integer DatagramBufferPool::_num_reused = 0;
+AtomicAdjust::Integer DatagramBufferPool::_num_allocated = 0;
+
+/**
+ * Returns the number of arrays currently waiting in the pool.
+ */
+int DatagramBufferPool::
+get_num_pooled() {
+  return get_pool()->size();
+}
+
+/**
+ * Returns the number of times get_buffer() has returned an array from the
+ * pool.
+ */
+size_t DatagramBufferPool::
+get_num_reused() {
+  return (size_t)AtomicAdjust::get(_num_reused);
+}
+
+/**
+ * Returns the number of times get_buffer() has had to allocate a new array,
+ * because the pool was empty.
+ */
+size_t DatagramBufferPool::
+get_num_allocated() {
+  return (size_t)AtomicAdjust::get(_num_allocated);
+}
+
+/**
+ * Returns an empty array, from the pool if possible.  The array is not
+ * shared with anything else.
+ */
+PTA_uchar DatagramBufferPool::
+get_buffer() {
+  PTA_uchar buffer;
+  if (get_pool()->pop(buffer)) {
+    AtomicAdjust::inc(_num_reused);
+    return buffer;
+  }
+
+  // Charge the new array to NetDatagram, so that MemoryUsage can tell these
+  // apart from the arrays of other datagrams.
+  AtomicAdjust::inc(_num_allocated);
+  return PTA_uchar::empty_array(0, NetDatagram::get_class_type());
+}
+
+/**
+ * Gives the array back to the pool, if nothing else is sharing it and it
+ * isn't too large.  In any case, the buffer is cleared on return.
+ */
+void DatagramBufferPool::
+release_buffer(PTA_uchar &buffer) {
+  if (buffer.is_null() || buffer.get_ref_count() != 1 ||
+      buffer.v().capacity() > (size_t)net_datagram_pool_max_buffer) {
+    buffer.clear();
+    return;
+  }
+
+  buffer.v().clear();
+  get_pool()->push(MOVE(buffer), net_datagram_pool_size);
+  buffer.clear();
+}
+
+/**
+ * Returns the pool, creating it the first time.
+ */
+AtomicQueue<PTA_uchar> *DatagramBufferPool::
+get_pool() {
+  AtomicQueue<PTA_uchar> *pool = (AtomicQueue<PTA_uchar> *)AtomicAdjust::get_ptr(_pool);
+  if (pool == (AtomicQueue<PTA_uchar> *)NULL) {
+    AtomicQueue<PTA_uchar> *new_pool = new AtomicQueue<PTA_uchar>;
+    pool = (AtomicQueue<PTA_uchar> *)AtomicAdjust::compare_and_exchange_ptr(_pool, NULL, new_pool);
+    if (pool != (AtomicQueue<PTA_uchar> *)NULL) {
+      delete new_pool;
+    } else {
+      pool = new_pool;
+    }
+  }
+  return pool;
+}
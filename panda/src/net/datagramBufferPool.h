@@ -0,0 +1,49 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file datagramBufferPool.h
+ * @date 2026-10-18
+ */
+
+#ifndef DATAGRAMBUFFERPOOL_H
+#define DATAGRAMBUFFERPOOL_H
+
+#include "pandabase.h"
+#include "pta_uchar.h"
+#include "atomicQueue.h"
+#include "atomicAdjust.h"
+
+/**
+ * A global pool of the arrays that hold the data of NetDatagrams.  Received
+ * datagrams take their arrays from here, and a NetDatagram gives its array
+ * back when it is destructed or cleared, as long as nothing else is still
+ * sharing the array.  This way, a steady stream of network traffic doesn't
+ * need to allocate memory for each datagram.
+ *
+ * The pool holds at most net-datagram-pool-size arrays, and doesn't keep
+ * arrays that have grown larger than net-datagram-pool-max-buffer bytes.
+ */
+class EXPCL_PANDA_NET DatagramBufferPool {
+PUBLISHED:
+  static int get_num_pooled();
+  static size_t get_num_reused();
+  static size_t get_num_allocated();
+
+public:
+  static PTA_uchar get_buffer();
+  static void release_buffer(PTA_uchar &buffer);
+
+private:
+  static AtomicQueue<PTA_uchar> *get_pool();
+
+  static AtomicAdjust::Pointer _pool;
+  static AtomicAdjust::Integer _num_reused;
+  static AtomicAdjust::Integer _num_allocated;
+};
+
+#endif
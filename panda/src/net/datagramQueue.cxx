@@ -25,6 +25,7 @@ DatagramQueue() :
 {
   _shutdown = false;
   _max_queue_size = get_net_max_write_queue();
+  _num_waiting = 0;
 }
 
 /**
@@ -49,7 +50,7 @@ shutdown() {
   // thread blocking on extract() to return false.
   MutexHolder holder(_cvlock);
 
-  _shutdown = true;
+  AtomicAdjust::set(_shutdown, true);
   _cv.notify_all();
 }
 
@@ -64,24 +65,57 @@ shutdown() {
  */
 bool DatagramQueue::
 insert(const NetDatagram &data, bool block) {
-  MutexHolder holder(_cvlock);
-
-  bool enqueue_ok = ((int)_queue.size() < _max_queue_size);
-  if (block) {
-    while (!enqueue_ok && !_shutdown) {
+  bool enqueue_ok = _queue.push(data, (int)AtomicAdjust::get(_max_queue_size));
+
+  if (!enqueue_ok && block) {
+    MutexHolder holder(_cvlock);
+    AtomicAdjust::inc(_num_waiting);
+    while (!AtomicAdjust::get(_shutdown)) {
+      enqueue_ok = _queue.push(data, (int)AtomicAdjust::get(_max_queue_size));
+      if (enqueue_ok) {
+        break;
+      }
       _cv.wait();
-      enqueue_ok = ((int)_queue.size() < _max_queue_size);
     }
+    AtomicAdjust::dec(_num_waiting);
   }
 
   if (enqueue_ok) {
-    _queue.push_back(data);
+    wake_waiters();
   }
-  _cv.notify();  // Only need to wake up one thread.
 
   return enqueue_ok;
 }
 
+#ifdef USE_MOVE_SEMANTICS
+/**
+ * Like the above, but moves the datagram onto the queue rather than copying
+ * it.  If the datagram could not be queued, it is left unchanged.
+ */
+bool DatagramQueue::
+insert(NetDatagram &&data, bool block) {
+  bool enqueue_ok = _queue.push(move(data), (int)AtomicAdjust::get(_max_queue_size));
+
+  if (!enqueue_ok && block) {
+    MutexHolder holder(_cvlock);
+    AtomicAdjust::inc(_num_waiting);
+    while (!AtomicAdjust::get(_shutdown)) {
+      enqueue_ok = _queue.push(move(data), (int)AtomicAdjust::get(_max_queue_size));
+      if (enqueue_ok) {
+        break;
+      }
+      _cv.wait();
+    }
+    AtomicAdjust::dec(_num_waiting);
+  }
+
+  if (enqueue_ok) {
+    wake_waiters();
+  }
+
+  return enqueue_ok;
+}
+#endif  // USE_MOVE_SEMANTICS
 
 /**
  * Extracts a datagram from the head of the queue, if one is available.  If a
@@ -101,22 +135,51 @@ extract(NetDatagram &result) {
   // connection pointer--we're about to go to sleep for a while.
   result.clear();
 
-  MutexHolder holder(_cvlock);
+  if (AtomicAdjust::get(_shutdown)) {
+    return false;
+  }
 
-  while (_queue.empty() && !_shutdown) {
-    _cv.wait();
+  if (!_queue.pop(result)) {
+    MutexHolder holder(_cvlock);
+    AtomicAdjust::inc(_num_waiting);
+    while (!AtomicAdjust::get(_shutdown) && !_queue.pop(result)) {
+      _cv.wait();
+    }
+    AtomicAdjust::dec(_num_waiting);
+
+    if (AtomicAdjust::get(_shutdown)) {
+      return false;
+    }
   }
 
-  if (_shutdown) {
+  // Wake up any threads waiting to stuff things into the queue.
+  wake_waiters();
+
+  return true;
+}
+
+/**
+ * Like extract(), but fills result with as many datagrams as are available,
+ * up to max_count, rather than just one.  This still blocks until at least
+ * one datagram is available.
+ */
+bool DatagramQueue::
+extract_batch(pvector<NetDatagram> &result, size_t max_count) {
+  result.clear();
+
+  NetDatagram datagram;
+  if (!extract(datagram)) {
     return false;
   }
+  result.push_back(datagram);
 
-  nassertr(!_queue.empty(), false);
-  result = _queue.front();
-  _queue.pop_front();
+  while (result.size() < max_count && _queue.pop(datagram)) {
+    result.push_back(datagram);
+  }
 
-  // Wake up any threads waiting to stuff things into the queue.
-  _cv.notify_all();
+  if (result.size() > 1) {
+    wake_waiters();
+  }
 
   return true;
 }
@@ -128,11 +191,16 @@ extract(NetDatagram &result) {
  *
  * It's also a crude check against unfortunate seg faults due to the queue
  * filling up and quietly consuming all available memory.
+ *
+ * The queue's storage is allocated when the first datagram is inserted, so
+ * after that point the queue can't be grown beyond the size it had then.
  */
 void DatagramQueue::
 set_max_queue_size(int max_size) {
-  MutexHolder holder(_cvlock);
-  _max_queue_size = max_size;
+  AtomicAdjust::set(_max_queue_size, max_size);
+
+  // Threads waiting for room may now have some.
+  wake_waiters();
 }
 
 /**
@@ -141,7 +209,7 @@ set_max_queue_size(int max_size) {
  */
 int DatagramQueue::
 get_max_queue_size() const {
-  return _max_queue_size;
+  return (int)AtomicAdjust::get(_max_queue_size);
 }
 
 /**
@@ -149,7 +217,18 @@ get_max_queue_size() const {
  */
 int DatagramQueue::
 get_current_queue_size() const {
-  MutexHolder holder(_cvlock);
-  int size = _queue.size();
-  return size;
+  return _queue.size();
+}
+
+/**
+ * Wakes up any threads that are waiting on the queue, after a datagram has
+ * been inserted or extracted.  The lock is only taken when there is in fact
+ * somebody waiting.
+ */
+void DatagramQueue::
+wake_waiters() {
+  if (AtomicAdjust::get(_num_waiting) != 0) {
+    MutexHolder holder(_cvlock);
+    _cv.notify_all();
+  }
 }
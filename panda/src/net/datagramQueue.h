@@ -17,14 +17,20 @@
 #include "pandabase.h"
 
 #include "netDatagram.h"
+#include "atomicQueue.h"
+#include "atomicAdjust.h"
 #include "pmutex.h"
 #include "conditionVarFull.h"
-#include "pdeque.h"
+#include "pvector.h"
 
 /**
  * A thread-safe, FIFO queue of NetDatagrams.  This is used by
  * ConnectionWriter for queuing up datagrams for its various threads to write
  * to sockets.
+ *
+ * Inserting and extracting datagrams doesn't take a lock; the mutex is only
+ * used by threads that have to wait, for a datagram or for space in the
+ * queue.
  */
 class EXPCL_PANDA_NET DatagramQueue {
 public:
@@ -33,20 +39,28 @@ public:
   void shutdown();
 
   bool insert(const NetDatagram &data, bool block = false);
+#ifdef USE_MOVE_SEMANTICS
+  bool insert(NetDatagram &&data, bool block = false);
+#endif
   bool extract(NetDatagram &result);
+  bool extract_batch(pvector<NetDatagram> &result, size_t max_count);
 
   void set_max_queue_size(int max_size);
   int get_max_queue_size() const;
   int get_current_queue_size() const;
 
 private:
+  void wake_waiters();
+
+  AtomicQueue<NetDatagram> _queue;
+  AtomicAdjust::Integer _max_queue_size;
+  AtomicAdjust::Integer _shutdown;
+
+  // The number of threads that are waiting on _cv, either for a datagram or
+  // for room to insert one.
+  AtomicAdjust::Integer _num_waiting;
   Mutex _cvlock;
   ConditionVarFull _cv;  // signaled when queue contents change.
-
-  typedef pdeque<NetDatagram> QueueType;
-  QueueType _queue;
-  bool _shutdown;
-  int _max_queue_size;
 };
 
 #endif
@@ -44,9 +44,10 @@ public:
 
 private:
   // The actual data for the header is stored (somewhat recursively) in its
-  // own NetDatagram object.  This is just for convenience of packing and
-  // unpacking the header.
-  NetDatagram _header;
+  // own Datagram object.  This is just for convenience of packing and
+  // unpacking the header.  The header is small enough that the Datagram
+  // stores it without allocating memory.
+  Datagram _header;
 };
 
 #include "datagramTCPHeader.I"
@@ -24,10 +24,11 @@
  */
 DatagramUDPHeader::
 DatagramUDPHeader(const NetDatagram &datagram) {
-  const string &str = datagram.get_message();
+  const uint8_t *data = (const uint8_t *)datagram.get_data();
+  size_t length = datagram.get_length();
   uint16_t checksum = 0;
-  for (size_t p = 0; p < str.size(); p++) {
-    checksum += (uint16_t)(uint8_t)str[p];
+  for (size_t p = 0; p < length; p++) {
+    checksum += (uint16_t)data[p];
   }
 
   // Now pack the header.
@@ -49,11 +50,12 @@ DatagramUDPHeader(const void *data) : _header(data, datagram_udp_header_size) {
  */
 bool DatagramUDPHeader::
 verify_datagram(const NetDatagram &datagram) const {
-  const string &str = datagram.get_message();
+  const uint8_t *data = (const uint8_t *)datagram.get_data();
+  size_t length = datagram.get_length();
 
   uint16_t checksum = 0;
-  for (size_t p = 0; p < str.size(); p++) {
-    checksum += (uint16_t)(uint8_t)str[p];
+  for (size_t p = 0; p < length; p++) {
+    checksum += (uint16_t)data[p];
   }
 
   if (checksum == get_datagram_checksum()) {
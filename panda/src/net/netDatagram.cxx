@@ -12,6 +12,7 @@
  */
 
 #include "netDatagram.h"
+#include "datagramBufferPool.h"
 
 TypeHandle NetDatagram::_type_handle;
 
@@ -26,8 +27,9 @@ NetDatagram() {
  * Constructs a datagram from an existing block of data.
  */
 NetDatagram::
-NetDatagram(const void *data, size_t size) :
-  Datagram(data, size) {
+NetDatagram(const void *data, size_t size) {
+  set_array(DatagramBufferPool::get_buffer());
+  append_data(data, size);
 }
 
 /**
@@ -55,6 +57,9 @@ NetDatagram(const NetDatagram &copy) :
  */
 void NetDatagram::
 operator = (const Datagram &copy) {
+  if (&copy != this) {
+    release_array();
+  }
   Datagram::operator = (copy);
   _connection.clear();
   _address.clear();
@@ -65,18 +70,30 @@ operator = (const Datagram &copy) {
  */
 void NetDatagram::
 operator = (const NetDatagram &copy) {
+  if (&copy != this) {
+    release_array();
+  }
   Datagram::operator = (copy);
   _connection = copy._connection;
   _address = copy._address;
 }
 
+/**
+ * Returns the data array to the DatagramBufferPool, if nothing else is using
+ * it.
+ */
+NetDatagram::
+~NetDatagram() {
+  release_array();
+}
+
 /**
  * Resets the datagram to empty, in preparation for building up a new
  * datagram.
  */
 void NetDatagram::
 clear() {
-  Datagram::clear();
+  release_array();
   _connection.clear();
   _address.clear();
 }
@@ -114,3 +131,19 @@ const NetAddress &NetDatagram::
 get_address() const {
   return _address;
 }
+
+/**
+ * Empties the datagram, giving its data array back to the DatagramBufferPool
+ * if this was the last reference to it.
+ */
+void NetDatagram::
+release_array() {
+  if (!has_array()) {
+    // The data, if any, is stored within the datagram itself.
+    Datagram::clear();
+    return;
+  }
+  PTA_uchar data = modify_array();
+  Datagram::clear();
+  DatagramBufferPool::release_buffer(data);
+}
@@ -46,6 +46,13 @@ PUBLISHED:
   void operator = (const Datagram &copy);
   void operator = (const NetDatagram &copy);
 
+#ifdef USE_MOVE_SEMANTICS
+  INLINE NetDatagram(NetDatagram &&from) NOEXCEPT;
+  INLINE void operator = (NetDatagram &&from) NOEXCEPT;
+#endif
+
+  virtual ~NetDatagram();
+
   virtual void clear();
 
   void set_connection(const PT(Connection) &connection);
@@ -62,6 +69,8 @@ public:
   INLINE bool operator < (const NetDatagram &other) const;
 
 private:
+  void release_array();
+
   PT(Connection) _connection;
   NetAddress _address;
 
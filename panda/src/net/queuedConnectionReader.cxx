@@ -111,6 +111,26 @@ receive_datagram(const NetDatagram &datagram) {
 }
 
 
+/**
+ * An internal function called by ConnectionReader() when several datagrams
+ * have been read at once.  They are added to the queue together.
+ */
+void QueuedConnectionReader::
+receive_datagrams(const NetDatagram *datagrams, int num_datagrams) {
+#ifdef SIMULATE_NETWORK_DELAY
+  for (int i = 0; i < num_datagrams; ++i) {
+    delay_datagram(datagrams[i]);
+  }
+
+#else  // SIMULATE_NETWORK_DELAY
+  if (enqueue_things(datagrams, num_datagrams) != num_datagrams) {
+    net_cat.error()
+      << "QueuedConnectionReader queue full!\n";
+  }
+#endif  // SIMULATE_NETWORK_DELAY
+}
+
+
 #ifdef SIMULATE_NETWORK_DELAY
 /**
  * Enables a simulated network latency.  All packets received from this point
@@ -20,7 +20,9 @@
 #include "connection.h"
 #include "netAddress.h"
 #include "lightMutex.h"
-#include "pdeque.h"
+#include "pvector.h"
+#include "atomicQueue.h"
+#include "atomicAdjust.h"
 #include "config_net.h"
 #include "lightMutexHolder.h"
 
@@ -49,14 +51,20 @@ protected:
   bool get_thing(Thing &thing);
 
   bool enqueue_thing(const Thing &thing);
+  int enqueue_things(const Thing *things, int num_things);
   bool enqueue_unique_thing(const Thing &thing);
 
 private:
+  AtomicQueue<Thing> _things;
+  AtomicAdjust::Integer _max_queue_size;
+  AtomicAdjust::Integer _overflow_flag;
+
+  // The things on the queue that were added by enqueue_unique_thing().  This
+  // is protected by _mutex, which is only needed by that method, and by
+  // get_thing() when _num_unique is nonzero.
   LightMutex _mutex;
-  pdeque<Thing> _things;
-  bool _available;
-  int _max_queue_size;
-  bool _overflow_flag;
+  pvector<Thing> _unique_things;
+  AtomicAdjust::Integer _num_unique;
 };
 
 #include "queuedReturn.I"
@@ -0,0 +1,318 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_datagram_alloc.cxx
+ * @date 2026-10-19
+ */
+
+#include "pandabase.h"
+#include "memoryHook.h"
+#include "atomicAdjust.h"
+#include "netDatagram.h"
+#include "datagramIterator.h"
+#include "datagramUDPHeader.h"
+#include "queuedConnectionManager.h"
+#include "queuedConnectionListener.h"
+#include "queuedConnectionReader.h"
+#include "connectionWriter.h"
+#include "connection.h"
+#include "datagramInputFile.h"
+#include "datagramOutputFile.h"
+
+#include <stdlib.h>
+
+// Counts the heap allocations made by some common operations on Datagrams:
+// building and reading a small field update, building a larger datagram,
+// verifying a UDP checksum, sending and receiving over a TCP connection to
+// ourselves, and reading small datagrams from a BAM-style stream.
+//
+// Allocations are counted both through the MemoryHook, which Panda's own
+// objects and pvectors use, and through the global operator new, which the
+// standard library uses.  Only the public interfaces that Datagram has
+// always had are used, so that this may be built against an older tree to
+// compare.
+//
+// With 100000 operations on Linux, before and after Datagram began keeping
+// up to 40 bytes inline:
+//
+//   field update, 14 bytes in 6 appends   3 -> 0
+//   200-byte datagram in 4-byte appends   7 -> 3
+//   UDP checksum verify, 100 bytes        3 -> 0
+//   TCP send of the field update          1 -> 0
+//   TCP receive of the field update       2 -> 0
+//   BAM read of a 30-byte object          1 -> 0
+
+static int num_ops = 10000;
+static int port = 5920;
+
+static AtomicAdjust::Integer num_allocs = 0;
+
+/**
+ * A MemoryHook that counts each allocation, and otherwise does whatever the
+ * hook it replaces did.
+ */
+class CountingHook : public MemoryHook {
+public:
+  CountingHook(const MemoryHook &copy) : MemoryHook(copy) {}
+
+  virtual void *heap_alloc_single(size_t size) {
+    AtomicAdjust::inc(num_allocs);
+    return MemoryHook::heap_alloc_single(size);
+  }
+  virtual void *heap_alloc_array(size_t size) {
+    AtomicAdjust::inc(num_allocs);
+    return MemoryHook::heap_alloc_array(size);
+  }
+  virtual void *heap_realloc_array(void *ptr, size_t size) {
+    AtomicAdjust::inc(num_allocs);
+    return MemoryHook::heap_realloc_array(ptr, size);
+  }
+};
+
+/**
+ * Counts the allocations made by the standard library.
+ */
+void *
+operator new(size_t size) {
+  AtomicAdjust::inc(num_allocs);
+  void *ptr = malloc(size > 0 ? size : 1);
+  if (ptr == NULL) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+/**
+ * The counterpart to the above.
+ */
+void
+operator delete(void *ptr) NOEXCEPT {
+  free(ptr);
+}
+
+/**
+ * Reports the average number of allocations made by one operation, given the
+ * value of num_allocs before and after num_ops of them.
+ */
+static void
+report(const char *name, AtomicAdjust::Integer before,
+       AtomicAdjust::Integer after) {
+  double per_op = (double)(after - before) / (double)num_ops;
+  nout << "  " << name << ": " << per_op << "\n";
+}
+
+/**
+ * Builds a 14-byte field update in 6 appends, reads it back, and throws it
+ * away.
+ */
+static void
+field_update(unsigned int i) {
+  Datagram dg;
+  dg.add_uint16(24);
+  dg.add_uint32(100000000 + i);
+  dg.add_uint16(107);
+  dg.add_uint8(1);
+  dg.add_int16(-5);
+  dg.add_uint8(i & 0xff);
+
+  DatagramIterator dgi(dg);
+  dgi.get_uint16();
+  dgi.get_uint32();
+  dgi.get_uint16();
+  dgi.get_uint8();
+  dgi.get_int16();
+  dgi.get_uint8();
+}
+
+/**
+ * Builds a 200-byte datagram in 4-byte appends.
+ */
+static void
+large_datagram(unsigned int i) {
+  Datagram dg;
+  for (int j = 0; j < 50; ++j) {
+    dg.add_uint32(i + j);
+  }
+}
+
+/**
+ * Computes the checksum of a 100-byte datagram and verifies it, as is done
+ * for every datagram sent and received over UDP.
+ */
+static void
+udp_checksum(const NetDatagram &dg) {
+  DatagramUDPHeader header(dg);
+  if (!header.verify_datagram(dg)) {
+    nout << "Checksum failed\n";
+    exit(1);
+  }
+}
+
+/**
+ * Opens a TCP connection from this process to itself, and returns both ends
+ * of it, or exits if that can't be done.
+ */
+static void
+open_loopback(ConnectionManager &cm, PT(Connection) &client,
+              PT(Connection) &server) {
+  PT(Connection) rendezvous;
+  for (int tries = 0; tries < 20 && rendezvous == NULL; ++tries) {
+    rendezvous = cm.open_TCP_server_rendezvous(port, 5);
+    if (rendezvous == NULL) {
+      ++port;
+    }
+  }
+  if (rendezvous == NULL) {
+    nout << "Unable to listen for TCP connections.\n";
+    exit(1);
+  }
+
+  QueuedConnectionListener listener(&cm, 0);
+  listener.add_connection(rendezvous);
+
+  client = cm.open_TCP_client_connection("localhost", port, 5000);
+  if (client == NULL) {
+    nout << "Unable to connect to port " << port << ".\n";
+    exit(1);
+  }
+  while (!listener.new_connection_available()) {
+    Thread::force_yield();
+  }
+  listener.get_new_connection(server);
+  cm.close_connection(rendezvous);
+}
+
+int
+main(int argc, char *argv[]) {
+  if (argc > 1) {
+    num_ops = max(atoi(argv[1]), 1);
+  }
+  if (argc > 2) {
+    port = atoi(argv[2]);
+  }
+  if (argc > 3) {
+    nout << "test_datagram_alloc [ops [port]]\n";
+    exit(1);
+  }
+
+  init_memory_hook();
+  memory_hook = new CountingHook(*memory_hook);
+
+  NetDatagram update;
+  update.add_uint16(24);
+  update.add_uint32(100000000);
+  update.add_uint16(107);
+  update.add_uint8(1);
+  update.add_int16(-5);
+  update.add_uint8(0);
+
+  NetDatagram checked;
+  for (int j = 0; j < 25; ++j) {
+    checked.add_uint32(j);
+  }
+
+  QueuedConnectionManager cm;
+  PT(Connection) client, server;
+  open_loopback(cm, client, server);
+  QueuedConnectionReader reader(&cm, 0);
+  reader.add_connection(server);
+  ConnectionWriter writer(&cm, 0);
+
+  // Write a stream of 30-byte datagrams, each holding one small object, as
+  // a BamWriter would.
+  ostringstream bam_out;
+  {
+    DatagramOutputFile dout;
+    dout.open(bam_out);
+    Datagram object;
+    object.add_uint16(12);
+    object.add_int32(7);
+    object.add_string("twenty-byte string!!");
+    object.add_uint16(0);
+    for (int i = 0; i < num_ops * 2; ++i) {
+      dout.put_datagram(object);
+    }
+  }
+  istringstream bam_in(bam_out.str());
+  DatagramInputFile din;
+  din.open(bam_in);
+
+  // Run each operation once first, so that we don't count the allocations
+  // made only the first time, such as filling a DeletedChain.
+  field_update(0);
+  large_datagram(0);
+  udp_checksum(checked);
+
+  nout << "Heap allocations per operation, over " << num_ops << ":\n";
+
+  AtomicAdjust::Integer before = AtomicAdjust::get(num_allocs);
+  for (int i = 0; i < num_ops; ++i) {
+    field_update((unsigned int)i);
+  }
+  report("field update, 14 bytes in 6 appends", before,
+         AtomicAdjust::get(num_allocs));
+
+  before = AtomicAdjust::get(num_allocs);
+  for (int i = 0; i < num_ops; ++i) {
+    large_datagram((unsigned int)i);
+  }
+  report("200-byte datagram in 4-byte appends", before,
+         AtomicAdjust::get(num_allocs));
+
+  before = AtomicAdjust::get(num_allocs);
+  for (int i = 0; i < num_ops; ++i) {
+    udp_checksum(checked);
+  }
+  report("UDP checksum verify, 100 bytes", before,
+         AtomicAdjust::get(num_allocs));
+
+  // Send and receive the field update over TCP.  The counts are kept apart
+  // by reading the counter between the two halves.
+  AtomicAdjust::Integer send_allocs = 0;
+  AtomicAdjust::Integer receive_allocs = 0;
+  NetDatagram received;
+  for (int i = -1; i < num_ops; ++i) {
+    before = AtomicAdjust::get(num_allocs);
+    if (!writer.send(update, client)) {
+      nout << "Send failed\n";
+      exit(1);
+    }
+    AtomicAdjust::Integer middle = AtomicAdjust::get(num_allocs);
+    while (!reader.data_available()) {
+      Thread::force_yield();
+    }
+    reader.get_data(received);
+    AtomicAdjust::Integer after = AtomicAdjust::get(num_allocs);
+    if (i >= 0) {
+      send_allocs += middle - before;
+      receive_allocs += after - middle;
+    }
+  }
+  report("TCP send of the field update", 0, send_allocs);
+  report("TCP receive of the field update", 0, receive_allocs);
+
+  // This skips the first datagram, for the same reason as above.
+  {
+    Datagram dg;
+    din.get_datagram(dg);
+  }
+  before = AtomicAdjust::get(num_allocs);
+  for (int i = 0; i < num_ops; ++i) {
+    Datagram dg;
+    if (!din.get_datagram(dg)) {
+      nout << "Read failed\n";
+      exit(1);
+    }
+  }
+  report("BAM read of a 30-byte object", before,
+         AtomicAdjust::get(num_allocs));
+
+  cm.close_connection(client);
+  cm.close_connection(server);
+  return 0;
+}
@@ -0,0 +1,102 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_datagram_queue.cxx
+ * @date 2026-10-18
+ */
+
+#include "pandabase.h"
+#include "datagramQueue.h"
+#include "netDatagram.h"
+#include "thread.h"
+#include "trueClock.h"
+#include "pvector.h"
+
+// Measures the throughput of DatagramQueue with a single consumer thread (as
+// in a ConnectionWriter with one thread) and an increasing number of producer
+// threads, each of which inserts the same number of datagrams.
+
+static const int datagrams_per_producer = 200000;
+
+class ProducerThread : public Thread {
+public:
+  ProducerThread(DatagramQueue *queue, int index) :
+    Thread("producer", "producer"),
+    _queue(queue),
+    _index(index) { }
+
+  virtual void thread_main() {
+    NetDatagram datagram;
+    datagram.add_uint32(_index);
+    for (int i = 0; i < datagrams_per_producer; ++i) {
+      _queue->insert(datagram, true);
+    }
+  }
+
+  DatagramQueue *_queue;
+  int _index;
+};
+
+class ConsumerThread : public Thread {
+public:
+  ConsumerThread(DatagramQueue *queue, int expected) :
+    Thread("consumer", "consumer"),
+    _queue(queue),
+    _expected(expected) { }
+
+  virtual void thread_main() {
+    NetDatagram datagram;
+    int count = 0;
+    while (count < _expected && _queue->extract(datagram)) {
+      ++count;
+    }
+  }
+
+  DatagramQueue *_queue;
+  int _expected;
+};
+
+int
+main(int argc, char *argv[]) {
+  TrueClock *clock = TrueClock::get_global_ptr();
+
+  static const int producer_counts[] = { 1, 2, 4, 8, 16 };
+  for (int pi = 0; pi < 5; ++pi) {
+    int num_producers = producer_counts[pi];
+    int total = num_producers * datagrams_per_producer;
+
+    DatagramQueue queue;
+    queue.set_max_queue_size(4096);
+
+    double start = clock->get_short_time();
+
+    PT(ConsumerThread) consumer = new ConsumerThread(&queue, total);
+    consumer->start(TP_normal, true);
+
+    pvector< PT(ProducerThread) > producers;
+    for (int i = 0; i < num_producers; ++i) {
+      PT(ProducerThread) producer = new ProducerThread(&queue, i);
+      producer->start(TP_normal, true);
+      producers.push_back(producer);
+    }
+
+    for (int i = 0; i < num_producers; ++i) {
+      producers[i]->join();
+    }
+    consumer->join();
+
+    double elapsed = clock->get_short_time() - start;
+    queue.shutdown();
+
+    nout << num_producers << " producers: " << total << " datagrams in "
+         << elapsed << " s, " << total / elapsed / 1000000.0
+         << " million per second\n";
+  }
+
+  return 0;
+}
@@ -0,0 +1,150 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_spam_load.cxx
+ * @date 2026-10-18
+ */
+
+#include "queuedConnectionManager.h"
+#include "queuedConnectionReader.h"
+#include "connectionWriter.h"
+#include "netAddress.h"
+#include "connection.h"
+#include "netDatagram.h"
+#include "datagramIterator.h"
+#include "trueClock.h"
+#include "thread.h"
+#include "pvector.h"
+
+#include <algorithm>
+
+// A load test for test_spam_server, which should be started in echo mode.
+// Opens many client connections at once, and keeps one datagram in flight on
+// each of them, reporting the round-trip throughput and latency.  Run it with
+// net-use-epoll set true and false to compare the two ConnectionReader
+// backends; the server's own setting matters the most.
+
+int
+main(int argc, char *argv[]) {
+  if (argc < 3 || argc > 5) {
+    nout << "test_spam_load host port [num_clients [seconds]]\n";
+    exit(1);
+  }
+
+  string hostname = argv[1];
+  int port = atoi(argv[2]);
+  int num_clients = (argc > 3) ? atoi(argv[3]) : 1000;
+  double duration = (argc > 4) ? atof(argv[4]) : 10.0;
+
+  NetAddress host;
+  if (!host.set_host(hostname, port)) {
+    nout << "Unknown host: " << hostname << "\n";
+    exit(1);
+  }
+
+  QueuedConnectionManager cm;
+  QueuedConnectionReader reader(&cm, 0);
+  ConnectionWriter writer(&cm, 0);
+
+  pvector< PT(Connection) > clients;
+  clients.reserve(num_clients);
+  for (int i = 0; i < num_clients; ++i) {
+    PT(Connection) c = cm.open_TCP_client_connection(host, 5000);
+    if (c.is_null()) {
+      nout << "Could only open " << i << " connections.\n";
+      break;
+    }
+    reader.add_connection(c);
+    clients.push_back(c);
+  }
+
+  if (clients.empty()) {
+    nout << "No connection.\n";
+    exit(1);
+  }
+
+  nout << "Opened " << clients.size() << " connections to " << hostname
+       << " on port " << port << "\n";
+
+  TrueClock *clock = TrueClock::get_global_ptr();
+
+  // Each datagram carries the index of its client and the time at which it
+  // was sent, so we can measure the latency when it comes back.
+  double start = clock->get_short_time();
+  for (size_t i = 0; i < clients.size(); ++i) {
+    NetDatagram datagram;
+    datagram.add_uint32((uint32_t)i);
+    datagram.add_float64(clock->get_short_time());
+    writer.send(datagram, clients[i]);
+  }
+
+  pvector<double> latencies;
+  int num_lost = 0;
+  double end = start + duration;
+  double now = start;
+
+  while (now < end && num_lost < (int)clients.size()) {
+    reader.poll();
+
+    while (cm.reset_connection_available()) {
+      PT(Connection) connection;
+      if (cm.get_reset_connection(connection)) {
+        cm.close_connection(connection);
+        num_lost++;
+      }
+    }
+
+    bool any = false;
+    while (reader.data_available()) {
+      NetDatagram datagram;
+      if (reader.get_data(datagram)) {
+        any = true;
+        DatagramIterator di(datagram);
+        uint32_t i = di.get_uint32();
+        double sent = di.get_float64();
+
+        now = clock->get_short_time();
+        latencies.push_back(now - sent);
+
+        if (i < clients.size()) {
+          NetDatagram reply;
+          reply.add_uint32(i);
+          reply.add_float64(now);
+          writer.send(reply, clients[i]);
+        }
+      }
+    }
+
+    if (!any) {
+      Thread::force_yield();
+    }
+    now = clock->get_short_time();
+  }
+
+  double elapsed = now - start;
+  nout << latencies.size() << " round trips in " << elapsed << " s: "
+       << latencies.size() / elapsed << " per second";
+  if (num_lost != 0) {
+    nout << ", " << num_lost << " connections lost";
+  }
+  nout << "\n";
+
+  if (!latencies.empty()) {
+    std::sort(latencies.begin(), latencies.end());
+    size_t n = latencies.size();
+    nout << "Latency: median " << latencies[n / 2] * 1000.0
+         << " ms, 99th percentile " << latencies[(n * 99) / 100] * 1000.0
+         << " ms, max " << latencies[n - 1] * 1000.0 << " ms\n";
+  }
+
+  for (size_t i = 0; i < clients.size(); ++i) {
+    cm.close_connection(clients[i]);
+  }
+
+  return (0);
+}
@@ -32,13 +32,18 @@
 
 int
 main(int argc, char *argv[]) {
-  if (argc != 2) {
-    nout << "test_spam_server port\n";
+  if (argc != 2 && !(argc == 3 && strcmp(argv[2], "echo") == 0)) {
+    nout << "test_spam_server port [echo]\n";
     exit(1);
   }
 
   int port = atoi(argv[1]);
 
+  // In echo mode, each datagram is sent back only to the client it came from,
+  // rather than to all of the clients.  This is the mode used by
+  // test_spam_load.
+  bool echo = (argc == 3);
+
   QueuedConnectionManager cm;
   PT(Connection) rendezvous = cm.open_TCP_server_rendezvous(port, 5);
 
@@ -95,11 +100,17 @@ main(int argc, char *argv[]) {
       NetDatagram datagram;
       if (reader.get_data(datagram)) {
         num_received++;
-        Clients::iterator ci;
-        for (ci = clients.begin(); ci != clients.end(); ++ci) {
-          if (writer.send(datagram, (*ci))) {
+        if (echo) {
+          if (writer.send(datagram, datagram.get_connection())) {
             num_sent++;
           }
+        } else {
+          Clients::iterator ci;
+          for (ci = clients.begin(); ci != clients.end(); ++ci) {
+            if (writer.send(datagram, (*ci))) {
+              num_sent++;
+            }
+          }
         }
       }
     }
@@ -27,6 +27,7 @@
 #include "colorWriteAttrib.h"
 #include "compassEffect.h"
 #include "cullFaceAttrib.h"
+#include "cullArena.h"
 #include "cullBin.h"
 #include "cullBinAttrib.h"
 #include "cullResult.h"
@@ -369,6 +370,13 @@ ConfigVariableBool allow_live_flatten
           "only has an effect when Panda is not compiled for a release "
           "build."));
 
+ConfigVariableBool use_cull_arena
+("use-cull-arena", true,
+ PRC_DESC("Set this true to allocate the CullableObjects created during each "
+          "cull traversal from an arena belonging to that frame's "
+          "CullResult, which is released all at once after the frame has "
+          "been drawn, rather than allocating each one from the heap."));
+
 /**
  * Initializes the library.  This must be called at least once before any of
  * the functions or classes in this library can be used.  Normally it will be
@@ -397,6 +405,7 @@ init_libpgraph() {
   ColorWriteAttrib::init_type();
   CompassEffect::init_type();
   CullFaceAttrib::init_type();
+  CullArena::init_type();
   CullBin::init_type();
   CullBinAttrib::init_type();
   CullResult::init_type();
@@ -72,6 +72,7 @@ extern ConfigVariableList load_file_type;
 extern ConfigVariableString default_model_extension;
 
 extern ConfigVariableBool allow_live_flatten;
+extern ConfigVariableBool use_cull_arena;
 
 extern EXPCL_PANDA_PGRAPH void init_libpgraph();
 
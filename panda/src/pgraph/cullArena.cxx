@@ -0,0 +1,180 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file cullArena.cxx
+ * @date 2026-10-18
+ */
+
+#include "cullArena.h"
+#include "lightMutexHolder.h"
+#include "memoryHook.h"
+
+TypeHandle CullArena::_type_handle;
+
+void *CullArena::_free_chunks = NULL;
+size_t CullArena::_num_free_chunks = 0;
+LightMutex CullArena::_free_chunks_lock;
+
+// The arena that is current for the calling thread.
+static THREAD_LOCAL CullArena *current_arena = NULL;
+
+// The size of each chunk.  Objects larger than a quarter of this come from
+// the heap instead.
+static const size_t chunk_size = 64 * 1024;
+static const size_t max_object_size = chunk_size / 4;
+
+// No more than this many chunks are kept for reuse; any more are freed.
+static const size_t max_free_chunks = 64;
+
+// Each object is preceded by a pointer to its arena, padded to keep the
+// alignment.
+static const size_t header_size = MEMORY_HOOK_ALIGNMENT;
+
+/**
+ *
+ */
+CullArena::
+CullArena() :
+  _chunks(NULL),
+  _num_chunks(0),
+  _next(NULL),
+  _remaining(0),
+  _used_size(0)
+{
+}
+
+/**
+ * Gives the arena's chunks back for reuse.  By now, every object allocated
+ * from the arena has been deleted.
+ */
+CullArena::
+~CullArena() {
+  nassertv(current_arena != this);
+
+  LightMutexHolder holder(_free_chunks_lock);
+  while (_chunks != NULL) {
+    void *chunk = _chunks;
+    _chunks = *(void **)chunk;
+
+    if (_num_free_chunks < max_free_chunks) {
+      *(void **)chunk = _free_chunks;
+      _free_chunks = chunk;
+      ++_num_free_chunks;
+    } else {
+      PANDA_FREE_ARRAY(chunk);
+    }
+  }
+}
+
+/**
+ * Returns a block of the indicated size from the arena, aligned to
+ * MEMORY_HOOK_ALIGNMENT.  The block is not freed until the whole arena is.
+ * Only one thread at a time may allocate from a given arena.
+ */
+void *CullArena::
+allocate(size_t size) {
+  size = (size + MEMORY_HOOK_ALIGNMENT - 1) & ~(size_t)(MEMORY_HOOK_ALIGNMENT - 1);
+  nassertr(size <= chunk_size - MEMORY_HOOK_ALIGNMENT, NULL);
+
+  if (size > _remaining) {
+    _next = (char *)new_chunk() + MEMORY_HOOK_ALIGNMENT;
+    _remaining = chunk_size - MEMORY_HOOK_ALIGNMENT;
+  }
+
+  void *result = _next;
+  _next += size;
+  _remaining -= size;
+  _used_size += size;
+  return result;
+}
+
+/**
+ * Makes the indicated arena, which may be NULL, current for the calling
+ * thread, so that objects that use ALLOC_CULL_ARENA are allocated from it.
+ * Returns the arena that was current before, which should be restored when
+ * the caller is done.
+ */
+CullArena *CullArena::
+set_current(CullArena *arena) {
+  CullArena *prev = current_arena;
+  current_arena = arena;
+  return prev;
+}
+
+/**
+ * Returns the arena that is current for the calling thread, or NULL if there
+ * is none.
+ */
+CullArena *CullArena::
+get_current() {
+  return current_arena;
+}
+
+/**
+ * Allocates an object of the indicated size from the current arena, or from
+ * the heap if there is no current arena or the object is too large.  Used by
+ * ALLOC_CULL_ARENA.
+ */
+void *CullArena::
+alloc_object(size_t size) {
+  CullArena *arena = current_arena;
+  char *block;
+  if (arena != (CullArena *)NULL && size <= max_object_size) {
+    block = (char *)arena->allocate(size + header_size);
+    arena->ref();
+  } else {
+    block = (char *)PANDA_MALLOC_SINGLE(size + header_size);
+    arena = NULL;
+  }
+
+  *(CullArena **)block = arena;
+  return block + header_size;
+}
+
+/**
+ * Deletes an object allocated by alloc_object().  Used by ALLOC_CULL_ARENA.
+ */
+void CullArena::
+free_object(void *ptr) {
+  if (ptr == NULL) {
+    return;
+  }
+
+  char *block = (char *)ptr - header_size;
+  CullArena *arena = *(CullArena **)block;
+  if (arena == (CullArena *)NULL) {
+    PANDA_FREE_SINGLE(block);
+  } else {
+    unref_delete(arena);
+  }
+}
+
+/**
+ * Adds a new chunk to the arena, reusing one given back by an earlier arena
+ * if possible, and returns it.
+ */
+void *CullArena::
+new_chunk() {
+  void *chunk = NULL;
+  {
+    LightMutexHolder holder(_free_chunks_lock);
+    if (_free_chunks != NULL) {
+      chunk = _free_chunks;
+      _free_chunks = *(void **)chunk;
+      --_num_free_chunks;
+    }
+  }
+  if (chunk == NULL) {
+    chunk = PANDA_MALLOC_ARRAY(chunk_size);
+  }
+
+  *(void **)chunk = _chunks;
+  _chunks = chunk;
+  ++_num_chunks;
+  return chunk;
+}
@@ -0,0 +1,103 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file cullArena.h
+ * @date 2026-10-18
+ */
+
+#ifndef CULLARENA_H
+#define CULLARENA_H
+
+#include "pandabase.h"
+#include "referenceCount.h"
+#include "lightMutex.h"
+
+/**
+ * A simple region allocator for the objects that are created by a cull
+ * traversal and thrown away after the frame has been drawn, chiefly the
+ * CullableObjects.  Each CullResult owns one, so that there is one for each
+ * frame in flight in each stage of the pipeline.
+ *
+ * While an arena is made current for a thread with set_current(), the
+ * classes that use ALLOC_CULL_ARENA are allocated by simply advancing a
+ * pointer within a chunk of the arena, and deleting them releases nothing.
+ * Each object holds a reference to its arena, and when the last of these and
+ * the CullResult's reference go away, all of the arena's chunks are given
+ * back at once, to be reused by the arenas of later frames.  Objects created
+ * while no arena is current come from the heap, as usual.
+ *
+ * Only the thread for which an arena is current may allocate from it, but the
+ * objects may be deleted in any thread.
+ */
+class EXPCL_PANDA_PGRAPH CullArena : public ReferenceCount {
+public:
+  CullArena();
+  virtual ~CullArena();
+
+  void *allocate(size_t size);
+  INLINE size_t get_num_chunks() const;
+  INLINE size_t get_used_size() const;
+
+  static CullArena *set_current(CullArena *arena);
+  static CullArena *get_current();
+
+  static void *alloc_object(size_t size);
+  static void free_object(void *ptr);
+
+private:
+  void *new_chunk();
+
+  // The chunks of this arena, linked through their first word.
+  void *_chunks;
+  size_t _num_chunks;
+  char *_next;
+  size_t _remaining;
+  size_t _used_size;
+
+  // Chunks that have been given back, to be reused by later arenas.
+  static void *_free_chunks;
+  static size_t _num_free_chunks;
+  static LightMutex _free_chunks_lock;
+
+public:
+  static TypeHandle get_class_type() {
+    return _type_handle;
+  }
+  static void init_type() {
+    ReferenceCount::init_type();
+    register_type(_type_handle, "CullArena",
+                  ReferenceCount::get_class_type());
+  }
+
+private:
+  static TypeHandle _type_handle;
+};
+
+// Put this macro in the public section of a class definition, instead of
+// ALLOC_DELETED_CHAIN, to allocate the objects of that class from the current
+// CullArena.
+#define ALLOC_CULL_ARENA(Type)                               \
+  inline void *operator new(size_t size) RETURNS_ALIGNED(MEMORY_HOOK_ALIGNMENT) { \
+    return CullArena::alloc_object(size);                    \
+  }                                                          \
+  inline void *operator new(size_t size, void *ptr) {        \
+    (void) size;                                             \
+    return ptr;                                              \
+  }                                                          \
+  inline void operator delete(void *ptr) {                   \
+    CullArena::free_object(ptr);                             \
+  }                                                          \
+  inline void operator delete(void *, void *) {              \
+  }                                                          \
+  inline static bool validate_ptr(const void *ptr) {         \
+    return (ptr != NULL);                                    \
+  }
+
+#include "cullArena.I"
+
+#endif
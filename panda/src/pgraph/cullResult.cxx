@@ -67,6 +67,10 @@ CullResult(GraphicsStateGuardianBase *gsg,
 #ifndef NDEBUG
   _show_transparency = show_transparency.get_value();
 #endif
+
+  if (use_cull_arena) {
+    _arena = new CullArena;
+  }
 }
 
 /**
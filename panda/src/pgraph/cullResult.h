@@ -19,6 +19,7 @@
 #include "cullBinManager.h"
 #include "renderState.h"
 #include "cullableObject.h"
+#include "cullArena.h"
 #include "geomMunger.h"
 #include "referenceCount.h"
 #include "pointerTo.h"
@@ -51,6 +52,7 @@ PUBLISHED:
   PT(CullResult) make_next() const;
 
   INLINE CullBin *get_bin(int bin_index);
+  INLINE CullArena *get_arena() const;
 
   void add_object(CullableObject *object, const CullTraverser *traverser);
   void finish_cull(SceneSetup *scene_setup, Thread *current_thread);
@@ -85,6 +87,9 @@ private:
   typedef pvector< PT(CullBin) > Bins;
   Bins _bins;
 
+  // The CullableObjects added during this frame are allocated from here.
+  PT(CullArena) _arena;
+
 #ifndef NDEBUG
   bool _show_transparency;
 #endif
@@ -17,6 +17,7 @@
 #include "externalThread.h"
 #include "genericThread.h"
 #include "thread.h"
+#include "parallelFor.h"
 #include "pandaSystem.h"
 
 #include "dconfig.h"
@@ -53,6 +54,16 @@ ConfigVariableInt thread_stack_size
           "created for each newly-created thread.  Not all thread "
           "implementations respect this value."));
 
+/**
+ * The implementation of global_parallel_for that is installed by this
+ * library, so that code below it may use parallel_for() too.
+ */
+static void
+pipeline_parallel_for(ParallelForFunc *func, void *data, int num_items,
+                      int num_threads) {
+  parallel_for(func, data, num_items, num_threads);
+}
+
 /**
  * Initializes the library.  This must be called at least once before any of
  * the functions or classes in this library can be used.  Normally it will be
@@ -79,4 +90,6 @@ init_libpipeline() {
   ps->add_system("threads");
   }
 #endif  // HAVE_THREADS
+
+  global_parallel_for = &pipeline_parallel_for;
 }
@@ -0,0 +1,91 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file parallelFor.cxx
+ * @date 2026-10-18
+ */
+
+#include "parallelFor.h"
+#include "genericThread.h"
+#include "pointerTo.h"
+
+namespace {
+  struct ParallelForBlock {
+    ParallelForFunc *_func;
+    void *_data;
+    int _begin;
+    int _end;
+  };
+}
+
+/**
+ * The thread function for each of the worker threads of parallel_for().
+ */
+static void
+parallel_for_main(void *user_data) {
+  ParallelForBlock *block = (ParallelForBlock *)user_data;
+  (*block->_func)(block->_data, block->_begin, block->_end);
+}
+
+/**
+ * Calls func() on the items [0, num_items), split into contiguous blocks that
+ * are processed concurrently by up to num_threads threads.  The calling
+ * thread processes the first block itself, and then waits for the others.
+ */
+void
+parallel_for(ParallelForFunc *func, void *data, int num_items,
+             int num_threads, const string &sync_name) {
+  if (num_threads <= 0) {
+    num_threads = Thread::get_num_supported_threads();
+  }
+  if (!Thread::is_true_threads()) {
+    num_threads = 1;
+  }
+  num_threads = min(num_threads, num_items);
+
+  if (num_threads <= 1) {
+    if (num_items > 0) {
+      (*func)(data, 0, num_items);
+    }
+    return;
+  }
+
+  ParallelForBlock *blocks = new ParallelForBlock[num_threads];
+  PT(GenericThread) *threads = new PT(GenericThread)[num_threads];
+
+  for (int ti = 0; ti < num_threads; ++ti) {
+    ParallelForBlock &block = blocks[ti];
+    block._func = func;
+    block._data = data;
+    block._begin = (int)((int64_t)num_items * ti / num_threads);
+    block._end = (int)((int64_t)num_items * (ti + 1) / num_threads);
+  }
+
+  for (int ti = 1; ti < num_threads; ++ti) {
+    ostringstream strm;
+    strm << sync_name << "-" << ti;
+    threads[ti] = new GenericThread(strm.str(), sync_name,
+                                    &parallel_for_main, &blocks[ti]);
+    if (!threads[ti]->start(TP_normal, true)) {
+      // If we couldn't start the thread, do the work ourselves.
+      threads[ti].clear();
+      parallel_for_main(&blocks[ti]);
+    }
+  }
+
+  parallel_for_main(&blocks[0]);
+
+  for (int ti = 1; ti < num_threads; ++ti) {
+    if (threads[ti] != (GenericThread *)NULL) {
+      threads[ti]->join();
+    }
+  }
+
+  delete[] threads;
+  delete[] blocks;
+}
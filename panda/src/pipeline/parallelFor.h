@@ -0,0 +1,30 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file parallelFor.h
+ * @date 2026-10-18
+ */
+
+#ifndef PARALLELFOR_H
+#define PARALLELFOR_H
+
+#include "pandabase.h"
+
+// ParallelForFunc is defined in dtoolbase_cc.h, so that lower-level code may
+// also use it via global_parallel_for.
+
+// Calls func() on the items [0, num_items), split into contiguous blocks
+// that are processed concurrently by up to num_threads threads, including
+// the calling thread.  Returns when all of the items have been processed.
+// If num_threads is 0 or less, uses Thread::get_num_supported_threads().
+// The items must be independent of each other; no locking is performed.
+EXPCL_PANDA_PIPELINE void
+parallel_for(ParallelForFunc *func, void *data, int num_items,
+             int num_threads = 0, const string &sync_name = "ParallelFor");
+
+#endif
@@ -19,6 +19,15 @@
 #include "conditionVarDebug.h"
 #include "conditionVarFullDebug.h"
 
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif
+#include <windows.h>
+#elif defined(PHAVE_UNISTD_H)
+#include <unistd.h>
+#endif
+
 Thread *Thread::_main_thread;
 Thread *Thread::_external_thread;
 TypeHandle Thread::_type_handle;
@@ -161,6 +170,34 @@ write_status(ostream &out) {
 #endif
 }
 
+/**
+ * Returns the number of threads that the hardware can usefully run
+ * concurrently, as reported by the operating system.  This is a reasonable
+ * upper bound on the number of worker threads to spawn for a parallelizable
+ * operation.  Returns 1 if true threads are not available, or if the number
+ * cannot be determined.
+ */
+int Thread::
+get_num_supported_threads() {
+  if (!is_true_threads()) {
+    return 1;
+  }
+
+  static int num_threads = 0;
+  if (num_threads == 0) {
+    int count = 1;
+#ifdef _WIN32
+    SYSTEM_INFO sysinfo;
+    GetSystemInfo(&sysinfo);
+    count = (int)sysinfo.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    num_threads = max(count, 1);
+  }
+  return num_threads;
+}
+
 /**
  * Starts the thread executing.  It is only valid to call this once.
  *
@@ -58,6 +58,22 @@ ConfigVariableDouble pfm_resize_radius
           "always call box_filter() or gaussian_filter() explicitly with "
           "a specific radius."));
 
+ConfigVariableInt pnmimage_filter_threads
+("pnmimage-filter-threads", 0,
+ PRC_DESC("The number of threads that PNMImage::box_filter_from() and "
+          "gaussian_filter_from(), and the PfmFile equivalents, may use to "
+          "filter a large image.  Set this to 0 to use as many threads as "
+          "the hardware supports, or to 1 to do all filtering on the "
+          "calling thread."));
+
+ConfigVariableInt pnmimage_filter_min_thread_work
+("pnmimage-filter-min-thread-work", 262144,
+ PRC_DESC("The approximate number of multiply-add operations that must be "
+          "available for each thread before pnmimage-filter-threads will "
+          "spawn an additional thread to filter an image.  This prevents "
+          "the overhead of starting threads from dominating the filtering "
+          "of small images."));
+
 /**
  * Initializes the library.  This must be called at least once before any of
  * the functions or classes in this library can be used.  Normally it will be
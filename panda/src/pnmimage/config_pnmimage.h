@@ -18,6 +18,7 @@
 #include "notifyCategoryProxy.h"
 #include "configVariableBool.h"
 #include "configVariableDouble.h"
+#include "configVariableInt.h"
 
 NotifyCategoryDecl(pnmimage, EXPCL_PANDA_PNMIMAGE, EXPTP_PANDA_PNMIMAGE);
 
@@ -27,6 +28,9 @@ extern ConfigVariableBool pfm_resize_gaussian;
 extern ConfigVariableBool pfm_resize_quick;
 extern ConfigVariableDouble pfm_resize_radius;
 
+extern ConfigVariableInt pnmimage_filter_threads;
+extern ConfigVariableInt pnmimage_filter_min_thread_work;
+
 extern EXPCL_PANDA_PNMIMAGE void init_libpnmimage();
 
 #endif
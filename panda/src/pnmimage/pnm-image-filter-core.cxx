@@ -13,6 +13,81 @@
 // dominant, and we map getset functions for the channel in question to
 // GETVALSETVAL.
 
+// Each pass of the filter is implemented as a function operating on a range
+// of rows, so that run_filter_blocks() may farm it out to several threads.
+// FILTER_PASTE generates a unique name for these per instance of this file.
+
+#ifndef FILTER_PASTE
+#define FILTER_PASTE2(a, b) a ## b
+#define FILTER_PASTE(a, b) FILTER_PASTE2(a, b)
+#endif
+
+struct FILTER_PASTE(FUNCTION_NAME, _data) {
+  IMAGETYPE *_dest;
+  const IMAGETYPE *_source;
+  int _channel;
+
+  // The column-major matrix holding the results of the first pass: the
+  // column for each a value occupies _matrix_stride consecutive values.
+  StoreType *_matrix;
+  int _matrix_stride;
+
+  FilterTable _a_table;
+  FilterTable _b_table;
+};
+
+// Scales the source rows [begin, end) in the A direction, storing the results
+// in the matrix.
+static void
+FILTER_PASTE(FUNCTION_NAME, _a_pass)(void *data_ptr, int begin, int end) {
+  FILTER_PASTE(FUNCTION_NAME, _data) &data = *(FILTER_PASTE(FUNCTION_NAME, _data) *)data_ptr;
+  const IMAGETYPE &source = *data._source;
+  int channel = data._channel;
+  int source_a_size = source.ASIZE();
+  int dest_a_size = data._a_table._dest_len;
+
+  StoreType *temp_source = (StoreType *)PANDA_MALLOC_ARRAY(source_a_size * sizeof(StoreType));
+  StoreType *temp_dest = (StoreType *)PANDA_MALLOC_ARRAY(dest_a_size * sizeof(StoreType));
+
+  for (int b = begin; b < end; b++) {
+    for (int a = 0; a < source_a_size; a++) {
+      temp_source[a] = (StoreType)(source_max * source.GETVAL(a, b, channel));
+    }
+
+    filter_row(temp_dest, temp_source, data._a_table);
+
+    StoreType *matrix = data._matrix + b;
+    for (int a = 0; a < dest_a_size; a++) {
+      matrix[(size_t)a * data._matrix_stride] = temp_dest[a];
+    }
+  }
+
+  PANDA_FREE_ARRAY(temp_source);
+  PANDA_FREE_ARRAY(temp_dest);
+}
+
+// Scales the matrix columns [begin, end) in the B direction, storing the
+// results in the destination image.
+static void
+FILTER_PASTE(FUNCTION_NAME, _b_pass)(void *data_ptr, int begin, int end) {
+  FILTER_PASTE(FUNCTION_NAME, _data) &data = *(FILTER_PASTE(FUNCTION_NAME, _data) *)data_ptr;
+  IMAGETYPE &dest = *data._dest;
+  int channel = data._channel;
+  int dest_b_size = data._b_table._dest_len;
+
+  StoreType *temp_dest = (StoreType *)PANDA_MALLOC_ARRAY(dest_b_size * sizeof(StoreType));
+
+  for (int a = begin; a < end; a++) {
+    filter_row(temp_dest, data._matrix + (size_t)a * data._matrix_stride,
+               data._b_table);
+
+    for (int b = 0; b < dest_b_size; b++) {
+      dest.SETVAL(a, b, channel, (float)temp_dest[b]/(float)source_max);
+    }
+  }
+
+  PANDA_FREE_ARRAY(temp_dest);
+}
 
 static void
 FUNCTION_NAME(IMAGETYPE &dest, const IMAGETYPE &source,
@@ -21,74 +96,46 @@ FUNCTION_NAME(IMAGETYPE &dest, const IMAGETYPE &source,
     return;
   }
 
+  FILTER_PASTE(FUNCTION_NAME, _data) data;
+  data._dest = &dest;
+  data._source = &source;
+  data._channel = channel;
+
   // First, set up a 2-d column-major matrix of StoreTypes, big enough to hold
   // the image xelvals scaled in the A direction only.  This will hold the
   // adjusted xel data from our first pass.
+  data._matrix_stride = source.BSIZE();
+  data._matrix = (StoreType *)PANDA_MALLOC_ARRAY((size_t)dest.ASIZE() * source.BSIZE() * sizeof(StoreType));
 
-  StoreType **matrix = (StoreType **)PANDA_MALLOC_ARRAY(dest.ASIZE() * sizeof(StoreType *));
-
-  int a, b;
-
-  for (a=0; a<dest.ASIZE(); a++) {
-    matrix[a] = (StoreType *)PANDA_MALLOC_ARRAY(source.BSIZE() * sizeof(StoreType));
-  }
-
-  // First, scale the image in the A direction.
-  float scale;
-  StoreType *temp_source, *temp_dest;
-
-  scale = (float)dest.ASIZE() / (float)source.ASIZE();
-  temp_source = (StoreType *)PANDA_MALLOC_ARRAY(source.ASIZE() * sizeof(StoreType));
-  temp_dest = (StoreType *)PANDA_MALLOC_ARRAY(dest.ASIZE() * sizeof(StoreType));
-
+  // Compute the filter weights for both axes up front.
   WorkType *filter;
   float filter_width;
+  float scale;
 
+  scale = (float)dest.ASIZE() / (float)source.ASIZE();
   make_filter(scale, width, filter, filter_width);
-
-  for (b = 0; b < source.BSIZE(); b++) {
-    for (a = 0; a < source.ASIZE(); a++) {
-      temp_source[a] = (StoreType)(source_max * source.GETVAL(a, b, channel));
-    }
-
-    filter_row(temp_dest, dest.ASIZE(),
-               temp_source, source.ASIZE(),
-               scale,
-               filter, filter_width);
-
-    for (a = 0; a < dest.ASIZE(); a++) {
-      matrix[a][b] = temp_dest[a];
-    }
-  }
-
-  PANDA_FREE_ARRAY(temp_source);
-  PANDA_FREE_ARRAY(temp_dest);
+  make_filter_table(data._a_table, dest.ASIZE(), source.ASIZE(),
+                    scale, filter, filter_width);
   PANDA_FREE_ARRAY(filter);
 
-  // Now, scale the image in the B direction.
   scale = (float)dest.BSIZE() / (float)source.BSIZE();
-  temp_dest = (StoreType *)PANDA_MALLOC_ARRAY(dest.BSIZE() * sizeof(StoreType));
-
   make_filter(scale, width, filter, filter_width);
+  make_filter_table(data._b_table, dest.BSIZE(), source.BSIZE(),
+                    scale, filter, filter_width);
+  PANDA_FREE_ARRAY(filter);
 
-  for (a = 0; a < dest.ASIZE(); a++) {
-    filter_row(temp_dest, dest.BSIZE(),
-               matrix[a], source.BSIZE(),
-               scale,
-               filter, filter_width);
-
-    for (b = 0; b < dest.BSIZE(); b++) {
-      dest.SETVAL(a, b, channel, (float)temp_dest[b]/(float)source_max);
-    }
-  }
+  // First, scale the image in the A direction.
+  run_filter_blocks(&FILTER_PASTE(FUNCTION_NAME, _a_pass), &data,
+                    source.BSIZE(),
+                    source.ASIZE() + dest.ASIZE() * data._a_table._stride);
 
-  PANDA_FREE_ARRAY(temp_dest);
-  PANDA_FREE_ARRAY(filter);
+  // Now, scale the image in the B direction.
+  run_filter_blocks(&FILTER_PASTE(FUNCTION_NAME, _b_pass), &data,
+                    dest.ASIZE(),
+                    dest.BSIZE() * (data._b_table._stride + 1));
 
   // Now, clean up our temp matrix and go home!
-
-  for (a = 0; a < dest.ASIZE(); a++) {
-    PANDA_FREE_ARRAY(matrix[a]);
-  }
-  PANDA_FREE_ARRAY(matrix);
+  free_filter_table(data._a_table);
+  free_filter_table(data._b_table);
+  PANDA_FREE_ARRAY(data._matrix);
 }
@@ -37,77 +37,58 @@
 #include "pnmImage.h"
 #include "pfmFile.h"
 
-// WorkType is an abstraction that allows the filtering process to be
-// recompiled to use either floating-point or integer arithmetic.  On SGI
-// machines, there doesn't seem to be much of a performance difference-- if
-// anything, the integer arithmetic is slower--though certainly other
-// architectures may differ.
-
-// A StoreType is a numeric type that is used to store the intermediate values
-// of the filtering computation; temporary calculations are performed using
-// WorkTypes.  source_max represents the largest value that will be stored in
-// a StoreType, while filter_max represents the largest value that will
-// multiplied by it as a weighted filter (source_max * filter_max must fit
-// comfortably within a WorkType, with room to spare).
-
-// Floating-point arithmetic is slightly faster and slightly more precise, but
-// the main reason to use it is that it is conceptually easy to understand.
-// All values are scaled in the range 0..1, as they should be.
-
-// The biggest reason to use integer arithmetic is space.  A table of
-// StoreTypes must be allocated to match the size of the image.  On an SGI,
-// sizeof(float) is 4, while sizeof(short) is 2 and sizeof(char) is, of
-// course, 1.  Since the source precision is probably 8 bits anyway (there are
-// usually 8 bits per channel), it doesn't cost any precision at all to use
-// shorts, and not very much to use chars.
-
-// To use double-precision floating point, 8 bytes: (strictly for the
-// neurotic)
-/*
-typedef double WorkType;
-typedef double StoreType;
-static const WorkType source_max = 1.0;
-static const WorkType filter_max = 1.0;
-*/
-
-// To use single-precision floating point, 4 bytes:
+#include "parallelFor.h"
+#include "config_pnmimage.h"
+
+#if defined(__SSE2__) || (_M_IX86_FP >= 2) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define PNM_FILTER_SSE2 1
+#endif
+
+// WorkType is the numeric type used for the temporary calculations of the
+// filtering process, while StoreType is used to store the intermediate values
+// of the filtering computation.  source_max represents the largest value that
+// will be stored in a StoreType, while filter_max represents the largest value
+// that will be multiplied by it as a weighted filter.
+
+// These used to be switchable to integer arithmetic, to save space on
+// machines with little memory.  Since the weights are now normalized in
+// advance (see FilterTable, below), and the convolution may be vectorized
+// using SSE2, they must remain single-precision floating point.
 typedef float WorkType;
 typedef float StoreType;
 static const WorkType source_max = 1.0f;
 static const WorkType filter_max = 1.0f;
 
-/*
-// To use 16-bit integer arithmetic, 2 bytes:
-typedef unsigned long WorkType;
-typedef unsigned short StoreType;
-static const WorkType source_max = 65535;
-static const WorkType filter_max = 255;
-*/
-
-/*
-// To use 8-bit integer arithmetic, 1 byte:
-typedef unsigned long WorkType;
-typedef unsigned char StoreType;
-static const WorkType source_max = 255;
-static const WorkType filter_max = 255;
-*/
-
-// filter_row() filters a single row by convolving with a one-dimensional
-// kernel filter.  The kernel is defined by an array of weights in filter[],
-// where the ith element of filter corresponds to abs(d * scale), if
-// scale>1.0, and abs(d), if scale<=1.0, where d is the offset from the center
-// and varies from -filter_width to filter_width.
+// A FilterTable holds, for each value of the destination row, the range of
+// source values that contribute to it and the normalized weight of each
+// contribution.  Since these depend only on the scale and the filter
+// function, and not on the row being filtered, we can compute them once per
+// axis and then apply them to every row and every channel of the image, which
+// reduces the inner loop of filter_row() to a simple dot product.
+struct FilterTable {
+  int _dest_len;
+  int _stride;
+  int *_left;
+  int *_count;
+  WorkType *_weights;
+};
+
+// make_filter_table() builds a FilterTable for filtering a row of source_len
+// values into a row of dest_len values.  The kernel is defined by an array of
+// weights in filter[], where the ith element of filter corresponds to abs(d *
+// scale), if scale>1.0, and abs(d), if scale<=1.0, where d is the offset from
+// the center and varies from -filter_width to filter_width.
 
 // Note that filter_width is not necessarily the length of the array; it is
 // the radius of interest of the filter function.  The array may need to be
 // larger (by a factor of scale), to adequately cover all the values.
 
 static void
-filter_row(StoreType dest[], int dest_len,
-           const StoreType source[], int source_len,
-           float scale,                    //  == dest_len / source_len
-           const WorkType filter[],
-           float filter_width) {
+make_filter_table(FilterTable &table, int dest_len, int source_len,
+                  float scale,                    //  == dest_len / source_len
+                  const WorkType filter[],
+                  float filter_width) {
   // If we are expanding the row (scale > 1.0), we need to look at a
   // fractional granularity.  Hence, we scale our filter index by scale.  If
   // we are compressing (scale < 1.0), we don't need to fiddle with the filter
@@ -121,6 +102,14 @@ filter_row(StoreType dest[], int dest_len,
     iscale = scale;
   }
 
+  // The widest possible range of interest determines the spacing of the
+  // weights in the table.
+  table._dest_len = dest_len;
+  table._stride = min((int)cceil(filter_width * 2.0f) + 2, source_len);
+  table._left = (int *)PANDA_MALLOC_ARRAY(dest_len * sizeof(int));
+  table._count = (int *)PANDA_MALLOC_ARRAY(dest_len * sizeof(int));
+  table._weights = (WorkType *)PANDA_MALLOC_ARRAY(dest_len * table._stride * sizeof(WorkType));
+
   for (int dest_x = 0; dest_x < dest_len; dest_x++) {
     // The additional offset of 0.5 keeps the pixel centered.
     float center = (dest_x + 0.5f) / scale - 0.5f;
@@ -130,42 +119,120 @@ filter_row(StoreType dest[], int dest_len,
     // value in this range.
     int left = max((int)cfloor(center - filter_width), 0);
     int right = min((int)cceil(center + filter_width), source_len - 1);
+    right = min(right, left + table._stride - 1);
 
     // right_center is the point just to the right of the center.  This allows
     // us to flip the sign of the offset when we cross the center point.
     int right_center = (int)cceil(center);
 
+    WorkType *weights = table._weights + dest_x * table._stride;
     WorkType net_weight = 0;
-    WorkType net_value = 0;
 
     int index, source_x;
 
     // This loop is broken into two pieces--the left of center and the right
     // of center--so we don't have to incur the overhead of calling fabs()
     // each time through the loop.
-    for (source_x = left; source_x < right_center; source_x++) {
+    for (source_x = left; source_x < right_center && source_x <= right; source_x++) {
       index = (int)(iscale * (center - source_x) + 0.5f);
-      net_value += filter[index] * source[source_x];
+      weights[source_x - left] = filter[index];
       net_weight += filter[index];
     }
 
     for (; source_x <= right; source_x++) {
       index = (int)(iscale * (source_x - center) + 0.5f);
-      net_value += filter[index] * source[source_x];
+      weights[source_x - left] = filter[index];
       net_weight += filter[index];
     }
 
+    table._left[dest_x] = left;
     if (net_weight > 0) {
-      dest[dest_x] = (StoreType)(net_value / net_weight);
+      table._count[dest_x] = right - left + 1;
+      for (int i = 0; i <= right - left; ++i) {
+        weights[i] /= net_weight;
+      }
     } else {
-      dest[dest_x] = 0;
+      table._count[dest_x] = 0;
+    }
+  }
+}
+
+// Frees the arrays allocated by make_filter_table().
+static void
+free_filter_table(FilterTable &table) {
+  PANDA_FREE_ARRAY(table._left);
+  PANDA_FREE_ARRAY(table._count);
+  PANDA_FREE_ARRAY(table._weights);
+}
+
+// filter_row() filters a single row by convolving with a one-dimensional
+// kernel filter, as described by a FilterTable built for this row length.
+static void
+filter_row(StoreType dest[], const StoreType source[],
+           const FilterTable &table) {
+  const WorkType *weights = table._weights;
+
+  for (int dest_x = 0;
+       dest_x < table._dest_len;
+       dest_x++, weights += table._stride) {
+    const StoreType *row = source + table._left[dest_x];
+    int count = table._count[dest_x];
+    int i = 0;
+    WorkType net_value = 0;
+
+#ifdef PNM_FILTER_SSE2
+    // Four taps at a time.  This changes the order of summation, so the
+    // result may differ from the scalar loop in the last bit or so.
+    if (count >= 4) {
+      __m128 sum = _mm_setzero_ps();
+      for (; i + 4 <= count; i += 4) {
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(weights + i),
+                                         _mm_loadu_ps(row + i)));
+      }
+      sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+      sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+      net_value = _mm_cvtss_f32(sum);
+    }
+#endif
+
+    for (; i < count; ++i) {
+      net_value += weights[i] * row[i];
     }
+
+    dest[dest_x] = (StoreType)net_value;
   }
   Thread::consider_yield();
 }
 
-// As above, but we also accept an array of weight values per element, to
-// support scaling a sparse array (as in a PfmFile).
+// To make good use of a many-core machine, each pass of the filter is broken
+// up into blocks of rows, which are handed to a number of worker threads.
+// The rows are independent of each other, so the threads need no
+// synchronization other than waiting for all of them to finish.
+
+// Calls func() on the rows [0, num_rows), possibly split across several
+// threads.  row_cost is an estimate of the number of operations required per
+// row, and is used to decide whether it is worth spawning threads at all.
+static void
+run_filter_blocks(ParallelForFunc *func, void *data,
+                  int num_rows, int row_cost) {
+  int num_threads = pnmimage_filter_threads;
+  if (num_threads <= 0) {
+    num_threads = Thread::get_num_supported_threads();
+  }
+
+  // Don't bother with threads unless each one has a meaningful amount of
+  // work to do.
+  int64_t total_cost = (int64_t)num_rows * (int64_t)max(row_cost, 1);
+  int64_t min_cost = max((int)pnmimage_filter_min_thread_work, 1);
+  num_threads = (int)min((int64_t)num_threads, total_cost / min_cost);
+
+  parallel_for(func, data, num_rows, max(num_threads, 1), "PNMFilter");
+}
+
+// filter_sparse_row() is the old-style, per-row filter, which we still use
+// for scaling a sparse array (as in a PfmFile).  The kernel is defined by an
+// array of weights in filter[], as described for make_filter_table(), above,
+// and we also accept an array of weight values per element.
 static void
 filter_sparse_row(StoreType dest[], StoreType dest_weight[], int dest_len,
                   const StoreType source[], const StoreType source_weight[], int source_len,
@@ -288,7 +355,7 @@ gaussian_filter_impl(float scale, float width,
 
   float sigma = width/2;
   filter_width = 3.0 * sigma;
-  int actual_width = (int)cceil((filter_width + 1) * fscale);
+  int actual_width = (int)cceil((filter_width + 1) * fscale) + 1;
 
   // G(x, y) = (1(2 pi sigma^2)) * exp( - (x^2 + y^2)  (2 sigma^2))
 
@@ -54,6 +54,43 @@ ConfigVariableDouble pstats_tcp_ratio
           "that are too large for UDP and must be sent via TCP anyway.  1.0 "
           "means all messages are sent TCP; 0.0 means all are sent UDP."));
 
+ConfigVariableInt pstats_ring_buffer_size
+("pstats-ring-buffer-size", 0,
+ PRC_DESC("If this is nonzero, each thread records its start and stop events "
+          "in a ring buffer of this many events, without taking a lock, "
+          "instead of appending them to its frame data under a lock.  The "
+          "events are collected at the end of each frame, and periodically "
+          "by a background thread (see pstats-drain-interval).  This makes "
+          "timing much cheaper in heavily instrumented, many-threaded "
+          "programs.  A thread that fills its ring collects the events "
+          "itself, so nothing is lost if it is too small."));
+
+ConfigVariableDouble pstats_drain_interval
+("pstats-drain-interval", 0.005,
+ PRC_DESC("If pstats-ring-buffer-size is nonzero, this is the number of "
+          "seconds between the times that a background thread moves the "
+          "events out of the ring buffers, so that the threads rarely find "
+          "them full.  Set this to 0 to collect the events only at the end "
+          "of each frame."));
+
+ConfigVariableDouble pstats_sample_frequency
+("pstats-sample-frequency", 0.0,
+ PRC_DESC("If this is nonzero, PStatClient::connect() starts a sampling "
+          "profiler, which interrupts the process this many times per "
+          "second of CPU time to see which function is running and which "
+          "collector it is running under.  When the client disconnects, "
+          "the functions that took the most time under each collector are "
+          "reported.  This finds the hot spots that have no collectors of "
+          "their own.  Only available on Linux."));
+
+ConfigVariableFilename pstats_capture_file
+("pstats-capture-file", "",
+ PRC_DESC("If this is set to a filename, PStatClient::connect() writes the "
+          "collector and thread definitions and every frame of data to this "
+          "file, instead of connecting to a PStats server.  The file can be "
+          "read later by text-stats -i, which reports timing statistics "
+          "without needing a running client or a display."));
+
 ConfigVariableString pstats_host
 ("pstats-host", "localhost");
 
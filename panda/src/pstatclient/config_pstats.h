@@ -22,6 +22,7 @@
 #include "configVariableInt.h"
 #include "configVariableDouble.h"
 #include "configVariableBool.h"
+#include "configVariableFilename.h"
 
 // Configure variables for pstats package.
 
@@ -33,6 +34,10 @@ extern EXPCL_PANDA_PSTATCLIENT ConfigVariableDouble pstats_max_rate;
 extern EXPCL_PANDA_PSTATCLIENT ConfigVariableBool pstats_threaded_write;
 extern EXPCL_PANDA_PSTATCLIENT ConfigVariableInt pstats_max_queue_size;
 extern EXPCL_PANDA_PSTATCLIENT ConfigVariableDouble pstats_tcp_ratio;
+extern EXPCL_PANDA_PSTATCLIENT ConfigVariableInt pstats_ring_buffer_size;
+extern EXPCL_PANDA_PSTATCLIENT ConfigVariableDouble pstats_drain_interval;
+extern EXPCL_PANDA_PSTATCLIENT ConfigVariableFilename pstats_capture_file;
+extern EXPCL_PANDA_PSTATCLIENT ConfigVariableDouble pstats_sample_frequency;
 
 extern EXPCL_PANDA_PSTATCLIENT ConfigVariableString pstats_host;
 extern EXPCL_PANDA_PSTATCLIENT ConfigVariableInt pstats_port;
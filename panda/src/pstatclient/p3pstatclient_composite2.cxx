@@ -1,7 +1,9 @@
 
 #include "pStatCollectorDef.cxx"
 #include "pStatCollectorForward.cxx"
+#include "pStatEventRing.cxx"
 #include "pStatFrameData.cxx"
+#include "pStatProfiler.cxx"
 #include "pStatProperties.cxx"
 #include "pStatServerControlMessage.cxx"
 #include "pStatThread.cxx"
@@ -23,9 +23,11 @@
 #include "pStatThread.h"
 #include "config_pstats.h"
 #include "pStatProperties.h"
+#include "pStatProfiler.h"
 #include "thread.h"
 #include "clockObject.h"
 #include "neverFreeMemory.h"
+#include "threadCacheAllocator.h"
 
 PStatCollector PStatClient::_heap_total_size_pcollector("System memory:Heap");
 PStatCollector PStatClient::_heap_overhead_size_pcollector("System memory:Heap:Overhead");
@@ -39,6 +41,11 @@ PStatCollector PStatClient::_mmap_size_pcollector("System memory:MMap");
 PStatCollector PStatClient::_mmap_nf_unused_size_pcollector("System memory:MMap:NeverFree:Unused");
 PStatCollector PStatClient::_mmap_dc_active_other_size_pcollector("System memory:MMap:NeverFree:Active:Other");
 PStatCollector PStatClient::_mmap_dc_inactive_other_size_pcollector("System memory:MMap:NeverFree:Inactive:Other");
+PStatCollector PStatClient::_alloc_total_size_pcollector("Allocator");
+PStatCollector PStatClient::_alloc_in_use_size_pcollector("Allocator:In use");
+PStatCollector PStatClient::_alloc_thread_cache_size_pcollector("Allocator:Thread caches");
+PStatCollector PStatClient::_alloc_central_cache_size_pcollector("Allocator:Central caches");
+PStatCollector PStatClient::_alloc_free_size_pcollector("Allocator:Free pages");
 PStatCollector PStatClient::_pstats_pcollector("*:PStats");
 PStatCollector PStatClient::_clock_wait_pcollector("Wait:Clock Wait:Sleep");
 PStatCollector PStatClient::_clock_busy_wait_pcollector("Wait:Clock Wait:Spin");
@@ -65,6 +72,12 @@ PerThreadData() {
   _has_level = false;
   _level = 0.0;
   _nested_count = 0;
+#ifdef DO_MEMORY_USAGE
+  _allocs = NULL;
+  _prev_allocs = NULL;
+  _reported_count = 0;
+  _reported_size = 0;
+#endif
 }
 
 /**
@@ -73,7 +86,8 @@ PerThreadData() {
 PStatClient::
 PStatClient() :
   _lock("PStatClient::_lock"),
-  _impl(NULL)
+  _impl(NULL),
+  _ring_size(0)
 {
   _collectors = NULL;
   _collectors_size = 0;
@@ -376,6 +390,25 @@ main_tick() {
   }
 #endif  // DO_MEMORY_USAGE
 
+#ifdef USE_MEMORY_THREAD_CACHE
+  // The thread-caching allocator can tell us where its memory is, whether or
+  // not we are tracking memory usage.
+  if (is_connected()) {
+    ThreadCacheAllocator *alloc = ThreadCacheAllocator::get_global_ptr();
+    size_t total = alloc->get_mapped_size() - alloc->get_released_size();
+    size_t thread_cache = alloc->get_thread_cache_size();
+    size_t central_cache = alloc->get_central_cache_size();
+    size_t free_pages = alloc->get_free_span_size();
+    size_t cached = thread_cache + central_cache + free_pages;
+
+    _alloc_total_size_pcollector.set_level(total);
+    _alloc_in_use_size_pcollector.set_level(total > cached ? total - cached : 0);
+    _alloc_thread_cache_size_pcollector.set_level(thread_cache);
+    _alloc_central_cache_size_pcollector.set_level(central_cache);
+    _alloc_free_size_pcollector.set_level(free_pages);
+  }
+#endif  // USE_MEMORY_THREAD_CACHE
+
   get_global_pstats()->client_main_tick();
 }
 
@@ -445,7 +478,16 @@ bool PStatClient::
 client_connect(string hostname, int port) {
   ReMutexHolder holder(_lock);
   client_disconnect();
-  return get_impl()->client_connect(hostname, port);
+  _ring_size = max((int)pstats_ring_buffer_size, 0);
+  if (!get_impl()->client_connect(hostname, port)) {
+    return false;
+  }
+
+  if (pstats_sample_frequency > 0.0) {
+    PStatProfiler::clear();
+    PStatProfiler::start(pstats_sample_frequency);
+  }
+  return true;
 }
 
 /**
@@ -454,12 +496,24 @@ client_connect(string hostname, int port) {
 void PStatClient::
 client_disconnect() {
   ReMutexHolder holder(_lock);
+  if (PStatProfiler::is_running() && pstats_sample_frequency > 0.0) {
+    // The profiler was started by client_connect().
+    PStatProfiler::stop();
+    if (PStatProfiler::get_num_samples() != 0) {
+      pstats_cat.info()
+        << "CPU samples by collector: ";
+      PStatProfiler::write(pstats_cat.info(false));
+    }
+  }
+
   if (has_impl()) {
     _impl->client_disconnect();
     delete _impl;
     _impl = NULL;
   }
 
+  _ring_size = 0;
+
   ThreadPointer *threads = (ThreadPointer *)_threads;
   for (int ti = 0; ti < _num_threads; ++ti) {
     InternalThread *thread = threads[ti];
@@ -467,6 +521,11 @@ client_disconnect() {
     thread->_is_active = false;
     thread->_next_packet = 0.0;
     thread->_frame_data.clear();
+
+    if (thread->_ring != (PStatEventRing *)NULL) {
+      LightMutexHolder holder(thread->_thread_lock);
+      thread->_ring->clear();
+    }
   }
 
   CollectorPointer *collectors = (CollectorPointer *)_collectors;
@@ -476,7 +535,7 @@ client_disconnect() {
     for (ii = collector->_per_thread.begin();
          ii != collector->_per_thread.end();
          ++ii) {
-      (*ii)._nested_count = 0;
+      AtomicAdjust::set((*ii)._nested_count, 0);
     }
   }
 }
@@ -732,8 +791,8 @@ is_started(int collector_index, int thread_index) const {
   InternalThread *thread = get_thread_ptr(thread_index);
 
   if (client_is_connected() && collector->is_active() && thread->_is_active) {
-    LightMutexHolder holder(thread->_thread_lock);
-    if (collector->_per_thread[thread_index]._nested_count == 0) {
+    PerThreadData &ptd = collector->_per_thread[thread_index];
+    if (AtomicAdjust::get(ptd._nested_count) == 0) {
       // Not started.
       return false;
     }
@@ -764,15 +823,39 @@ start(int collector_index, int thread_index) {
   InternalThread *thread = get_thread_ptr(thread_index);
 
   if (collector->is_active() && thread->_is_active) {
+    if (PStatProfiler::is_running()) {
+      PStatProfiler::push_collector(collector_index, thread_index);
+    }
+#ifdef DO_MEMORY_USAGE
+    if (MemoryUsage::is_counting_allocs()) {
+      start_alloc_counter(collector, collector_index, thread_index);
+    }
+#endif
+
+    PStatEventRing *ring = get_own_ring(thread, thread_index);
+    if (ring != (PStatEventRing *)NULL) {
+      // We are timing our own thread, so nobody else is adding to its ring,
+      // and we don't need the lock.
+      PerThreadData &ptd = collector->_per_thread[thread_index];
+      if (ptd.inc_nested_count() && thread->_thread_active) {
+        double now = get_real_time();
+        if (!ring->add_start(collector_index, now)) {
+          add_overflow_event(thread, collector_index, true, now);
+        }
+      }
+      return;
+    }
+
     LightMutexHolder holder(thread->_thread_lock);
-    if (collector->_per_thread[thread_index]._nested_count == 0) {
+    if (collector->_per_thread[thread_index].inc_nested_count()) {
       // This collector wasn't already started in this thread; record a new
       // data point.
       if (thread->_thread_active) {
-        thread->_frame_data.add_start(collector_index, get_real_time());
+        double now = get_real_time();
+        drain_ring(thread, now);
+        thread->_frame_data.add_start(collector_index, now);
       }
     }
-    collector->_per_thread[thread_index]._nested_count++;
   }
 }
 
@@ -796,14 +879,14 @@ start(int collector_index, int thread_index, double as_of) {
 
   if (collector->is_active() && thread->_is_active) {
     LightMutexHolder holder(thread->_thread_lock);
-    if (collector->_per_thread[thread_index]._nested_count == 0) {
+    if (collector->_per_thread[thread_index].inc_nested_count()) {
       // This collector wasn't already started in this thread; record a new
       // data point.
       if (thread->_thread_active) {
+        drain_ring(thread, get_real_time());
         thread->_frame_data.add_start(collector_index, as_of);
       }
     }
-    collector->_per_thread[thread_index]._nested_count++;
   }
 }
 
@@ -826,8 +909,43 @@ stop(int collector_index, int thread_index) {
   InternalThread *thread = get_thread_ptr(thread_index);
 
   if (collector->is_active() && thread->_is_active) {
+    if (PStatProfiler::is_running()) {
+      PStatProfiler::pop_collector(collector_index, thread_index);
+    }
+#ifdef DO_MEMORY_USAGE
+    if (MemoryUsage::is_counting_allocs()) {
+      stop_alloc_counter(collector, thread_index);
+    }
+#endif
+
+    PStatEventRing *ring = get_own_ring(thread, thread_index);
+    if (ring != (PStatEventRing *)NULL) {
+      // As in start(), we don't need the lock to time our own thread.
+      PerThreadData &ptd = collector->_per_thread[thread_index];
+      AtomicAdjust::Integer count = ptd.dec_nested_count();
+      if (count == 0) {
+        if (pstats_cat.is_debug()) {
+          pstats_cat.debug()
+            << "Collector " << get_collector_fullname(collector_index)
+            << " was already stopped in thread " << get_thread_name(thread_index)
+            << "!\n";
+        }
+        return;
+      }
+
+      if (count == 1 && thread->_thread_active) {
+        double now = get_real_time();
+        if (!ring->add_stop(collector_index, now)) {
+          add_overflow_event(thread, collector_index, false, now);
+        }
+      }
+      return;
+    }
+
     LightMutexHolder holder(thread->_thread_lock);
-    if (collector->_per_thread[thread_index]._nested_count == 0) {
+    AtomicAdjust::Integer count =
+      collector->_per_thread[thread_index].dec_nested_count();
+    if (count == 0) {
       if (pstats_cat.is_debug()) {
         pstats_cat.debug()
           << "Collector " << get_collector_fullname(collector_index)
@@ -837,13 +955,13 @@ stop(int collector_index, int thread_index) {
       return;
     }
 
-    collector->_per_thread[thread_index]._nested_count--;
-
-    if (collector->_per_thread[thread_index]._nested_count == 0) {
+    if (count == 1) {
       // This collector has now been completely stopped; record a new data
       // point.
       if (thread->_thread_active) {
-        thread->_frame_data.add_stop(collector_index, get_real_time());
+        double now = get_real_time();
+        drain_ring(thread, now);
+        thread->_frame_data.add_stop(collector_index, now);
       }
     }
   }
@@ -869,7 +987,9 @@ stop(int collector_index, int thread_index, double as_of) {
 
   if (collector->is_active() && thread->_is_active) {
     LightMutexHolder holder(thread->_thread_lock);
-    if (collector->_per_thread[thread_index]._nested_count == 0) {
+    AtomicAdjust::Integer count =
+      collector->_per_thread[thread_index].dec_nested_count();
+    if (count == 0) {
       if (pstats_cat.is_debug()) {
         pstats_cat.debug()
           << "Collector " << get_collector_fullname(collector_index)
@@ -879,11 +999,10 @@ stop(int collector_index, int thread_index, double as_of) {
       return;
     }
 
-    collector->_per_thread[thread_index]._nested_count--;
-
-    if (collector->_per_thread[thread_index]._nested_count == 0) {
+    if (count == 1) {
       // This collector has now been completely stopped; record a new data
       // point.
+      drain_ring(thread, get_real_time());
       thread->_frame_data.add_stop(collector_index, as_of);
     }
   }
@@ -1119,6 +1238,106 @@ add_thread(PStatClient::InternalThread *thread) {
   }
 }
 
+/**
+ * Creates the event ring for the indicated thread, which must be the calling
+ * thread, and returns it.
+ */
+PStatEventRing *PStatClient::
+make_ring(InternalThread *thread) {
+  LightMutexHolder holder(thread->_thread_lock);
+  if (thread->_ring == (PStatEventRing *)NULL) {
+    // Anything recorded before now is already in the frame data, ahead of
+    // anything that will go into the ring.
+    thread->_ring = new PStatEventRing(_ring_size);
+  }
+  return thread->_ring;
+}
+
+/**
+ * Called when the calling thread's event ring is full.  Makes room by
+ * draining the ring ourselves, and adds the event directly to the frame data
+ * behind the drained events.
+ */
+void PStatClient::
+add_overflow_event(InternalThread *thread, int collector_index,
+                   bool is_start, double time) {
+  LightMutexHolder holder(thread->_thread_lock);
+  drain_ring(thread, time);
+  if (is_start) {
+    thread->_frame_data.add_start(collector_index, time);
+  } else {
+    thread->_frame_data.add_stop(collector_index, time);
+  }
+}
+
+#ifdef DO_MEMORY_USAGE
+/**
+ * Called when a collector is started, while count-allocs-by-collector is in
+ * effect.  If the collector is being started by its own thread and was not
+ * already started, makes its allocation counter the current one for the
+ * thread, so that it is charged for the thread's allocations until it stops
+ * or another collector is started inside it.
+ */
+void PStatClient::
+start_alloc_counter(Collector *collector, int collector_index,
+                    int thread_index) {
+  if (Thread::get_current_thread()->get_pstats_index() != thread_index) {
+    return;
+  }
+  PerThreadData &ptd = collector->_per_thread[thread_index];
+  if (AtomicAdjust::get(ptd._nested_count) != 0) {
+    return;
+  }
+
+  if (AtomicAdjust::get(collector->_allocs_index) < 0) {
+    // The first time this collector is started by anyone, make the level
+    // collectors that will report its allocations.  They mirror the
+    // collector hierarchy, so that each parent shows the total of its
+    // children.
+    ReMutexHolder holder(_lock);
+    if (collector->_allocs_index < 0) {
+      string fullname = get_collector_fullname(collector_index);
+      PStatCollector allocs("Allocations:" + fullname, this);
+      PStatCollector allocated("Allocated:" + fullname, this);
+      collector->_allocated_index = allocated.get_index();
+      AtomicAdjust::set(collector->_allocs_index, allocs.get_index());
+    }
+  }
+
+  if (ptd._allocs == (MemoryUsage::AllocCounter *)NULL) {
+    // This is never freed, since the collector never goes away either.
+    ptd._allocs = new MemoryUsage::AllocCounter;
+    ptd._allocs->_count = 0;
+    ptd._allocs->_size = 0;
+  }
+  ptd._prev_allocs = MemoryUsage::set_alloc_counter(ptd._allocs);
+}
+
+/**
+ * Called when a collector is stopped, while count-allocs-by-collector is in
+ * effect.  Undoes the effect of start_alloc_counter() when the outermost
+ * start of the collector on its own thread is stopped.
+ */
+void PStatClient::
+stop_alloc_counter(Collector *collector, int thread_index) {
+  if (Thread::get_current_thread()->get_pstats_index() != thread_index) {
+    return;
+  }
+  PerThreadData &ptd = collector->_per_thread[thread_index];
+  if (AtomicAdjust::get(ptd._nested_count) != 1 ||
+      ptd._allocs == (MemoryUsage::AllocCounter *)NULL) {
+    return;
+  }
+
+  // If the collectors were not stopped in the reverse order they were
+  // started, the counter may no longer be ours; in that case, leave it
+  // alone rather than restoring the wrong one.
+  if (MemoryUsage::get_alloc_counter() == ptd._allocs) {
+    MemoryUsage::set_alloc_counter(ptd._prev_allocs);
+  }
+}
+#endif  // DO_MEMORY_USAGE
+
 /**
  * Called when the thread is deactivated (swapped for another running thread).
  * This is intended to provide a callback hook for PStats to assign time to
@@ -1139,7 +1358,14 @@ deactivate_hook(Thread *thread) {
     // Start _thread_block_pcollector, by hand, being careful not to grab any
     // mutexes while we do it.
     double now = _impl->get_real_time();
-    ithread->_frame_data.add_start(_thread_block_pcollector.get_index(), now);
+    int index = _thread_block_pcollector.get_index();
+    if (ithread->_ring == (PStatEventRing *)NULL ||
+        !ithread->_ring->add_start(index, now)) {
+      // The ring is full.  The events in it came first, so they must go
+      // into the frame data ahead of this one.
+      drain_ring(ithread, now);
+      ithread->_frame_data.add_start(index, now);
+    }
     ithread->_thread_active = false;
   }
 }
@@ -1162,7 +1388,13 @@ activate_hook(Thread *thread) {
 
   if (!ithread->_thread_active) {
     double now = _impl->get_real_time();
-    ithread->_frame_data.add_stop(_thread_block_pcollector.get_index(), now);
+    int index = _thread_block_pcollector.get_index();
+    if (ithread->_ring == (PStatEventRing *)NULL ||
+        !ithread->_ring->add_stop(index, now)) {
+      // As above, empty the ring first.
+      drain_ring(ithread, now);
+      ithread->_frame_data.add_stop(index, now);
+    }
     ithread->_thread_active = true;
   }
 }
@@ -1196,6 +1428,8 @@ InternalThread(Thread *thread) :
   _frame_number(0),
   _next_packet(0.0),
   _thread_active(true),
+  _ring(NULL),
+  _frame_start(0.0),
   _thread_lock(string("PStatClient::InternalThread ") + thread->get_name())
 {
 }
@@ -1212,6 +1446,8 @@ InternalThread(const string &name, const string &sync_name) :
   _frame_number(0),
   _next_packet(0.0),
   _thread_active(true),
+  _ring(NULL),
+  _frame_start(0.0),
   _thread_lock(string("PStatClient::InternalThread ") + name)
 {
 }
@@ -17,6 +17,7 @@
 #include "pandabase.h"
 
 #include "pStatFrameData.h"
+#include "pStatEventRing.h"
 #include "pStatCollectorDef.h"
 #include "reMutex.h"
 #include "lightMutex.h"
@@ -29,6 +30,7 @@
 #include "atomicAdjust.h"
 #include "numeric_types.h"
 #include "bitArray.h"
+#include "memoryUsage.h"
 
 class PStatClientImpl;
 class PStatCollector;
@@ -145,6 +147,18 @@ private:
   INLINE Collector *get_collector_ptr(int collector_index) const;
   INLINE InternalThread *get_thread_ptr(int thread_index) const;
 
+  INLINE PStatEventRing *get_own_ring(InternalThread *thread, int thread_index);
+  PStatEventRing *make_ring(InternalThread *thread);
+  void add_overflow_event(InternalThread *thread, int collector_index,
+                          bool is_start, double time);
+  INLINE void drain_ring(InternalThread *thread, double max_time);
+
+#ifdef DO_MEMORY_USAGE
+  void start_alloc_counter(Collector *collector, int collector_index,
+                           int thread_index);
+  void stop_alloc_counter(Collector *collector, int thread_index);
+#endif
+
   virtual void deactivate_hook(Thread *thread);
   virtual void activate_hook(Thread *thread);
 
@@ -161,9 +175,28 @@ private:
   class PerThreadData {
   public:
     PerThreadData();
+    INLINE bool inc_nested_count();
+    INLINE AtomicAdjust::Integer dec_nested_count();
+
     bool _has_level;
     double _level;
-    int _nested_count;
+
+    // The number of times the collector has been started in this thread
+    // without being stopped.  The thread changes this without the lock when
+    // it times itself, while other threads may change it with the lock held,
+    // so it is only ever changed atomically.
+    AtomicAdjust::Integer _nested_count;
+
+#ifdef DO_MEMORY_USAGE
+    // If count-allocs-by-collector is set, this counts the allocations made
+    // by this thread while this collector is the innermost one started.
+    // _prev_allocs is the counter to restore when the collector stops, and
+    // the other two are what was last reported to the server.
+    MemoryUsage::AllocCounter *_allocs;
+    MemoryUsage::AllocCounter *_prev_allocs;
+    size_t _reported_count;
+    size_t _reported_size;
+#endif
   };
   typedef pvector<PerThreadData> PerThread;
 
@@ -193,6 +226,14 @@ private:
     // Relations to other collectors.
     ThingsByName _children;
     PerThread _per_thread;
+
+#ifdef DO_MEMORY_USAGE
+    // The level collectors that report the allocations counted for this
+    // collector, or -1 if they have not been made yet.  _allocs_index is set
+    // last, once both exist.
+    AtomicAdjust::Integer _allocs_index;
+    int _allocated_index;
+#endif
   };
   typedef Collector *CollectorPointer;
   AtomicAdjust::Pointer _collectors;  // CollectorPointer *_collectors;
@@ -218,9 +259,16 @@ private:
     bool _thread_active;
     BitArray _active_collectors;  // no longer used.
 
+    // If pstats-ring-buffer-size is set, this is created the first time the
+    // thread times anything, and the thread records its start and stop
+    // events here.  _frame_start is the time the current frame began.
+    PStatEventRing *_ring;
+    double _frame_start;
+
     // This mutex is used to protect writes to _frame_data for this particular
     // thread, as well as writes to the _per_thread data for this particular
-    // thread in the Collector class, above.
+    // thread in the Collector class, above.  Whoever holds it may also drain
+    // _ring.
     LightMutex _thread_lock;
   };
   typedef InternalThread *ThreadPointer;
@@ -230,6 +278,10 @@ private:
 
   mutable PStatClientImpl *_impl;
 
+  // The capacity of each thread's event ring, or 0 if rings are not in use.
+  // This is set from pstats-ring-buffer-size when we connect.
+  int _ring_size;
+
   static PStatCollector _heap_total_size_pcollector;
   static PStatCollector _heap_overhead_size_pcollector;
   static PStatCollector _heap_single_size_pcollector;
@@ -242,6 +294,11 @@ private:
   static PStatCollector _mmap_nf_unused_size_pcollector;
   static PStatCollector _mmap_dc_active_other_size_pcollector;
   static PStatCollector _mmap_dc_inactive_other_size_pcollector;
+  static PStatCollector _alloc_total_size_pcollector;
+  static PStatCollector _alloc_in_use_size_pcollector;
+  static PStatCollector _alloc_thread_cache_size_pcollector;
+  static PStatCollector _alloc_central_cache_size_pcollector;
+  static PStatCollector _alloc_free_size_pcollector;
   static PStatCollector _pstats_pcollector;
   static PStatCollector _clock_wait_pcollector;
   static PStatCollector _clock_busy_wait_pcollector;
@@ -23,6 +23,7 @@
 #include "pStatThread.h"
 #include "config_pstats.h"
 #include "pStatProperties.h"
+#include "lightMutexHolder.h"
 #include "cmath.h"
 
 #include <algorithm>
@@ -42,13 +43,15 @@ PStatClientImpl(PStatClient *client) :
   _last_frame(0.0),
   _client(client),
   _reader(this, 0),
-  _writer(this, pstats_threaded_write ? 1 : 0)
+  _writer(this, pstats_threaded_write ? 1 : 0),
+  _drain_done(0)
 {
   _writer.set_max_queue_size(pstats_max_queue_size);
   _reader.set_tcp_header_size(4);
   _writer.set_tcp_header_size(4);
   _is_connected = false;
   _got_udp_port = false;
+  _is_capturing = false;
   _collectors_reported = 0;
   _threads_reported = 0;
 
@@ -88,38 +91,49 @@ bool PStatClientImpl::
 client_connect(string hostname, int port) {
   nassertr(!_is_connected, true);
 
-  if (hostname.empty()) {
-    hostname = pstats_host;
-  }
-  if (port < 0) {
-    port = pstats_port;
-  }
+  if (!pstats_capture_file.empty()) {
+    if (!open_capture(pstats_capture_file)) {
+      return false;
+    }
 
-  if (!_server.set_host(hostname, port)) {
-    pstats_cat.error()
-      << "Unknown host: " << hostname << "\n";
-    return false;
-  }
+  } else {
+    if (hostname.empty()) {
+      hostname = pstats_host;
+    }
+    if (port < 0) {
+      port = pstats_port;
+    }
 
-  _tcp_connection = open_TCP_client_connection(_server, 5000);
+    if (!_server.set_host(hostname, port)) {
+      pstats_cat.error()
+        << "Unknown host: " << hostname << "\n";
+      return false;
+    }
 
-  if (_tcp_connection.is_null()) {
-    pstats_cat.error()
-      << "Couldn't connect to PStatServer at " << hostname << ":"
-      << port << "\n";
-    return false;
-  }
-  // Make sure we're not queuing up multiple TCP sockets--we expect immediate
-  // writes of our TCP datagrams.
-  _tcp_connection->set_collect_tcp(false);
+    _tcp_connection = open_TCP_client_connection(_server, 5000);
 
-  _reader.add_connection(_tcp_connection);
-  _is_connected = true;
+    if (_tcp_connection.is_null()) {
+      pstats_cat.error()
+        << "Couldn't connect to PStatServer at " << hostname << ":"
+        << port << "\n";
+      return false;
+    }
+    // Make sure we're not queuing up multiple TCP sockets--we expect
+    // immediate writes of our TCP datagrams.
+    _tcp_connection->set_collect_tcp(false);
 
-  _udp_connection = open_UDP_connection();
+    _reader.add_connection(_tcp_connection);
+    _is_connected = true;
+
+    _udp_connection = open_UDP_connection();
+  }
 
   send_hello();
 
+  if (_client->_ring_size != 0) {
+    start_drain_thread();
+  }
+
 #ifdef DEBUG_THREADS
   MutexDebug::increment_pstats();
 #endif // DEBUG_THREADS
@@ -132,13 +146,21 @@ client_connect(string hostname, int port) {
  */
 void PStatClientImpl::
 client_disconnect() {
+  stop_drain_thread();
+
   if (_is_connected) {
 #ifdef DEBUG_THREADS
     MutexDebug::decrement_pstats();
 #endif // DEBUG_THREADS
-    _reader.remove_connection(_tcp_connection);
-    close_connection(_tcp_connection);
-    close_connection(_udp_connection);
+    if (_is_capturing) {
+      LightMutexHolder holder(_capture_lock);
+      _capture_file.close();
+      _is_capturing = false;
+    } else {
+      _reader.remove_connection(_tcp_connection);
+      close_connection(_tcp_connection);
+      close_connection(_udp_connection);
+    }
   }
 
   _tcp_connection.clear();
@@ -170,7 +192,7 @@ new_frame(int thread_index) {
 
   // If we've got the UDP port by the time the frame starts, it's time to
   // become active and start actually tracking data.
-  if (_got_udp_port) {
+  if (_got_udp_port || _is_capturing) {
     pthread->_is_active = true;
   }
 
@@ -178,43 +200,170 @@ new_frame(int thread_index) {
     return;
   }
 
-  double frame_start = get_real_time();
+  double frame_start;
   int frame_number = -1;
   PStatFrameData frame_data;
 
+  if (pthread->_ring != (PStatEventRing *)NULL) {
+    // The thread adds its events to its ring without holding its lock, so we
+    // take the ones recorded up to now, and mark the end of the frame and the
+    // start of the next one ourselves, rather than through stop() and
+    // start().
+    LightMutexHolder holder(pthread->_thread_lock);
+    frame_start = get_real_time();
+    pthread->_ring->drain(pthread->_frame_data, pthread->_frame_start,
+                          frame_start);
+
+    if (!pthread->_frame_data.is_empty()) {
+      pthread->_frame_data.add_stop(0, frame_start);
+      add_levels(pthread, thread_index);
+      pthread->_frame_data.swap(frame_data);
+      frame_number = pthread->_frame_number;
+    }
+
+    pthread->_frame_data.clear();
+    pthread->_frame_number++;
+    pthread->_frame_start = frame_start;
+    pthread->_frame_data.add_start(0, frame_start);
+
+  } else {
+    frame_start = get_real_time();
+    new_frame_data(pthread, thread_index, frame_start, frame_number,
+                   frame_data);
+  }
+
+  // Also record the time for the PStats operation itself.
+  int current_thread_index = Thread::get_current_thread()->get_pstats_index();
+  int pstats_index = PStatClient::_pstats_pcollector.get_index();
+  _client->start(pstats_index, current_thread_index, frame_start);
+
+  if (frame_number != -1) {
+    transmit_frame_data(thread_index, frame_number, frame_data);
+  }
+  _client->stop(pstats_index, current_thread_index, get_real_time());
+}
+
+/**
+ * Called by new_frame() to end the frame and start a new one on a thread
+ * that records its events directly in its frame data.  Fills in frame_data
+ * and frame_number with the frame that was ended, if any.
+ */
+void PStatClientImpl::
+new_frame_data(PStatClient::InternalThread *pthread, int thread_index,
+               double frame_start, int &frame_number,
+               PStatFrameData &frame_data) {
   if (!pthread->_frame_data.is_empty()) {
     // Collector 0 is the whole frame.
     _client->stop(0, thread_index, frame_start);
 
-    // Fill up the level data for all the collectors who have level data for
-    // this pthread.
-    int num_collectors = _client->_num_collectors;
-    PStatClient::CollectorPointer *collectors =
-      (PStatClient::CollectorPointer *)_client->_collectors;
-    for (int i = 0; i < num_collectors; i++) {
-      const PStatClient::PerThreadData &ptd =
-        collectors[i]->_per_thread[thread_index];
-      if (ptd._has_level) {
-        pthread->_frame_data.add_level(i, ptd._level);
-      }
-    }
+    add_levels(pthread, thread_index);
     pthread->_frame_data.swap(frame_data);
     frame_number = pthread->_frame_number;
   }
 
   pthread->_frame_data.clear();
   pthread->_frame_number++;
+  pthread->_frame_start = frame_start;
   _client->start(0, thread_index, frame_start);
+}
 
-  // Also record the time for the PStats operation itself.
-  int current_thread_index = Thread::get_current_thread()->get_pstats_index();
-  int pstats_index = PStatClient::_pstats_pcollector.get_index();
-  _client->start(pstats_index, current_thread_index, frame_start);
+/**
+ * Fills up the level data for all the collectors who have level data for
+ * the indicated thread.
+ */
+void PStatClientImpl::
+add_levels(PStatClient::InternalThread *pthread, int thread_index) {
+  int num_collectors = _client->_num_collectors;
+  PStatClient::CollectorPointer *collectors =
+    (PStatClient::CollectorPointer *)_client->_collectors;
+  for (int i = 0; i < num_collectors; i++) {
+    PStatClient::PerThreadData &ptd = collectors[i]->_per_thread[thread_index];
+    if (ptd._has_level) {
+      pthread->_frame_data.add_level(i, ptd._level);
+    }
 
-  if (frame_number != -1) {
-    transmit_frame_data(thread_index, frame_number, frame_data);
+#ifdef DO_MEMORY_USAGE
+    if (ptd._allocs != (MemoryUsage::AllocCounter *)NULL) {
+      // Report what the thread allocated under this collector since the last
+      // frame.  The counter belongs to the thread, which may be adding to it
+      // right now; at worst, we miss a few of its allocations until the next
+      // frame.
+      size_t count = ptd._allocs->_count;
+      size_t size = ptd._allocs->_size;
+      int allocs_index = (int)AtomicAdjust::get(collectors[i]->_allocs_index);
+      pthread->_frame_data.add_level(allocs_index,
+                                     (double)(count - ptd._reported_count));
+      pthread->_frame_data.add_level(collectors[i]->_allocated_index,
+                                     (double)(size - ptd._reported_size));
+      ptd._reported_count = count;
+      ptd._reported_size = size;
+    }
+#endif
+  }
+}
+
+/**
+ * Starts the thread that drains the threads' event rings, if it is wanted and
+ * threading is available.
+ */
+void PStatClientImpl::
+start_drain_thread() {
+  if (_drain_thread != (GenericThread *)NULL ||
+      pstats_drain_interval <= 0.0 || !Thread::is_threading_supported()) {
+    return;
+  }
+
+  AtomicAdjust::set(_drain_done, 0);
+  _drain_thread = new GenericThread("PStats drain", "PStats drain",
+                                    &drain_thread_main, this);
+  if (!_drain_thread->start(TP_low, true)) {
+    _drain_thread.clear();
+  }
+}
+
+/**
+ * Stops the drain thread, if it is running, and waits for it to finish.
+ */
+void PStatClientImpl::
+stop_drain_thread() {
+  if (_drain_thread != (GenericThread *)NULL) {
+    AtomicAdjust::set(_drain_done, 1);
+    _drain_thread->join();
+    _drain_thread.clear();
+  }
+}
+
+/**
+ * The body of the drain thread.
+ */
+void PStatClientImpl::
+drain_thread_main(void *data) {
+  PStatClientImpl *self = (PStatClientImpl *)data;
+  double interval = pstats_drain_interval;
+  while (!AtomicAdjust::get(self->_drain_done)) {
+    Thread::sleep(interval);
+    self->drain_rings();
+  }
+}
+
+/**
+ * Moves the waiting events out of each thread's ring and into its frame
+ * data, so that the rings seldom fill up.  Called periodically by the drain
+ * thread.
+ */
+void PStatClientImpl::
+drain_rings() {
+  int num_threads = AtomicAdjust::get(_client->_num_threads);
+  for (int ti = 0; ti < num_threads; ++ti) {
+    PStatClient::InternalThread *pthread = _client->get_thread_ptr(ti);
+    PStatEventRing *ring = pthread->_ring;
+    if (ring != (PStatEventRing *)NULL && pthread->_is_active &&
+        !ring->is_empty()) {
+      LightMutexHolder holder(pthread->_thread_lock);
+      ring->drain(pthread->_frame_data, pthread->_frame_start,
+                  get_real_time());
+    }
   }
-  _client->stop(pstats_index, current_thread_index, get_real_time());
 }
 
 /**
@@ -235,7 +384,7 @@ add_frame(int thread_index, const PStatFrameData &frame_data) {
 
   // If we've got the UDP port by the time the frame starts, it's time to
   // become active and start actually tracking data.
-  if (_got_udp_port) {
+  if (_got_udp_port || _is_capturing) {
     pthread->_is_active = true;
   }
 
@@ -266,6 +415,17 @@ transmit_frame_data(int thread_index, int frame_number,
   nassertv(thread_index >= 0 && thread_index < _client->_num_threads);
   PStatClient::InternalThread *thread = _client->get_thread_ptr(thread_index);
   if (_is_connected && thread->_is_active) {
+    if (_is_capturing) {
+      // Every frame goes into the capture file; there's no server to flood.
+      Datagram datagram;
+      datagram.add_uint8(0);
+      datagram.add_uint16(thread_index);
+      datagram.add_uint32(frame_number);
+      if (frame_data.write_datagram(datagram, _client)) {
+        write_capture(datagram);
+      }
+      return;
+    }
 
     // We don't want to send too many packets in a hurry and flood the server.
     // Check that enough time has elapsed for us to send a new packet.  If
@@ -369,6 +529,53 @@ transmit_control_data() {
 }
 
 
+/**
+ * Opens the indicated file to receive the frame data, in place of a
+ * connection to a server.  Returns true on success.
+ */
+bool PStatClientImpl::
+open_capture(const Filename &filename) {
+  Filename capture_filename = filename;
+  capture_filename.set_binary();
+
+  LightMutexHolder holder(_capture_lock);
+  if (!_capture_file.open(capture_filename) ||
+      !_capture_file.write_header(get_pstat_capture_header())) {
+    pstats_cat.error()
+      << "Couldn't open PStats capture file " << capture_filename << "\n";
+    _capture_file.close();
+    return false;
+  }
+
+  pstats_cat.info()
+    << "Capturing PStats data to " << capture_filename << "\n";
+  _is_connected = true;
+  _is_capturing = true;
+  return true;
+}
+
+/**
+ * Appends the indicated message to the capture file.  Returns true on
+ * success.
+ */
+bool PStatClientImpl::
+write_capture(const Datagram &datagram) {
+  LightMutexHolder holder(_capture_lock);
+  if (!_is_capturing) {
+    // We were disconnected in the meantime.
+    return false;
+  }
+
+  if (!_capture_file.put_datagram(datagram)) {
+    if (pstats_cat.is_debug()) {
+      pstats_cat.debug()
+        << "Couldn't write to capture file.\n";
+    }
+    return false;
+  }
+  return true;
+}
+
 /**
  * Returns the current machine's hostname.
  */
@@ -401,7 +608,20 @@ send_hello() {
 
   Datagram datagram;
   message.encode(datagram);
-  _writer.send(datagram, _tcp_connection, true);
+  send_control_datagram(datagram);
+}
+
+/**
+ * Sends a control message to the server over TCP, or writes it to the capture
+ * file.
+ */
+void PStatClientImpl::
+send_control_datagram(const Datagram &datagram) {
+  if (_is_capturing) {
+    write_capture(datagram);
+  } else {
+    _writer.send(datagram, _tcp_connection, true);
+  }
 }
 
 /**
@@ -428,7 +648,7 @@ report_new_collectors() {
 
     Datagram datagram;
     message.encode(datagram);
-    _writer.send(datagram, _tcp_connection, true);
+    send_control_datagram(datagram);
   }
 }
 
@@ -451,7 +671,7 @@ report_new_threads() {
 
     Datagram datagram;
     message.encode(datagram);
-    _writer.send(datagram, _tcp_connection, true);
+    send_control_datagram(datagram);
   }
 }
 
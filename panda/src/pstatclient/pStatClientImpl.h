@@ -20,6 +20,7 @@
 #ifdef DO_PSTATS
 
 #include "pStatFrameData.h"
+#include "pStatClient.h"
 #include "connectionManager.h"
 #include "queuedConnectionReader.h"
 #include "connectionWriter.h"
@@ -27,6 +28,10 @@
 
 #include "trueClock.h"
 #include "pmap.h"
+#include "genericThread.h"
+#include "atomicAdjust.h"
+#include "datagramOutputFile.h"
+#include "lightMutex.h"
 
 class PStatClient;
 class PStatServerControlMessage;
@@ -69,6 +74,16 @@ public:
   void add_frame(int thread_index, const PStatFrameData &frame_data);
 
 private:
+  void new_frame_data(PStatClient::InternalThread *pthread, int thread_index,
+                      double frame_start, int &frame_number,
+                      PStatFrameData &frame_data);
+  void add_levels(PStatClient::InternalThread *pthread, int thread_index);
+
+  void start_drain_thread();
+  void stop_drain_thread();
+  static void drain_thread_main(void *data);
+  void drain_rings();
+
   void transmit_frame_data(int thread_index, int frame_number,
                            const PStatFrameData &frame_data);
 
@@ -78,9 +93,18 @@ private:
   double _delta;
   double _last_frame;
 
+  // This thread periodically moves the events out of each thread's ring, if
+  // the threads are using them.
+  PT(GenericThread) _drain_thread;
+  AtomicAdjust::Integer _drain_done;
+
+  bool open_capture(const Filename &filename);
+  bool write_capture(const Datagram &datagram);
+
   // Networking stuff
   string get_hostname();
   void send_hello();
+  void send_control_datagram(const Datagram &datagram);
   void report_new_collectors();
   void report_new_threads();
   void handle_server_control_message(const PStatServerControlMessage &message);
@@ -93,6 +117,12 @@ private:
   bool _is_connected;
   bool _got_udp_port;
 
+  // If pstats-capture-file is set, everything we would have sent to the
+  // server goes into this file instead.
+  bool _is_capturing;
+  DatagramOutputFile _capture_file;
+  LightMutex _capture_lock;
+
   NetAddress _server;
   QueuedConnectionReader _reader;
   ConnectionWriter _writer;
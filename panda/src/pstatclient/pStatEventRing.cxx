@@ -0,0 +1,85 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file pStatEventRing.cxx
+ * @date 2026-10-19
+ */
+
+#include "pStatEventRing.h"
+#include "pStatFrameData.h"
+
+/**
+ * Creates a ring with room for at least the indicated number of events.
+ */
+PStatEventRing::
+PStatEventRing(int capacity) {
+  int size = 16;
+  while (size < capacity && size < (1 << 24)) {
+    size <<= 1;
+  }
+
+  _head = 0;
+  _cached_tail = 0;
+  _tail = 0;
+  _mask = size - 1;
+  _wrap = size * 2 - 1;
+  _events = (Event *)PANDA_MALLOC_ARRAY(size * sizeof(Event));
+}
+
+/**
+ *
+ */
+PStatEventRing::
+~PStatEventRing() {
+  PANDA_FREE_ARRAY(_events);
+}
+
+/**
+ * Moves the waiting events to the end of the indicated frame data, and
+ * returns the number of events moved.  The first event timestamped after
+ * max_time, and all that follow it, are left behind to be drained into the
+ * next frame.  Any event timestamped before min_time is moved up to
+ * min_time, since it was recorded too late to make it into the previous
+ * frame.
+ *
+ * Only one thread at a time may call this.
+ */
+int PStatEventRing::
+drain(PStatFrameData &dest, double min_time, double max_time) {
+  AtomicAdjust::Integer tail = _tail;
+  AtomicAdjust::Integer head = AtomicAdjust::get(_head);
+
+  int count = 0;
+  while (tail != head) {
+    const Event &event = _events[tail & _mask];
+    if (event._time > max_time) {
+      break;
+    }
+    double time = max(event._time, min_time);
+    if (event._index & 0x8000) {
+      dest.add_stop(event._index & 0x7fff, time);
+    } else {
+      dest.add_start(event._index, time);
+    }
+    tail = (tail + 1) & _wrap;
+    ++count;
+  }
+
+  // This tells the writer that the slots may be reused.
+  publish(_tail, tail);
+  return count;
+}
+
+/**
+ * Throws away all of the waiting events.  This counts as draining the ring,
+ * so only one thread at a time may call this, or drain().
+ */
+void PStatEventRing::
+clear() {
+  AtomicAdjust::set(_tail, AtomicAdjust::get(_head));
+}
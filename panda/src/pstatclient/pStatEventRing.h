@@ -0,0 +1,77 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file pStatEventRing.h
+ * @date 2026-10-19
+ */
+
+#ifndef PSTATEVENTRING_H
+#define PSTATEVENTRING_H
+
+#include "pandabase.h"
+#include "atomicAdjust.h"
+
+class PStatFrameData;
+
+/**
+ * A fixed-size ring of start and stop events, recorded by one thread and
+ * collected by another, without either of them taking a lock.  Each thread
+ * that PStatClient times gets one of these when pstats-ring-buffer-size is
+ * nonzero; the thread adds its own events to it, and they are moved into the
+ * thread's PStatFrameData by whoever holds the thread's lock, either at the
+ * end of the frame or periodically by the PStats drain thread.
+ *
+ * Only one thread may add events, and only one thread at a time may drain
+ * them.  Adding an event is a couple of stores and one atomic write, and
+ * never allocates memory; if the ring is full, it fails, and the caller must
+ * drain the ring itself.
+ */
+class EXPCL_PANDA_PSTATCLIENT PStatEventRing {
+public:
+  PStatEventRing(int capacity);
+  ~PStatEventRing();
+
+  INLINE bool add_start(int index, double time);
+  INLINE bool add_stop(int index, double time);
+
+  INLINE int get_capacity() const;
+  INLINE bool is_empty() const;
+
+  int drain(PStatFrameData &dest, double min_time, double max_time);
+  void clear();
+
+private:
+  INLINE bool push(int index, double time);
+  INLINE static void publish(AtomicAdjust::Integer &var,
+                             AtomicAdjust::Integer value);
+
+  class Event {
+  public:
+    int _index;
+    double _time;
+  };
+
+  // The writing thread owns _head and its copy of _tail, and the reading
+  // thread owns _tail.  They are kept apart so that the two threads don't
+  // fight over the same cache line.
+  AtomicAdjust::Integer _head;
+  AtomicAdjust::Integer _cached_tail;
+  char _pad0[64 - 2 * sizeof(AtomicAdjust::Integer)];
+  AtomicAdjust::Integer _tail;
+  char _pad1[64 - sizeof(AtomicAdjust::Integer)];
+
+  // The positions count up to twice the capacity before wrapping around, so
+  // that a full ring can be told apart from an empty one.
+  AtomicAdjust::Integer _mask;
+  AtomicAdjust::Integer _wrap;
+  Event *_events;
+};
+
+#include "pStatEventRing.I"
+
+#endif
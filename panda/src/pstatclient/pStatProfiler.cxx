@@ -0,0 +1,428 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file pStatProfiler.cxx
+ * @date 2026-10-19
+ */
+
+#include "pStatProfiler.h"
+#include "pStatClient.h"
+#include "config_pstats.h"
+#include "thread.h"
+#include "filename.h"
+#include "pmap.h"
+#include "pvector.h"
+
+#include <algorithm>
+#include <stdio.h>
+
+#if defined(DO_PSTATS) && defined(__linux__)
+#define HAVE_PSTATS_SAMPLING
+#endif
+
+#ifdef HAVE_PSTATS_SAMPLING
+#include <signal.h>
+#include <errno.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#include <dlfcn.h>
+#include <cxxabi.h>
+#endif
+
+bool PStatProfiler::_running = false;
+AtomicAdjust::Integer PStatProfiler::_generation = 0;
+AtomicAdjust::Integer PStatProfiler::_num_samples = 0;
+AtomicAdjust::Integer PStatProfiler::_num_dropped = 0;
+PStatProfiler::Sample *PStatProfiler::_samples = NULL;
+
+// The number of different function and collector pairs that can be told
+// apart.  Samples that don't fit are counted as dropped.
+static const int num_sample_slots = 1 << 16;
+static const int max_probes = 64;
+
+#ifdef HAVE_PSTATS_SAMPLING
+
+// Each thread keeps its own stack of the collectors it has started, so that
+// the signal handler knows what the interrupted thread was doing.  The
+// initial-exec model keeps these in static TLS, which the signal handler may
+// safely read even in a dynamically loaded library.
+#define SAMPLE_TLS __thread __attribute__((tls_model("initial-exec")))
+static const int max_stack_depth = 32;
+static SAMPLE_TLS int collector_stack[max_stack_depth];
+static SAMPLE_TLS int stack_depth = 0;
+static SAMPLE_TLS AtomicAdjust::Integer stack_generation = 0;
+
+static struct sigaction prev_action;
+
+/**
+ * Returns the address of the instruction that was interrupted.
+ */
+static void *
+get_interrupted_pc(void *context) {
+  ucontext_t *uc = (ucontext_t *)context;
+#if defined(__x86_64__)
+  return (void *)uc->uc_mcontext.gregs[REG_RIP];
+#elif defined(__i386__)
+  return (void *)uc->uc_mcontext.gregs[REG_EIP];
+#elif defined(__aarch64__)
+  return (void *)uc->uc_mcontext.pc;
+#elif defined(__arm__)
+  return (void *)uc->uc_mcontext.arm_pc;
+#else
+  return NULL;
+#endif
+}
+
+/**
+ * The SIGPROF handler.  It may interrupt any thread at any point, so it only
+ * reads the thread's own collector stack and updates the sample table with
+ * atomic operations.
+ */
+static void
+handle_sigprof(int, siginfo_t *, void *context) {
+  int saved_errno = errno;
+  PStatProfiler::record_sample(get_interrupted_pc(context));
+  errno = saved_errno;
+}
+
+/**
+ * Makes sure the calling thread's collector stack belongs to the current run
+ * of the profiler, emptying it if it was left over from an earlier one.
+ */
+static inline void
+check_stack_generation(AtomicAdjust::Integer generation) {
+  if (stack_generation != generation) {
+    stack_depth = 0;
+    stack_generation = generation;
+  }
+}
+
+#endif  // HAVE_PSTATS_SAMPLING
+
+/**
+ * Starts taking the indicated number of samples per second of CPU time used
+ * by the process.  Returns true on success, or false if sampling isn't
+ * available.  Samples taken before are kept; call clear() to start afresh.
+ */
+bool PStatProfiler::
+start(double frequency) {
+#ifdef HAVE_PSTATS_SAMPLING
+  nassertr(frequency > 0.0, false);
+  if (_running) {
+    stop();
+  }
+
+  if (_samples == (Sample *)NULL) {
+    // This is never freed, since a signal might still be on its way after
+    // stop().
+    _samples = (Sample *)PANDA_MALLOC_ARRAY(num_sample_slots * sizeof(Sample));
+    memset(_samples, 0, num_sample_slots * sizeof(Sample));
+  }
+
+  // Look up a symbol now, so that dladdr() and friends have done their lazy
+  // setup before any signal arrives.
+  Dl_info info;
+  dladdr((void *)&start, &info);
+
+  AtomicAdjust::inc(_generation);
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_sigaction = &handle_sigprof;
+  action.sa_flags = SA_SIGINFO | SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  if (sigaction(SIGPROF, &action, &prev_action) != 0) {
+    pstats_cat.error()
+      << "Couldn't install SIGPROF handler.\n";
+    return false;
+  }
+
+  long usec = max((long)(1000000.0 / frequency), 1L);
+  struct itimerval timer;
+  timer.it_interval.tv_sec = usec / 1000000;
+  timer.it_interval.tv_usec = usec % 1000000;
+  timer.it_value = timer.it_interval;
+
+  _running = true;
+  if (setitimer(ITIMER_PROF, &timer, NULL) != 0) {
+    _running = false;
+    sigaction(SIGPROF, &prev_action, NULL);
+    pstats_cat.error()
+      << "Couldn't start the profiling timer.\n";
+    return false;
+  }
+
+  if (pstats_cat.is_debug()) {
+    pstats_cat.debug()
+      << "Sampling at " << frequency << " Hz\n";
+  }
+  return true;
+
+#else
+  pstats_cat.warning()
+    << "Sampling profiler is not available on this platform.\n";
+  return false;
+#endif  // HAVE_PSTATS_SAMPLING
+}
+
+/**
+ * Stops taking samples.  The samples taken so far are kept.
+ */
+void PStatProfiler::
+stop() {
+#ifdef HAVE_PSTATS_SAMPLING
+  if (!_running) {
+    return;
+  }
+
+  struct itimerval timer;
+  memset(&timer, 0, sizeof(timer));
+  setitimer(ITIMER_PROF, &timer, NULL);
+
+  // Rather than restoring the previous handler, which might terminate the
+  // process if a last signal is still pending, we ignore any stragglers.
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = SIG_IGN;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGPROF, &action, NULL);
+
+  _running = false;
+#endif  // HAVE_PSTATS_SAMPLING
+}
+
+/**
+ * Throws away the samples taken so far.  Does nothing while the profiler is
+ * running.
+ */
+void PStatProfiler::
+clear() {
+  nassertv(!_running);
+  if (_samples != (Sample *)NULL) {
+    memset(_samples, 0, num_sample_slots * sizeof(Sample));
+  }
+  AtomicAdjust::set(_num_samples, 0);
+  AtomicAdjust::set(_num_dropped, 0);
+}
+
+/**
+ * Returns the number of samples taken since the last clear(), including any
+ * that were dropped.
+ */
+int PStatProfiler::
+get_num_samples() {
+  return (int)AtomicAdjust::get(_num_samples);
+}
+
+/**
+ * Writes a report of the samples taken so far: for each collector, the
+ * number of samples taken while it was the innermost one running, and the
+ * functions that were running most often at the time.
+ */
+void PStatProfiler::
+write(ostream &out, int max_functions) {
+  int num_samples = get_num_samples();
+  int num_dropped = (int)AtomicAdjust::get(_num_dropped);
+  out << num_samples << " samples";
+  if (num_dropped != 0) {
+    out << " (" << num_dropped << " dropped)";
+  }
+  out << "\n";
+
+#ifdef HAVE_PSTATS_SAMPLING
+  if (_samples == (Sample *)NULL || num_samples == 0) {
+    return;
+  }
+
+  // Add up the samples by collector, and by function within each collector.
+  typedef pmap<string, int> Functions;
+  typedef pmap<int, Functions> Collectors;
+  Collectors collectors;
+  pmap<int, int> totals;
+
+  for (int i = 0; i < num_sample_slots; ++i) {
+    const Sample &sample = _samples[i];
+    void *pc = AtomicAdjust::get_ptr(sample._pc);
+    int count = (int)AtomicAdjust::get(sample._count);
+    if (pc == NULL || count == 0) {
+      continue;
+    }
+    int collector_index = (int)AtomicAdjust::get(sample._collector) - 2;
+
+    string name;
+    Dl_info info;
+    if (dladdr(pc, &info) != 0 && info.dli_sname != NULL) {
+      int status = -1;
+      char *demangled =
+        abi::__cxa_demangle(info.dli_sname, NULL, NULL, &status);
+      if (status == 0 && demangled != NULL) {
+        name = demangled;
+      } else {
+        name = info.dli_sname;
+      }
+      free(demangled);
+
+    } else {
+      ostringstream strm;
+      if (dladdr(pc, &info) != 0 && info.dli_fname != NULL) {
+        strm << Filename::from_os_specific(info.dli_fname).get_basename()
+             << "+0x" << hex
+             << (size_t)((char *)pc - (char *)info.dli_fbase);
+      } else {
+        strm << pc;
+      }
+      name = strm.str();
+    }
+
+    collectors[collector_index][name] += count;
+    totals[collector_index] += count;
+  }
+
+  // List the collectors with the most samples first.
+  pvector<pair<int, int> > order;
+  pmap<int, int>::const_iterator ti;
+  for (ti = totals.begin(); ti != totals.end(); ++ti) {
+    order.push_back(pair<int, int>(-(*ti).second, (*ti).first));
+  }
+  sort(order.begin(), order.end());
+
+  PStatClient *client = PStatClient::get_global_pstats();
+  for (size_t ci = 0; ci < order.size(); ++ci) {
+    int collector_index = order[ci].second;
+    int collector_total = -order[ci].first;
+
+    out << "\n";
+    if (collector_index >= 0 &&
+        collector_index < client->get_num_collectors()) {
+      out << client->get_collector_fullname(collector_index);
+    } else {
+      out << "(no collector)";
+    }
+    out << ": " << collector_total << " samples, "
+        << collector_total * 100 / num_samples << "%\n";
+
+    const Functions &functions = collectors[collector_index];
+    pvector<pair<int, string> > hot;
+    Functions::const_iterator fi;
+    for (fi = functions.begin(); fi != functions.end(); ++fi) {
+      hot.push_back(pair<int, string>(-(*fi).second, (*fi).first));
+    }
+    sort(hot.begin(), hot.end());
+
+    for (int hi = 0; hi < (int)hot.size() && hi < max_functions; ++hi) {
+      char formatted[32];
+      sprintf(formatted, "  %5.1f%% %8d  ",
+              -hot[hi].first * 100.0 / collector_total, -hot[hi].first);
+      out << formatted << hot[hi].second << "\n";
+    }
+  }
+#endif  // HAVE_PSTATS_SAMPLING
+}
+
+/**
+ * Called by PStatClient when a collector is started, while the profiler is
+ * running.  If the collector is being started in the calling thread, it
+ * becomes the one that the thread's samples are counted against.
+ */
+void PStatProfiler::
+push_collector(int collector_index, int thread_index) {
+#ifdef HAVE_PSTATS_SAMPLING
+  if (Thread::get_current_thread()->get_pstats_index() != thread_index) {
+    return;
+  }
+  check_stack_generation(AtomicAdjust::get(_generation));
+
+  int depth = stack_depth;
+  if (depth < max_stack_depth) {
+    collector_stack[depth] = collector_index;
+  }
+  // The signal handler may look at the stack at any point, so the new entry
+  // must be in place before the depth says so.
+  __atomic_signal_fence(__ATOMIC_SEQ_CST);
+  stack_depth = depth + 1;
+#endif  // HAVE_PSTATS_SAMPLING
+}
+
+/**
+ * Called by PStatClient when a collector is stopped, while the profiler is
+ * running.
+ */
+void PStatProfiler::
+pop_collector(int collector_index, int thread_index) {
+#ifdef HAVE_PSTATS_SAMPLING
+  if (Thread::get_current_thread()->get_pstats_index() != thread_index) {
+    return;
+  }
+  check_stack_generation(AtomicAdjust::get(_generation));
+
+  int depth = stack_depth;
+  if (depth > max_stack_depth) {
+    // We lost track of the collectors this deep; just count down.
+    stack_depth = depth - 1;
+    return;
+  }
+
+  // Collectors are usually stopped in the reverse order they were started,
+  // but if not, we drop everything started after this one.  A collector
+  // that was started before the profiler was isn't on the stack at all.
+  for (int i = depth - 1; i >= 0; --i) {
+    if (collector_stack[i] == collector_index) {
+      stack_depth = i;
+      return;
+    }
+  }
+#endif  // HAVE_PSTATS_SAMPLING
+}
+
+/**
+ * Counts a sample of the indicated instruction against the innermost
+ * collector of the calling thread.  Called from the signal handler, so it
+ * must not allocate memory or take a lock.
+ */
+void PStatProfiler::
+record_sample(void *pc) {
+#ifdef HAVE_PSTATS_SAMPLING
+  AtomicAdjust::inc(_num_samples);
+  if (pc == NULL || _samples == (Sample *)NULL) {
+    AtomicAdjust::inc(_num_dropped);
+    return;
+  }
+
+  // A slot's collector is 0 until whoever claimed the slot stores it, so the
+  // collectors are stored plus two, which makes -1, for no collector, 1.
+  int collector_index = -1;
+  if (stack_generation == AtomicAdjust::get(_generation) && stack_depth > 0) {
+    int depth = min((int)stack_depth, max_stack_depth);
+    collector_index = collector_stack[depth - 1];
+  }
+  AtomicAdjust::Integer collector = collector_index + 2;
+
+  size_t hash = ((size_t)pc >> 2) * 2654435761u + (size_t)collector * 40503u;
+  for (int probe = 0; probe < max_probes; ++probe) {
+    Sample &sample = _samples[(hash + probe) & (num_sample_slots - 1)];
+    void *slot_pc = AtomicAdjust::get_ptr(sample._pc);
+    if (slot_pc == NULL) {
+      slot_pc = AtomicAdjust::compare_and_exchange_ptr(sample._pc, NULL, pc);
+      if (slot_pc == NULL) {
+        // We claimed this slot.  Another thread that finds it before we have
+        // stored the collector will claim a slot of its own; write() adds
+        // them together.
+        AtomicAdjust::set(sample._collector, collector);
+        AtomicAdjust::inc(sample._count);
+        return;
+      }
+    }
+    if (slot_pc == pc && AtomicAdjust::get(sample._collector) == collector) {
+      AtomicAdjust::inc(sample._count);
+      return;
+    }
+  }
+
+  AtomicAdjust::inc(_num_dropped);
+#endif  // HAVE_PSTATS_SAMPLING
+}
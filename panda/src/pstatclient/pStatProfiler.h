@@ -0,0 +1,65 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file pStatProfiler.h
+ * @date 2026-10-19
+ */
+
+#ifndef PSTATPROFILER_H
+#define PSTATPROFILER_H
+
+#include "pandabase.h"
+#include "atomicAdjust.h"
+
+/**
+ * A sampling CPU profiler that finds the time spent in code that has no
+ * collectors of its own.  While it runs, the process is interrupted many
+ * times a second of CPU time, and each interruption is counted against the
+ * function that was running and the innermost collector that the running
+ * thread had started.  write() then lists, for each collector, the functions
+ * that took the most of its time.
+ *
+ * This only works on Linux, and only while a PStatClient is connected, since
+ * that is when collectors are started and stopped.  It is started
+ * automatically on connect if pstats-sample-frequency is set.  Functions are
+ * named as dladdr() finds them, so a program built without -rdynamic may
+ * have its own static functions credited to a nearby exported function.
+ */
+class EXPCL_PANDA_PSTATCLIENT PStatProfiler {
+PUBLISHED:
+  static bool start(double frequency);
+  static void stop();
+  INLINE static bool is_running();
+
+  static void clear();
+  static int get_num_samples();
+  static void write(ostream &out, int max_functions = 10);
+
+public:
+  static void push_collector(int collector_index, int thread_index);
+  static void pop_collector(int collector_index, int thread_index);
+  static void record_sample(void *pc);
+
+private:
+  class Sample {
+  public:
+    AtomicAdjust::Pointer _pc;
+    AtomicAdjust::Integer _collector;
+    AtomicAdjust::Integer _count;
+  };
+
+  static bool _running;
+  static AtomicAdjust::Integer _generation;
+  static AtomicAdjust::Integer _num_samples;
+  static AtomicAdjust::Integer _num_dropped;
+  static Sample *_samples;
+};
+
+#include "pStatProfiler.I"
+
+#endif
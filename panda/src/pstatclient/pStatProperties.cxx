@@ -29,6 +29,10 @@ static const int current_pstat_minor_version = 0;
 // Incremented to 2.1 on 52101 to add support for TCP frame data.  Incremented
 // to 3.0 on 42805 to bump TCP headers to 32 bits.
 
+// The first bytes of a PStats capture file.
+static const char capture_header[] = "pst\0\n\r";
+static const size_t capture_header_size = 6;
+
 /**
  * Returns the current major version number of the PStats protocol.  This is
  * the version number that will be reported by clients running this code, and
@@ -55,6 +59,17 @@ get_current_pstat_minor_version() {
   return current_pstat_minor_version;
 }
 
+/**
+ * Returns the string that begins a file written by a PStatClient when pstats-
+ * capture-file is set.  The rest of the file is the same sequence of
+ * messages the client would otherwise have sent to a server over TCP,
+ * starting with the greeting, each stored as a length-prefixed datagram.
+ */
+string
+get_pstat_capture_header() {
+  return string(capture_header, capture_header_size);
+}
+
 
 #ifdef DO_PSTATS
 
@@ -196,6 +211,13 @@ static LevelCollectorProperties level_properties[] = {
   { 1, "System memory:Heap:Overhead",      { 0.9, 0.7, 0.8 } },
   { 1, "System memory:Heap:External",      { 0.2, 0.2, 0.5 } },
   { 1, "System memory:MMap",               { 0.9, 0.4, 0.7 } },
+  { 1, "Allocator",                        { 0.4, 0.7, 0.9 },  "MB", 64, 1048576 },
+  { 1, "Allocator:In use",                 { 0.8, 0.3, 0.3 } },
+  { 1, "Allocator:Thread caches",          { 0.3, 0.8, 0.3 } },
+  { 1, "Allocator:Central caches",         { 0.2, 0.4, 0.9 } },
+  { 1, "Allocator:Free pages",             { 0.7, 0.7, 0.7 } },
+  { 1, "Allocations",                      { 0.9, 0.6, 0.2 },  "", 1000 },
+  { 1, "Allocated",                        { 0.6, 0.2, 0.9 },  "KB", 256, 1024 },
   { 1, "Vertex Data",                      { 1.0, 0.4, 0.0 },  "MB", 64, 1048576 },
   { 1, "Vertex Data:Independent",          { 0.9, 0.1, 0.9 } },
   { 1, "Vertex Data:Small",                { 0.2, 0.3, 0.4 } },
@@ -218,6 +240,9 @@ static LevelCollectorProperties level_properties[] = {
   { 1, "Collision Volumes",                { 1.0, 0.8, 0.5 },  "", 500 },
   { 1, "Collision Tests",                  { 0.5, 0.8, 1.0 },  "", 100 },
   { 1, "Command latency",                  { 0.8, 0.2, 0.0 },  "ms", 10, 1.0 / 1000.0 },
+  { 1, "Task graph",                       { 0.3, 0.6, 0.9 },  "ms", 20, 1.0 / 1000.0 },
+  { 1, "Net:UDP receive batch",            { 0.3, 0.7, 0.3 },  "", 64 },
+  { 1, "Net:UDP send batch",               { 0.7, 0.3, 0.7 },  "", 64 },
   { 0, NULL }
 };
 
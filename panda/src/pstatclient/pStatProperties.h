@@ -22,6 +22,7 @@ class PStatCollectorDef;
 
 EXPCL_PANDA_PSTATCLIENT int get_current_pstat_major_version();
 EXPCL_PANDA_PSTATCLIENT int get_current_pstat_minor_version();
+EXPCL_PANDA_PSTATCLIENT string get_pstat_capture_header();
 
 #ifdef DO_PSTATS
 void initialize_collector_def(const PStatClient *client, PStatCollectorDef *def);
@@ -0,0 +1,262 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_overhead.cxx
+ * @date 2026-10-19
+ */
+
+#include "config_pstats.h"
+#include "pStatClient.h"
+#include "pStatCollector.h"
+#include "pStatServerControlMessage.h"
+#include "genericThread.h"
+#include "trueClock.h"
+#include "atomicAdjust.h"
+
+#include "queuedConnectionManager.h"
+#include "queuedConnectionListener.h"
+#include "queuedConnectionReader.h"
+#include "connectionWriter.h"
+#include "netDatagram.h"
+
+// Measures what it costs to time something with PStats, by running a number
+// of threads that each start and stop a collector a million times, first
+// with each thread's frame data protected by a lock, and then with each
+// thread recording its events in a ring (pstats-ring-buffer-size).  The
+// client talks to a stand-in server in this process, which answers the
+// client's greeting and throws away the frames it is sent.
+
+static int num_threads = 4;
+static int num_pairs = 1000000;
+static const int pairs_per_frame = 1000;
+static const int server_port = 5195;
+
+static AtomicAdjust::Integer num_finished = 0;
+
+class Worker {
+public:
+  string _sync_name;
+  double _elapsed;
+};
+
+/**
+ * A stand-in for the PStats server, just enough to get the client going.
+ */
+class Server {
+public:
+  Server();
+  bool listen();
+  void poll();
+
+  QueuedConnectionManager _manager;
+  QueuedConnectionListener _listener;
+  QueuedConnectionReader _reader;
+  ConnectionWriter _writer;
+  PT(Connection) _tcp_connection;
+  PT(Connection) _udp_connection;
+  bool _said_hello;
+};
+
+/**
+ *
+ */
+Server::
+Server() :
+  _listener(&_manager, 0),
+  _reader(&_manager, 0),
+  _writer(&_manager, 0),
+  _said_hello(false)
+{
+  _reader.set_tcp_header_size(4);
+  _writer.set_tcp_header_size(4);
+}
+
+/**
+ * Opens the ports the client will connect to.
+ */
+bool Server::
+listen() {
+  PT(Connection) rendezvous =
+    _manager.open_TCP_server_rendezvous(server_port, 5);
+  if (rendezvous.is_null()) {
+    return false;
+  }
+  _listener.add_connection(rendezvous);
+
+  _udp_connection = _manager.open_UDP_connection(server_port + 1);
+  if (_udp_connection.is_null()) {
+    return false;
+  }
+  _reader.add_connection(_udp_connection);
+  return true;
+}
+
+/**
+ * Accepts the client, answers its greeting, and discards everything else it
+ * sends.
+ */
+void Server::
+poll() {
+  if (_tcp_connection.is_null() && _listener.new_connection_available()) {
+    PT(Connection) rendezvous;
+    NetAddress address;
+    if (_listener.get_new_connection(rendezvous, address, _tcp_connection)) {
+      _reader.add_connection(_tcp_connection);
+    }
+  }
+
+  while (_reader.data_available()) {
+    NetDatagram datagram;
+    if (_reader.get_data(datagram) && !_said_hello &&
+        datagram.get_connection() == _tcp_connection) {
+      PStatServerControlMessage message;
+      message._type = PStatServerControlMessage::T_hello;
+      message._server_hostname = "localhost";
+      message._server_progname = "test_overhead";
+      message._udp_port = server_port + 1;
+
+      Datagram reply;
+      message.encode(reply);
+      _writer.send(reply, _tcp_connection);
+      _said_hello = true;
+    }
+  }
+}
+
+/**
+ * The body of each benchmark thread.
+ */
+static void
+run_worker(void *data) {
+  Worker *worker = (Worker *)data;
+  PStatCollector collector("Benchmark");
+
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double start = clock->get_short_time();
+  for (int i = 0; i < num_pairs; ++i) {
+    collector.start();
+    collector.stop();
+    if ((i % pairs_per_frame) == pairs_per_frame - 1) {
+      PStatClient::thread_tick(worker->_sync_name);
+    }
+  }
+  worker->_elapsed = clock->get_short_time() - start;
+  AtomicAdjust::inc(num_finished);
+}
+
+/**
+ * Runs the benchmark threads, ticking the main thread and the server while
+ * they run, and returns the average time per start/stop pair in nanoseconds.
+ */
+static double
+run_threads(Server &server) {
+  AtomicAdjust::set(num_finished, 0);
+
+  if (!Thread::is_threading_supported()) {
+    // Run the one worker in the main thread instead.
+    Worker worker;
+    worker._sync_name = "Main";
+    run_worker(&worker);
+    return worker._elapsed / num_pairs * 1.0e9;
+  }
+
+  pvector<Worker> workers(num_threads);
+  pvector<PT(GenericThread)> threads;
+
+  for (int t = 0; t < num_threads; ++t) {
+    ostringstream strm;
+    strm << "Worker " << t;
+    workers[t]._sync_name = strm.str();
+    workers[t]._elapsed = 0.0;
+    PT(GenericThread) thread =
+      new GenericThread(strm.str(), strm.str(), &run_worker, &workers[t]);
+    thread->start(TP_normal, true);
+    threads.push_back(thread);
+  }
+
+  while (AtomicAdjust::get(num_finished) < num_threads) {
+    server.poll();
+    PStatClient::main_tick();
+    Thread::sleep(0.01);
+  }
+
+  double total = 0.0;
+  for (int t = 0; t < num_threads; ++t) {
+    threads[t]->join();
+    total += workers[t]._elapsed;
+  }
+  return total / num_threads / num_pairs * 1.0e9;
+}
+
+/**
+ * Connects to the stand-in server with the indicated ring size, and runs the
+ * benchmark.
+ */
+static double
+run_connected(Server &server, int ring_size) {
+  pstats_ring_buffer_size.set_value(ring_size);
+  if (!PStatClient::connect("localhost", server_port)) {
+    nout << "Couldn't connect to the stand-in server.\n";
+    exit(1);
+  }
+
+  // Let the client receive the server's greeting, report its collectors and
+  // threads, and start its first frame.
+  for (int i = 0; i < 10; ++i) {
+    server.poll();
+    PStatClient::main_tick();
+    Thread::sleep(0.01);
+  }
+
+  double ns = run_threads(server);
+  PStatClient::disconnect();
+
+  server._reader.remove_connection(server._tcp_connection);
+  server._manager.close_connection(server._tcp_connection);
+  server._tcp_connection.clear();
+  server._said_hello = false;
+  return ns;
+}
+
+int
+main(int argc, char *argv[]) {
+  if (argc > 1) {
+    num_threads = max(atoi(argv[1]), 1);
+  }
+  if (argc > 2) {
+    num_pairs = max(atoi(argv[2]), pairs_per_frame);
+  }
+  if (argc > 3) {
+    nout << "test_overhead [threads [pairs]]\n";
+    exit(1);
+  }
+
+  if (!Thread::is_threading_supported()) {
+    num_threads = 1;
+  }
+
+  Server server;
+  if (!server.listen()) {
+    nout << "Couldn't open port " << server_port << ".\n";
+    exit(1);
+  }
+
+  nout << num_threads << " threads, " << num_pairs
+       << " start/stop pairs each:\n";
+
+  double ns = run_threads(server);
+  nout << "  not connected: " << ns << " ns per pair\n";
+
+  ns = run_connected(server, 0);
+  nout << "  locked:        " << ns << " ns per pair\n";
+
+  ns = run_connected(server, 16384);
+  nout << "  ring buffer:   " << ns << " ns per pair\n";
+
+  return 0;
+}
@@ -37,7 +37,9 @@ BamCache() :
   _active(true),
   _read_only(false),
   _index(new BamCacheIndex),
-  _index_stale_since(0)
+  _index_stale_since(0),
+  _index_shards(0),
+  _index_size(0)
 {
   ConfigVariableFilename model_cache_dir
     ("model-cache-dir", Filename(),
@@ -81,6 +83,24 @@ BamCache() :
     ("model-cache-max-kbytes", 10485760,
      PRC_DESC("This is the maximum size of the model cache, in kilobytes."));
 
+  ConfigVariableInt model_cache_index_shards
+    ("model-cache-index-shards", 0,
+     PRC_DESC("If this is nonzero, the model cache index is kept in a hash "
+              "table in the file index.map, divided into this many shards, "
+              "instead of in an index.boo file.  Every process using the "
+              "cache maps the table into memory and updates it in place, so "
+              "there is no index to flush or merge, and reading it takes "
+              "no lock.  This is worth setting when several processes "
+              "share one model-cache-dir."));
+
+  ConfigVariableInt model_cache_index_size
+    ("model-cache-index-size", 65536,
+     PRC_DESC("The number of files the hash table index has room for, when "
+              "model-cache-index-shards is nonzero.  When a shard of the "
+              "table fills up, its least recently used file is removed from "
+              "the cache to make room.  If the table already exists, its "
+              "existing size is used instead."));
+
   _cache_models = model_cache_models;
   _cache_textures = model_cache_textures;
   _cache_compressed_textures = model_cache_compressed_textures;
@@ -88,6 +108,8 @@ BamCache() :
 
   _flush_time = model_cache_flush;
   _max_kbytes = model_cache_max_kbytes;
+  _index_shards = model_cache_index_shards;
+  _index_size = model_cache_index_size;
 
   if (!model_cache_dir.empty()) {
     set_root(model_cache_dir);
@@ -128,7 +150,10 @@ set_root(const Filename &root) {
   delete _index;
   _index = new BamCacheIndex;
   _index_stale_since = 0;
-  read_index();
+  _hash_index.clear();
+  if (!open_hash_index()) {
+    read_index();
+  }
   check_cache_size();
 
   nassertv(vfs->is_directory(_root));
@@ -152,16 +177,40 @@ set_root(const Filename &root) {
  */
 PT(BamCacheRecord) BamCache::
 lookup(const Filename &source_filename, const string &cache_extension) {
-  ReMutexHolder holder(_lock);
+  // With the hash table index, the lock is held only long enough to see
+  // where the cache is, and the cache file is read without it, so that
+  // several threads may be loading from the cache at once.  With the
+  // ordinary index, the lock is held throughout, as it always has been.
+  Filename root;
+  PT(BamCacheHashIndex) hash_index;
+  {
+    ReMutexHolder holder(_lock);
+    if (_hash_index == (BamCacheHashIndex *)NULL) {
+      consider_flush_index();
+      return do_lookup(_root, NULL, source_filename, cache_extension);
+    }
+    root = _root;
+    hash_index = _hash_index;
+  }
+
   consider_flush_index();
+  return do_lookup(root, hash_index, source_filename, cache_extension);
+}
 
+/**
+ * The implementation of lookup(), given the cache directory and the hash
+ * table index, if there is one.
+ */
+PT(BamCacheRecord) BamCache::
+do_lookup(const Filename &root, BamCacheHashIndex *hash_index,
+          const Filename &source_filename, const string &cache_extension) {
   VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
 
   Filename source_pathname(source_filename);
   source_pathname.make_absolute(vfs->get_cwd());
 
   Filename rel_pathname(source_pathname);
-  rel_pathname.make_relative_to(_root, false);
+  rel_pathname.make_relative_to(root, false);
   if (rel_pathname.is_local()) {
     // If the source pathname is already within the cache directory, don't
     // cache it further.
@@ -171,7 +220,8 @@ lookup(const Filename &source_filename, const string &cache_extension) {
   Filename cache_filename = hash_filename(source_pathname.get_fullpath());
   cache_filename.set_extension(cache_extension);
 
-  return find_and_read_record(source_pathname, cache_filename);
+  return find_and_read_record(root, hash_index, source_pathname,
+                              cache_filename);
 }
 
 /**
@@ -181,21 +231,42 @@ lookup(const Filename &source_filename, const string &cache_extension) {
  */
 bool BamCache::
 store(BamCacheRecord *record) {
-  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
-  ReMutexHolder holder(_lock);
   nassertr(!record->_cache_pathname.empty(), false);
   nassertr(record->has_data(), false);
 
-  if (_read_only) {
-    return false;
+  // As in lookup(), the cache file is written without holding the lock only
+  // if the hash table index is in use.
+  Filename root;
+  PT(BamCacheHashIndex) hash_index;
+  {
+    ReMutexHolder holder(_lock);
+    if (_read_only) {
+      return false;
+    }
+    if (_hash_index == (BamCacheHashIndex *)NULL) {
+      return do_store(_root, NULL, record);
+    }
+    root = _root;
+    hash_index = _hash_index;
   }
 
+  return do_store(root, hash_index, record);
+}
+
+/**
+ * The implementation of store(), given the cache directory and the hash
+ * table index, if there is one.
+ */
+bool BamCache::
+do_store(const Filename &root, BamCacheHashIndex *hash_index,
+         BamCacheRecord *record) {
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
   consider_flush_index();
 
 #ifndef NDEBUG
   // Ensure that the cache_pathname is within the _root directory tree.
   Filename rel_pathname(record->_cache_pathname);
-  rel_pathname.make_relative_to(_root, false);
+  rel_pathname.make_relative_to(root, false);
   nassertr(rel_pathname.is_local(), false);
 #endif  // NDEBUG
 
@@ -287,7 +358,12 @@ store(BamCacheRecord *record) {
     }
   }
 
-  add_to_index(record);
+  if (hash_index != (BamCacheHashIndex *)NULL) {
+    add_to_hash_index(root, hash_index, record);
+  } else {
+    ReMutexHolder holder(_lock);
+    add_to_index(record);
+  }
 
   return true;
 }
@@ -299,6 +375,7 @@ store(BamCacheRecord *record) {
  */
 void BamCache::
 emergency_read_only() {
+  ReMutexHolder holder(_lock);
   util_cat.error() <<
     "Could not write to the Bam Cache.  Disabling future attempts.\n";
   _read_only = true;
@@ -387,7 +464,11 @@ flush_index() {
  */
 void BamCache::
 list_index(ostream &out, int indent_level) const {
-  _index->write(out, indent_level);
+  if (_hash_index != (BamCacheHashIndex *)NULL) {
+    _hash_index->write(out, indent_level);
+  } else {
+    _index->write(out, indent_level);
+  }
 }
 
 /**
@@ -597,6 +678,19 @@ rebuild_index() {
       }
     }
   }
+
+  if (_hash_index != (BamCacheHashIndex *)NULL) {
+    // The records we found go into the hash table index instead, which is
+    // written as we go.
+    BamCacheIndex::Records::const_iterator ri;
+    for (ri = _index->_records.begin(); ri != _index->_records.end(); ++ri) {
+      add_to_hash_index(_root, _hash_index, (*ri).second);
+    }
+    delete _index;
+    _index = new BamCacheIndex;
+    return;
+  }
+
   _index->process_new_records();
 
   _index_stale_since = time(NULL);
@@ -634,6 +728,11 @@ remove_from_index(const Filename &source_pathname) {
  */
 void BamCache::
 check_cache_size() {
+  if (_hash_index != (BamCacheHashIndex *)NULL) {
+    check_hash_cache_size(_root, _hash_index);
+    return;
+  }
+
   if (_index->_cache_size == 0) {
     // 0 means no limit.
     return;
@@ -659,6 +758,84 @@ check_cache_size() {
   }
 }
 
+/**
+ * Opens the hash table index in the cache directory, if
+ * model-cache-index-shards asks for one, filling it in from the cache files
+ * if it is new.  Returns true if the hash table index is now in use, or false
+ * if the ordinary index should be used instead.
+ */
+bool BamCache::
+open_hash_index() {
+  if (_index_shards <= 0) {
+    return false;
+  }
+
+  PT(BamCacheHashIndex) hash_index = new BamCacheHashIndex;
+  Filename index_pathname(_root, Filename("index.map"));
+  bool created;
+  if (!hash_index->open(index_pathname, _index_shards, _index_size,
+                        created)) {
+    util_cat.warning()
+      << "Unable to open " << index_pathname
+      << "; using the ordinary model cache index instead.\n";
+    return false;
+  }
+
+  _hash_index = hash_index;
+  if (created) {
+    rebuild_index();
+  }
+  return true;
+}
+
+/**
+ * Updates the hash table index entry for the indicated record, and then
+ * deletes any cache files that no longer fit.  This does not need the lock,
+ * nor does it hold up other processes for longer than it takes to update one
+ * entry.
+ */
+void BamCache::
+add_to_hash_index(const Filename &root, BamCacheHashIndex *hash_index,
+                  const BamCacheRecord *record) {
+  string evicted_filename;
+  if (hash_index->add_record(record, evicted_filename)) {
+    if (!evicted_filename.empty()) {
+      VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+      Filename cache_pathname(root, Filename(evicted_filename));
+      if (util_cat.is_debug()) {
+        util_cat.debug()
+          << "Deleting " << cache_pathname
+          << " to make room in the model cache index\n";
+      }
+      vfs->delete_file(cache_pathname);
+    }
+    check_hash_cache_size(root, hash_index);
+  }
+}
+
+/**
+ * The hash table index equivalent of check_cache_size().  Each file deleted
+ * costs one update to one shard of the index.
+ */
+void BamCache::
+check_hash_cache_size(const Filename &root, BamCacheHashIndex *hash_index) {
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+  while (hash_index->get_cache_size() / 1024 > _max_kbytes) {
+    string cache_filename;
+    if (!hash_index->evict_old_file(cache_filename)) {
+      // Never mind; the cache is empty.
+      break;
+    }
+    Filename cache_pathname(root, Filename(cache_filename));
+    if (util_cat.is_debug()) {
+      util_cat.debug()
+        << "Deleting " << cache_pathname
+        << " to keep cache size below " << _max_kbytes << "K\n";
+    }
+    vfs->delete_file(cache_pathname);
+  }
+}
+
 /**
  * Reads the index data from the specified filename.  Returns a newly-
  * allocated BamCacheIndex object on success, or NULL on failure.
@@ -761,14 +938,20 @@ do_write_index(const Filename &index_pathname, const BamCacheIndex *index) {
  * the case of a hash collision, it may be a variant of the cache filename.
  */
 PT(BamCacheRecord) BamCache::
-find_and_read_record(const Filename &source_pathname,
+find_and_read_record(const Filename &root, BamCacheHashIndex *hash_index,
+                     const Filename &source_pathname,
                      const Filename &cache_filename) {
   int pass = 0;
   while (true) {
     PT(BamCacheRecord) record =
-      read_record(source_pathname, cache_filename, pass);
+      read_record(root, hash_index, source_pathname, cache_filename, pass);
     if (record != (BamCacheRecord *)NULL) {
-      add_to_index(record);
+      if (hash_index != (BamCacheHashIndex *)NULL) {
+        add_to_hash_index(root, hash_index, record);
+      } else {
+        ReMutexHolder holder(_lock);
+        add_to_index(record);
+      }
       return record;
     }
     ++pass;
@@ -780,11 +963,12 @@ find_and_read_record(const Filename &source_pathname,
  * be read and it matches the source filename.
  */
 PT(BamCacheRecord) BamCache::
-read_record(const Filename &source_pathname,
+read_record(const Filename &root, BamCacheHashIndex *hash_index,
+            const Filename &source_pathname,
             const Filename &cache_filename,
             int pass) {
   VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
-  Filename cache_pathname(_root, cache_filename);
+  Filename cache_pathname(root, cache_filename);
   if (pass != 0) {
     ostringstream strm;
     strm << cache_pathname.get_basename_wo_extension() << "_" << pass;
@@ -816,7 +1000,12 @@ read_record(const Filename &source_pathname,
         << "Deleting invalid cache file " << cache_pathname << "\n";
     }
     vfs->delete_file(cache_pathname);
-    remove_from_index(source_pathname);
+    if (hash_index != (BamCacheHashIndex *)NULL) {
+      hash_index->remove_record(source_pathname);
+    } else {
+      ReMutexHolder holder(_lock);
+      remove_from_index(source_pathname);
+    }
 
     PT(BamCacheRecord) record =
       new BamCacheRecord(source_pathname, cache_filename);
@@ -16,6 +16,7 @@
 
 #include "pandabase.h"
 #include "bamCacheRecord.h"
+#include "bamCacheHashIndex.h"
 #include "pointerTo.h"
 #include "filename.h"
 #include "pmap.h"
@@ -38,6 +39,10 @@ class BamCacheIndex;
  * multiple different processes writing to the same index, and without relying
  * too heavily on low-level os-provided file locks (which work poorly with C++
  * iostreams).
+ *
+ * If model-cache-index-shards is nonzero, the index is instead kept in a
+ * BamCacheHashIndex, which all of the processes share through a memory
+ * mapping and update in place.
  */
 class EXPCL_PANDA_PUTIL BamCache {
 PUBLISHED:
@@ -110,14 +115,31 @@ private:
 
   void check_cache_size();
 
+  bool open_hash_index();
+  void add_to_hash_index(const Filename &root, BamCacheHashIndex *hash_index,
+                         const BamCacheRecord *record);
+  void check_hash_cache_size(const Filename &root,
+                             BamCacheHashIndex *hash_index);
+
   void emergency_read_only();
 
   static BamCacheIndex *do_read_index(const Filename &index_pathname);
   static bool do_write_index(const Filename &index_pathname, const BamCacheIndex *index);
 
-  PT(BamCacheRecord) find_and_read_record(const Filename &source_pathname,
+  PT(BamCacheRecord) do_lookup(const Filename &root,
+                               BamCacheHashIndex *hash_index,
+                               const Filename &source_filename,
+                               const string &cache_extension);
+  bool do_store(const Filename &root, BamCacheHashIndex *hash_index,
+                BamCacheRecord *record);
+
+  PT(BamCacheRecord) find_and_read_record(const Filename &root,
+                                          BamCacheHashIndex *hash_index,
+                                          const Filename &source_pathname,
                                           const Filename &cache_filename);
-  PT(BamCacheRecord) read_record(const Filename &source_pathname,
+  PT(BamCacheRecord) read_record(const Filename &root,
+                                 BamCacheHashIndex *hash_index,
+                                 const Filename &source_pathname,
                                  const Filename &cache_filename,
                                  int pass);
   static PT(BamCacheRecord) do_read_record(const Filename &cache_pathname,
@@ -143,6 +165,11 @@ private:
   Filename _index_pathname;
   string _index_ref_contents;
 
+  // This is used instead of _index if model-cache-index-shards is set.
+  int _index_shards;
+  int _index_size;
+  PT(BamCacheHashIndex) _hash_index;
+
   ReMutex _lock;
 };
 
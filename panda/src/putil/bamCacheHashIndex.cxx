@@ -0,0 +1,926 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file bamCacheHashIndex.cxx
+ * @date 2026-10-19
+ */
+
+#include "bamCacheHashIndex.h"
+#include "config_util.h" // util_cat
+#include "indent.h"
+#include "thread.h"
+
+#include <time.h>
+#include <string.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/file.h>
+#endif
+
+// The first word of the file once it has been set up.  This changes if the
+// layout of the file, or the way it is locked, ever does.
+static const uint32_t index_magic = 0x33696370;  // "pci3"
+
+// The locks are taken on bytes starting at this offset in the file, which is
+// well past the end of its data, so that they never cover the mapped memory.
+// The first byte is locked while the file is being set up, and the next one
+// for each shard.
+static const int64_t lock_base = (int64_t)1 << 30;
+
+LightMutex BamCacheHashIndex::_shard_mutexes[num_shard_mutexes];
+LightMutex BamCacheHashIndex::_init_mutex;
+
+// The index is shared with other processes, which may be running different
+// builds of Panda, so these are used instead of AtomicAdjust, whose Integer
+// type varies with the platform and with HAVE_THREADS.
+#ifdef _MSC_VER
+static INLINE uint32_t
+atomic_load(const uint32_t *var) {
+  uint32_t value = *(const volatile uint32_t *)var;
+  MemoryBarrier();
+  return value;
+}
+
+static INLINE void
+atomic_store(uint32_t *var, uint32_t value) {
+  MemoryBarrier();
+  *(volatile uint32_t *)var = value;
+}
+
+static INLINE bool
+atomic_cas(uint32_t *var, uint32_t old_value, uint32_t new_value) {
+  return (uint32_t)InterlockedCompareExchange
+    ((volatile LONG *)var, (LONG)new_value, (LONG)old_value) == old_value;
+}
+
+static INLINE int64_t
+atomic_load64(const int64_t *var) {
+  return InterlockedCompareExchange64((volatile LONG64 *)var, 0, 0);
+}
+
+static INLINE void
+atomic_store64(int64_t *var, int64_t value) {
+  InterlockedExchange64((volatile LONG64 *)var, value);
+}
+
+static INLINE void
+acquire_fence() {
+  MemoryBarrier();
+}
+
+static INLINE void
+release_fence() {
+  MemoryBarrier();
+}
+
+#else  // _MSC_VER
+static INLINE uint32_t
+atomic_load(const uint32_t *var) {
+  return __atomic_load_n(var, __ATOMIC_ACQUIRE);
+}
+
+static INLINE void
+atomic_store(uint32_t *var, uint32_t value) {
+  __atomic_store_n(var, value, __ATOMIC_RELEASE);
+}
+
+static INLINE bool
+atomic_cas(uint32_t *var, uint32_t old_value, uint32_t new_value) {
+  return __atomic_compare_exchange_n(var, &old_value, new_value, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+static INLINE int64_t
+atomic_load64(const int64_t *var) {
+  return __atomic_load_n(var, __ATOMIC_ACQUIRE);
+}
+
+static INLINE void
+atomic_store64(int64_t *var, int64_t value) {
+  __atomic_store_n(var, value, __ATOMIC_RELEASE);
+}
+
+static INLINE void
+acquire_fence() {
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+}
+
+static INLINE void
+release_fence() {
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+#endif  // _MSC_VER
+
+/**
+ *
+ */
+BamCacheHashIndex::
+BamCacheHashIndex() :
+  _header(NULL),
+  _shards(NULL),
+  _slots(NULL),
+  _num_shards(0),
+  _slots_per_shard(0),
+  _next_evict_shard(0)
+{
+#ifdef _WIN32
+  _lock_handle = INVALID_HANDLE_VALUE;
+#else
+  _lock_fd = -1;
+  _lock_pid = 0;
+  _use_ofd_locks = false;
+  _flock_count = 0;
+#endif
+}
+
+/**
+ *
+ */
+BamCacheHashIndex::
+~BamCacheHashIndex() {
+  close();
+}
+
+/**
+ * Maps the indicated index file into memory, creating it if it does not
+ * already exist, with the indicated number of shards and room for about the
+ * indicated number of records.  If the file was already created by another
+ * process with a different size, it is used as it is.
+ *
+ * Returns true on success, false on failure.  created is set true if the
+ * file was new, or was not a valid index, and so is empty; the caller should
+ * then fill it in from the cache files on disk.
+ */
+bool BamCacheHashIndex::
+open(const Filename &pathname, int num_shards, int num_entries,
+     bool &created) {
+  close();
+  created = false;
+
+  num_shards = max(num_shards, 1);
+  int slots_per_shard = max(num_entries / num_shards, 16);
+  if (!open_lock_file(pathname)) {
+    util_cat.error()
+      << "Unable to open model cache index " << pathname << "\n";
+    return false;
+  }
+  if (!init_file(pathname, num_shards, slots_per_shard, created)) {
+    close_lock_file();
+    return false;
+  }
+
+  const Header *header = (const Header *)_file.get_data();
+  int file_shards = (int)header->_num_shards;
+  int file_slots = (int)header->_slots_per_shard;
+  if (file_shards != num_shards || file_slots != slots_per_shard) {
+    if (file_shards <= 0 || file_shards > 0x10000 ||
+        file_slots <= 0 || file_slots > 0x1000000) {
+      util_cat.error()
+        << pathname << " is not a valid model cache index.\n";
+      _file.close();
+      close_lock_file();
+      return false;
+    }
+
+    // Some other process made the file with different settings.  We have to
+    // agree with it, so map the file again at its size.
+    if (util_cat.is_debug()) {
+      util_cat.debug()
+        << pathname << " has " << file_shards << " shards of "
+        << file_slots << " slots; using it as it is.\n";
+    }
+    _file.close();
+    if (!init_file(pathname, file_shards, file_slots, created)) {
+      close_lock_file();
+      return false;
+    }
+  }
+
+  unsigned char *data = _file.get_write_data();
+  _header = (Header *)data;
+  _num_shards = file_shards;
+  _slots_per_shard = file_slots;
+  _shards = (Shard *)(data + sizeof(Header));
+  _slots = (Slot *)(_shards + file_shards);
+  return true;
+}
+
+/**
+ * Unmaps the index file.  The file itself remains, for the next process.
+ */
+void BamCacheHashIndex::
+close() {
+  _file.close();
+  close_lock_file();
+  _header = NULL;
+  _shards = NULL;
+  _slots = NULL;
+  _num_shards = 0;
+  _slots_per_shard = 0;
+}
+
+/**
+ * Records the indicated record in the index, replacing whatever was there
+ * for the same source file.  Returns true if the index was changed, or false
+ * if it already held the record as it is, or if the record could not be
+ * added.  If the record's shard was full, the least recently used record in
+ * it is dropped to make room, and its cache filename is stored in
+ * evicted_filename; the caller should delete that file.
+ */
+bool BamCacheHashIndex::
+add_record(const BamCacheRecord *record, string &evicted_filename) {
+  nassertr(is_open(), false);
+  evicted_filename.clear();
+
+  string filename = record->get_cache_filename().get_fullpath();
+  if (filename.size() >= sizeof(_slots->_cache_filename)) {
+    if (util_cat.is_debug()) {
+      util_cat.debug()
+        << "Cache filename " << filename << " is too long to index.\n";
+    }
+    return false;
+  }
+
+  uint64_t key = hash_pathname(record->get_source_pathname());
+  int shard_index = get_shard_index(key);
+
+  Slot data;
+  memset(&data, 0, sizeof(data));
+  data._state = SS_used;
+  data._key = key;
+  data._record_size = (int64_t)record->_record_size;
+  data._recorded_time = (int64_t)record->_recorded_time;
+  data._access_time = (int64_t)max(record->_record_access_time,
+                                   record->_recorded_time);
+  strcpy(data._cache_filename, filename.c_str());
+
+  Slot copy;
+  int slot_index = find_record(shard_index, key, copy);
+  if (slot_index >= 0 &&
+      copy._record_size == data._record_size &&
+      copy._recorded_time == data._recorded_time &&
+      filename == copy._cache_filename) {
+    // Nothing has changed but the access time, which may be stored without
+    // locking the shard.
+    if (data._access_time > copy._access_time) {
+      atomic_store64(&get_slot(shard_index, slot_index)->_access_time,
+                     data._access_time);
+    }
+    return false;
+  }
+
+  if (!lock_shard(shard_index)) {
+    return false;
+  }
+
+  // Look again, now that nobody else can change the shard.
+  int start = get_start_slot(key);
+  int free_index = -1;
+  slot_index = -1;
+  for (int i = 0; i < _slots_per_shard; ++i) {
+    int si = (start + i) % _slots_per_shard;
+    const Slot *slot = get_slot(shard_index, si);
+    if (slot->_state == SS_used) {
+      if (slot->_key == key) {
+        slot_index = si;
+        break;
+      }
+    } else {
+      if (free_index < 0) {
+        free_index = si;
+      }
+      if (slot->_state == SS_empty) {
+        break;
+      }
+    }
+  }
+
+  int64_t old_size = 0;
+  if (slot_index >= 0) {
+    old_size = get_slot(shard_index, slot_index)->_record_size;
+
+  } else {
+    if (free_index < 0) {
+      // The shard is full.  Make room by dropping its least recently used
+      // record.
+      free_index = find_oldest(shard_index);
+      if (free_index < 0) {
+        unlock_shard(shard_index);
+        return false;
+      }
+      evicted_filename = get_slot(shard_index, free_index)->_cache_filename;
+      clear_slot(shard_index, free_index);
+    }
+    slot_index = free_index;
+    Shard *shard = get_shard(shard_index);
+    atomic_store64(&shard->_num_records, shard->_num_records + 1);
+  }
+
+  write_slot(get_slot(shard_index, slot_index), data);
+  Shard *shard = get_shard(shard_index);
+  atomic_store64(&shard->_cache_size,
+                 shard->_cache_size + data._record_size - old_size);
+
+  unlock_shard(shard_index);
+  return true;
+}
+
+/**
+ * Removes the record for the indicated source file, if there is one.
+ * Returns true if it was found, false otherwise.
+ */
+bool BamCacheHashIndex::
+remove_record(const Filename &source_pathname) {
+  nassertr(is_open(), false);
+  uint64_t key = hash_pathname(source_pathname);
+  int shard_index = get_shard_index(key);
+
+  Slot copy;
+  if (find_record(shard_index, key, copy) < 0) {
+    return false;
+  }
+
+  if (!lock_shard(shard_index)) {
+    return false;
+  }
+  bool found = false;
+  int start = get_start_slot(key);
+  for (int i = 0; i < _slots_per_shard; ++i) {
+    int si = (start + i) % _slots_per_shard;
+    const Slot *slot = get_slot(shard_index, si);
+    if (slot->_state == SS_empty) {
+      break;
+    }
+    if (slot->_state == SS_used && slot->_key == key) {
+      clear_slot(shard_index, si);
+      found = true;
+      break;
+    }
+  }
+  unlock_shard(shard_index);
+  return found;
+}
+
+/**
+ * Removes the least recently used record from one of the shards, taking the
+ * shards in turn, and stores its cache filename, relative to the cache
+ * directory, in cache_filename.  The caller should delete that file.
+ * Returns false if the index is empty.
+ *
+ * Since each call looks at one shard only, this is only an approximation of
+ * evicting the least recently used record overall, but it touches only a
+ * small part of the index.
+ */
+bool BamCacheHashIndex::
+evict_old_file(string &cache_filename) {
+  nassertr(is_open(), false);
+  for (int i = 0; i < _num_shards; ++i) {
+    int shard_index =
+      (int)(AtomicAdjust::get(_next_evict_shard) % _num_shards);
+    AtomicAdjust::set(_next_evict_shard, (shard_index + 1) % _num_shards);
+
+    if (!lock_shard(shard_index)) {
+      return false;
+    }
+    int slot_index = find_oldest(shard_index);
+    if (slot_index >= 0) {
+      cache_filename = get_slot(shard_index, slot_index)->_cache_filename;
+      clear_slot(shard_index, slot_index);
+      unlock_shard(shard_index);
+      return true;
+    }
+    unlock_shard(shard_index);
+  }
+
+  return false;
+}
+
+/**
+ * Returns the total size in bytes of the cache files in the index.
+ */
+int64_t BamCacheHashIndex::
+get_cache_size() const {
+  nassertr(is_open(), 0);
+  int64_t total = 0;
+  for (int shard_index = 0; shard_index < _num_shards; ++shard_index) {
+    total += atomic_load64(&get_shard(shard_index)->_cache_size);
+  }
+  return total;
+}
+
+/**
+ * Returns the number of records in the index.
+ */
+int BamCacheHashIndex::
+get_num_records() const {
+  nassertr(is_open(), 0);
+  int64_t total = 0;
+  for (int shard_index = 0; shard_index < _num_shards; ++shard_index) {
+    total += atomic_load64(&get_shard(shard_index)->_num_records);
+  }
+  return (int)total;
+}
+
+/**
+ *
+ */
+void BamCacheHashIndex::
+write(ostream &out, int indent_level) const {
+  nassertv(is_open());
+  indent(out, indent_level)
+    << "BamCacheHashIndex, " << get_num_records() << " records in "
+    << _num_shards << " shards:\n";
+
+  for (int shard_index = 0; shard_index < _num_shards; ++shard_index) {
+    for (int si = 0; si < _slots_per_shard; ++si) {
+      Slot copy;
+      if (read_slot(get_slot(shard_index, si), copy) &&
+          copy._state == SS_used) {
+        indent(out, indent_level + 2)
+          << setw(10) << copy._record_size << " "
+          << copy._cache_filename << "\n";
+      }
+    }
+  }
+  out << "\n";
+  indent(out, indent_level)
+    << setw(12) << get_cache_size() << " bytes total\n";
+}
+
+/**
+ * Returns the key under which the record for the indicated source file is
+ * stored.  This is the 64-bit FNV-1a hash of its full pathname.
+ */
+uint64_t BamCacheHashIndex::
+hash_pathname(const Filename &source_pathname) {
+  const string &fullpath = source_pathname.get_fullpath();
+  uint64_t hash = (uint64_t)0xcbf29ce484222325ULL;
+  for (string::const_iterator si = fullpath.begin();
+       si != fullpath.end();
+       ++si) {
+    hash ^= (unsigned char)(*si);
+    hash *= (uint64_t)0x100000001b3ULL;
+  }
+  return hash;
+}
+
+/**
+ * Copies the indicated slot, making sure that no writer changed it while it
+ * was being copied.  Returns true on success, or false if the slot was being
+ * written the whole time, which can happen only if a writer died while
+ * writing it.
+ */
+bool BamCacheHashIndex::
+read_slot(const Slot *slot, Slot &copy) {
+  for (int tries = 0; tries < 1000; ++tries) {
+    uint32_t seq = atomic_load(&slot->_seq);
+    if ((seq & 1) == 0) {
+      copy._state = slot->_state;
+      copy._key = slot->_key;
+      copy._record_size = slot->_record_size;
+      copy._recorded_time = slot->_recorded_time;
+      copy._access_time = atomic_load64(&slot->_access_time);
+      memcpy(copy._cache_filename, slot->_cache_filename,
+             sizeof(copy._cache_filename));
+
+      acquire_fence();
+      if (atomic_load(&slot->_seq) == seq) {
+        copy._seq = seq;
+        copy._cache_filename[sizeof(copy._cache_filename) - 1] = '\0';
+        return true;
+      }
+    }
+    if ((tries & 63) == 63) {
+      Thread::force_yield();
+    }
+  }
+  return false;
+}
+
+/**
+ * Looks for the record with the indicated key in the indicated shard,
+ * without locking it.  If it is found, copies it and returns its slot;
+ * otherwise, returns -1.
+ */
+int BamCacheHashIndex::
+find_record(int shard_index, uint64_t key, Slot &copy) const {
+  int start = get_start_slot(key);
+  for (int i = 0; i < _slots_per_shard; ++i) {
+    int si = (start + i) % _slots_per_shard;
+    if (!read_slot(get_slot(shard_index, si), copy) ||
+        copy._state == SS_empty) {
+      return -1;
+    }
+    if (copy._state == SS_used && copy._key == key) {
+      return si;
+    }
+  }
+  return -1;
+}
+
+/**
+ * Waits for and takes the lock on the indicated shard.  The lock excludes
+ * other processes as well as other threads in this one.  Returns true on
+ * success, or false if the file could not be locked.
+ *
+ * The shard is marked dirty until it is unlocked.  If it was already marked,
+ * the last process to lock it died while holding the lock, and so it is
+ * repaired first.
+ */
+bool BamCacheHashIndex::
+lock_shard(int shard_index) {
+  const LightMutex &mutex = _shard_mutexes[shard_index % num_shard_mutexes];
+  mutex.acquire();
+  if (!lock_file_byte(lock_base + 1 + shard_index)) {
+    mutex.release();
+    return false;
+  }
+
+  Shard *shard = get_shard(shard_index);
+  if (atomic_load(&shard->_dirty) != 0) {
+    repair_shard(shard_index);
+  } else {
+    atomic_store(&shard->_dirty, 1);
+  }
+  return true;
+}
+
+/**
+ * Releases the lock taken by lock_shard(), which must be held by the calling
+ * thread.
+ */
+void BamCacheHashIndex::
+unlock_shard(int shard_index) {
+  const LightMutex &mutex = _shard_mutexes[shard_index % num_shard_mutexes];
+  nassertv(mutex.debug_is_locked());
+  atomic_store(&get_shard(shard_index)->_dirty, 0);
+  unlock_file_byte(lock_base + 1 + shard_index);
+  mutex.release();
+}
+
+/**
+ * Puts right a shard that was left dirty by a process that died while it
+ * held the lock.  Any slot that was being written is cleared, since there is
+ * no telling how much of it was written, and the shard's totals are counted
+ * again from its slots.  The shard must be locked.
+ */
+void BamCacheHashIndex::
+repair_shard(int shard_index) {
+  int64_t cache_size = 0;
+  int64_t num_records = 0;
+  int num_cleared = 0;
+  for (int si = 0; si < _slots_per_shard; ++si) {
+    Slot *slot = get_slot(shard_index, si);
+    uint32_t seq = atomic_load(&slot->_seq);
+    if ((seq & 1) != 0) {
+      // A removed marker is safe whatever was here, since searches pass
+      // through it.  Whatever cache file this slot named is forgotten.
+      slot->_state = SS_removed;
+      atomic_store(&slot->_seq, seq + 1);
+      ++num_cleared;
+
+    } else if (slot->_state == SS_used) {
+      cache_size += slot->_record_size;
+      ++num_records;
+    }
+  }
+
+  Shard *shard = get_shard(shard_index);
+  atomic_store64(&shard->_cache_size, cache_size);
+  atomic_store64(&shard->_num_records, num_records);
+
+  if (util_cat.is_debug()) {
+    util_cat.debug()
+      << "Repaired shard " << shard_index << " of the model cache index, "
+      << "clearing " << num_cleared << " slots.\n";
+  }
+}
+
+/**
+ * Waits for and takes an exclusive lock on the indicated byte of the index
+ * file, on behalf of this process.  Where that kind of lock is not available,
+ * the whole file is locked instead.  The operating system releases the lock
+ * if the process dies.  Returns true on success, false on failure.
+ */
+bool BamCacheHashIndex::
+lock_file_byte(int64_t offset) {
+#ifdef _WIN32
+  OVERLAPPED overlapped;
+  memset(&overlapped, 0, sizeof(overlapped));
+  overlapped.Offset = (DWORD)(offset & 0xffffffff);
+  overlapped.OffsetHigh = (DWORD)(offset >> 32);
+  if (!LockFileEx((HANDLE)_lock_handle, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0,
+                  &overlapped)) {
+    util_cat.error()
+      << "Unable to lock the model cache index: error "
+      << GetLastError() << "\n";
+    return false;
+  }
+  return true;
+
+#else
+  if (_lock_pid != (int)getpid()) {
+    // We have been forked since the file was opened.  A child shares its
+    // parent's open file description, and with it any lock taken through
+    // it, so it needs one of its own.
+    _init_mutex.acquire();
+    bool reopened =
+      (_lock_pid == (int)getpid()) || open_lock_file(_lock_pathname);
+    _init_mutex.release();
+    if (!reopened) {
+      util_cat.error()
+        << "Unable to reopen model cache index " << _lock_pathname << "\n";
+      return false;
+    }
+  }
+
+#ifdef F_OFD_SETLKW
+  if (_use_ofd_locks) {
+    struct flock fl;
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type = F_WRLCK;
+    fl.l_whence = SEEK_SET;
+    fl.l_start = (off_t)offset;
+    fl.l_len = 1;
+
+    while (fcntl(_lock_fd, F_OFD_SETLKW, &fl) != 0) {
+      if (errno != EINTR) {
+        util_cat.error()
+          << "Unable to lock the model cache index: " << strerror(errno)
+          << "\n";
+        return false;
+      }
+    }
+    return true;
+  }
+#endif  // F_OFD_SETLKW
+
+  // The older kind of byte-range lock belongs to the whole process, and is
+  // dropped as soon as the process closes any descriptor of the file, as
+  // MappedFile does after mapping it.  So instead we lock the whole file,
+  // which is held by this descriptor until it is closed.  The first thread
+  // to want it takes it for all of the others.
+  _flock_mutex.acquire();
+  if (_flock_count == 0) {
+    while (flock(_lock_fd, LOCK_EX) != 0) {
+      if (errno != EINTR) {
+        util_cat.error()
+          << "Unable to lock the model cache index: " << strerror(errno)
+          << "\n";
+        _flock_mutex.release();
+        return false;
+      }
+    }
+  }
+  ++_flock_count;
+  _flock_mutex.release();
+  return true;
+#endif  // _WIN32
+}
+
+/**
+ * Releases the lock taken by a matching call to lock_file_byte().
+ */
+void BamCacheHashIndex::
+unlock_file_byte(int64_t offset) {
+#ifdef _WIN32
+  OVERLAPPED overlapped;
+  memset(&overlapped, 0, sizeof(overlapped));
+  overlapped.Offset = (DWORD)(offset & 0xffffffff);
+  overlapped.OffsetHigh = (DWORD)(offset >> 32);
+  UnlockFileEx((HANDLE)_lock_handle, 0, 1, 0, &overlapped);
+
+#else
+#ifdef F_OFD_SETLK
+  if (_use_ofd_locks) {
+    struct flock fl;
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type = F_UNLCK;
+    fl.l_whence = SEEK_SET;
+    fl.l_start = (off_t)offset;
+    fl.l_len = 1;
+    fcntl(_lock_fd, F_OFD_SETLK, &fl);
+    return;
+  }
+#endif  // F_OFD_SETLK
+
+  _flock_mutex.acquire();
+  if (_flock_count > 0 && --_flock_count == 0) {
+    flock(_lock_fd, LOCK_UN);
+  }
+  _flock_mutex.release();
+#endif  // _WIN32
+}
+
+/**
+ * Stores the indicated data in the slot, apart from its sequence number.  A
+ * reader that copies the slot at the same time will see the sequence number
+ * change, and try again.  The shard must be locked.
+ */
+void BamCacheHashIndex::
+write_slot(Slot *slot, const Slot &data) {
+  uint32_t seq = slot->_seq | 1;
+  atomic_store(&slot->_seq, seq);
+  release_fence();
+
+  slot->_state = data._state;
+  slot->_key = data._key;
+  slot->_record_size = data._record_size;
+  slot->_recorded_time = data._recorded_time;
+  atomic_store64(&slot->_access_time, data._access_time);
+  memcpy(slot->_cache_filename, data._cache_filename,
+         sizeof(slot->_cache_filename));
+
+  atomic_store(&slot->_seq, seq + 1);
+}
+
+/**
+ * Removes the record in the indicated slot from the index.  The shard must
+ * be locked.
+ */
+void BamCacheHashIndex::
+clear_slot(int shard_index, int slot_index) {
+  Slot *slot = get_slot(shard_index, slot_index);
+  nassertv(slot->_state == SS_used);
+  int64_t size = slot->_record_size;
+
+  Slot data;
+  memset(&data, 0, sizeof(data));
+
+  int next = (slot_index + 1) % _slots_per_shard;
+  if (get_slot(shard_index, next)->_state != SS_empty) {
+    // A search for some other record may have to pass through this slot on
+    // its way to the next one, so leave a marker.
+    data._state = SS_removed;
+    write_slot(slot, data);
+
+  } else {
+    // No search goes on past this slot, so it may be emptied, and so may
+    // any removed slots just before it.
+    data._state = SS_empty;
+    write_slot(slot, data);
+
+    int prev = slot_index;
+    for (int i = 1; i < _slots_per_shard; ++i) {
+      prev = (prev + _slots_per_shard - 1) % _slots_per_shard;
+      Slot *prev_slot = get_slot(shard_index, prev);
+      if (prev_slot->_state != SS_removed) {
+        break;
+      }
+      write_slot(prev_slot, data);
+    }
+  }
+
+  Shard *shard = get_shard(shard_index);
+  atomic_store64(&shard->_cache_size, shard->_cache_size - size);
+  atomic_store64(&shard->_num_records, shard->_num_records - 1);
+}
+
+/**
+ * Returns the slot holding the least recently used record in the indicated
+ * shard, or -1 if the shard is empty.  The shard must be locked.
+ */
+int BamCacheHashIndex::
+find_oldest(int shard_index) const {
+  int oldest = -1;
+  int64_t oldest_time = 0;
+  for (int si = 0; si < _slots_per_shard; ++si) {
+    Slot *slot = get_slot(shard_index, si);
+    if (slot->_state == SS_used) {
+      int64_t access_time = atomic_load64(&slot->_access_time);
+      if (oldest < 0 || access_time < oldest_time) {
+        oldest = si;
+        oldest_time = access_time;
+      }
+    }
+  }
+  return oldest;
+}
+
+/**
+ * Opens the handle on the index file through which it is locked, creating
+ * the file if necessary.  Returns true on success, false on failure.
+ */
+bool BamCacheHashIndex::
+open_lock_file(const Filename &pathname) {
+  close_lock_file();
+
+#ifdef _WIN32
+  wstring os_specific = pathname.to_os_specific_w();
+  HANDLE handle =
+    CreateFileW(os_specific.c_str(), GENERIC_READ | GENERIC_WRITE,
+                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (handle == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  _lock_handle = handle;
+
+#else
+  string os_specific = pathname.to_os_specific();
+  _lock_fd = ::open(os_specific.c_str(), O_RDWR | O_CREAT, 0666);
+  if (_lock_fd < 0) {
+    return false;
+  }
+  fcntl(_lock_fd, F_SETFD, FD_CLOEXEC);
+  _lock_pid = (int)getpid();
+  _lock_pathname = pathname;
+
+  // Prefer open file description locks where the kernel has them, since
+  // they lock each shard separately.  Otherwise, lock_file_byte() falls back
+  // to locking the whole file.
+  _use_ofd_locks = false;
+  _flock_count = 0;
+#ifdef F_OFD_GETLK
+  struct flock fl;
+  memset(&fl, 0, sizeof(fl));
+  fl.l_type = F_WRLCK;
+  fl.l_whence = SEEK_SET;
+  fl.l_start = (off_t)lock_base;
+  fl.l_len = 1;
+  _use_ofd_locks = (fcntl(_lock_fd, F_OFD_GETLK, &fl) == 0);
+#endif
+#endif  // _WIN32
+
+  return true;
+}
+
+/**
+ * Closes the handle opened by open_lock_file(), which releases any locks
+ * taken through it.
+ */
+void BamCacheHashIndex::
+close_lock_file() {
+#ifdef _WIN32
+  if (_lock_handle != INVALID_HANDLE_VALUE) {
+    CloseHandle((HANDLE)_lock_handle);
+    _lock_handle = INVALID_HANDLE_VALUE;
+  }
+#else
+  if (_lock_fd >= 0) {
+    ::close(_lock_fd);
+    _lock_fd = -1;
+  }
+#endif
+}
+
+/**
+ * Maps the file at the size needed for the indicated number of shards and
+ * slots.  If the file is not yet a valid index, sets it up as one with that
+ * number of shards and slots, and sets created true.  The file is locked
+ * while this is done, so that only one process sets it up; if a process dies
+ * in the middle of it, the file is still not valid, and the next process to
+ * open it sets it up again.
+ */
+bool BamCacheHashIndex::
+init_file(const Filename &pathname, int num_shards, int slots_per_shard,
+          bool &created) {
+  size_t size = sizeof(Header) + sizeof(Shard) * (size_t)num_shards +
+    sizeof(Slot) * (size_t)num_shards * slots_per_shard;
+  if (!_file.open_read_write(pathname, size)) {
+    util_cat.error()
+      << "Unable to map model cache index " << pathname << "\n";
+    return false;
+  }
+
+  // The mutex keeps out other threads, and other indexes on the same file,
+  // in this process.
+  _init_mutex.acquire();
+  if (!lock_file_byte(lock_base)) {
+    _init_mutex.release();
+    _file.close();
+    return false;
+  }
+
+  Header *header = (Header *)_file.get_write_data();
+  uint32_t magic = atomic_load(&header->_magic);
+  if (magic != index_magic) {
+    if (magic != 0) {
+      util_cat.info()
+        << pathname << " is not a valid model cache index; replacing it.\n";
+    }
+    memset((unsigned char *)header + sizeof(uint32_t), 0,
+           size - sizeof(uint32_t));
+    header->_num_shards = (uint32_t)num_shards;
+    header->_slots_per_shard = (uint32_t)slots_per_shard;
+    atomic_store(&header->_magic, index_magic);
+    created = true;
+  }
+
+  unlock_file_byte(lock_base);
+  _init_mutex.release();
+  return true;
+}
@@ -0,0 +1,178 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file bamCacheHashIndex.h
+ * @date 2026-10-19
+ */
+
+#ifndef BAMCACHEHASHINDEX_H
+#define BAMCACHEHASHINDEX_H
+
+#include "pandabase.h"
+#include "bamCacheRecord.h"
+#include "referenceCount.h"
+#include "mappedFile.h"
+#include "filename.h"
+#include "atomicAdjust.h"
+#include "lightMutex.h"
+
+/**
+ * An alternative to BamCacheIndex, used by the BamCache when
+ * model-cache-index-shards is nonzero.  The index is a fixed-size hash table
+ * in a file in the cache directory, which every process using the cache maps
+ * into memory and updates in place, so that there is nothing to flush, merge
+ * or rewrite.
+ *
+ * The table is divided into shards by the hash of each record's source
+ * pathname.  Looking up a record takes no lock at all; each slot carries a
+ * sequence number that tells a reader when it has raced with a writer and
+ * must look again.  A writer locks only the one shard it is changing.  The
+ * lock is a mutex, to exclude other threads, together with a lock on one byte
+ * of the file, to exclude other processes.  The operating system releases
+ * the latter if the process holding it dies.
+ *
+ * Each shard keeps its own totals, and is marked dirty while it is locked.
+ * If a writer dies in the middle of changing a shard, the next one to lock
+ * it finds the mark, and recounts the shard and clears any slot that was
+ * left half-written.
+ *
+ * Only the size, times and cache filename of each record are stored, which
+ * is all that is needed to keep the cache within its size limit.
+ */
+class EXPCL_PANDA_PUTIL BamCacheHashIndex : public ReferenceCount {
+public:
+  BamCacheHashIndex();
+  ~BamCacheHashIndex();
+
+  bool open(const Filename &pathname, int num_shards, int num_entries,
+            bool &created);
+  void close();
+  INLINE bool is_open() const;
+
+  bool add_record(const BamCacheRecord *record, string &evicted_filename);
+  bool remove_record(const Filename &source_pathname);
+  bool evict_old_file(string &cache_filename);
+
+  int64_t get_cache_size() const;
+  int get_num_records() const;
+
+  void write(ostream &out, int indent_level = 0) const;
+
+private:
+  // These are the structures stored in the mapped file: a Header, followed
+  // by a Shard for each shard, followed by all of the Slots, shard by shard.
+  // They are all fixed-size, and each begins on a cache line.
+  class Header {
+  public:
+    uint32_t _magic;
+    uint32_t _num_shards;
+    uint32_t _slots_per_shard;
+    uint32_t _unused;
+    char _pad[48];
+  };
+
+  class Shard {
+  public:
+    // The totals of the records in the shard's slots.
+    int64_t _cache_size;
+    int64_t _num_records;
+
+    // This is nonzero while the shard is locked, and so is left nonzero if
+    // the process holding the lock dies.
+    uint32_t _dirty;
+    char _pad[44];
+  };
+
+  enum SlotState {
+    SS_empty = 0,
+    SS_used,
+    SS_removed,
+  };
+
+  class Slot {
+  public:
+    // This is odd while the slot is being written.
+    uint32_t _seq;
+    uint32_t _state;
+    uint64_t _key;
+    int64_t _record_size;
+    int64_t _recorded_time;
+
+    // This is updated without locking the shard, whenever the record is
+    // looked up.
+    int64_t _access_time;
+
+    char _cache_filename[88];
+  };
+
+  static uint64_t hash_pathname(const Filename &source_pathname);
+  INLINE int get_shard_index(uint64_t key) const;
+  INLINE int get_start_slot(uint64_t key) const;
+  INLINE Shard *get_shard(int shard_index) const;
+  INLINE Slot *get_slot(int shard_index, int slot_index) const;
+
+  static bool read_slot(const Slot *slot, Slot &copy);
+  int find_record(int shard_index, uint64_t key, Slot &copy) const;
+
+  bool lock_shard(int shard_index);
+  void unlock_shard(int shard_index);
+  void repair_shard(int shard_index);
+  bool lock_file_byte(int64_t offset);
+  void unlock_file_byte(int64_t offset);
+  void write_slot(Slot *slot, const Slot &data);
+  void clear_slot(int shard_index, int slot_index);
+  int find_oldest(int shard_index) const;
+
+  bool open_lock_file(const Filename &pathname);
+  void close_lock_file();
+  bool init_file(const Filename &pathname, int num_shards,
+                 int slots_per_shard, bool &created);
+
+private:
+  MappedFile _file;
+  Header *_header;
+  Shard *_shards;
+  Slot *_slots;
+  int _num_shards;
+  int _slots_per_shard;
+
+  // The shard from which this process will next evict a record.
+  AtomicAdjust::Integer _next_evict_shard;
+
+  // A second handle on the index file, on which the byte-range locks are
+  // taken.  It stays open for as long as the file is mapped.
+#ifdef _WIN32
+  void *_lock_handle;
+#else
+  int _lock_fd;
+  bool _use_ofd_locks;
+
+  // Without open file description locks, the whole file is locked with
+  // flock() instead, on behalf of all of the threads of this process that
+  // have locked a shard through this index.  This counts them.
+  LightMutex _flock_mutex;
+  int _flock_count;
+
+  // The process that opened _lock_fd.  A child forked from it must open the
+  // file again before it can lock it.
+  int _lock_pid;
+  Filename _lock_pathname;
+#endif
+
+  // The file locks do not exclude other threads of the same process, so
+  // each shard is also guarded by one of these.  They are shared by all of
+  // the indexes in the process, so that two indexes on the same file also
+  // exclude each other.
+  enum { num_shard_mutexes = 64 };
+  static LightMutex _shard_mutexes[num_shard_mutexes];
+  static LightMutex _init_mutex;
+};
+
+#include "bamCacheHashIndex.I"
+
+#endif
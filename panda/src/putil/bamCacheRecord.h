@@ -142,6 +142,7 @@ private:
 
   friend class BamCache;
   friend class BamCacheIndex;
+  friend class BamCacheHashIndex;
   friend class BamCacheRecord::SortByAccessTime;
 };
 
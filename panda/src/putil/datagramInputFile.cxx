@@ -147,36 +147,16 @@ get_datagram(Datagram &data) {
   // Make sure we have a reasonable datagram size for putting into memory.
   nassertr(num_bytes == (size_t)num_bytes, false);
 
-  // Now, read the datagram itself.
-
-  // If the number of bytes is large, we will need to allocate a temporary
-  // buffer from the heap.  Otherwise, we can get away with allocating it on
-  // the stack, via alloca().
-  if (num_bytes > 65536) {
-    char *buffer = (char *)PANDA_MALLOC_ARRAY(num_bytes);
-    nassertr(buffer != (char *)NULL, false);
-
-    _in->read(buffer, num_bytes);
-    if (_in->fail() || _in->eof()) {
-      _error = true;
-      PANDA_FREE_ARRAY(buffer);
-      return false;
-    }
-
-    data = Datagram(buffer, num_bytes);
-    PANDA_FREE_ARRAY(buffer);
-
-  } else {
-    char *buffer = (char *)alloca(num_bytes);
-    nassertr(buffer != (char *)NULL, false);
-
-    _in->read(buffer, num_bytes);
-    if (_in->fail() || _in->eof()) {
-      _error = true;
-      return false;
-    }
-
-    data = Datagram(buffer, num_bytes);
+  // Now, read the datagram itself, directly into the datagram's own buffer.
+  // A small datagram is stored within the Datagram object, so that reading
+  // it allocates no memory at all.
+  data = Datagram();
+  data.pad_bytes(num_bytes);
+  _in->read((char *)data.modify_data(), num_bytes);
+  if (_in->fail() || _in->eof()) {
+    _error = true;
+    data.clear();
+    return false;
   }
   Thread::consider_yield();
 
@@ -1,6 +1,7 @@
 #include "animInterface.cxx"
 #include "autoTextureScale.cxx"
 #include "bamCache.cxx"
+#include "bamCacheHashIndex.cxx"
 #include "bamCacheIndex.cxx"
 #include "bamCacheRecord.cxx"
 #include "bamEnums.cxx"
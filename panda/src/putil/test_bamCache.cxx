@@ -0,0 +1,225 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_bamCache.cxx
+ * @date 2026-10-19
+ */
+
+#include "pandabase.h"
+#include "config_util.h"
+#include "bamCache.h"
+#include "bamCacheRecord.h"
+#include "paramValue.h"
+#include "configVariableInt.h"
+#include "virtualFileSystem.h"
+#include "genericThread.h"
+#include "trueClock.h"
+
+// Measures how fast a number of threads can load files from one BamCache at
+// the same time, first with the ordinary index, and then with the hash table
+// index (model-cache-index-shards).  Each thread looks up randomly chosen
+// files from a cache that has already been filled.  With the ordinary index,
+// the lookups take turns holding the BamCache lock; with the hash table
+// index, they read the cache files at the same time.
+//
+// To see several processes sharing a cache, run one copy with -d and a
+// directory name to fill it, and then several copies with the same -d at
+// once.  The directory is left in place afterwards.
+
+static int num_threads = 4;
+static int num_lookups = 2000;
+static int num_files = 200;
+
+static ConfigVariableInt model_cache_index_shards
+("model-cache-index-shards", 0);
+
+class Loader {
+public:
+  BamCache *_cache;
+  pvector<Filename> *_sources;
+  unsigned int _seed;
+  int _hits;
+  double _elapsed;
+};
+
+/**
+ * The body of each loading thread.
+ */
+static void
+run_loader(void *data) {
+  Loader *loader = (Loader *)data;
+  TrueClock *clock = TrueClock::get_global_ptr();
+
+  double start = clock->get_short_time();
+  for (int i = 0; i < num_lookups; ++i) {
+    loader->_seed = loader->_seed * 1103515245 + 12345;
+    int fi = (int)((loader->_seed >> 8) % loader->_sources->size());
+    PT(BamCacheRecord) record =
+      loader->_cache->lookup((*loader->_sources)[fi], "bam");
+    if (record != (BamCacheRecord *)NULL && record->has_data()) {
+      ++(loader->_hits);
+    }
+  }
+  loader->_elapsed = clock->get_short_time() - start;
+}
+
+/**
+ * Fills the cache in the indicated directory with whichever source files it
+ * doesn't already hold, and then has the loading threads read from it.
+ * Returns the number of lookups per second, over all threads.
+ */
+static double
+run_cache(const Filename &cache_dir, pvector<Filename> &sources,
+          int num_shards) {
+  model_cache_index_shards.set_value(num_shards);
+  cache_dir.mkdir();
+
+  BamCache *cache = new BamCache;
+  cache->set_root(cache_dir);
+
+  for (size_t fi = 0; fi < sources.size(); ++fi) {
+    PT(BamCacheRecord) record = cache->lookup(sources[fi], "bam");
+    if (record != (BamCacheRecord *)NULL && !record->has_data()) {
+      record->add_dependent_file(sources[fi]);
+      record->set_data(new ParamString(sources[fi].get_fullpath()));
+      cache->store(record);
+    }
+  }
+
+  pvector<Loader> loaders(num_threads);
+  for (int t = 0; t < num_threads; ++t) {
+    loaders[t]._cache = cache;
+    loaders[t]._sources = &sources;
+    loaders[t]._seed = (unsigned int)t * 7919 + 1;
+    loaders[t]._hits = 0;
+    loaders[t]._elapsed = 0.0;
+  }
+
+  if (num_threads == 1) {
+    run_loader(&loaders[0]);
+
+  } else {
+    pvector<PT(GenericThread)> threads;
+    for (int t = 0; t < num_threads; ++t) {
+      ostringstream strm;
+      strm << "Loader " << t;
+      PT(GenericThread) thread =
+        new GenericThread(strm.str(), strm.str(), &run_loader, &loaders[t]);
+      thread->start(TP_normal, true);
+      threads.push_back(thread);
+    }
+    for (int t = 0; t < num_threads; ++t) {
+      threads[t]->join();
+    }
+  }
+
+  double elapsed = 0.0;
+  int hits = 0;
+  for (int t = 0; t < num_threads; ++t) {
+    elapsed = max(elapsed, loaders[t]._elapsed);
+    hits += loaders[t]._hits;
+  }
+  int total = num_threads * num_lookups;
+  if (hits != total) {
+    nout << "  (" << total - hits << " of " << total
+         << " lookups missed the cache)\n";
+  }
+
+  delete cache;
+  return total / elapsed;
+}
+
+/**
+ * Deletes the indicated directory and the files in it.
+ */
+static void
+remove_dir(const Filename &dir) {
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+  PT(VirtualFileList) contents = vfs->scan_directory(dir);
+  if (contents != (VirtualFileList *)NULL) {
+    for (int i = 0; i < contents->get_num_files(); ++i) {
+      contents->get_file(i)->delete_file();
+    }
+  }
+  dir.rmdir();
+}
+
+int
+main(int argc, char *argv[]) {
+  Filename base_dir;
+  if (argc > 2 && strcmp(argv[1], "-d") == 0) {
+    base_dir = Filename::from_os_specific(argv[2]);
+    argc -= 2;
+    argv += 2;
+  }
+  if (argc > 1) {
+    num_threads = max(atoi(argv[1]), 1);
+  }
+  if (argc > 2) {
+    num_lookups = max(atoi(argv[2]), 1);
+  }
+  if (argc > 3) {
+    num_files = max(atoi(argv[3]), 1);
+  }
+  if (argc > 4) {
+    nout << "test_bamCache [-d dir] [threads [lookups [files]]]\n";
+    exit(1);
+  }
+
+  if (!Thread::is_threading_supported()) {
+    num_threads = 1;
+  }
+
+  init_libputil();
+
+  bool keep_dir = !base_dir.empty();
+  if (!keep_dir) {
+    base_dir = Filename::temporary("", "test_bamCache");
+  }
+  base_dir.make_dir();
+  base_dir.mkdir();
+  Filename source_dir(base_dir, "src");
+  source_dir.mkdir();
+
+  pvector<Filename> sources;
+  for (int fi = 0; fi < num_files; ++fi) {
+    ostringstream strm;
+    strm << "model" << fi << ".egg";
+    Filename source(source_dir, strm.str());
+    source.set_text();
+    if (!source.exists()) {
+      // Another process sharing the directory may already have written it,
+      // and changing it now would invalidate its cache records.
+      pofstream out;
+      if (!source.open_write(out)) {
+        nout << "Couldn't write " << source << "\n";
+        exit(1);
+      }
+      out << "// source file " << fi << "\n";
+    }
+    sources.push_back(source);
+  }
+
+  nout << num_threads << " threads, " << num_lookups << " lookups each, of "
+       << num_files << " files:\n";
+
+  double rate = run_cache(Filename(base_dir, "classic"), sources, 0);
+  nout << "  index.boo: " << (int)rate << " lookups per second\n";
+
+  rate = run_cache(Filename(base_dir, "hashed"), sources, 16);
+  nout << "  index.map: " << (int)rate << " lookups per second\n";
+
+  if (keep_dir) {
+    return 0;
+  }
+  remove_dir(Filename(base_dir, "classic"));
+  remove_dir(Filename(base_dir, "hashed"));
+  remove_dir(source_dir);
+  base_dir.rmdir();
+  return 0;
+}
@@ -1,3 +1,4 @@
+#include "pStatCaptureReader.cxx"
 #include "pStatClientData.cxx"
 #include "pStatGraph.cxx"
 #include "pStatListener.cxx"
@@ -0,0 +1,224 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file pStatCaptureReader.cxx
+ * @date 2026-10-19
+ */
+
+#include "pStatCaptureReader.h"
+
+#include "pStatClientControlMessage.h"
+#include "pStatFrameData.h"
+#include "pStatProperties.h"
+#include "datagram.h"
+#include "datagramIterator.h"
+
+/**
+ *
+ */
+PStatCaptureReader::
+PStatCaptureReader() :
+  _got_hello(false),
+  _error(false)
+{
+}
+
+/**
+ *
+ */
+PStatCaptureReader::
+~PStatCaptureReader() {
+  close();
+}
+
+/**
+ * Opens the indicated capture file and checks its header.  Returns true on
+ * success, or false if the file can't be read or isn't a PStats capture.
+ */
+bool PStatCaptureReader::
+open(const Filename &filename) {
+  close();
+
+  _filename = filename;
+  _filename.set_binary();
+  if (!_in.open(_filename)) {
+    nout << "Unable to read " << _filename << "\n";
+    _error = true;
+    return false;
+  }
+
+  string expected = get_pstat_capture_header();
+  string header;
+  if (!_in.read_header(header, expected.size()) || header != expected) {
+    nout << _filename << " is not a PStats capture file.\n";
+    _in.close();
+    _error = true;
+    return false;
+  }
+
+  _client_data = new PStatClientData(NULL);
+  return true;
+}
+
+/**
+ * Closes the file, and forgets everything that was read from it.
+ */
+void PStatCaptureReader::
+close() {
+  _in.close();
+  _client_data.clear();
+  _client_hostname = string();
+  _client_progname = string();
+  _got_hello = false;
+  _error = false;
+}
+
+/**
+ * Reads the next frame in the file, of any thread, handling any collector or
+ * thread definitions that come before it.  Returns true if a frame was read,
+ * or false at the end of the file or on error; is_error() tells the two
+ * apart.
+ */
+bool PStatCaptureReader::
+read_frame(int &thread_index, int &frame_number, PStatFrameData &frame_data) {
+  if (_error || _client_data == (PStatClientData *)NULL) {
+    return false;
+  }
+
+  Datagram datagram;
+  while (_in.get_datagram(datagram)) {
+    PStatClientControlMessage message;
+    if (message.decode(datagram, _client_data)) {
+      if (!handle_client_control_message(message)) {
+        _error = true;
+        return false;
+      }
+      continue;
+    }
+
+    if (message._type != PStatClientControlMessage::T_datagram) {
+      nout << "Unexpected message in " << _filename << "\n";
+      _error = true;
+      return false;
+    }
+
+    if (!_got_hello) {
+      // The client always writes its greeting first; without it, we don't
+      // know which version of the frame data we are looking at.
+      nout << _filename << " has frame data before the client's greeting.\n";
+      _error = true;
+      return false;
+    }
+
+    DatagramIterator source(datagram);
+    if (_client_data->is_at_least(2, 1)) {
+      // Skip the zero byte that marks this as frame data.
+      source.get_uint8();
+    }
+
+    thread_index = source.get_uint16();
+    frame_number = source.get_uint32();
+    frame_data.clear();
+    frame_data.read_datagram(source, _client_data);
+    return true;
+  }
+
+  // We've reached the end of the file.  If the client was killed in the
+  // middle of writing a frame, that frame is quietly lost, which isn't worth
+  // failing over.
+  return false;
+}
+
+/**
+ * Returns true if the file could not be read, or contained something other
+ * than PStats data.
+ */
+bool PStatCaptureReader::
+is_error() const {
+  return _error;
+}
+
+/**
+ * Returns the collector and thread definitions read from the file so far.
+ */
+PStatClientData *PStatCaptureReader::
+get_client_data() const {
+  return _client_data;
+}
+
+/**
+ * Returns the hostname of the machine that wrote the capture, once the first
+ * frame has been read.
+ */
+const string &PStatCaptureReader::
+get_client_hostname() const {
+  return _client_hostname;
+}
+
+/**
+ * Returns the name of the program that wrote the capture, once the first
+ * frame has been read.
+ */
+const string &PStatCaptureReader::
+get_client_progname() const {
+  return _client_progname;
+}
+
+/**
+ * Records the information in a control message that the client wrote to the
+ * file.  Returns true on success, or false if the capture can't be read by
+ * this version of the code.
+ */
+bool PStatCaptureReader::
+handle_client_control_message(const PStatClientControlMessage &message) {
+  switch (message._type) {
+  case PStatClientControlMessage::T_hello:
+    {
+      _client_data->set_version(message._major_version,
+                                message._minor_version);
+      int server_major_version = get_current_pstat_major_version();
+      int server_minor_version = get_current_pstat_minor_version();
+
+      if (message._major_version != server_major_version ||
+          message._minor_version > server_minor_version) {
+        nout << _filename << " was written with PStats version "
+             << message._major_version << "." << message._minor_version
+             << ", but this program understands version "
+             << server_major_version << "." << server_minor_version << ".\n";
+        return false;
+      }
+      _client_hostname = message._client_hostname;
+      _client_progname = message._client_progname;
+      _got_hello = true;
+    }
+    break;
+
+  case PStatClientControlMessage::T_define_collectors:
+    {
+      for (int i = 0; i < (int)message._collectors.size(); i++) {
+        _client_data->add_collector(message._collectors[i]);
+      }
+    }
+    break;
+
+  case PStatClientControlMessage::T_define_threads:
+    {
+      for (int i = 0; i < (int)message._names.size(); i++) {
+        int thread_index = message._first_thread_index + i;
+        _client_data->define_thread(thread_index, message._names[i]);
+      }
+    }
+    break;
+
+  default:
+    nout << "Invalid control message in " << _filename << "\n";
+    return false;
+  }
+
+  return true;
+}
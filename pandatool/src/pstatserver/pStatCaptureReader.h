@@ -0,0 +1,61 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file pStatCaptureReader.h
+ * @date 2026-10-19
+ */
+
+#ifndef PSTATCAPTUREREADER_H
+#define PSTATCAPTUREREADER_H
+
+#include "pandatoolbase.h"
+
+#include "pStatClientData.h"
+#include "datagramInputFile.h"
+#include "filename.h"
+#include "pointerTo.h"
+
+class PStatClientControlMessage;
+class PStatFrameData;
+
+/**
+ * Reads back a file written by a PStatClient with pstats-capture-file set.
+ * The collector and thread definitions are gathered into a PStatClientData
+ * as they are encountered, and the frames are returned one at a time, in the
+ * order the client recorded them, so that a whole run can be analyzed
+ * without keeping it all in memory.
+ */
+class PStatCaptureReader {
+public:
+  PStatCaptureReader();
+  ~PStatCaptureReader();
+
+  bool open(const Filename &filename);
+  void close();
+
+  bool read_frame(int &thread_index, int &frame_number,
+                  PStatFrameData &frame_data);
+  bool is_error() const;
+
+  PStatClientData *get_client_data() const;
+  const string &get_client_hostname() const;
+  const string &get_client_progname() const;
+
+private:
+  bool handle_client_control_message(const PStatClientControlMessage &message);
+
+  DatagramInputFile _in;
+  Filename _filename;
+  PT(PStatClientData) _client_data;
+  string _client_hostname;
+  string _client_progname;
+  bool _got_hello;
+  bool _error;
+};
+
+#endif
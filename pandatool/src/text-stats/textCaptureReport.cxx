@@ -0,0 +1,503 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file textCaptureReport.cxx
+ * @date 2026-10-19
+ */
+
+#include "textCaptureReport.h"
+
+#include "pStatClientData.h"
+#include "pStatCollectorDef.h"
+#include "pStatFrameData.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+
+namespace {
+  // Orders the children of a collector the way the PStats graphs do: by
+  // their sort value, and then by name.
+  class SortCollectors {
+  public:
+    SortCollectors(const PStatClientData *client_data) :
+      _client_data(client_data) {}
+
+    bool operator () (int a, int b) const {
+      const PStatCollectorDef &adef = _client_data->get_collector_def(a);
+      const PStatCollectorDef &bdef = _client_data->get_collector_def(b);
+      if (adef._sort != bdef._sort) {
+        return adef._sort < bdef._sort;
+      }
+      return adef._name < bdef._name;
+    }
+
+    const PStatClientData *_client_data;
+  };
+
+  // A collector that is running, for add_frame().
+  class OpenCollector {
+  public:
+    OpenCollector() : _depth(0), _start(0.0) {}
+    int _depth;
+    double _start;
+  };
+}
+
+/**
+ *
+ */
+TextCaptureReport::
+TextCaptureReport() :
+  _num_bins(20),
+  _hitch_ms(0.0),
+  _max_hitches(20)
+{
+}
+
+/**
+ * Sets the number of equal-width bins in the frame time histogram.  The
+ * histogram covers the range up to the 99th percentile; the slower frames
+ * are counted in one more bin after these.
+ */
+void TextCaptureReport::
+set_num_bins(int num_bins) {
+  _num_bins = max(num_bins, 1);
+}
+
+/**
+ * Sets the frame time, in milliseconds, above which a frame is reported as a
+ * hitch.  If this is 0, the default, a frame is a hitch if it takes more than
+ * twice as long as the median frame of its thread.
+ */
+void TextCaptureReport::
+set_hitch_ms(double hitch_ms) {
+  _hitch_ms = hitch_ms;
+}
+
+/**
+ * Sets the largest number of hitches listed for each thread.  The slowest
+ * ones are listed.
+ */
+void TextCaptureReport::
+set_max_hitches(int max_hitches) {
+  _max_hitches = max_hitches;
+}
+
+/**
+ * Reads all of the frames in the indicated capture file.  Returns true on
+ * success, or false if the file couldn't be read.
+ */
+bool TextCaptureReport::
+read(const Filename &filename) {
+  _threads.clear();
+  if (!_reader.open(filename)) {
+    return false;
+  }
+
+  int thread_index, frame_number;
+  PStatFrameData frame_data;
+  while (_reader.read_frame(thread_index, frame_number, frame_data)) {
+    add_frame(thread_index, frame_number, frame_data);
+  }
+
+  return !_reader.is_error();
+}
+
+/**
+ * Writes the report on the frames that were read.
+ */
+void TextCaptureReport::
+write(ostream &out) const {
+  const PStatClientData *client_data = _reader.get_client_data();
+  if (client_data == (PStatClientData *)NULL) {
+    return;
+  }
+
+  out << "Capture of " << _reader.get_client_progname()
+      << " on " << _reader.get_client_hostname() << "\n";
+
+  for (int ti = 0; ti < (int)_threads.size(); ++ti) {
+    if (!_threads[ti]._frame_ms.empty()) {
+      out << "\n";
+      write_thread(out, ti, _threads[ti]);
+    }
+  }
+}
+
+/**
+ * Adds the times and levels recorded in one frame to the statistics for its
+ * thread.
+ */
+void TextCaptureReport::
+add_frame(int thread_index, int frame_number,
+          const PStatFrameData &frame_data) {
+  if (frame_data.is_time_empty()) {
+    return;
+  }
+  if (thread_index >= (int)_threads.size()) {
+    _threads.resize(thread_index + 1);
+  }
+  ThreadStats &stats = _threads[thread_index];
+  size_t slot = stats._frame_ms.size();
+
+  stats._frame_numbers.push_back(frame_number);
+  stats._frame_ms.push_back(frame_data.get_net_time() * 1000.0);
+
+  // Add up the time spent in each collector.  A collector that is started
+  // again while it is already running is only counted once.
+  typedef pmap<int, OpenCollector> Open;
+  Open open;
+  pmap<int, double> totals;
+
+  size_t num_events = frame_data.get_num_events();
+  for (size_t n = 0; n < num_events; ++n) {
+    int collector_index = frame_data.get_time_collector(n);
+    if (collector_index == 0) {
+      // That's the frame itself.
+      continue;
+    }
+
+    OpenCollector &oc = open[collector_index];
+    if (frame_data.is_start(n)) {
+      if (oc._depth++ == 0) {
+        oc._start = frame_data.get_time(n);
+      }
+    } else if (oc._depth > 0) {
+      if (--oc._depth == 0) {
+        totals[collector_index] += frame_data.get_time(n) - oc._start;
+      }
+    }
+  }
+
+  // Anything still running ran until the end of the frame.
+  Open::const_iterator oi;
+  for (oi = open.begin(); oi != open.end(); ++oi) {
+    if ((*oi).second._depth > 0) {
+      totals[(*oi).first] += frame_data.get_end() - (*oi).second._start;
+    }
+  }
+
+  pmap<int, double>::const_iterator ti;
+  for (ti = totals.begin(); ti != totals.end(); ++ti) {
+    vector_double &times = stats._times[(*ti).first];
+    times.resize(slot, 0.0);
+    times.push_back((*ti).second * 1000.0);
+  }
+
+  size_t num_levels = frame_data.get_num_levels();
+  for (size_t n = 0; n < num_levels; ++n) {
+    int collector_index = frame_data.get_level_collector(n);
+    stats._levels[collector_index].push_back(frame_data.get_level(n));
+  }
+}
+
+/**
+ * Writes the part of the report for one thread.
+ */
+void TextCaptureReport::
+write_thread(ostream &out, int thread_index, const ThreadStats &stats) const {
+  const PStatClientData *client_data = _reader.get_client_data();
+
+  vector_double sorted = stats._frame_ms;
+  sort(sorted.begin(), sorted.end());
+  double median = get_percentile(sorted, 50.0);
+
+  char formatted[256];
+  out << "Thread " << client_data->get_thread_name(thread_index)
+      << ", " << sorted.size() << " frames\n";
+  sprintf(formatted,
+          "  frame time: mean %.3f, p50 %.3f, p90 %.3f, p99 %.3f, "
+          "max %.3f ms\n",
+          get_mean(sorted), median, get_percentile(sorted, 90.0),
+          get_percentile(sorted, 99.0), sorted.back());
+  out << formatted;
+
+  out << "\n";
+  write_histogram(out, sorted);
+  out << "\n";
+  write_collectors(out, stats);
+  if (!stats._levels.empty()) {
+    out << "\n";
+    write_levels(out, stats);
+  }
+  out << "\n";
+  write_hitches(out, stats, median);
+}
+
+/**
+ * Writes a histogram of the indicated frame times, which have been sorted.
+ */
+void TextCaptureReport::
+write_histogram(ostream &out, const vector_double &sorted) const {
+  static const int bar_width = 40;
+
+  double low = sorted.front();
+  double high = get_percentile(sorted, 99.0);
+  double width = (high - low) / _num_bins;
+  if (width <= 0.0) {
+    width = 0.001;
+  }
+
+  // The last bin counts the frames above the 99th percentile.
+  vector_int counts(_num_bins + 1, 0);
+  for (size_t i = 0; i < sorted.size(); ++i) {
+    int bin;
+    if (sorted[i] > high) {
+      bin = _num_bins;
+    } else {
+      bin = min((int)((sorted[i] - low) / width), _num_bins - 1);
+    }
+    ++counts[bin];
+  }
+  int max_count = *max_element(counts.begin(), counts.end());
+
+  out << "  frame time histogram (ms):\n";
+  char formatted[256];
+  for (int bin = 0; bin <= _num_bins; ++bin) {
+    if (bin < _num_bins) {
+      sprintf(formatted, "  %9.3f - %9.3f %7d ",
+              low + bin * width, low + (bin + 1) * width, counts[bin]);
+    } else if (counts[bin] != 0) {
+      sprintf(formatted, "  %9.3f +           %7d ", high, counts[bin]);
+    } else {
+      break;
+    }
+    out << formatted
+        << string(counts[bin] * bar_width / max_count, '#') << "\n";
+  }
+}
+
+/**
+ * Writes the percentiles of the time spent in each collector, with the
+ * collectors in a tree.
+ */
+void TextCaptureReport::
+write_collectors(ostream &out, const ThreadStats &stats) const {
+  const PStatClientData *client_data = _reader.get_client_data();
+  size_t num_frames = stats._frame_ms.size();
+
+  vector_int order, depths;
+  get_collector_order(order, depths);
+
+  char formatted[256];
+  sprintf(formatted, "  %-40s %7s %9s %9s %9s %9s %9s\n",
+          "collector (ms)", "frames", "mean", "p50", "p90", "p99", "max");
+  out << formatted;
+
+  for (size_t i = 0; i < order.size(); ++i) {
+    Samples::const_iterator si = stats._times.find(order[i]);
+    if (si == stats._times.end()) {
+      continue;
+    }
+    const vector_double &times = (*si).second;
+
+    // Count the frames in which the collector ran at all.
+    int num_active = 0;
+    for (size_t f = 0; f < times.size(); ++f) {
+      if (times[f] > 0.0) {
+        ++num_active;
+      }
+    }
+
+    vector_double sorted = times;
+    sorted.resize(num_frames, 0.0);
+    sort(sorted.begin(), sorted.end());
+
+    string name = string(depths[i] * 2, ' ') +
+      client_data->get_collector_def(order[i])._name;
+    sprintf(formatted, "  %-40s %7d %9.3f %9.3f %9.3f %9.3f %9.3f\n",
+            name.c_str(), num_active, get_mean(sorted),
+            get_percentile(sorted, 50.0), get_percentile(sorted, 90.0),
+            get_percentile(sorted, 99.0), sorted.back());
+    out << formatted;
+  }
+}
+
+/**
+ * Writes the percentiles of each level collector, such as the number of
+ * vertices or the amount of memory in use.
+ */
+void TextCaptureReport::
+write_levels(ostream &out, const ThreadStats &stats) const {
+  const PStatClientData *client_data = _reader.get_client_data();
+
+  vector_int order, depths;
+  get_collector_order(order, depths);
+
+  char formatted[256];
+  sprintf(formatted, "  %-40s %7s %11s %11s %11s %11s  %s\n",
+          "level", "frames", "p50", "p90", "p99", "max", "units");
+  out << formatted;
+
+  for (size_t i = 0; i < order.size(); ++i) {
+    Samples::const_iterator si = stats._levels.find(order[i]);
+    if (si == stats._levels.end()) {
+      continue;
+    }
+
+    vector_double sorted = (*si).second;
+    sort(sorted.begin(), sorted.end());
+
+    const PStatCollectorDef &def = client_data->get_collector_def(order[i]);
+    string name = string(depths[i] * 2, ' ') + def._name;
+    sprintf(formatted, "  %-40s %7d %11.5g %11.5g %11.5g %11.5g  %s\n",
+            name.c_str(), (int)sorted.size(),
+            get_percentile(sorted, 50.0), get_percentile(sorted, 90.0),
+            get_percentile(sorted, 99.0), sorted.back(),
+            def._level_units.c_str());
+    out << formatted;
+  }
+}
+
+/**
+ * Lists the slowest frames that took longer than the hitch threshold, each
+ * with the collectors that ran furthest over their median time on that
+ * frame.
+ */
+void TextCaptureReport::
+write_hitches(ostream &out, const ThreadStats &stats, double median) const {
+  static const int num_culprits = 3;
+  const PStatClientData *client_data = _reader.get_client_data();
+
+  double threshold = (_hitch_ms > 0.0) ? _hitch_ms : median * 2.0;
+
+  // Sort the hitches, slowest first.
+  pvector<pair<double, size_t> > hitches;
+  for (size_t slot = 0; slot < stats._frame_ms.size(); ++slot) {
+    if (stats._frame_ms[slot] > threshold) {
+      hitches.push_back(pair<double, size_t>(-stats._frame_ms[slot], slot));
+    }
+  }
+  sort(hitches.begin(), hitches.end());
+
+  char formatted[256];
+  sprintf(formatted, "  %d hitches over %.3f ms", (int)hitches.size(),
+          threshold);
+  out << formatted;
+  if ((int)hitches.size() > _max_hitches) {
+    out << ", slowest " << _max_hitches << " listed";
+  }
+  out << ":\n";
+
+  if (hitches.empty()) {
+    return;
+  }
+
+  size_t num_frames = stats._frame_ms.size();
+  pmap<int, double> medians;
+  Samples::const_iterator si;
+  for (si = stats._times.begin(); si != stats._times.end(); ++si) {
+    vector_double sorted = (*si).second;
+    sorted.resize(num_frames, 0.0);
+    sort(sorted.begin(), sorted.end());
+    medians[(*si).first] = get_percentile(sorted, 50.0);
+  }
+
+  for (int h = 0; h < (int)hitches.size() && h < _max_hitches; ++h) {
+    size_t slot = hitches[h].second;
+
+    pvector<pair<double, int> > culprits;
+    for (si = stats._times.begin(); si != stats._times.end(); ++si) {
+      const vector_double &times = (*si).second;
+      if (slot < times.size()) {
+        double excess = times[slot] - medians[(*si).first];
+        if (excess > 0.0) {
+          culprits.push_back(pair<double, int>(-excess, (*si).first));
+        }
+      }
+    }
+    sort(culprits.begin(), culprits.end());
+
+    sprintf(formatted, "    frame %d: %.3f ms", stats._frame_numbers[slot],
+            stats._frame_ms[slot]);
+    out << formatted;
+    for (int c = 0; c < (int)culprits.size() && c < num_culprits; ++c) {
+      sprintf(formatted, "%s +%.3f", (c == 0) ? " (" : ", ",
+              -culprits[c].first);
+      out << formatted;
+      out << " " << client_data->get_collector_fullname(culprits[c].second);
+    }
+    out << (culprits.empty() ? "\n" : ")\n");
+  }
+}
+
+/**
+ * Fills order with all of the collectors, each one followed by its children,
+ * and depths with how deep each one is in the tree.  Collector 0, the frame
+ * itself, is left out.
+ */
+void TextCaptureReport::
+get_collector_order(vector_int &order, vector_int &depths) const {
+  const PStatClientData *client_data = _reader.get_client_data();
+
+  Children children;
+  int num_collectors = client_data->get_num_collectors();
+  for (int i = 1; i < num_collectors; ++i) {
+    if (client_data->has_collector(i)) {
+      children[client_data->get_collector_def(i)._parent_index].push_back(i);
+    }
+  }
+
+  Children::iterator ci;
+  for (ci = children.begin(); ci != children.end(); ++ci) {
+    sort((*ci).second.begin(), (*ci).second.end(),
+         SortCollectors(client_data));
+  }
+
+  add_children(children, 0, 0, order, depths);
+}
+
+/**
+ * Recursively adds the children of the indicated collector for
+ * get_collector_order().
+ */
+void TextCaptureReport::
+add_children(const Children &children, int parent, int depth,
+             vector_int &order, vector_int &depths) {
+  Children::const_iterator ci = children.find(parent);
+  if (ci == children.end()) {
+    return;
+  }
+
+  const vector_int &kids = (*ci).second;
+  for (size_t i = 0; i < kids.size(); ++i) {
+    order.push_back(kids[i]);
+    depths.push_back(depth);
+    add_children(children, kids[i], depth + 1, order, depths);
+  }
+}
+
+/**
+ * Returns the indicated percentile of the values, which have been sorted,
+ * using the nearest-rank method.
+ */
+double TextCaptureReport::
+get_percentile(const vector_double &sorted, double percent) {
+  if (sorted.empty()) {
+    return 0.0;
+  }
+  int rank = (int)ceil(percent / 100.0 * sorted.size());
+  rank = max(min(rank, (int)sorted.size()), 1);
+  return sorted[rank - 1];
+}
+
+/**
+ * Returns the mean of the values.
+ */
+double TextCaptureReport::
+get_mean(const vector_double &values) {
+  if (values.empty()) {
+    return 0.0;
+  }
+  double total = 0.0;
+  for (size_t i = 0; i < values.size(); ++i) {
+    total += values[i];
+  }
+  return total / values.size();
+}
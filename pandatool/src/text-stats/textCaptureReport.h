@@ -0,0 +1,87 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file textCaptureReport.h
+ * @date 2026-10-19
+ */
+
+#ifndef TEXTCAPTUREREPORT_H
+#define TEXTCAPTUREREPORT_H
+
+#include "pandatoolbase.h"
+
+#include "pStatCaptureReader.h"
+#include "vector_double.h"
+#include "vector_int.h"
+#include "pvector.h"
+#include "pmap.h"
+
+class PStatFrameData;
+
+/**
+ * Reads a whole PStats capture file and summarizes it: for each thread, the
+ * distribution of frame times as percentiles and a histogram, the
+ * percentiles of the time spent in each collector and of each level, and a
+ * list of the frames that took much longer than usual, with the collectors
+ * most responsible.  The output is plain text, meant to be kept and compared
+ * between runs.
+ */
+class TextCaptureReport {
+public:
+  TextCaptureReport();
+
+  void set_num_bins(int num_bins);
+  void set_hitch_ms(double hitch_ms);
+  void set_max_hitches(int max_hitches);
+
+  bool read(const Filename &filename);
+  void write(ostream &out) const;
+
+private:
+  typedef pmap<int, vector_double> Samples;
+
+  class ThreadStats {
+  public:
+    vector_int _frame_numbers;
+    vector_double _frame_ms;
+
+    // The time, in milliseconds, spent in each collector on every frame,
+    // including the frames in which it didn't run at all.
+    Samples _times;
+
+    // The value of each level, on only the frames that reported it.
+    Samples _levels;
+  };
+
+  void add_frame(int thread_index, int frame_number,
+                 const PStatFrameData &frame_data);
+
+  void write_thread(ostream &out, int thread_index,
+                    const ThreadStats &stats) const;
+  void write_histogram(ostream &out, const vector_double &sorted) const;
+  void write_collectors(ostream &out, const ThreadStats &stats) const;
+  void write_levels(ostream &out, const ThreadStats &stats) const;
+  void write_hitches(ostream &out, const ThreadStats &stats,
+                     double median) const;
+
+  typedef pmap<int, vector_int> Children;
+  void get_collector_order(vector_int &order, vector_int &depths) const;
+  static void add_children(const Children &children, int parent, int depth,
+                           vector_int &order, vector_int &depths);
+  static double get_percentile(const vector_double &sorted, double percent);
+  static double get_mean(const vector_double &values);
+
+  PStatCaptureReader _reader;
+  pvector<ThreadStats> _threads;
+
+  int _num_bins;
+  double _hitch_ms;
+  int _max_hitches;
+};
+
+#endif
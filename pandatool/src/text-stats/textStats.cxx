@@ -13,6 +13,8 @@
 
 #include "textStats.h"
 #include "textMonitor.h"
+#include "textCaptureReport.h"
+#include "textTraceExport.h"
 
 #include "pStatServer.h"
 #include "config_pstats.h"
@@ -36,7 +38,13 @@ TextStats() {
   set_program_description
     ("This is a simple PStats server that listens on a TCP port for a "
      "connection from a PStatClient in a Panda player.  It will then report "
-     "frame rate and timing information sent by the player.");
+     "frame rate and timing information sent by the player.\n\n"
+
+     "Alternatively, with -i, it reads a file written by a client with "
+     "pstats-capture-file set, and reports the distribution of frame "
+     "times, the percentiles of the time spent in each collector, and the "
+     "frames that took much longer than usual, or with -trace, converts "
+     "the file for viewing in a trace viewer.");
 
   add_option
     ("p", "port", 0,
@@ -55,8 +63,52 @@ TextStats() {
      "Filename where to print. If not given then stderr is being used.",
      &TextStats::dispatch_string, &_got_outputFileName, &_outputFileName);
 
+  add_option
+    ("i", "filename", 0,
+     "Read the frame data from the indicated capture file, instead of "
+     "listening for a connection, and write a summary of it.",
+     &TextStats::dispatch_filename, &_got_capture_filename,
+     &_capture_filename);
+
+  add_option
+    ("bins", "n", 0,
+     "With -i, specify the number of bins in the frame time histogram.  "
+     "The default is 20.",
+     &TextStats::dispatch_int, NULL, &_num_bins);
+
+  add_option
+    ("hitch", "ms", 0,
+     "With -i, report the frames that took longer than this many "
+     "milliseconds.  The default is twice the median frame time of each "
+     "thread.",
+     &TextStats::dispatch_double, NULL, &_hitch_ms);
+
+  add_option
+    ("trace", "filename", 0,
+     "With -i, write the frame data to the indicated file in the JSON trace "
+     "event format, for viewing in chrome://tracing or the Perfetto UI, "
+     "instead of writing a summary.",
+     &TextStats::dispatch_filename, &_got_trace_filename, &_trace_filename);
+
+  add_option
+    ("pid", "pid", 0,
+     "With -trace, specify the process ID to give the client in the trace.  "
+     "Use the client's real process ID to merge the trace with one recorded "
+     "by other tools.",
+     &TextStats::dispatch_int, NULL, &_trace_pid);
+
+  add_option
+    ("offset", "seconds", 0,
+     "With -trace, add this many seconds to every timestamp.  The client's "
+     "PStats clock starts near zero when the client starts.",
+     &TextStats::dispatch_double, NULL, &_trace_offset);
+
   _outFile = NULL;
   _port = pstats_port;
+  _num_bins = 20;
+  _hitch_ms = 0.0;
+  _trace_pid = 1;
+  _trace_offset = 0.0;
 }
 
 
@@ -75,6 +127,15 @@ make_monitor() {
  */
 void TextStats::
 run() {
+  if (_got_capture_filename) {
+    if (_got_trace_filename) {
+      export_trace();
+    } else {
+      report_capture();
+    }
+    return;
+  }
+
   // Set up a global signal handler to catch Interrupt (Control-C) so we can
   // clean up nicely if the user stops us.
   signal(SIGINT, &signal_handler);
@@ -96,6 +157,47 @@ run() {
   nout << "Exiting.\n";
 }
 
+/**
+ * Writes a summary of the frames in the capture file named with -i.
+ */
+void TextStats::
+report_capture() {
+  TextCaptureReport report;
+  report.set_num_bins(_num_bins);
+  report.set_hitch_ms(_hitch_ms);
+  if (!report.read(_capture_filename)) {
+    exit(1);
+  }
+
+  if (_got_outputFileName) {
+    ofstream out(_outputFileName.c_str(), ios::out);
+    report.write(out);
+  } else {
+    report.write(cout);
+  }
+}
+
+/**
+ * Converts the capture file named with -i to the trace file named with
+ * -trace.
+ */
+void TextStats::
+export_trace() {
+  _trace_filename.set_text();
+  ofstream out;
+  if (!_trace_filename.open_write(out)) {
+    nout << "Unable to write " << _trace_filename << "\n";
+    exit(1);
+  }
+
+  TextTraceExport trace;
+  trace.set_pid(_trace_pid);
+  trace.set_time_offset(_trace_offset);
+  if (!trace.write(_capture_filename, out)) {
+    exit(1);
+  }
+}
+
 
 int main(int argc, char *argv[]) {
   TextStats prog;
@@ -18,6 +18,7 @@
 
 #include "programBase.h"
 #include "pStatServer.h"
+#include "filename.h"
 
 #include <iostream>
 #include <fstream>
@@ -35,9 +36,22 @@ public:
   void run();
 
 private:
+  void report_capture();
+  void export_trace();
+
   int _port;
   bool _show_raw_data;
 
+  bool _got_capture_filename;
+  Filename _capture_filename;
+  int _num_bins;
+  double _hitch_ms;
+
+  bool _got_trace_filename;
+  Filename _trace_filename;
+  int _trace_pid;
+  double _trace_offset;
+
   // [PECI]
   bool _got_outputFileName;
   string _outputFileName;
@@ -0,0 +1,278 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file textTraceExport.cxx
+ * @date 2026-10-19
+ */
+
+#include "textTraceExport.h"
+
+#include "pStatCaptureReader.h"
+#include "pStatFrameData.h"
+#include "pmap.h"
+#include "cmath.h"
+
+#include <stdio.h>
+
+namespace {
+  // A collector that is running, for write_frame().
+  class OpenCollector {
+  public:
+    OpenCollector() : _depth(0), _start(0.0) {}
+    int _depth;
+    double _start;
+  };
+
+  // Returns true if the number is neither a NaN nor an infinity.
+  bool is_finite(double value) {
+    return !cnan(value) && !cinf(value);
+  }
+}
+
+/**
+ *
+ */
+TextTraceExport::
+TextTraceExport() :
+  _pid(1),
+  _time_offset(0.0),
+  _any_events(false)
+{
+}
+
+/**
+ * Sets the process ID written with every event.  Set this to the real
+ * process ID of the client to line its events up with the same process in
+ * another trace.
+ */
+void TextTraceExport::
+set_pid(int pid) {
+  _pid = pid;
+}
+
+/**
+ * Sets the number of seconds to add to every PStats time.
+ */
+void TextTraceExport::
+set_time_offset(double offset) {
+  _time_offset = offset;
+}
+
+/**
+ * Reads the indicated capture file and writes it to the stream as a trace.
+ * Returns true on success, or false if the file couldn't be read.
+ */
+bool TextTraceExport::
+write(const Filename &capture_filename, ostream &out) {
+  int thread_index, frame_number;
+  PStatFrameData frame_data;
+
+  // A collector may be used before the client gets around to writing its
+  // definition, so we read through the file once just for the definitions,
+  // and then again to write out the events.
+  PStatCaptureReader reader;
+  if (!reader.open(capture_filename)) {
+    return false;
+  }
+  while (reader.read_frame(thread_index, frame_number, frame_data)) {
+  }
+  if (reader.is_error()) {
+    return false;
+  }
+  _client_data = reader.get_client_data();
+  string process_name = reader.get_client_progname() + " on " +
+    reader.get_client_hostname();
+
+  if (!reader.open(capture_filename)) {
+    return false;
+  }
+
+  _any_events = false;
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+  begin_event(out);
+  out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << _pid
+      << ",\"args\":{\"name\":";
+  write_string(out, process_name);
+  out << "}}";
+
+  int num_threads = _client_data->get_num_threads();
+  for (int ti = 0; ti < num_threads; ++ti) {
+    if (_client_data->has_thread(ti)) {
+      begin_event(out);
+      out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << _pid
+          << ",\"tid\":" << ti << ",\"args\":{\"name\":";
+      write_string(out, _client_data->get_thread_name(ti));
+      out << "}}";
+
+      begin_event(out);
+      out << "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":" << _pid
+          << ",\"tid\":" << ti << ",\"args\":{\"sort_index\":" << ti
+          << "}}";
+    }
+  }
+
+  while (reader.read_frame(thread_index, frame_number, frame_data)) {
+    write_frame(out, thread_index, frame_number, frame_data);
+  }
+
+  out << "\n]}\n";
+  _client_data.clear();
+  return !reader.is_error();
+}
+
+/**
+ * Writes the events for one frame of one thread.
+ */
+void TextTraceExport::
+write_frame(ostream &out, int thread_index, int frame_number,
+            const PStatFrameData &frame_data) {
+  char formatted[128];
+
+  double frame_start = frame_data.get_start() + _time_offset;
+  if (!is_finite(frame_start)) {
+    // A corrupt frame can't be placed on the timeline at all.
+    return;
+  }
+
+  if (!frame_data.is_time_empty() && is_finite(frame_data.get_net_time())) {
+    begin_event(out);
+    sprintf(formatted, ",\"ts\":%.3f,\"dur\":%.3f",
+            frame_start * 1.0e6, frame_data.get_net_time() * 1.0e6);
+    out << "{\"name\":\"Frame\",\"cat\":\"pstats\",\"ph\":\"X\",\"pid\":"
+        << _pid << ",\"tid\":" << thread_index << formatted
+        << ",\"args\":{\"frame\":" << frame_number << "}}";
+  }
+
+  // Pair up the starts and stops of each collector.  A collector that is
+  // started again while it is already running becomes one event.
+  typedef pmap<int, OpenCollector> Open;
+  Open open;
+
+  size_t num_events = frame_data.get_num_events();
+  for (size_t n = 0; n < num_events; ++n) {
+    int collector_index = frame_data.get_time_collector(n);
+    if (collector_index == 0) {
+      // The frame itself was written above.
+      continue;
+    }
+
+    OpenCollector &oc = open[collector_index];
+    if (frame_data.is_start(n)) {
+      if (oc._depth++ == 0) {
+        oc._start = frame_data.get_time(n);
+      }
+    } else if (oc._depth > 0) {
+      if (--oc._depth == 0) {
+        write_event(out, _client_data->get_collector_name(collector_index),
+                    thread_index, oc._start, frame_data.get_time(n));
+      }
+    }
+  }
+
+  // Anything still running ran until the end of the frame.
+  Open::const_iterator oi;
+  for (oi = open.begin(); oi != open.end(); ++oi) {
+    if ((*oi).second._depth > 0) {
+      write_event(out, _client_data->get_collector_name((*oi).first),
+                  thread_index, (*oi).second._start, frame_data.get_end());
+    }
+  }
+
+  // Counters belong to the whole process, so the levels of any thread but
+  // the main one are named for their thread.
+  string suffix;
+  if (thread_index != 0) {
+    suffix = " (" + _client_data->get_thread_name(thread_index) + ")";
+  }
+
+  size_t num_levels = frame_data.get_num_levels();
+  for (size_t n = 0; n < num_levels; ++n) {
+    int collector_index = frame_data.get_level_collector(n);
+    begin_event(out);
+    out << "{\"name\":";
+    write_string(out, _client_data->get_collector_fullname(collector_index) +
+                 suffix);
+    sprintf(formatted, ",\"ts\":%.3f,\"args\":{\"value\":",
+            frame_start * 1.0e6);
+    out << ",\"cat\":\"pstats\",\"ph\":\"C\",\"pid\":" << _pid << formatted;
+    write_number(out, frame_data.get_level(n));
+    out << "}}";
+  }
+}
+
+/**
+ * Writes a complete event for one run of a collector.
+ */
+void TextTraceExport::
+write_event(ostream &out, const string &name, int thread_index,
+            double start, double end) {
+  if (!is_finite(start + _time_offset) || !is_finite(end - start)) {
+    // There's no way to write this in JSON.
+    return;
+  }
+
+  char formatted[128];
+  sprintf(formatted, ",\"ts\":%.3f,\"dur\":%.3f}",
+          (start + _time_offset) * 1.0e6, (end - start) * 1.0e6);
+
+  begin_event(out);
+  out << "{\"name\":";
+  write_string(out, name);
+  out << ",\"cat\":\"pstats\",\"ph\":\"X\",\"pid\":" << _pid
+      << ",\"tid\":" << thread_index << formatted;
+}
+
+/**
+ * Writes whatever must come before the next event in the list.
+ */
+void TextTraceExport::
+begin_event(ostream &out) {
+  if (_any_events) {
+    out << ",\n";
+  } else {
+    out << "\n";
+    _any_events = true;
+  }
+}
+
+/**
+ * Writes the indicated string as a quoted JSON string.
+ */
+void TextTraceExport::
+write_string(ostream &out, const string &str) {
+  out << '"';
+  for (string::const_iterator si = str.begin(); si != str.end(); ++si) {
+    unsigned char ch = (unsigned char)(*si);
+    if (ch == '"' || ch == '\\') {
+      out << '\\' << (char)ch;
+    } else if (ch < 0x20) {
+      char formatted[8];
+      sprintf(formatted, "\\u%04x", ch);
+      out << formatted;
+    } else {
+      out << (char)ch;
+    }
+  }
+  out << '"';
+}
+
+/**
+ * Writes the indicated number as a JSON number, or as null if it is a NaN or
+ * an infinity, which JSON has no way to write.
+ */
+void TextTraceExport::
+write_number(ostream &out, double value) {
+  if (!is_finite(value)) {
+    out << "null";
+    return;
+  }
+  char formatted[32];
+  sprintf(formatted, "%.17g", value);
+  out << formatted;
+}
@@ -0,0 +1,58 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file textTraceExport.h
+ * @date 2026-10-19
+ */
+
+#ifndef TEXTTRACEEXPORT_H
+#define TEXTTRACEEXPORT_H
+
+#include "pandatoolbase.h"
+
+#include "pStatClientData.h"
+#include "filename.h"
+#include "pointerTo.h"
+
+class PStatFrameData;
+
+/**
+ * Converts a PStats capture file to the JSON trace event format read by
+ * chrome://tracing and the Perfetto UI.  Each PStats thread becomes a thread
+ * of the trace; each time a collector runs becomes a complete ("X") event,
+ * nested under its frame, and each level becomes a counter.
+ *
+ * The timestamps are the client's PStats clock, in microseconds, which
+ * starts near zero when the client starts; set_time_offset() can move them
+ * onto the clock of a trace recorded by other tools.
+ */
+class TextTraceExport {
+public:
+  TextTraceExport();
+
+  void set_pid(int pid);
+  void set_time_offset(double offset);
+
+  bool write(const Filename &capture_filename, ostream &out);
+
+private:
+  void write_frame(ostream &out, int thread_index, int frame_number,
+                   const PStatFrameData &frame_data);
+  void write_event(ostream &out, const string &name, int thread_index,
+                   double start, double end);
+  void begin_event(ostream &out);
+  static void write_string(ostream &out, const string &str);
+  static void write_number(ostream &out, double value);
+
+  PT(PStatClientData) _client_data;
+  int _pid;
+  double _time_offset;
+  bool _any_events;
+};
+
+#endif